@@ -3,80 +3,126 @@
 
 #include <flutter/standard_message_codec.h>
 
+#include "plugins/common/common.h"
+
 #define STR_LINK_TROUBLESHOOTING \
   "https://github.com/bluefireteam/audioplayers/blob/main/troubleshooting.md"
 
 AudioPlayer::AudioPlayer(const std::string& channelName,
-                         BinaryMessenger* messenger)
+                         BinaryMessenger* messenger,
+                         PipelinePool* pipelinePool,
+                         SoundPool* soundPool)
     : BasicMessageChannel(messenger,
                           channelName,
                           &flutter::StandardMessageCodec::GetInstance()),
-      media_state_(GST_STATE_VOID_PENDING) {
+      media_state_(GST_STATE_VOID_PENDING),
+      pipelinePool_(pipelinePool),
+      positionTimer_(g_main_context_get_thread_default()),
+      soundPool_(soundPool) {
   SetMessageHandler([&](const EncodableValue& /* message */,
                         const flutter::MessageReply<EncodableValue>& reply) {
     reply(EncodableValue());
     return;
   });
 
-  // Get the calling context.
-  context_ = g_main_context_get_thread_default();
-
-  playbin_ = gst_element_factory_make("playbin", nullptr);
-  if (!playbin_) {
+  auto pipeline = pipelinePool_->Acquire();
+  if (!pipeline) {
     throw std::runtime_error("Not all elements could be created.");
   }
+  AttachPipeline(std::move(pipeline));
+}
 
-  // Setup stereo balance controller
-  panorama_ = gst_element_factory_make("audiopanorama", nullptr);
-  if (panorama_) {
-    audiobin_ = gst_bin_new(nullptr);
-    audiosink_ = gst_element_factory_make("autoaudiosink", nullptr);
-
-    gst_bin_add_many(GST_BIN(audiobin_), panorama_, audiosink_, nullptr);
-    gst_element_link(panorama_, audiosink_);
-
-    GstPad* sinkpad = gst_element_get_static_pad(panorama_, "sink");
-    panoramaSinkPad_ = gst_ghost_pad_new("sink", sinkpad);
-    gst_element_add_pad(audiobin_, panoramaSinkPad_);
-    gst_object_unref(GST_OBJECT(sinkpad));
-
-    g_object_set(G_OBJECT(playbin_), "audio-sink", audiobin_, nullptr);
-    g_object_set(G_OBJECT(panorama_), "method", 1, nullptr);
+AudioPlayer::~AudioPlayer() {
+  positionTimer_.Stop();
+  StopDiscoverer();
+  ReleaseVoice();
+  if (pipeline_) {
+    DetachPipeline();
   }
+}
 
-  // Setup source options
-  g_signal_connect(playbin_, "source-setup",
-                   G_CALLBACK(AudioPlayer::SourceSetup), &source_);
+void AudioPlayer::AttachPipeline(
+    std::unique_ptr<PipelinePool::Pipeline> pipeline) {
+  std::lock_guard<std::mutex> lock(positionTimer_.mutex());
+  pipeline_ = std::move(pipeline);
+  playbin_ = pipeline_->playbin;
+  panorama_ = pipeline_->panorama;
+  bus_ = pipeline_->bus;
+  media_state_ = GST_STATE_VOID_PENDING;
 
-  bus_ = gst_element_get_bus(playbin_);
+  g_object_set(G_OBJECT(playbin_), "volume", volume_, NULL);
+  if (panorama_) {
+    g_object_set(G_OBJECT(panorama_), "panorama", balance_, NULL);
+  }
+  aboutToFinishId_ =
+      g_signal_connect(playbin_, "about-to-finish",
+                       G_CALLBACK(AudioPlayer::OnAboutToFinish), this);
 
-  // Watch bus messages for one time events
+  // Watch bus messages for one time events.  Messages a prepared pipeline
+  // posted while prerolling are delivered now.
   gst_bus_add_watch(bus_, (GstBusFunc)AudioPlayer::OnBusMessage, this);
 }
 
-AudioPlayer::~AudioPlayer() {
-  gst_element_set_state(playbin_, GST_STATE_NULL);
+void AudioPlayer::DetachPipeline() {
+  std::lock_guard<std::mutex> lock(positionTimer_.mutex());
+  gst_bus_remove_watch(bus_);
+  g_signal_handler_disconnect(playbin_, aboutToFinishId_);
+  aboutToFinishId_ = 0;
+  playbin_ = nullptr;
+  panorama_ = nullptr;
+  bus_ = nullptr;
+  pipelinePool_->Release(std::move(pipeline_));
 }
 
-void AudioPlayer::SourceSetup(GstElement* /* playbin */,
-                              GstElement* source,
-                              GstElement** /* p_src */) {
-  // Allow sources from unencrypted / misconfigured connections
-  if (g_object_class_find_property(G_OBJECT_GET_CLASS(source), "ssl-strict") !=
-      nullptr) {
-    g_object_set(G_OBJECT(source), "ssl-strict", FALSE, NULL);
+void AudioPlayer::SetSourceUrl(const std::string& url) {
+  bool changed;
+  {
+    std::lock_guard<std::mutex> lock(nextMutex_);
+    changed = url_ != url;
+    if (changed) {
+      url_ = url;
+      nextUrl_.clear();
+      switchedUrl_.clear();
+    }
   }
-}
 
-void AudioPlayer::SetSourceUrl(const std::string& url) {
-  if (url_ != url) {
-    url_ = url;
-    // clear source
-    gst_element_set_state(playbin_, GST_STATE_NULL);
+  if (lowLatency_) {
+    if (!changed) {
+      if (voice_) {
+        OnPrepared(true);
+      }
+      return;
+    }
+    ReleaseVoice();
     isInitialized_ = false;
     isPlaying_ = false;
-    if (!url_.empty()) {
-      g_object_set(GST_OBJECT(playbin_), "uri", url_.c_str(), NULL);
+    UpdatePositionTimer();
+    if (!url.empty()) {
+      soundPool_->Load(
+          url, this, [this, url](std::shared_ptr<const SoundPool::Clip> clip) {
+            OnClipLoaded(url, std::move(clip));
+          });
+    }
+    return;
+  }
+
+  if (changed) {
+    isInitialized_ = false;
+    isPlaying_ = false;
+    UpdatePositionTimer();
+    sourceSetAt_ = g_get_monotonic_time();
+    // Swap in the pipeline prerolled by SetNextSourceUrl.
+    if (!url.empty()) {
+      if (auto prepared = pipelinePool_->TakePrepared(url)) {
+        DetachPipeline();
+        AttachPipeline(std::move(prepared));
+        return;
+      }
+    }
+    // clear source
+    gst_element_set_state(playbin_, GST_STATE_NULL);
+    if (!url.empty()) {
+      g_object_set(GST_OBJECT(playbin_), "uri", url.c_str(), NULL);
       if (playbin_ && (playbin_->current_state != GST_STATE_READY)) {
         GstStateChangeReturn ret =
             gst_element_set_state(playbin_, GST_STATE_READY);
@@ -91,12 +137,138 @@ void AudioPlayer::SetSourceUrl(const std::string& url) {
   }
 }
 
+void AudioPlayer::SetNextSourceUrl(const std::string& url) {
+  if (lowLatency_) {
+    // Decode ahead, the clip is then taken from the cache.
+    if (!url.empty()) {
+      soundPool_->Load(
+          url, this, [](std::shared_ptr<const SoundPool::Clip> /* clip */) {});
+    }
+    return;
+  }
+  bool current;
+  {
+    std::lock_guard<std::mutex> lock(nextMutex_);
+    nextUrl_ = url;
+    current = url == url_;
+  }
+  if (!url.empty() && !current) {
+    pipelinePool_->Prepare(url);
+  }
+}
+
+void AudioPlayer::OnAboutToFinish(GstElement* playbin, AudioPlayer* data) {
+  // Streaming thread: setting the uri here makes playbin continue with the
+  // next source without draining the sink.
+  std::lock_guard<std::mutex> lock(data->nextMutex_);
+  if (data->nextUrl_.empty() || data->isLooping_) {
+    return;
+  }
+  g_object_set(G_OBJECT(playbin), "uri", data->nextUrl_.c_str(), NULL);
+  data->switchedUrl_ = std::move(data->nextUrl_);
+  data->nextUrl_.clear();
+}
+
+void AudioPlayer::OnStreamStart() {
+  std::string url;
+  {
+    std::lock_guard<std::mutex> lock(nextMutex_);
+    url = std::move(switchedUrl_);
+    switchedUrl_.clear();
+    if (!url.empty()) {
+      url_ = url;
+    }
+  }
+  if (url.empty()) {
+    return;
+  }
+  // No EOS is posted for the source that ended, playlists advance on this.
+  OnComplete();
+  // Played from this pipeline, the prerolled copy is not needed.
+  pipelinePool_->Discard(url);
+  OnLog((std::string("Gapless transition to ") + url).c_str());
+  OnDurationUpdate();
+}
+
+std::string AudioPlayer::GetUrl() {
+  std::lock_guard<std::mutex> lock(nextMutex_);
+  return url_;
+}
+
+void AudioPlayer::SetPlayerMode(const std::string& playerMode) {
+  const bool lowLatency = playerMode == "PlayerMode.lowLatency";
+  if (lowLatency == lowLatency_ || !soundPool_) {
+    return;
+  }
+  // Reload the current source in the new mode.
+  const std::string url = GetUrl();
+  ReleaseMediaSource();
+  lowLatency_ = lowLatency;
+  if (!url.empty()) {
+    SetSourceUrl(url);
+  }
+}
+
+void AudioPlayer::OnClipLoaded(const std::string& url,
+                               std::shared_ptr<const SoundPool::Clip> clip) {
+  if (url != GetUrl()) {
+    return;
+  }
+  if (!clip) {
+    flutter::EncodableValue details("Decoding the clip failed.");
+    OnError("LinuxAudioError",
+            "Failed to set source. For troubleshooting, "
+            "see: " STR_LINK_TROUBLESHOOTING,
+            &details, nullptr);
+    return;
+  }
+
+  clip_ = std::move(clip);
+  voice_ = soundPool_->AddVoice(clip_, this, [this] { OnPlaybackEnded(); });
+  if (!voice_) {
+    OnError("LinuxAudioError", "Low latency output is not available.",
+            nullptr, nullptr);
+    return;
+  }
+  soundPool_->SetParams(voice_, voiceParams_);
+  isInitialized_ = true;
+  OnPrepared(true);
+  OnDurationUpdate();
+  if (isPlaying_) {
+    Resume();
+  }
+}
+
+void AudioPlayer::ReleaseVoice() {
+  if (!soundPool_) {
+    return;
+  }
+  // No load or completion callback may run after this.
+  soundPool_->Cancel(this);
+  if (voice_) {
+    soundPool_->RemoveVoice(voice_);
+    voice_ = 0;
+  }
+  clip_.reset();
+}
+
 void AudioPlayer::ReleaseMediaSource() {
   if (isPlaying_)
     isPlaying_ = false;
   if (isInitialized_)
     isInitialized_ = false;
-  url_.clear();
+  {
+    std::lock_guard<std::mutex> lock(nextMutex_);
+    url_.clear();
+    nextUrl_.clear();
+    switchedUrl_.clear();
+  }
+  UpdatePositionTimer();
+
+  if (lowLatency_) {
+    ReleaseVoice();
+    return;
+  }
 
   GstState playbinState;
   gst_element_get_state(playbin_, &playbinState, nullptr, GST_CLOCK_TIME_NONE);
@@ -138,6 +310,11 @@ gboolean AudioPlayer::OnBusMessage(GstBus* /* bus */,
         }
       }
       break;
+    case GST_MESSAGE_STREAM_START:
+      if (GST_MESSAGE_SRC(message) == GST_OBJECT(data->playbin_)) {
+        data->OnStreamStart();
+      }
+      break;
     case GST_MESSAGE_DURATION_CHANGED:
       data->OnDurationUpdate();
       break;
@@ -220,6 +397,7 @@ void AudioPlayer::OnMediaStateChange(GstObject* src,
       }
       if (isInitialized_) {
         isInitialized_ = false;
+        UpdatePositionTimer();
       }
     } else if (*old_state == GST_STATE_PAUSED &&
                *new_state == GST_STATE_PLAYING) {
@@ -227,6 +405,8 @@ void AudioPlayer::OnMediaStateChange(GstObject* src,
     } else if (*new_state >= GST_STATE_PAUSED) {
       if (!isInitialized_) {
         isInitialized_ = true;
+        SPDLOG_DEBUG("{} prepared in {} ms", GetUrl(),
+                     (g_get_monotonic_time() - sourceSetAt_) / 1000);
         OnPrepared(true);
         if (isPlaying_) {
           Resume();
@@ -234,12 +414,13 @@ void AudioPlayer::OnMediaStateChange(GstObject* src,
       }
     } else if (isInitialized_) {
       isInitialized_ = false;
+      UpdatePositionTimer();
     }
   }
 }
 
 void AudioPlayer::OnPrepared(bool isPrepared) {
-  if (media_state_ != GST_STATE_PLAYING) {
+  if (!lowLatency_ && media_state_ != GST_STATE_PLAYING) {
     Resume();
   }
   flutter::EncodableValue value(flutter::EncodableMap{
@@ -261,6 +442,8 @@ void AudioPlayer::OnDurationUpdate() {
 }
 
 void AudioPlayer::OnSeekCompleted() {
+  // Report the new position with the next tick even if it did not change.
+  lastPosition_ = -1;
   EncodableValue value(flutter::EncodableMap{
       {flutter::EncodableValue("event"),
        flutter::EncodableValue("audio.onSeekComplete")},
@@ -270,12 +453,7 @@ void AudioPlayer::OnSeekCompleted() {
 }
 
 void AudioPlayer::OnPlaybackEnded() {
-  flutter::EncodableValue value(flutter::EncodableMap{
-      {flutter::EncodableValue("event"),
-       flutter::EncodableValue("audio.onComplete")},
-      {flutter::EncodableValue("value"), flutter::EncodableValue(true)},
-  });
-  Send(value);
+  OnComplete();
 
   if (GetLooping()) {
     Play();
@@ -284,6 +462,15 @@ void AudioPlayer::OnPlaybackEnded() {
   }
 }
 
+void AudioPlayer::OnComplete() {
+  flutter::EncodableValue value(flutter::EncodableMap{
+      {flutter::EncodableValue("event"),
+       flutter::EncodableValue("audio.onComplete")},
+      {flutter::EncodableValue("value"), flutter::EncodableValue(true)},
+  });
+  Send(value);
+}
+
 void AudioPlayer::OnLog(const gchar* message) {
   EncodableValue value(flutter::EncodableMap{
       {flutter::EncodableValue("event"),
@@ -295,21 +482,34 @@ void AudioPlayer::OnLog(const gchar* message) {
 }
 
 void AudioPlayer::SetBalance(float balance) {
-  if (!panorama_) {
-    OnLog("Audiopanorama was not initialized");
-    return;
-  }
-
   if (balance > 1.0f) {
     balance = 1.0f;
   } else if (balance < -1.0f) {
     balance = -1.0f;
   }
+
+  if (lowLatency_) {
+    voiceParams_.balance = balance;
+    if (voice_) {
+      soundPool_->SetParams(voice_, voiceParams_);
+    }
+    return;
+  }
+
+  balance_ = balance;
+  if (!panorama_) {
+    OnLog("Audiopanorama was not initialized");
+    return;
+  }
   g_object_set(G_OBJECT(panorama_), "panorama", balance, NULL);
 }
 
 void AudioPlayer::SetLooping(bool isLooping) {
   isLooping_ = isLooping;
+  voiceParams_.looping = isLooping;
+  if (voice_) {
+    soundPool_->SetParams(voice_, voiceParams_);
+  }
 }
 
 bool AudioPlayer::GetLooping() const {
@@ -322,6 +522,14 @@ void AudioPlayer::SetVolume(double volume) {
   } else if (volume < 0) {
     volume = 0;
   }
+  if (lowLatency_) {
+    voiceParams_.volume = volume;
+    if (voice_) {
+      soundPool_->SetParams(voice_, voiceParams_);
+    }
+    return;
+  }
+  volume_ = volume;
   g_object_set(G_OBJECT(playbin_), "volume", volume, NULL);
 }
 
@@ -377,6 +585,22 @@ void AudioPlayer::SetPlayback(int64_t position, double rate) {
 }
 
 void AudioPlayer::SetPlaybackRate(double rate) {
+  if (lowLatency_) {
+    if (rate == 0) {
+      Pause();
+      return;
+    }
+    if (rate < 0) {
+      OnLog("Backwards playback is not supported in low latency mode.");
+      return;
+    }
+    playbackRate_ = rate;
+    voiceParams_.rate = rate;
+    if (voice_) {
+      soundPool_->SetParams(voice_, voiceParams_);
+    }
+    return;
+  }
   SetPlayback(GetPosition().value_or(0), rate);
 }
 
@@ -387,6 +611,12 @@ void AudioPlayer::SetPosition(int64_t position) {
   if (!isInitialized_) {
     return;
   }
+  if (lowLatency_) {
+    // Takes effect with the next mixed period, there is no flush to wait for.
+    soundPool_->Seek(voice_, position);
+    OnSeekCompleted();
+    return;
+  }
   SetPlayback(position, playbackRate_);
 }
 
@@ -394,6 +624,12 @@ void AudioPlayer::SetPosition(int64_t position) {
  * @return int64_t the position in milliseconds
  */
 std::optional<int64_t> AudioPlayer::GetPosition() {
+  if (lowLatency_) {
+    if (!voice_) {
+      return std::nullopt;
+    }
+    return std::make_optional(soundPool_->GetPosition(voice_));
+  }
   gint64 current = 0;
   if (!gst_element_query_position(playbin_, GST_FORMAT_TIME, &current)) {
     OnLog("Could not query current position.");
@@ -406,16 +642,131 @@ std::optional<int64_t> AudioPlayer::GetPosition() {
  * @return int64_t the duration in milliseconds
  */
 std::optional<int64_t> AudioPlayer::GetDuration() {
+  if (lowLatency_) {
+    if (!clip_) {
+      return std::nullopt;
+    }
+    return std::make_optional(clip_->duration_ms());
+  }
   gint64 duration = 0;
   if (!gst_element_query_duration(playbin_, GST_FORMAT_TIME, &duration)) {
-    // FIXME: Get duration for MP3 with variable bit rate with gst-discoverer:
-    // https://gstreamer.freedesktop.org/documentation/pbutils/gstdiscoverer.html?gi-language=c#gst_discoverer_info_get_duration
+    // E.g. MP3 with variable bit rate, ask the discoverer once per source.
+    if (discoveredUrl_ == GetUrl() && discoveredDuration_.has_value()) {
+      return discoveredDuration_;
+    }
+    DiscoverDuration();
     OnLog("Could not query current duration.");
     return std::nullopt;
   }
   return std::make_optional(duration / 1000000);
 }
 
+void AudioPlayer::SetPositionUpdateInterval(guint intervalMs) {
+  positionInterval_ = intervalMs;
+  // Restart with the new interval.
+  positionTimer_.Stop();
+  UpdatePositionTimer();
+}
+
+void AudioPlayer::UpdatePositionTimer() {
+  const bool run = isPlaying_ && isInitialized_ && positionInterval_ > 0;
+  if (run == positionTimer_.running()) {
+    return;
+  }
+  if (!run) {
+    positionTimer_.Stop();
+    // Final position where playback paused.
+    if (isInitialized_) {
+      OnPositionUpdate();
+    }
+    return;
+  }
+  lastPosition_ = -1;
+  positionTimer_.Start(positionInterval_, [this] { OnPositionUpdate(); });
+}
+
+void AudioPlayer::OnPositionUpdate() {
+  int64_t position;
+  if (lowLatency_) {
+    if (!voice_) {
+      return;
+    }
+    position = soundPool_->GetPosition(voice_);
+  } else {
+    // Not GetPosition(), a failing query is not worth a log event per tick.
+    gint64 current = 0;
+    if (!playbin_ ||
+        !gst_element_query_position(playbin_, GST_FORMAT_TIME, &current)) {
+      return;
+    }
+    position = current / 1000000;
+  }
+  if (position == lastPosition_) {
+    return;
+  }
+  lastPosition_ = position;
+  flutter::EncodableValue value(flutter::EncodableMap{
+      {flutter::EncodableValue("event"),
+       flutter::EncodableValue("audio.onCurrentPosition")},
+      {flutter::EncodableValue("value"), flutter::EncodableValue(position)},
+  });
+  Send(value);
+}
+
+void AudioPlayer::DiscoverDuration() {
+  const std::string url = GetUrl();
+  if (url.empty() || discoveredUrl_ == url) {
+    return;
+  }
+  if (!discoverer_) {
+    GError* error = nullptr;
+    discoverer_ = gst_discoverer_new(kDiscoverTimeout, &error);
+    if (!discoverer_) {
+      OnLog((std::string("Could not create discoverer: ") +
+             (error ? error->message : ""))
+                .c_str());
+      g_clear_error(&error);
+      return;
+    }
+    g_signal_connect(discoverer_, "discovered",
+                     G_CALLBACK(AudioPlayer::OnDiscovered), this);
+    // Results are delivered on the main context, like bus messages.
+    gst_discoverer_start(discoverer_);
+  }
+  discoveredUrl_ = url;
+  discoveredDuration_.reset();
+  gst_discoverer_discover_uri_async(discoverer_, url.c_str());
+}
+
+void AudioPlayer::StopDiscoverer() {
+  if (discoverer_) {
+    gst_discoverer_stop(discoverer_);
+    g_signal_handlers_disconnect_by_data(discoverer_, this);
+    g_object_unref(discoverer_);
+    discoverer_ = nullptr;
+  }
+  discoveredUrl_.clear();
+  discoveredDuration_.reset();
+}
+
+void AudioPlayer::OnDiscovered(GstDiscoverer* /* discoverer */,
+                               GstDiscovererInfo* info,
+                               GError* /* error */,
+                               AudioPlayer* data) {
+  const gchar* uri = gst_discoverer_info_get_uri(info);
+  if (!uri || data->discoveredUrl_ != uri) {
+    return;
+  }
+  const GstClockTime duration = gst_discoverer_info_get_duration(info);
+  if (gst_discoverer_info_get_result(info) != GST_DISCOVERER_OK ||
+      !GST_CLOCK_TIME_IS_VALID(duration)) {
+    data->OnLog("Could not discover duration.");
+    return;
+  }
+  data->discoveredDuration_ = static_cast<int64_t>(duration / GST_MSECOND);
+  data->OnDurationUpdate();
+}
+
 void AudioPlayer::Play() {
   SetPosition(0);
   Resume();
@@ -425,9 +776,14 @@ void AudioPlayer::Pause() {
   if (isPlaying_) {
     isPlaying_ = false;
   }
+  UpdatePositionTimer();
   if (!isInitialized_) {
     return;
   }
+  if (lowLatency_) {
+    soundPool_->SetPlaying(voice_, false);
+    return;
+  }
   GstStateChangeReturn ret = gst_element_set_state(playbin_, GST_STATE_PAUSED);
   if (ret == GST_STATE_CHANGE_SUCCESS) {
   } else if (ret == GST_STATE_CHANGE_FAILURE) {
@@ -442,6 +798,9 @@ void AudioPlayer::Stop() {
     return;
   }
   SetPosition(0);
+  if (lowLatency_) {
+    return;
+  }
   // Block thread to wait for state, as it is not expected to be waited to
   // "seek complete" event on the dart side.
   GstStateChangeReturn ret =
@@ -459,6 +818,11 @@ void AudioPlayer::Resume() {
   if (!isInitialized_) {
     return;
   }
+  UpdatePositionTimer();
+  if (lowLatency_) {
+    soundPool_->SetPlaying(voice_, true);
+    return;
+  }
   GstStateChangeReturn ret = gst_element_set_state(playbin_, GST_STATE_PLAYING);
   if (ret == GST_STATE_CHANGE_SUCCESS) {
     // Update duration when start playing, as no event is emitted elsewhere
@@ -474,29 +838,9 @@ void AudioPlayer::Dispose() {
     throw std::runtime_error("Player was already disposed (Dispose)");
 
   ReleaseMediaSource();
+  positionTimer_.Stop();
+  StopDiscoverer();
 
-  if (bus_) {
-    gst_bus_remove_watch(bus_);
-    gst_object_unref(GST_OBJECT(bus_));
-    bus_ = nullptr;
-  }
-
-  if (source_) {
-    gst_object_unref(GST_OBJECT(source_));
-    source_ = nullptr;
-  }
-
-  if (panorama_) {
-    gst_element_set_state(audiobin_, GST_STATE_NULL);
-
-    gst_element_remove_pad(audiobin_, panoramaSinkPad_);
-    gst_bin_remove(GST_BIN(audiobin_), audiosink_);
-    gst_bin_remove(GST_BIN(audiobin_), panorama_);
-
-    // audiobin gets unreferenced (2x) via playbin
-    panorama_ = nullptr;
-  }
-
-  gst_object_unref(GST_OBJECT(playbin_));
-  playbin_ = nullptr;
+  // The pipeline goes back to the pool for the next player.
+  DetachPipeline();
 }
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <string>
@@ -15,13 +17,25 @@
 
 extern "C" {
 #include <gst/gst.h>
+#include <gst/pbutils/pbutils.h>
 }
 
+#include "pipeline_pool.h"
+#include "position_timer.h"
+#include "sound_pool.h"
+
 using namespace flutter;
 
 class AudioPlayer : public flutter::BasicMessageChannel<> {
  public:
-  AudioPlayer(const std::string& playerId, BinaryMessenger* messenger);
+  // Interval of audio.onCurrentPosition events while playing
+  static constexpr guint kDefaultPositionInterval = 200;
+  static constexpr GstClockTime kDiscoverTimeout = 5 * GST_SECOND;
+
+  AudioPlayer(const std::string& playerId,
+              BinaryMessenger* messenger,
+              PipelinePool* pipelinePool,
+              SoundPool* soundPool);
 
   ~AudioPlayer();
 
@@ -51,8 +65,19 @@ class AudioPlayer : public flutter::BasicMessageChannel<> {
 
   void SetPosition(int64_t position);
 
+  // 0 stops audio.onCurrentPosition events.
+  void SetPositionUpdateInterval(guint intervalMs);
+
   void SetSourceUrl(const std::string& url);
 
+  // Source played gapless after the current one ends.  It is prerolled right
+  // away, so switching to it with SetSourceUrl starts without delay as well.
+  void SetNextSourceUrl(const std::string& url);
+
+  // "PlayerMode.lowLatency" plays the source from the shared SoundPool,
+  // anything else from this player's playbin.
+  void SetPlayerMode(const std::string& playerMode);
+
   void ReleaseMediaSource();
 
   void OnError(const gchar* code,
@@ -64,29 +89,76 @@ class AudioPlayer : public flutter::BasicMessageChannel<> {
 
  private:
   const std::string eventChannelName_;
-  GMainContext* context_;
   GstState media_state_;
 
-  // Gst members
+  // Gst members, owned by pipeline_
+  PipelinePool* pipelinePool_;
+  std::unique_ptr<PipelinePool::Pipeline> pipeline_;
   GstElement* playbin_{};
-  GstElement* source_{};
   GstElement* panorama_{};
-  GstElement* audiobin_{};
-  GstElement* audiosink_{};
-  GstPad* panoramaSinkPad_{};
   GstBus* bus_{};
+  gulong aboutToFinishId_{};
 
   bool isInitialized_{};
   bool isPlaying_{};
-  bool isLooping_{};
+  // Also read by about-to-finish on the streaming thread
+  std::atomic<bool> isLooping_{};
+  double volume_ = 1.0;
+  float balance_ = 0.0f;
+  // Start of the last source change, for the prepare time
+  gint64 sourceSetAt_{};
+
+  // Position events, sent from the calling context while playing.  Its
+  // mutex keeps ticks out while the pipeline is swapped.
+  PositionTimer positionTimer_;
+  guint positionInterval_ = kDefaultPositionInterval;
+  int64_t lastPosition_ = -1;
+
+  // Duration of streams that do not answer the duration query
+  GstDiscoverer* discoverer_{};
+  std::string discoveredUrl_;
+  std::optional<int64_t> discoveredDuration_;
+
+  // Gapless playback, guarded by nextMutex_
+  std::mutex nextMutex_;
+  std::string nextUrl_;
+  // Set when about-to-finish switched to nextUrl_, until its stream starts
+  std::string switchedUrl_;
+  // Also set on the main context by a gapless transition
+  std::string url_;
   bool isSeekCompleted_ = true;
   double playbackRate_ = 1.0;
 
-  std::string url_;
+  // Low latency mode
+  SoundPool* soundPool_;
+  bool lowLatency_{};
+  std::shared_ptr<const SoundPool::Clip> clip_;
+  SoundPool::VoiceId voice_{};
+  SoundPool::VoiceParams voiceParams_;
+
+  void AttachPipeline(std::unique_ptr<PipelinePool::Pipeline> pipeline);
+
+  void DetachPipeline();
+
+  static void OnAboutToFinish(GstElement* playbin, AudioPlayer* data);
 
-  static void SourceSetup(GstElement* playbin,
-                          GstElement* source,
-                          GstElement** p_src);
+  void OnStreamStart();
+
+  // url_ with nextMutex_ held.
+  std::string GetUrl();
+
+  void UpdatePositionTimer();
+
+  void OnPositionUpdate();
+
+  void DiscoverDuration();
+
+  void StopDiscoverer();
+
+  static void OnDiscovered(GstDiscoverer* discoverer,
+                           GstDiscovererInfo* info,
+                           GError* error,
+                           AudioPlayer* data);
 
   static gboolean OnBusMessage(GstBus* bus,
                                GstMessage* message,
@@ -94,6 +166,11 @@ class AudioPlayer : public flutter::BasicMessageChannel<> {
 
   void SetPlayback(int64_t seekTo, double rate);
 
+  void OnClipLoaded(const std::string& url,
+                    std::shared_ptr<const SoundPool::Clip> clip);
+
+  void ReleaseVoice();
+
   void OnMediaError(GError* error, gchar* debug);
 
   void OnMediaStateChange(GstObject* src,
@@ -106,5 +183,7 @@ class AudioPlayer : public flutter::BasicMessageChannel<> {
 
   void OnPlaybackEnded();
 
+  void OnComplete();
+
   void OnPrepared(bool isPrepared);
 };
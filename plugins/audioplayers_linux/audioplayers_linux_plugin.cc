@@ -53,9 +53,17 @@ AudioplayersLinuxPlugin::AudioplayersLinuxPlugin(
 
   // start the main loop if not already running
   plugin_common_glib::MainLoop::GetInstance();
+
+  pipelinePool_ = std::make_unique<PipelinePool>();
+  soundPool_ = std::make_unique<SoundPool>();
 }
 
-AudioplayersLinuxPlugin::~AudioplayersLinuxPlugin() = default;
+AudioplayersLinuxPlugin::~AudioplayersLinuxPlugin() {
+  // Players hold pipelines and voices of the pools.
+  audioPlayers_.clear();
+  soundPool_.reset();
+  pipelinePool_.reset();
+}
 
 AudioPlayer* AudioplayersLinuxPlugin::GetPlayer(const std::string& playerId) {
   auto searchPlayer = audioPlayers_.find(playerId);
@@ -71,8 +79,9 @@ void AudioplayersLinuxPlugin::Create(
   auto searchPlayer = audioPlayers_.find(player_id);
   if (searchPlayer == audioPlayers_.end()) {
     std::string event_channel = "xyz.luan/audioplayers/events/" + player_id;
-    auto player =
-        std::make_unique<AudioPlayer>(std::move(event_channel), messenger_);
+    auto player = std::make_unique<AudioPlayer>(
+        std::move(event_channel), messenger_, pipelinePool_.get(),
+        soundPool_.get());
     audioPlayers_.insert(std::make_pair(player_id, std::move(player)));
   }
   result(std::nullopt);
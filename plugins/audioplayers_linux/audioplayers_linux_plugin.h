@@ -22,6 +22,8 @@
 
 #include "audio_player.h"
 #include "messages.h"
+#include "pipeline_pool.h"
+#include "sound_pool.h"
 
 namespace audioplayers_linux_plugin {
 
@@ -123,6 +125,10 @@ class AudioplayersLinuxPlugin final : public flutter::Plugin,
 
  private:
   flutter::BinaryMessenger* messenger_;
+  // Playbins handed out to and returned by players
+  std::unique_ptr<PipelinePool> pipelinePool_;
+  // Shared output of all players in low latency mode
+  std::unique_ptr<SoundPool> soundPool_;
 };
 
 }  // namespace audioplayers_linux_plugin
@@ -25,6 +25,7 @@
 #include <flutter/method_channel.h>
 #include <flutter/standard_method_codec.h>
 
+#include <algorithm>
 #include <optional>
 #include <string>
 
@@ -141,6 +142,26 @@ void AudioPlayersApi::SetUp(flutter::BinaryMessenger* binary_messenger,
               url = std::string("file://") + url;
             }
             player->SetSourceUrl(url);
+          } else if (method_name == "setNextSourceUrl") {
+            // Linux only: gapless follow-up source, a null URL clears it.
+            EncodableValue valueUrl;
+            EncodableValue valueIsLocal;
+            for (auto& it : *args) {
+              if ("url" == std::get<std::string>(it.first)) {
+                valueUrl = it.second;
+              } else if ("isLocal" == std::get<std::string>(it.first))
+                valueIsLocal = it.second;
+            }
+
+            std::string url = valueUrl.IsNull()
+                                   ? std::string()
+                                   : std::get<std::string>(valueUrl);
+            bool isLocal =
+                !valueIsLocal.IsNull() && std::get<bool>(valueIsLocal);
+            if (isLocal && !url.empty()) {
+              url = std::string("file://") + url;
+            }
+            player->SetNextSourceUrl(url);
           } else if (method_name == "getDuration") {
             auto optDuration = player->GetDuration();
             result->Success(optDuration.has_value()
@@ -164,6 +185,22 @@ void AudioPlayersApi::SetUp(flutter::BinaryMessenger* binary_messenger,
                                 ? EncodableValue(optPosition.value())
                                 : EncodableValue());
             return;
+          } else if (method_name == "setPositionUpdateInterval") {
+            // Linux only: interval of audio.onCurrentPosition in ms, 0 stops
+            // the events.
+            EncodableValue valueInterval;
+            for (auto& it : *args) {
+              if ("interval" == std::get<std::string>(it.first)) {
+                valueInterval = it.second;
+                break;
+              }
+            }
+            guint interval = AudioPlayer::kDefaultPositionInterval;
+            if (!valueInterval.IsNull()) {
+              interval = static_cast<guint>(
+                  std::max(std::get<int32_t>(valueInterval), 0));
+            }
+            player->SetPositionUpdateInterval(interval);
           } else if (method_name == "setPlaybackRate") {
             EncodableValue valuePlaybackRate;
             for (auto& it : *args) {
@@ -198,8 +235,18 @@ void AudioPlayersApi::SetUp(flutter::BinaryMessenger* binary_messenger,
             auto looping = releaseMode.find("loop") != std::string::npos;
             player->SetLooping(looping);
           } else if (method_name == "setPlayerMode") {
-            // TODO check support for low latency mode:
-            // https://gstreamer.freedesktop.org/documentation/additional/design/latency.html?gi-language=c
+            EncodableValue valuePlayerMode;
+            for (auto& it : *args) {
+              if ("playerMode" == std::get<std::string>(it.first)) {
+                valuePlayerMode = it.second;
+                break;
+              }
+            }
+            std::string playerMode =
+                valuePlayerMode.IsNull()
+                    ? std::string()
+                    : std::get<std::string>(valuePlayerMode);
+            player->SetPlayerMode(playerMode);
           } else if (method_name == "setBalance") {
             EncodableValue valueBalance;
             for (auto& it : *args) {
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pipeline_pool.h"
+
+#include <cstdlib>
+
+#include "plugins/common/common.h"
+
+PipelinePool::Pipeline::~Pipeline() {
+  if (playbin) {
+    gst_element_set_state(playbin, GST_STATE_NULL);
+    gst_object_unref(bus);
+    gst_object_unref(playbin);
+  }
+}
+
+PipelinePool::~PipelinePool() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  SPDLOG_DEBUG("pipeline pool: {} created, {} reused, {} prepared hits",
+               created_, reused_, prepared_hits_);
+  prepared_.clear();
+  idle_.clear();
+}
+
+std::unique_ptr<PipelinePool::Pipeline> PipelinePool::Create() {
+  auto pipeline = std::make_unique<Pipeline>();
+  pipeline->playbin = gst_element_factory_make("playbin", nullptr);
+  if (!pipeline->playbin) {
+    return nullptr;
+  }
+
+  // Setup stereo balance controller
+  GstElement* audiosink = CreateSink();
+  pipeline->panorama = gst_element_factory_make("audiopanorama", nullptr);
+  if (pipeline->panorama && !audiosink) {
+    gst_object_unref(gst_object_ref_sink(pipeline->panorama));
+    pipeline->panorama = nullptr;
+  }
+  if (pipeline->panorama) {
+    GstElement* audiobin = gst_bin_new(nullptr);
+
+    gst_bin_add_many(GST_BIN(audiobin), pipeline->panorama, audiosink, nullptr);
+    gst_element_link(pipeline->panorama, audiosink);
+
+    GstPad* sinkpad = gst_element_get_static_pad(pipeline->panorama, "sink");
+    gst_element_add_pad(audiobin, gst_ghost_pad_new("sink", sinkpad));
+    gst_object_unref(GST_OBJECT(sinkpad));
+
+    g_object_set(G_OBJECT(pipeline->playbin), "audio-sink", audiobin, nullptr);
+    g_object_set(G_OBJECT(pipeline->panorama), "method", 1, nullptr);
+  } else if (audiosink) {
+    g_object_set(G_OBJECT(pipeline->playbin), "audio-sink", audiosink, nullptr);
+  }
+
+  // Setup source options
+  g_signal_connect(pipeline->playbin, "source-setup",
+                   G_CALLBACK(PipelinePool::SourceSetup), nullptr);
+
+  pipeline->bus = gst_element_get_bus(pipeline->playbin);
+  return pipeline;
+}
+
+GstElement* PipelinePool::CreateSink() {
+  const char* description = getenv(kSinkEnvironmentVariable);
+  if (!description) {
+    return gst_element_factory_make("autoaudiosink", nullptr);
+  }
+  GError* error = nullptr;
+  GstElement* sink = gst_parse_bin_from_description(description, TRUE, &error);
+  if (!sink) {
+    spdlog::error("Failed to create sink {}: {}", description,
+                  error ? error->message : "unknown");
+    g_clear_error(&error);
+  }
+  return sink;
+}
+
+void PipelinePool::SourceSetup(GstElement* /* playbin */,
+                               GstElement* source,
+                               gpointer /* user_data */) {
+  // Allow sources from unencrypted / misconfigured connections
+  if (g_object_class_find_property(G_OBJECT_GET_CLASS(source), "ssl-strict") !=
+      nullptr) {
+    g_object_set(G_OBJECT(source), "ssl-strict", FALSE, NULL);
+  }
+}
+
+void PipelinePool::Reset(Pipeline* pipeline) {
+  gst_element_set_state(pipeline->playbin, GST_STATE_NULL);
+  // Drop messages of the previous user.
+  gst_bus_set_flushing(pipeline->bus, TRUE);
+  gst_bus_set_flushing(pipeline->bus, FALSE);
+  g_object_set(G_OBJECT(pipeline->playbin), "volume", 1.0, nullptr);
+  if (pipeline->panorama) {
+    g_object_set(G_OBJECT(pipeline->panorama), "panorama", 0.0f, nullptr);
+  }
+  pipeline->uri.clear();
+}
+
+std::unique_ptr<PipelinePool::Pipeline> PipelinePool::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!idle_.empty()) {
+      auto pipeline = std::move(idle_.front());
+      idle_.pop_front();
+      reused_++;
+      return pipeline;
+    }
+    created_++;
+  }
+  return Create();
+}
+
+std::unique_ptr<PipelinePool::Pipeline> PipelinePool::TakePrepared(
+    const std::string& uri) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = prepared_.begin(); it != prepared_.end(); ++it) {
+    if ((*it)->uri == uri) {
+      auto pipeline = std::move(*it);
+      prepared_.erase(it);
+      prepared_hits_++;
+      return pipeline;
+    }
+  }
+  return nullptr;
+}
+
+void PipelinePool::Release(std::unique_ptr<Pipeline> pipeline) {
+  if (!pipeline) {
+    return;
+  }
+  Reset(pipeline.get());
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (idle_.size() < kMaxIdle) {
+    idle_.push_back(std::move(pipeline));
+  }
+}
+
+void PipelinePool::Prepare(const std::string& uri) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& pipeline : prepared_) {
+      if (pipeline->uri == uri) {
+        return;
+      }
+    }
+  }
+
+  auto pipeline = Acquire();
+  if (!pipeline) {
+    return;
+  }
+  pipeline->uri = uri;
+  g_object_set(GST_OBJECT(pipeline->playbin), "uri", uri.c_str(), nullptr);
+  if (gst_element_set_state(pipeline->playbin, GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_FAILURE) {
+    spdlog::error("Failed to prepare {}", uri);
+    Release(std::move(pipeline));
+    return;
+  }
+
+  std::unique_ptr<Pipeline> evicted;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    prepared_.push_front(std::move(pipeline));
+    if (prepared_.size() > kMaxPrepared) {
+      evicted = std::move(prepared_.back());
+      prepared_.pop_back();
+    }
+  }
+  Release(std::move(evicted));
+}
+
+void PipelinePool::Discard(const std::string& uri) {
+  std::unique_ptr<Pipeline> discarded;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = prepared_.begin(); it != prepared_.end(); ++it) {
+      if ((*it)->uri == uri) {
+        discarded = std::move(*it);
+        prepared_.erase(it);
+        break;
+      }
+    }
+  }
+  Release(std::move(discarded));
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+extern "C" {
+#include <gst/gst.h>
+}
+
+/**
+ * Playbins shared by the players of the plugin.
+ *
+ * A pipeline is playbin with an audiopanorama ! autoaudiosink bin.  Players
+ * take one on creation and hand it back on dispose; returned pipelines are
+ * reset to NULL and kept idle for the next player, so playlists that create
+ * and dispose players do not rebuild elements each time.
+ *
+ * Prepare() prerolls a URI in a spare pipeline.  A player setting that URI as
+ * source swaps its own pipeline for the prepared one and starts without
+ * waiting for the source to open and the decoders to preroll.
+ */
+class PipelinePool {
+ public:
+  static constexpr size_t kMaxIdle = 4;
+  // A prepared pipeline holds the audio device while PAUSED.
+  static constexpr size_t kMaxPrepared = 2;
+  // gst-launch style description replacing autoaudiosink, e.g. for
+  // "fakesink sync=true"
+  static constexpr char kSinkEnvironmentVariable[] = "AUDIOPLAYERS_SINK";
+
+  struct Pipeline {
+    GstElement* playbin{};
+    // nullptr when audiopanorama is not available
+    GstElement* panorama{};
+    GstBus* bus{};
+    // URI prerolled by Prepare()
+    std::string uri;
+
+    ~Pipeline();
+  };
+
+  PipelinePool() = default;
+  ~PipelinePool();
+
+  // Prevent copying.
+  PipelinePool(PipelinePool const&) = delete;
+  PipelinePool& operator=(PipelinePool const&) = delete;
+
+  /**
+   * @brief Take an idle pipeline, or build one
+   * @return std::unique_ptr<Pipeline>
+   * @retval nullptr Elements could not be created
+   * @relation
+   * gstreamer
+   */
+  std::unique_ptr<Pipeline> Acquire();
+
+  /**
+   * @brief Take the pipeline prepared for a URI
+   * @param[in] uri URI passed to Prepare()
+   * @return std::unique_ptr<Pipeline>
+   * @retval nullptr The URI was not prepared
+   * @relation
+   * gstreamer
+   */
+  std::unique_ptr<Pipeline> TakePrepared(const std::string& uri);
+
+  /**
+   * @brief Reset a pipeline to NULL and keep it for reuse.  The bus must no
+   * longer be watched.
+   * @param[in] pipeline Pipeline from Acquire() or TakePrepared()
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void Release(std::unique_ptr<Pipeline> pipeline);
+
+  /**
+   * @brief Preroll a URI in a spare pipeline, replacing the least recently
+   * prepared one when all slots are in use
+   * @param[in] uri URI to prepare
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void Prepare(const std::string& uri);
+
+  // Drop the prepared pipeline of a URI, if any.
+  void Discard(const std::string& uri);
+
+ private:
+  std::mutex mutex_;
+  std::list<std::unique_ptr<Pipeline>> idle_;
+  // Most recently prepared first
+  std::list<std::unique_ptr<Pipeline>> prepared_;
+
+  uint64_t created_ = 0;
+  uint64_t reused_ = 0;
+  uint64_t prepared_hits_ = 0;
+
+  static std::unique_ptr<Pipeline> Create();
+
+  // autoaudiosink, or the sink described by kSinkEnvironmentVariable.
+  static GstElement* CreateSink();
+
+  static void Reset(Pipeline* pipeline);
+
+  static void SourceSetup(GstElement* playbin,
+                          GstElement* source,
+                          gpointer user_data);
+};
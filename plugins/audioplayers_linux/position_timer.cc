@@ -0,0 +1,53 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "position_timer.h"
+
+PositionTimer::PositionTimer(GMainContext* context) : context_(context) {}
+
+PositionTimer::~PositionTimer() {
+  Stop();
+}
+
+void PositionTimer::Start(guint interval_ms, std::function<void()> tick) {
+  Stop();
+  std::lock_guard<std::mutex> lock(*mutex_);
+  source_ = g_timeout_source_new(interval_ms);
+  g_source_set_callback(
+      source_, OnTick, new TickData{mutex_, std::move(tick)},
+      [](gpointer data) { delete static_cast<TickData*>(data); });
+  g_source_attach(source_, context_);
+}
+
+void PositionTimer::Stop() {
+  std::lock_guard<std::mutex> lock(*mutex_);
+  if (source_) {
+    g_source_destroy(source_);
+    g_source_unref(source_);
+    source_ = nullptr;
+  }
+}
+
+gboolean PositionTimer::OnTick(gpointer user_data) {
+  auto data = static_cast<TickData*>(user_data);
+  std::lock_guard<std::mutex> lock(*data->mutex);
+  // Destroyed with the lock held, the owner is alive until then.
+  if (g_source_is_destroyed(g_main_current_source())) {
+    return G_SOURCE_REMOVE;
+  }
+  data->tick();
+  return G_SOURCE_CONTINUE;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+extern "C" {
+#include <glib.h>
+}
+
+/**
+ * Periodic tick on a GLib main context, for position events.
+ *
+ * g_source_destroy does not wait for a tick already dispatched, and the
+ * source may be dispatched once more after its owner is gone.  Ticks
+ * therefore run with a mutex held that is shared with the source: Stop()
+ * destroys the source with it held, so no tick runs once Stop() returns,
+ * and a late dispatch finds the source destroyed without touching the
+ * owner.
+ */
+class PositionTimer {
+ public:
+  /**
+   * @brief Create a stopped timer
+   * @param[in] context Context the ticks run on, nullptr for the default
+   * @relation
+   * glib
+   */
+  explicit PositionTimer(GMainContext* context);
+  ~PositionTimer();
+
+  // Prevent copying.
+  PositionTimer(PositionTimer const&) = delete;
+  PositionTimer& operator=(PositionTimer const&) = delete;
+
+  /**
+   * @brief Start ticking, replacing a running timer
+   * @param[in] interval_ms Interval of the ticks
+   * @param[in] tick Invoked on the context with mutex() held
+   * @return void
+   * @relation
+   * glib
+   */
+  void Start(guint interval_ms, std::function<void()> tick);
+
+  /**
+   * @brief Stop ticking.  Waits for a tick running on another thread, none
+   * runs after this returns.  Must not be called from a tick.
+   * @return void
+   * @relation
+   * glib
+   */
+  void Stop();
+
+  bool running() const { return source_ != nullptr; }
+
+  // Held while a tick runs; the owner takes it to change state ticks read.
+  std::mutex& mutex() { return *mutex_; }
+
+ private:
+  struct TickData {
+    std::shared_ptr<std::mutex> mutex;
+    std::function<void()> tick;
+  };
+
+  GMainContext* context_;
+  std::shared_ptr<std::mutex> mutex_ = std::make_shared<std::mutex>();
+  GSource* source_{};
+
+  static gboolean OnTick(gpointer user_data);
+};
@@ -0,0 +1,495 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sound_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+}
+
+#include "plugins/common/common.h"
+
+namespace {
+
+constexpr gint kPlayFlagAudio = 1 << 1;
+// Without a sample for this long the source is considered stalled.
+constexpr gint64 kDecodeTimeoutUs = 10 * G_USEC_PER_SEC;
+constexpr char kPcmCaps[] =
+    "audio/x-raw, format=(string)F32LE, layout=(string)interleaved, "
+    "rate=(int)48000, channels=(int)2";
+
+}  // namespace
+
+SoundPool::SoundPool()
+    : dispatch_mutex_(std::make_shared<std::mutex>()),
+      mix_(kPeriodFrames * kChannels) {
+  decode_thread_ = std::thread(&SoundPool::DecodeLoop, this);
+}
+
+SoundPool::~SoundPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+  }
+  decode_cv_.notify_one();
+  decode_thread_.join();
+
+  if (pipeline_) {
+    gst_element_set_state(pipeline_, GST_STATE_NULL);
+    gst_object_unref(pipeline_);
+    pipeline_ = nullptr;
+  }
+
+  // A Dispatch running a callback sees the source destroyed once it takes
+  // the lock again and leaves the pool alone.
+  std::lock_guard<std::mutex> dispatch_lock(*dispatch_mutex_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (dispatch_source_) {
+    g_source_destroy(dispatch_source_);
+    g_source_unref(dispatch_source_);
+    dispatch_source_ = nullptr;
+  }
+  notifications_.clear();
+  SPDLOG_DEBUG("sound pool: {} clips cached ({} bytes), {} voices max",
+               cache_.size(), cache_bytes_, max_voices_);
+}
+
+void SoundPool::Load(const std::string& uri,
+                     const void* owner,
+                     LoadCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = cache_.find(uri);
+  if (it != cache_.end()) {
+    lru_.remove(uri);
+    lru_.push_front(uri);
+    auto clip = it->second;
+    Post(owner, [callback = std::move(callback), clip] { callback(clip); });
+    return;
+  }
+
+  auto& requests = pending_[uri];
+  requests.push_back({owner, std::move(callback)});
+  if (requests.size() == 1) {
+    decode_queue_.push_back(uri);
+    decode_cv_.notify_one();
+  }
+}
+
+void SoundPool::DecodeLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    decode_cv_.wait(lock, [this] { return exit_ || !decode_queue_.empty(); });
+    if (exit_) {
+      break;
+    }
+    const std::string uri = decode_queue_.front();
+    decode_queue_.pop_front();
+
+    lock.unlock();
+    auto clip = Decode(uri);
+    lock.lock();
+
+    if (clip) {
+      Insert(clip);
+    }
+    auto it = pending_.find(uri);
+    if (it == pending_.end()) {
+      continue;
+    }
+    for (auto& request : it->second) {
+      Post(request.owner,
+           [callback = std::move(request.callback), clip] { callback(clip); });
+    }
+    pending_.erase(it);
+  }
+}
+
+std::shared_ptr<const SoundPool::Clip> SoundPool::Decode(
+    const std::string& uri) {
+  GstElement* playbin = gst_element_factory_make("playbin", nullptr);
+  GstElement* convert = gst_element_factory_make("audioconvert", nullptr);
+  GstElement* resample = gst_element_factory_make("audioresample", nullptr);
+  GstElement* sink = gst_element_factory_make("appsink", nullptr);
+  if (!playbin || !convert || !resample || !sink) {
+    spdlog::error("Failed to create decoder for {}", uri);
+    for (GstElement* element : {playbin, convert, resample, sink}) {
+      if (element) {
+        gst_object_unref(gst_object_ref_sink(element));
+      }
+    }
+    return nullptr;
+  }
+
+  GstElement* bin = gst_bin_new(nullptr);
+  gst_bin_add_many(GST_BIN(bin), convert, resample, sink, nullptr);
+  gst_element_link(convert, resample);
+  GstCaps* caps = gst_caps_from_string(kPcmCaps);
+  gst_element_link_filtered(resample, sink, caps);
+  gst_caps_unref(caps);
+  GstPad* pad = gst_element_get_static_pad(convert, "sink");
+  gst_element_add_pad(bin, gst_ghost_pad_new("sink", pad));
+  gst_object_unref(pad);
+
+  // Decode as fast as possible, audio only.
+  g_object_set(sink, "sync", FALSE, nullptr);
+  g_object_set(playbin, "uri", uri.c_str(), "audio-sink", bin, "flags",
+               kPlayFlagAudio, nullptr);
+
+  auto clip = std::make_shared<Clip>();
+  clip->uri = uri;
+  bool failed = gst_element_set_state(playbin, GST_STATE_PLAYING) ==
+                GST_STATE_CHANGE_FAILURE;
+  GstBus* bus = gst_element_get_bus(playbin);
+  gint64 deadline = g_get_monotonic_time() + kDecodeTimeoutUs;
+  const size_t max_samples = static_cast<size_t>(
+      GST_TIME_AS_SECONDS(kMaxClipDuration) * kSampleRate * kChannels);
+  while (!failed) {
+    GstSample* sample =
+        gst_app_sink_try_pull_sample(GST_APP_SINK(sink), 100 * GST_MSECOND);
+    if (sample) {
+      GstBuffer* buffer = gst_sample_get_buffer(sample);
+      GstMapInfo map;
+      if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        const auto data = reinterpret_cast<const float*>(map.data);
+        clip->samples.insert(clip->samples.end(), data,
+                             data + map.size / sizeof(float));
+        gst_buffer_unmap(buffer, &map);
+      }
+      gst_sample_unref(sample);
+      deadline = g_get_monotonic_time() + kDecodeTimeoutUs;
+      if (clip->samples.size() > max_samples) {
+        spdlog::error("{} is too long for low latency mode", uri);
+        failed = true;
+      }
+      continue;
+    }
+    if (gst_app_sink_is_eos(GST_APP_SINK(sink))) {
+      break;
+    }
+    if (GstMessage* msg = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR)) {
+      GError* err;
+      gst_message_parse_error(msg, &err, nullptr);
+      spdlog::error("Failed to decode {}: {}", uri, err->message);
+      g_clear_error(&err);
+      gst_message_unref(msg);
+      failed = true;
+    } else if (g_get_monotonic_time() > deadline) {
+      spdlog::error("Timed out decoding {}", uri);
+      failed = true;
+    }
+  }
+
+  gst_element_set_state(playbin, GST_STATE_NULL);
+  gst_object_unref(bus);
+  gst_object_unref(playbin);
+  if (failed || clip->samples.empty()) {
+    return nullptr;
+  }
+  clip->samples.shrink_to_fit();
+  SPDLOG_DEBUG("decoded {}: {} ms", uri, clip->duration_ms());
+  return clip;
+}
+
+void SoundPool::Insert(const std::shared_ptr<const Clip>& clip) {
+  cache_[clip->uri] = clip;
+  lru_.remove(clip->uri);
+  lru_.push_front(clip->uri);
+  cache_bytes_ += clip->samples.size() * sizeof(float);
+
+  // Voices keep their clip alive, eviction only drops the cache reference.
+  while (cache_bytes_ > kMaxCacheBytes && lru_.size() > 1) {
+    auto it = cache_.find(lru_.back());
+    cache_bytes_ -= it->second->samples.size() * sizeof(float);
+    cache_.erase(it);
+    lru_.pop_back();
+  }
+}
+
+void SoundPool::Post(const void* owner, std::function<void()> callback) {
+  notifications_.push_back({owner, std::move(callback)});
+  if (!dispatch_source_) {
+    dispatch_source_ = g_idle_source_new();
+    g_source_set_priority(dispatch_source_, G_PRIORITY_DEFAULT);
+    g_source_set_callback(
+        dispatch_source_, Dispatch, new DispatchData{dispatch_mutex_, this},
+        [](gpointer data) { delete static_cast<DispatchData*>(data); });
+    g_source_attach(dispatch_source_, nullptr);
+  }
+}
+
+gboolean SoundPool::Dispatch(gpointer user_data) {
+  auto data = static_cast<DispatchData*>(user_data);
+  GSource* source = g_main_current_source();
+  std::unique_lock<std::mutex> dispatch_lock(*data->mutex);
+  // Destroyed with the lock held, the pool is alive until then.
+  if (g_source_is_destroyed(source)) {
+    return G_SOURCE_REMOVE;
+  }
+  auto obj = data->pool;
+  std::unique_lock<std::mutex> lock(obj->mutex_);
+  // Notifications posted meanwhile are taken by this loop, the source stays
+  // attached until it ends.
+  while (!obj->notifications_.empty()) {
+    auto callback = std::move(obj->notifications_.front().callback);
+    obj->dispatch_owner_ = obj->notifications_.front().owner;
+    obj->dispatch_thread_ = std::this_thread::get_id();
+    obj->notifications_.pop_front();
+
+    // Callbacks may call back into the pool, Cancel included.
+    lock.unlock();
+    dispatch_lock.unlock();
+    callback();
+    callback = nullptr;
+    dispatch_lock.lock();
+    if (g_source_is_destroyed(source)) {
+      return G_SOURCE_REMOVE;
+    }
+    lock.lock();
+
+    obj->dispatch_owner_ = nullptr;
+    obj->dispatch_cv_.notify_all();
+  }
+  g_source_unref(obj->dispatch_source_);
+  obj->dispatch_source_ = nullptr;
+  return G_SOURCE_REMOVE;
+}
+
+void SoundPool::Cancel(const void* owner) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  notifications_.remove_if(
+      [owner](const Notification& n) { return n.owner == owner; });
+  for (auto& [uri, requests] : pending_) {
+    requests.remove_if(
+        [owner](const PendingLoad& load) { return load.owner == owner; });
+  }
+  // Wait for a callback of the owner running on another thread.  Called
+  // from that callback, it is already running.
+  dispatch_cv_.wait(lock, [this, owner] {
+    return dispatch_owner_ != owner ||
+           dispatch_thread_ == std::this_thread::get_id();
+  });
+}
+
+SoundPool::VoiceId SoundPool::AddVoice(std::shared_ptr<const Clip> clip,
+                                       const void* owner,
+                                       std::function<void()> on_complete) {
+  if (!EnsureOutput()) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  const VoiceId id = next_voice_++;
+  Voice voice;
+  voice.clip = std::move(clip);
+  voice.owner = owner;
+  voice.on_complete = std::move(on_complete);
+  voices_.emplace(id, std::move(voice));
+  max_voices_ = std::max(max_voices_, voices_.size());
+  return id;
+}
+
+void SoundPool::RemoveVoice(VoiceId voice) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  voices_.erase(voice);
+}
+
+void SoundPool::SetPlaying(VoiceId voice, bool playing) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = voices_.find(voice);
+  if (it != voices_.end()) {
+    it->second.playing = playing;
+  }
+}
+
+void SoundPool::SetParams(VoiceId voice, const VoiceParams& params) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = voices_.find(voice);
+  if (it != voices_.end()) {
+    it->second.params = params;
+  }
+}
+
+void SoundPool::Seek(VoiceId voice, int64_t position_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = voices_.find(voice);
+  if (it == voices_.end()) {
+    return;
+  }
+  const double frame =
+      static_cast<double>(std::max<int64_t>(position_ms, 0)) * kSampleRate /
+      1000;
+  it->second.position =
+      std::min(frame, static_cast<double>(it->second.clip->frames()));
+}
+
+int64_t SoundPool::GetPosition(VoiceId voice) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = voices_.find(voice);
+  if (it == voices_.end()) {
+    return 0;
+  }
+  return static_cast<int64_t>(it->second.position * 1000 / kSampleRate);
+}
+
+bool SoundPool::EnsureOutput() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pipeline_) {
+    return true;
+  }
+
+  const char* sink_description = getenv(kSinkEnvironmentVariable);
+  GError* error = nullptr;
+  GstElement* sink = gst_parse_bin_from_description(
+      sink_description ? sink_description : "autoaudiosink", TRUE, &error);
+  if (!sink) {
+    spdlog::error("Failed to create low latency sink: {}",
+                  error ? error->message : "unknown");
+    g_clear_error(&error);
+    return false;
+  }
+
+  GstElement* appsrc = gst_element_factory_make("appsrc", nullptr);
+  GstElement* convert = gst_element_factory_make("audioconvert", nullptr);
+  GstElement* resample = gst_element_factory_make("audioresample", nullptr);
+  if (!appsrc || !convert || !resample) {
+    spdlog::error("Failed to create low latency output elements");
+    for (GstElement* element : {appsrc, convert, resample, sink}) {
+      if (element) {
+        gst_object_unref(gst_object_ref_sink(element));
+      }
+    }
+    return false;
+  }
+
+  pipeline_ = gst_pipeline_new("sound-pool");
+  appsrc_ = appsrc;
+  gst_bin_add_many(GST_BIN(pipeline_), appsrc_, convert, resample, sink,
+                   nullptr);
+  gst_element_link_many(appsrc_, convert, resample, sink, nullptr);
+
+  // One period queued in front of the sink keeps a new voice close to the
+  // output.  need-data fires as soon as it was taken.
+  GstCaps* caps = gst_caps_from_string(kPcmCaps);
+  g_object_set(appsrc_, "caps", caps, "format", GST_FORMAT_TIME, "max-bytes",
+               static_cast<guint64>(kPeriodFrames * kChannels * sizeof(float)),
+               "block", FALSE, nullptr);
+  gst_caps_unref(caps);
+  g_signal_connect(appsrc_, "need-data", G_CALLBACK(OnNeedData), this);
+  g_signal_connect(pipeline_, "deep-element-added",
+                   G_CALLBACK(OnDeepElementAdded), this);
+
+  if (gst_element_set_state(pipeline_, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    spdlog::error("Failed to start low latency output");
+    gst_object_unref(pipeline_);
+    pipeline_ = nullptr;
+    appsrc_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void SoundPool::OnDeepElementAdded(GstBin* /* bin */,
+                                   GstBin* /* sub_bin */,
+                                   GstElement* element,
+                                   gpointer /* user_data */) {
+  // autoaudiosink picks the real sink at runtime, shrink its ring buffer.
+  GObjectClass* klass = G_OBJECT_GET_CLASS(element);
+  if (g_object_class_find_property(klass, "buffer-time") &&
+      g_object_class_find_property(klass, "latency-time")) {
+    g_object_set(element, "buffer-time", kSinkBufferTimeUs, "latency-time",
+                 kSinkLatencyTimeUs, nullptr);
+  }
+}
+
+void SoundPool::OnNeedData(GstElement* appsrc,
+                           guint /* length */,
+                           gpointer user_data) {
+  auto obj = static_cast<SoundPool*>(user_data);
+  const gsize size = kPeriodFrames * kChannels * sizeof(float);
+  GstBuffer* buffer = gst_buffer_new_allocate(nullptr, size, nullptr);
+  {
+    std::lock_guard<std::mutex> lock(obj->mutex_);
+    obj->Mix();
+    gst_buffer_fill(buffer, 0, obj->mix_.data(), size);
+  }
+
+  GST_BUFFER_PTS(buffer) = gst_util_uint64_scale_int(
+      obj->frames_pushed_, GST_SECOND, kSampleRate);
+  GST_BUFFER_DURATION(buffer) =
+      gst_util_uint64_scale_int(kPeriodFrames, GST_SECOND, kSampleRate);
+  obj->frames_pushed_ += kPeriodFrames;
+  gst_app_src_push_buffer(GST_APP_SRC(appsrc), buffer);
+}
+
+void SoundPool::Mix() {
+  std::fill(mix_.begin(), mix_.end(), 0.0f);
+
+  for (auto& [id, voice] : voices_) {
+    if (!voice.playing) {
+      continue;
+    }
+    const float* samples = voice.clip->samples.data();
+    const auto frames = static_cast<double>(voice.clip->frames());
+    const auto& params = voice.params;
+    // Balance as audiopanorama's simple method: attenuate the far side.
+    const auto volume = static_cast<float>(params.volume);
+    const auto balance = static_cast<float>(params.balance);
+    const float left = volume * (balance > 0 ? 1 - balance : 1.0f);
+    const float right = volume * (balance < 0 ? 1 + balance : 1.0f);
+    const double rate = params.rate > 0 ? params.rate : 1.0;
+
+    bool ended = false;
+    for (guint i = 0; i < kPeriodFrames; i++) {
+      if (voice.position >= frames) {
+        if (!params.looping) {
+          ended = true;
+          break;
+        }
+        voice.position -= frames;
+      }
+      const auto index = static_cast<size_t>(voice.position);
+      const auto* frame = &samples[index * kChannels];
+      float l = frame[0];
+      float r = frame[1];
+      if (rate != 1.0 && index + 1 < voice.clip->frames()) {
+        // Linear interpolation between neighbouring frames.
+        const auto t = static_cast<float>(voice.position - index);
+        l += (frame[kChannels] - l) * t;
+        r += (frame[kChannels + 1] - r) * t;
+      }
+      mix_[i * kChannels] += l * left;
+      mix_[i * kChannels + 1] += r * right;
+      voice.position += rate;
+    }
+
+    if (ended) {
+      voice.playing = false;
+      voice.position = 0;
+      if (voice.on_complete) {
+        Post(voice.owner, voice.on_complete);
+      }
+    }
+  }
+
+  for (auto& sample : mix_) {
+    sample = std::clamp(sample, -1.0f, 1.0f);
+  }
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <gst/gst.h>
+}
+
+/**
+ * Low latency playback of short clips.
+ *
+ * Clips are decoded once into interleaved float PCM and cached by URI.  All
+ * voices are mixed into a single appsrc fed output pipeline that stays
+ * PLAYING while voices exist, so starting a sound only adds it to the mix:
+ * there is no state change and the number of sinks does not grow with the
+ * number of voices.  Start-to-sound latency is bounded by one queued period
+ * plus the sink buffer.
+ *
+ * Load results and voice completion are delivered on the GLib main context,
+ * like bus messages of the playbin based players.
+ */
+class SoundPool {
+ public:
+  static constexpr gint kSampleRate = 48000;
+  static constexpr gint kChannels = 2;
+  // Frames mixed per buffer, 2.7 ms
+  static constexpr guint kPeriodFrames = 128;
+  // Sink ring buffer, in microseconds
+  static constexpr gint64 kSinkBufferTimeUs = 8000;
+  static constexpr gint64 kSinkLatencyTimeUs = 2000;
+  // Longer clips belong in a playbin based player
+  static constexpr GstClockTime kMaxClipDuration = 30 * GST_SECOND;
+  static constexpr size_t kMaxCacheBytes = 64 * 1024 * 1024;
+  // gst-launch style description replacing autoaudiosink, e.g. for
+  // "fakesink sync=true" or "filesink location=/tmp/mix.raw"
+  static constexpr char kSinkEnvironmentVariable[] =
+      "AUDIOPLAYERS_LOW_LATENCY_SINK";
+
+  struct Clip {
+    std::string uri;
+    // Interleaved stereo at kSampleRate
+    std::vector<float> samples;
+
+    size_t frames() const { return samples.size() / kChannels; }
+    int64_t duration_ms() const {
+      return static_cast<int64_t>(frames()) * 1000 / kSampleRate;
+    }
+  };
+
+  struct VoiceParams {
+    double volume = 1.0;
+    // -1.0 left to 1.0 right
+    double balance = 0.0;
+    // Positive playback rate, 1.0 is normal speed
+    double rate = 1.0;
+    bool looping = false;
+  };
+
+  using VoiceId = uint64_t;
+  using LoadCallback = std::function<void(std::shared_ptr<const Clip> clip)>;
+
+  SoundPool();
+  ~SoundPool();
+
+  // Prevent copying.
+  SoundPool(SoundPool const&) = delete;
+  SoundPool& operator=(SoundPool const&) = delete;
+
+  /**
+   * @brief Decode a clip, or take it from the cache
+   * @param[in] uri URI of the clip
+   * @param[in] owner Key for Cancel
+   * @param[in] callback Invoked on the main context, nullptr if decoding
+   * failed
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void Load(const std::string& uri, const void* owner, LoadCallback callback);
+
+  /**
+   * @brief Add a paused voice at the start of a clip
+   * @param[in] clip Decoded clip
+   * @param[in] owner Key for Cancel
+   * @param[in] on_complete Invoked on the main context when a voice that is
+   * not looping reaches the end; it is then paused at the start
+   * @return VoiceId
+   * @relation
+   * gstreamer
+   */
+  VoiceId AddVoice(std::shared_ptr<const Clip> clip,
+                   const void* owner,
+                   std::function<void()> on_complete);
+
+  void RemoveVoice(VoiceId voice);
+
+  /**
+   * @brief Start or pause a voice.  A started voice is heard from the next
+   * mixed period.
+   * @param[in] voice Voice id
+   * @param[in] playing Mix the voice
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void SetPlaying(VoiceId voice, bool playing);
+
+  void SetParams(VoiceId voice, const VoiceParams& params);
+
+  void Seek(VoiceId voice, int64_t position_ms);
+
+  int64_t GetPosition(VoiceId voice);
+
+  /**
+   * @brief Drop pending loads and notifications of an owner.  When this
+   * returns none of its callbacks is running or will be invoked.
+   * @param[in] owner Key passed to Load and AddVoice
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void Cancel(const void* owner);
+
+ private:
+  struct Voice {
+    std::shared_ptr<const Clip> clip;
+    const void* owner;
+    std::function<void()> on_complete;
+    VoiceParams params;
+    // Fractional frame position, advanced by params.rate
+    double position = 0.0;
+    bool playing = false;
+  };
+
+  struct PendingLoad {
+    const void* owner;
+    LoadCallback callback;
+  };
+
+  struct Notification {
+    const void* owner;
+    std::function<void()> callback;
+  };
+
+  struct DispatchData {
+    std::shared_ptr<std::mutex> mutex;
+    SoundPool* pool;
+  };
+
+  // Held by Dispatch while it uses the pool, outlives the pool for a
+  // dispatch in flight.  Taken before mutex_.
+  std::shared_ptr<std::mutex> dispatch_mutex_;
+
+  // Guards everything below.
+  std::mutex mutex_;
+
+  std::map<VoiceId, Voice> voices_;
+  VoiceId next_voice_ = 1;
+
+  std::map<std::string, std::shared_ptr<const Clip>> cache_;
+  // URIs, most recently used first
+  std::list<std::string> lru_;
+  size_t cache_bytes_ = 0;
+
+  std::map<std::string, std::list<PendingLoad>> pending_;
+  std::deque<std::string> decode_queue_;
+  std::condition_variable decode_cv_;
+  bool exit_ = false;
+
+  std::list<Notification> notifications_;
+  // Attached to the default main context until the queued notifications
+  // have run
+  GSource* dispatch_source_{};
+  // Owner of the notification running on dispatch_thread_, if any.  Its
+  // callback runs without any lock held.
+  const void* dispatch_owner_{};
+  std::thread::id dispatch_thread_;
+  std::condition_variable dispatch_cv_;
+
+  GstElement* pipeline_{};
+  GstElement* appsrc_{};
+  guint64 frames_pushed_ = 0;
+  // Mix accumulator, streaming thread only
+  std::vector<float> mix_;
+  size_t max_voices_ = 0;
+
+  std::thread decode_thread_;
+
+  void DecodeLoop();
+
+  /**
+   * @brief Decode a URI to PCM, blocking
+   * @param[in] uri URI of the clip
+   * @return std::shared_ptr<const Clip>
+   * @retval nullptr Decoding failed or the clip is too long
+   * @relation
+   * gstreamer
+   */
+  static std::shared_ptr<const Clip> Decode(const std::string& uri);
+
+  // mutex_ must be held.
+  void Insert(const std::shared_ptr<const Clip>& clip);
+
+  // mutex_ must be held.
+  void Post(const void* owner, std::function<void()> callback);
+
+  static gboolean Dispatch(gpointer user_data);
+
+  bool EnsureOutput();
+
+  static void OnNeedData(GstElement* appsrc, guint length, gpointer user_data);
+
+  static void OnDeepElementAdded(GstBin* bin,
+                                 GstBin* sub_bin,
+                                 GstElement* element,
+                                 gpointer user_data);
+
+  // Mix one period of all playing voices into mix_, mutex_ must be held.
+  void Mix();
+};
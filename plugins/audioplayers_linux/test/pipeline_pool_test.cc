@@ -0,0 +1,316 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "pipeline_pool.h"
+#include "plugins/common/testing/testing.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr size_t kTracks = 50;
+constexpr char kSinkName[] = "pipeline-pool-test-sink";
+
+/**
+ * Audio rendered by the sink, by wall clock.  A gap is the time between the
+ * end of a buffer and the start of the next one, across tracks and
+ * pipelines.
+ */
+class Recorder {
+ public:
+  void Attach(PipelinePool::Pipeline* pipeline) {
+    sink_ = gst_bin_get_by_name(GST_BIN(pipeline->playbin), kSinkName);
+    EXPECT(sink_);
+    if (sink_) {
+      handoff_id_ =
+          g_signal_connect(sink_, "handoff", G_CALLBACK(OnHandoff), this);
+    }
+  }
+
+  void Detach() {
+    if (sink_) {
+      g_signal_handler_disconnect(sink_, handoff_id_);
+      gst_object_unref(sink_);
+      sink_ = nullptr;
+    }
+  }
+
+  // Average gap between tracks
+  double Report(const char* name, size_t tracks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double gaps_ms =
+        static_cast<double>(end_us_ - first_us_ - media_us_) / 1000;
+    const double average_ms = gaps_ms / static_cast<double>(tracks - 1);
+    printf("%s: %.0f ms of audio, gaps: average %.2f ms, max %.2f ms\n", name,
+           static_cast<double>(media_us_) / 1000, average_ms, max_gap_ms_);
+    return average_ms;
+  }
+
+  gint64 media_us() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return media_us_;
+  }
+
+ private:
+  std::mutex mutex_;
+  GstElement* sink_{};
+  gulong handoff_id_{};
+  gint64 first_us_ = 0;
+  // Wall clock at which the last buffer rendered ends
+  gint64 end_us_ = 0;
+  gint64 media_us_ = 0;
+  double max_gap_ms_ = 0;
+
+  static void OnHandoff(GstElement* /* sink */,
+                        GstBuffer* buffer,
+                        GstPad* /* pad */,
+                        gpointer user_data) {
+    auto obj = static_cast<Recorder*>(user_data);
+    const gint64 now = g_get_monotonic_time();
+    const auto duration =
+        GST_BUFFER_DURATION_IS_VALID(buffer)
+            ? static_cast<gint64>(
+                  GST_TIME_AS_USECONDS(GST_BUFFER_DURATION(buffer)))
+            : 0;
+    std::lock_guard<std::mutex> lock(obj->mutex_);
+    if (obj->end_us_) {
+      obj->max_gap_ms_ = std::max(
+          obj->max_gap_ms_, static_cast<double>(now - obj->end_us_) / 1000);
+    } else {
+      obj->first_us_ = now;
+    }
+    obj->end_us_ = now + duration;
+    obj->media_us_ += duration;
+  }
+};
+
+// Encodes 100 ms of a sine to Ogg Vorbis, false without the encoders.
+bool WriteClip(const fs::path& path) {
+  gchar* description = g_strdup_printf(
+      "audiotestsrc num-buffers=1 samplesperbuffer=4800 ! "
+      "audio/x-raw,rate=48000,channels=2 ! vorbisenc ! oggmux ! "
+      "filesink location=\"%s\"",
+      path.c_str());
+  GError* error = nullptr;
+  GstElement* pipeline = gst_parse_launch(description, &error);
+  g_free(description);
+  if (error) {
+    fprintf(stderr, "%s\n", error->message);
+    g_clear_error(&error);
+    if (pipeline) {
+      gst_object_unref(pipeline);
+    }
+    return false;
+  }
+
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  GstBus* bus = gst_element_get_bus(pipeline);
+  GstMessage* msg = gst_bus_timed_pop_filtered(
+      bus, GST_CLOCK_TIME_NONE,
+      static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  const bool written = GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+  gst_message_unref(msg);
+  gst_object_unref(bus);
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(pipeline);
+  return written;
+}
+
+std::string FileUri(const fs::path& path) {
+  gchar* uri = g_filename_to_uri(path.c_str(), nullptr, nullptr);
+  std::string result = uri ? uri : "";
+  g_free(uri);
+  return result;
+}
+
+// Pops messages of a pipeline up to one of the type, false on an error or
+// after 10 s.
+bool WaitFor(PipelinePool::Pipeline* pipeline, GstMessageType type) {
+  GstMessage* msg = gst_bus_timed_pop_filtered(
+      pipeline->bus, 10 * GST_SECOND,
+      static_cast<GstMessageType>(type | GST_MESSAGE_ERROR));
+  if (!msg) {
+    return false;
+  }
+  const bool error = GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR;
+  if (error) {
+    GError* err;
+    gst_message_parse_error(msg, &err, nullptr);
+    fprintf(stderr, "%s\n", err->message);
+    g_clear_error(&err);
+  }
+  gst_message_unref(msg);
+  return !error;
+}
+
+bool WaitPrerolled(PipelinePool::Pipeline* pipeline) {
+  return gst_element_get_state(pipeline->playbin, nullptr, nullptr,
+                               10 * GST_SECOND) == GST_STATE_CHANGE_SUCCESS;
+}
+
+void Finalized(gpointer data, GObject* /* object */) {
+  (*static_cast<size_t*>(data))++;
+}
+
+// Pipelines are reused first in, first out, reset, and capped.
+void TestIdle() {
+  size_t finalized = 0;
+  PipelinePool pool;
+  std::vector<std::unique_ptr<PipelinePool::Pipeline>> pipelines;
+  std::vector<GstElement*> playbins;
+  for (size_t i = 0; i < PipelinePool::kMaxIdle + 1; i++) {
+    pipelines.push_back(pool.Acquire());
+    EXPECT(pipelines.back());
+    playbins.push_back(pipelines.back()->playbin);
+    g_object_weak_ref(G_OBJECT(playbins.back()), Finalized, &finalized);
+  }
+  g_object_set(G_OBJECT(playbins[0]), "volume", 0.5, nullptr);
+  pipelines[0]->uri = "file:///a.ogg";
+  for (auto& pipeline : pipelines) {
+    pool.Release(std::move(pipeline));
+  }
+  EXPECT(finalized == 1);
+
+  auto pipeline = pool.Acquire();
+  EXPECT(pipeline && pipeline->playbin == playbins[0]);
+  EXPECT(pipeline && pipeline->uri.empty());
+  gdouble volume = 0;
+  g_object_get(G_OBJECT(playbins[0]), "volume", &volume, nullptr);
+  EXPECT(volume == 1.0);
+  pool.Release(std::move(pipeline));
+
+  EXPECT(!pool.TakePrepared("file:///a.ogg"));
+}
+
+// Next source set on about-to-finish, as AudioPlayer does.
+struct Playlist {
+  const std::vector<std::string>& uris;
+  std::atomic<size_t> next;
+};
+
+void OnAboutToFinish(GstElement* playbin, gpointer user_data) {
+  auto playlist = static_cast<Playlist*>(user_data);
+  const size_t next = playlist->next++;
+  if (next < playlist->uris.size()) {
+    g_object_set(G_OBJECT(playbin), "uri", playlist->uris[next].c_str(),
+                 nullptr);
+  }
+}
+
+// Plays all tracks in one pipeline.
+void BenchmarkGapless(PipelinePool& pool,
+                      const std::vector<std::string>& uris) {
+  Recorder recorder;
+  Playlist playlist{uris, 1};
+  auto pipeline = pool.Acquire();
+  const gulong id = g_signal_connect(pipeline->playbin, "about-to-finish",
+                                     G_CALLBACK(OnAboutToFinish), &playlist);
+  g_object_set(G_OBJECT(pipeline->playbin), "uri", uris[0].c_str(), nullptr);
+  gst_element_set_state(pipeline->playbin, GST_STATE_PAUSED);
+  EXPECT(WaitPrerolled(pipeline.get()));
+  recorder.Attach(pipeline.get());
+  gst_element_set_state(pipeline->playbin, GST_STATE_PLAYING);
+  EXPECT(WaitFor(pipeline.get(), GST_MESSAGE_EOS));
+  recorder.Detach();
+  g_signal_handler_disconnect(pipeline->playbin, id);
+  pool.Release(std::move(pipeline));
+
+  EXPECT(playlist.next == uris.size() + 1);
+  // Each clip decodes to about 100 ms
+  EXPECT(recorder.media_us() > 90000 * static_cast<gint64>(uris.size()));
+  EXPECT(recorder.Report("gapless", uris.size()) < 5);
+}
+
+// Plays each track in its own pipeline, as setSourceUrl after the previous
+// one completed.  With prepare, the next track is prerolled meanwhile as
+// setNextSourceUrl does.
+void BenchmarkSwap(PipelinePool& pool,
+                   const std::vector<std::string>& uris,
+                   bool prepare) {
+  Recorder recorder;
+  for (size_t i = 0; i < uris.size(); i++) {
+    std::unique_ptr<PipelinePool::Pipeline> pipeline;
+    if (prepare) {
+      pipeline = pool.TakePrepared(uris[i]);
+      EXPECT(pipeline || i == 0);
+    }
+    if (!pipeline) {
+      pipeline = pool.Acquire();
+      g_object_set(G_OBJECT(pipeline->playbin), "uri", uris[i].c_str(),
+                   nullptr);
+      gst_element_set_state(pipeline->playbin, GST_STATE_PAUSED);
+    }
+    EXPECT(WaitPrerolled(pipeline.get()));
+    recorder.Attach(pipeline.get());
+    gst_element_set_state(pipeline->playbin, GST_STATE_PLAYING);
+    if (prepare && i + 1 < uris.size()) {
+      pool.Prepare(uris[i + 1]);
+    }
+    EXPECT(WaitFor(pipeline.get(), GST_MESSAGE_EOS));
+    recorder.Detach();
+    pool.Release(std::move(pipeline));
+  }
+  recorder.Report(prepare ? "prepared" : "unprepared", uris.size());
+}
+
+}  // namespace
+
+// Plays kTracks short files back to back and reports the gaps.
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+  const std::string sink = std::string("fakesink name=") + kSinkName +
+                           " sync=true signal-handoffs=true";
+  setenv(PipelinePool::kSinkEnvironmentVariable, sink.c_str(), 1);
+
+  TestIdle();
+
+  char temp[] = "/tmp/pipeline_pool_test.XXXXXX";
+  if (!mkdtemp(temp)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  const fs::path dir(temp);
+  std::vector<std::string> uris;
+  if (WriteClip(dir / "0.ogg")) {
+    uris.push_back(FileUri(dir / "0.ogg"));
+    for (size_t i = 1; i < kTracks; i++) {
+      const auto path = dir / (std::to_string(i) + ".ogg");
+      fs::copy_file(dir / "0.ogg", path);
+      uris.push_back(FileUri(path));
+    }
+
+    PipelinePool pool;
+    BenchmarkGapless(pool, uris);
+    BenchmarkSwap(pool, uris, false);
+    BenchmarkSwap(pool, uris, true);
+  } else {
+    printf("benchmark skipped: cannot encode the test clip\n");
+  }
+
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+  return plugin_common_testing::TestResult();
+}
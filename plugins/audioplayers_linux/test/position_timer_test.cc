@@ -0,0 +1,158 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "plugins/common/testing/testing.h"
+#include "position_timer.h"
+
+namespace {
+
+using std::chrono::milliseconds;
+
+// Iterates a context on its own thread, like the plugin's main loop.
+class Loop {
+ public:
+  Loop() : context_(g_main_context_new()), thread_([this] { Run(); }) {}
+
+  ~Loop() {
+    exit_ = true;
+    g_main_context_wakeup(context_);
+    thread_.join();
+    g_main_context_unref(context_);
+  }
+
+  GMainContext* context() const { return context_; }
+  std::thread::id id() const { return thread_.get_id(); }
+
+ private:
+  GMainContext* context_;
+  std::atomic<bool> exit_{false};
+  std::thread thread_;
+
+  void Run() {
+    while (!exit_) {
+      g_main_context_iteration(context_, TRUE);
+    }
+  }
+};
+
+// Waits up to a second for a condition.
+template <typename Condition>
+bool WaitFor(Condition condition) {
+  for (int i = 0; i < 1000 && !condition(); i++) {
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  return condition();
+}
+
+// Ticks run on the context until stopped, and can be started again.
+void TestStartStop(Loop& loop) {
+  PositionTimer timer(loop.context());
+  EXPECT(!timer.running());
+
+  std::atomic<int> ticks{0};
+  std::atomic<bool> on_loop{true};
+  timer.Start(5, [&] {
+    on_loop = on_loop && std::this_thread::get_id() == loop.id();
+    ticks++;
+  });
+  EXPECT(timer.running());
+  EXPECT(WaitFor([&] { return ticks >= 3; }));
+  EXPECT(on_loop);
+
+  timer.Stop();
+  EXPECT(!timer.running());
+  const int stopped_at = ticks;
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT(ticks == stopped_at);
+  timer.Stop();
+
+  timer.Start(5, [&] { ticks++; });
+  EXPECT(WaitFor([&] { return ticks > stopped_at; }));
+}
+
+// Start replaces the running tick.
+void TestRestart(Loop& loop) {
+  PositionTimer timer(loop.context());
+  std::atomic<int> first{0};
+  std::atomic<int> second{0};
+  timer.Start(5, [&] { first++; });
+  EXPECT(WaitFor([&] { return first > 0; }));
+  timer.Start(5, [&] { second++; });
+  const int replaced_at = first;
+  EXPECT(WaitFor([&] { return second >= 3; }));
+  EXPECT(first == replaced_at);
+}
+
+// Stop waits for a tick running on the loop thread, the mutex keeps new
+// ticks out while held.
+void TestStopWaits(Loop& loop) {
+  PositionTimer timer(loop.context());
+  std::atomic<bool> running{false};
+  std::atomic<bool> done{false};
+  std::atomic<int> ticks{0};
+  timer.Start(5, [&] {
+    ticks++;
+    if (!done) {
+      running = true;
+      std::this_thread::sleep_for(milliseconds(100));
+      done = true;
+    }
+  });
+  EXPECT(WaitFor([&] { return running.load(); }));
+  timer.Stop();
+  EXPECT(done);
+  const int stopped_at = ticks;
+
+  timer.Start(5, [&] { ticks++; });
+  {
+    std::lock_guard<std::mutex> lock(timer.mutex());
+    const int locked_at = ticks;
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT(ticks == locked_at);
+  }
+  EXPECT(WaitFor([&] { return ticks > stopped_at; }));
+}
+
+// A timer destroyed while ticking leaves no tick behind.
+void TestDestroy(Loop& loop) {
+  std::atomic<int> ticks{0};
+  for (int i = 0; i < 20; i++) {
+    auto timer = std::make_unique<PositionTimer>(loop.context());
+    timer->Start(1, [&] { ticks++; });
+    std::this_thread::sleep_for(milliseconds(i % 3));
+    timer.reset();
+  }
+  const int destroyed_at = ticks;
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT(ticks == destroyed_at);
+}
+
+}  // namespace
+
+int main() {
+  Loop loop;
+  TestStartStop(loop);
+  TestRestart(loop);
+  TestStopWaits(loop);
+  TestDestroy(loop);
+  return plugin_common_testing::TestResult();
+}
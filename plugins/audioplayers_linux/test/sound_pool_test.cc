@@ -0,0 +1,323 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "plugins/common/testing/testing.h"
+#include "sound_pool.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr size_t kFrameBytes = SoundPool::kChannels * sizeof(float);
+
+fs::path dir;
+
+// Output of the pools created next, written as it is played.  Unbuffered,
+// the file size tells what has been heard so far.
+fs::path SetOutput(const char* name) {
+  const auto path = dir / name;
+  const std::string sink = "filesink sync=true buffer-mode=unbuffered " +
+                           std::string("location=\"") + path.string() + "\"";
+  setenv(SoundPool::kSinkEnvironmentVariable, sink.c_str(), 1);
+  return path;
+}
+
+size_t FramesWritten(const fs::path& output) {
+  std::error_code ec;
+  const auto size = fs::file_size(output, ec);
+  return ec ? 0 : size / kFrameBytes;
+}
+
+std::vector<float> ReadOutput(const fs::path& output) {
+  std::vector<float> samples(FramesWritten(output) * SoundPool::kChannels);
+  std::ifstream file(output, std::ios::binary);
+  file.read(reinterpret_cast<char*>(samples.data()),
+            static_cast<std::streamsize>(samples.size() * sizeof(float)));
+  return samples;
+}
+
+// Runs the default main context, where the pool delivers its callbacks.
+template <typename Done>
+bool RunUntil(Done done, gint64 timeout_ms = 5000) {
+  const gint64 deadline = g_get_monotonic_time() + timeout_ms * 1000;
+  while (!done()) {
+    if (g_get_monotonic_time() > deadline) {
+      return false;
+    }
+    g_main_context_iteration(nullptr, FALSE);
+    g_usleep(1000);
+  }
+  return true;
+}
+
+void Sleep(gint64 ms) {
+  RunUntil([] { return false; }, ms);
+}
+
+std::shared_ptr<const SoundPool::Clip> Constant(float left,
+                                                float right,
+                                                size_t frames) {
+  auto clip = std::make_shared<SoundPool::Clip>();
+  clip->uri = "constant";
+  for (size_t i = 0; i < frames; i++) {
+    clip->samples.push_back(left);
+    clip->samples.push_back(right);
+  }
+  return clip;
+}
+
+// Voices are mixed with their volume, balance and rate into the one output.
+// Sample values are powers of two, so the mix is exact and each frame tells
+// which voices it holds.
+void TestMix() {
+  const auto output = SetOutput("mix.raw");
+  SoundPool pool;
+  int owner;
+  int completed = 0;
+  auto on_complete = [&] { completed++; };
+
+  // Both channels at 0.25
+  const auto a =
+      pool.AddVoice(Constant(0.25f, 0.25f, 4800), &owner, on_complete);
+  // Right only, 0.0625
+  const auto b =
+      pool.AddVoice(Constant(0.125f, 0.125f, 4800), &owner, on_complete);
+  pool.SetParams(b, {0.5, 1.0, 1.0, false});
+  // Left only, 0.03125, in half the frames
+  const auto c =
+      pool.AddVoice(Constant(0.0625f, 0.0625f, 4800), &owner, on_complete);
+  pool.SetParams(c, {0.5, -1.0, 2.0, false});
+  EXPECT(a && b && c);
+
+  for (auto voice : {a, b, c}) {
+    pool.SetPlaying(voice, true);
+  }
+  EXPECT(RunUntil([&] { return completed == 3; }));
+  // Completion is posted when the end is mixed, the sink is further behind.
+  Sleep(50);
+
+  size_t frames_a = 0;
+  size_t frames_b = 0;
+  size_t frames_c = 0;
+  size_t unexpected = 0;
+  const auto samples = ReadOutput(output);
+  for (size_t i = 0; i < samples.size(); i += SoundPool::kChannels) {
+    const bool has_a = samples[i] >= 0.25f;
+    const float left = samples[i] - (has_a ? 0.25f : 0.0f);
+    const float right = samples[i + 1] - (has_a ? 0.25f : 0.0f);
+    frames_a += has_a;
+    frames_b += right == 0.0625f;
+    frames_c += left == 0.03125f;
+    unexpected += (left != 0.0f && left != 0.03125f) ||
+                  (right != 0.0f && right != 0.0625f);
+  }
+  EXPECT(frames_a == 4800);
+  EXPECT(frames_b == 4800);
+  EXPECT(frames_c == 2400);
+  EXPECT(unexpected == 0);
+
+  // Paused back at the start
+  EXPECT(pool.GetPosition(a) == 0);
+  pool.Seek(a, 50);
+  EXPECT(pool.GetPosition(a) == 50);
+  pool.Seek(a, 1000);
+  EXPECT(pool.GetPosition(a) == 100);
+}
+
+// Start-to-sound latency: frames heard between starting a voice and its
+// first frame reaching the sink.
+void TestLatency() {
+  constexpr size_t kPlays = 20;
+  const auto output = SetOutput("latency.raw");
+  SoundPool pool;
+  int owner;
+  size_t completed = 0;
+  const auto voice =
+      pool.AddVoice(Constant(0.5f, 0.5f, 480), &owner, [&] { completed++; });
+  EXPECT(RunUntil([&] { return FramesWritten(output) > 0; }));
+
+  std::vector<size_t> started;
+  for (size_t i = 0; i < kPlays; i++) {
+    // Off the period boundaries
+    Sleep(static_cast<gint64>(20 + i % 3));
+    started.push_back(FramesWritten(output));
+    pool.SetPlaying(voice, true);
+    EXPECT(RunUntil([&] { return completed == i + 1; }));
+  }
+  Sleep(50);
+
+  const auto samples = ReadOutput(output);
+  double max_ms = 0;
+  double total_ms = 0;
+  size_t heard = 0;
+  for (size_t frame = 0; frame < samples.size() / SoundPool::kChannels;
+       frame++) {
+    const bool sound = samples[frame * SoundPool::kChannels] != 0.0f;
+    const bool after_silence =
+        frame == 0 || samples[(frame - 1) * SoundPool::kChannels] == 0.0f;
+    if (!sound || !after_silence || heard == started.size()) {
+      continue;
+    }
+    const double ms = static_cast<double>(frame - started[heard]) * 1000 /
+                      SoundPool::kSampleRate;
+    max_ms = std::max(max_ms, ms);
+    total_ms += ms;
+    heard++;
+  }
+  EXPECT(heard == kPlays);
+  EXPECT(max_ms < 10);
+  printf("start to sound: average %.2f ms, max %.2f ms\n",
+         heard ? total_ms / static_cast<double>(heard) : 0, max_ms);
+}
+
+// Callbacks may cancel their owner and remove their voice.
+void TestCancelInCallback() {
+  SetOutput("cancel.raw");
+  SoundPool pool;
+  int owner;
+  SoundPool::VoiceId voice = 0;
+  bool completed = false;
+  voice = pool.AddVoice(Constant(0.5f, 0.5f, 480), &owner, [&] {
+    pool.Cancel(&owner);
+    pool.RemoveVoice(voice);
+    completed = true;
+  });
+  pool.SetPlaying(voice, true);
+  EXPECT(RunUntil([&] { return completed; }));
+}
+
+// Encodes a sine to Ogg Vorbis, false without the encoders.
+bool WriteClip(const fs::path& path, int buffers) {
+  gchar* description = g_strdup_printf(
+      "audiotestsrc num-buffers=%d samplesperbuffer=4800 ! "
+      "audio/x-raw,rate=48000,channels=2 ! vorbisenc ! oggmux ! "
+      "filesink location=\"%s\"",
+      buffers, path.c_str());
+  GError* error = nullptr;
+  GstElement* pipeline = gst_parse_launch(description, &error);
+  g_free(description);
+  if (error) {
+    fprintf(stderr, "%s\n", error->message);
+    g_clear_error(&error);
+    if (pipeline) {
+      gst_object_unref(pipeline);
+    }
+    return false;
+  }
+
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  GstBus* bus = gst_element_get_bus(pipeline);
+  GstMessage* msg = gst_bus_timed_pop_filtered(
+      bus, GST_CLOCK_TIME_NONE,
+      static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  const bool written = GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+  gst_message_unref(msg);
+  gst_object_unref(bus);
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(pipeline);
+  return written;
+}
+
+std::string FileUri(const fs::path& path) {
+  gchar* uri = g_filename_to_uri(path.c_str(), nullptr, nullptr);
+  std::string result = uri ? uri : "";
+  g_free(uri);
+  return result;
+}
+
+// Clips are decoded once, cancelled loads are not answered.
+void TestLoad() {
+  const auto a = dir / "a.ogg";
+  const auto b = dir / "b.ogg";
+  if (!WriteClip(a, 2) || !WriteClip(b, 1)) {
+    printf("load skipped: cannot encode the test clips\n");
+    return;
+  }
+
+  SoundPool pool;
+  int owner;
+  int other;
+  std::vector<std::shared_ptr<const SoundPool::Clip>> loaded;
+  auto on_load = [&](std::shared_ptr<const SoundPool::Clip> clip) {
+    loaded.push_back(std::move(clip));
+  };
+
+  pool.Load(FileUri(a), &owner, on_load);
+  EXPECT(RunUntil([&] { return loaded.size() == 1; }));
+  const auto clip = loaded[0];
+  // 9600 frames, give or take the encoder padding
+  EXPECT(clip && clip->frames() >= 9000 && clip->frames() <= 10200);
+
+  pool.Load(FileUri(a), &owner, on_load);
+  EXPECT(RunUntil([&] { return loaded.size() == 2; }));
+  EXPECT(loaded[1] == clip);
+
+  pool.Load(FileUri(dir / "missing.ogg"), &owner, on_load);
+  EXPECT(RunUntil([&] { return loaded.size() == 3; }));
+  EXPECT(loaded[2] == nullptr);
+
+  bool cancelled_called = false;
+  pool.Load(FileUri(b), &owner,
+            [&](std::shared_ptr<const SoundPool::Clip> /* clip */) {
+              cancelled_called = true;
+            });
+  pool.Cancel(&owner);
+  pool.Load(FileUri(b), &other, on_load);
+  EXPECT(RunUntil([&] { return loaded.size() == 4; }));
+  EXPECT(loaded[3] != nullptr);
+  // Answered first had it not been cancelled
+  EXPECT(!cancelled_called);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+  for (const char* name : {"appsrc", "audioconvert", "audioresample",
+                           "filesink", "playbin", "appsink"}) {
+    GstElementFactory* factory = gst_element_factory_find(name);
+    if (!factory) {
+      printf("skipped: no %s\n", name);
+      return plugin_common_testing::kSkipped;
+    }
+    gst_object_unref(factory);
+  }
+
+  char temp[] = "/tmp/sound_pool_test.XXXXXX";
+  if (!mkdtemp(temp)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  dir = temp;
+
+  TestMix();
+  TestLatency();
+  TestCancelInCallback();
+  TestLoad();
+
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+  return plugin_common_testing::TestResult();
+}
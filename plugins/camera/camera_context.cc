@@ -16,7 +16,8 @@
 
 #include "camera_context.h"
 
-#include <sstream>
+#include <algorithm>
+#include <chrono>
 
 #include <flutter/event_channel.h>
 #include <flutter/event_stream_handler_functions.h>
@@ -28,14 +29,108 @@
 #include <utility>
 
 #include <plugins/common/common.h>
+#include <plugins/common/glib/main_loop.h>
 
 namespace camera_plugin {
 
 static constexpr char kPictureCaptureExtension[] = "jpeg";
 static constexpr char kVideoCaptureExtension[] = "mp4";
 
+static constexpr char kResolutionPresetValueLow[] = "low";
+static constexpr char kResolutionPresetValueMedium[] = "medium";
+static constexpr char kResolutionPresetValueHigh[] = "high";
+static constexpr char kResolutionPresetValueVeryHigh[] = "veryHigh";
+static constexpr char kResolutionPresetValueUltraHigh[] = "ultraHigh";
+static constexpr char kResolutionPresetValueMax[] = "max";
+
+// One buffer is displayed, one waits for rendering, up to two are held by
+// the recorder and one by the image stream, the rest are in flight.
+static constexpr unsigned int kMinBufferCount = 7;
+// Full resolution RGB buffers are large; a burst waits for the encoder.
+static constexpr unsigned int kStillBufferCount = 2;
+
 using namespace plugin_common;
 
+namespace {
+
+int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+bool IsSupportedFormat(const libcamera::PixelFormat& format, bool still) {
+  const auto& formats = FrameSink::SupportedFormats();
+  if (std::find(formats.begin(), formats.end(), format) == formats.end()) {
+    return false;
+  }
+  return !still || StillEncoder::IsSupported(format);
+}
+
+// Pick the first usable format the stream offers.
+bool SelectFormat(libcamera::StreamConfiguration& cfg, bool still) {
+  const auto available = cfg.formats().pixelformats();
+  for (const auto& format : FrameSink::SupportedFormats()) {
+    if (IsSupportedFormat(format, still) &&
+        std::find(available.begin(), available.end(), format) !=
+            available.end()) {
+      cfg.pixelFormat = format;
+      return true;
+    }
+  }
+  return false;
+}
+
+// xdg-user-dir runs a shell; directories are looked up once per process.
+std::optional<std::string> GetUserDir(const std::string& name) {
+  static std::mutex mutex;
+  static std::map<std::string, std::optional<std::string>> dirs;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = dirs.find(name);
+  if (it == dirs.end()) {
+    std::string dir;
+    if (Command::Execute(("xdg-user-dir " + name).c_str(), dir)) {
+      it = dirs.emplace(name, StringTools::trim(dir, "\n")).first;
+    } else {
+      it = dirs.emplace(name, std::nullopt).first;
+    }
+  }
+  return it->second;
+}
+
+#if defined(ENABLE_RECORDER)
+// Enumerating encoders loads every GStreamer plugin; done once per process.
+EncoderRegistry* GetEncoderRegistry() {
+  static EncoderRegistry* registry = [] {
+    gst_init(nullptr, nullptr);
+    return new EncoderRegistry();
+  }();
+  return registry;
+}
+#endif
+
+// Size requested for a preset; validate() adjusts it to the nearest mode.
+libcamera::Size PresetSize(const std::string& preset,
+                           const libcamera::StreamFormats& formats,
+                           const libcamera::PixelFormat& format) {
+  if (preset == kResolutionPresetValueLow) {
+    return {320, 240};
+  } else if (preset == kResolutionPresetValueMedium) {
+    return {720, 480};
+  } else if (preset == kResolutionPresetValueHigh) {
+    return {1280, 720};
+  } else if (preset == kResolutionPresetValueVeryHigh) {
+    return {1920, 1080};
+  } else if (preset == kResolutionPresetValueUltraHigh) {
+    return {3840, 2160};
+  } else if (preset == kResolutionPresetValueMax) {
+    return formats.range(format).max;
+  }
+  return {640, 480};
+}
+
+}  // namespace
+
 CameraContext::CameraContext(std::string cameraName,
                              std::string resolutionPreset,
                              int64_t fps,
@@ -81,6 +176,17 @@ CameraContext::CameraContext(std::string cameraName,
 
 CameraContext::~CameraContext() {
   SPDLOG_DEBUG("[camera_plugin] ~CameraContext()");
+  StopCapture();
+  if (mPreview.is_initialized) {
+    texture_registrar_->TextureMakeCurrent();
+    mFrameSink.reset();
+    glDeleteFramebuffers(1, &mPreview.framebuffer);
+    glDeleteTextures(1, &mPreview.textureId);
+    texture_registrar_->TextureClearCurrent();
+    texture_registrar_->UnregisterTexture(mPreview.textureId);
+  }
+  mRequests.clear();
+  mAllocator.reset();
   mCamera->release();
   mCameraState = CAM_STATE_AVAILABLE;
 }
@@ -106,14 +212,24 @@ std::string CameraContext::Initialize(
 
   camera_id_ = camera_id;
   texture_registrar_ = plugin_registrar->texture_registrar();
+  messenger_ = plugin_registrar->messenger();
   mImageFormatGroup.assign(image_format_group);
 
   spdlog::debug(
       "[camera_plugin] Initialize: cameraId: {}, imageFormatGroup: [{}]",
       camera_id, mImageFormatGroup);
 
-  mPreview.width = 640;
-  mPreview.height = 480;
+  // Configure first so the texture matches the stream.  Cameras that
+  // cannot add a still stream take pictures from the viewfinder.
+  if ((StillEncoder::IsSupported() && ConfigureStreams(true)) ||
+      ConfigureStreams(false)) {
+    const auto& cfg = mConfig->at(0);
+    mPreview.width = static_cast<GLsizei>(cfg.size.width);
+    mPreview.height = static_cast<GLsizei>(cfg.size.height);
+  } else {
+    mPreview.width = 640;
+    mPreview.height = 480;
+  }
 
   /// Setup GL Texture 2D
   texture_registrar_->TextureMakeCurrent();
@@ -145,6 +261,11 @@ std::string CameraContext::Initialize(
 
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+  if (mStream) {
+    mFrameSink =
+        std::make_unique<FrameSink>(mPreview.textureId, mConfig->at(0));
+  }
+
   texture_registrar_->TextureClearCurrent();
 
   mPreview.descriptor = {
@@ -163,6 +284,11 @@ std::string CameraContext::Initialize(
       FlutterDesktopGpuSurfaceType::kFlutterDesktopGpuSurfaceTypeGlTexture2D,
       [&](size_t /* width */,
           size_t /* height */) -> const FlutterDesktopGpuSurfaceDescriptor* {
+        {
+          std::lock_guard<std::mutex> lock(mRenderMutex);
+          mFramePulled = true;
+        }
+        mRenderCv.notify_one();
         return &mPreview.descriptor;
       });
 
@@ -170,6 +296,10 @@ std::string CameraContext::Initialize(
   texture_registrar_->RegisterTexture(&texture);
   texture_registrar_->MarkTextureFrameAvailable(mPreview.textureId);
 
+  if (mStream && !StartCapture()) {
+    spdlog::error("[camera_plugin] Failed to start capture");
+  }
+
   auto props = mCamera->properties();
 
   std::string exposureMode("auto");
@@ -201,60 +331,584 @@ std::string CameraContext::Initialize(
   return channel_name;
 }
 
+bool CameraContext::ConfigureStreams(bool withStill) {
+  std::vector<libcamera::StreamRole> roles = {
+      libcamera::StreamRole::Viewfinder};
+  if (withStill) {
+    roles.push_back(libcamera::StreamRole::StillCapture);
+  }
+  auto config = mCamera->generateConfiguration(roles);
+  if (!config || config->size() != roles.size()) {
+    spdlog::debug("[camera_plugin] No configuration for {} stream(s)",
+                  roles.size());
+    return false;
+  }
+
+  auto& cfg = config->at(0);
+  SelectFormat(cfg, false);
+  cfg.size = PresetSize(mResolutionPreset, cfg.formats(), cfg.pixelFormat);
+  cfg.bufferCount = std::max(cfg.bufferCount, kMinBufferCount);
+  if (withStill) {
+    auto& still = config->at(1);
+    if (!SelectFormat(still, true)) {
+      spdlog::debug("[camera_plugin] No still format the encoder can take");
+      return false;
+    }
+    still.size = still.formats().range(still.pixelFormat).max;
+    still.bufferCount = kStillBufferCount;
+  }
+
+  switch (config->validate()) {
+    case libcamera::CameraConfiguration::Valid:
+      break;
+    case libcamera::CameraConfiguration::Adjusted:
+      spdlog::debug("[camera_plugin] Configuration adjusted");
+      break;
+    case libcamera::CameraConfiguration::Invalid:
+      spdlog::debug("[camera_plugin] Invalid configuration for {} stream(s)",
+                    roles.size());
+      return false;
+  }
+
+  // validate() may have swapped in a format we cannot display or encode.
+  if (!IsSupportedFormat(config->at(0).pixelFormat, false) ||
+      (withStill && config->size() != 2) ||
+      (withStill && !IsSupportedFormat(config->at(1).pixelFormat, true))) {
+    spdlog::debug("[camera_plugin] Adjusted configuration is not usable");
+    return false;
+  }
+
+  auto res = mCamera->configure(config.get());
+  if (res != 0) {
+    spdlog::error("[camera_plugin] Failed to configure camera: {}", res);
+    return false;
+  }
+  for (const auto& stream_cfg : *config) {
+    spdlog::debug("[camera_plugin] Configured: {}", stream_cfg.toString());
+  }
+
+  mConfig = std::move(config);
+  mStream = mConfig->at(0).stream();
+  mStillStream = withStill ? mConfig->at(1).stream() : nullptr;
+  mCameraState = CAM_STATE_CONFIGURED;
+  return true;
+}
+
+bool CameraContext::StartCapture() {
+  mAllocator = std::make_unique<libcamera::FrameBufferAllocator>(mCamera);
+  if (mAllocator->allocate(mStream) < 0) {
+    spdlog::error("[camera_plugin] Failed to allocate buffers");
+    return false;
+  }
+
+  for (const auto& buffer : mAllocator->buffers(mStream)) {
+    // The cookie indexes mRequestRefs.
+    auto request = mCamera->createRequest(mRequests.size());
+    if (!request || request->addBuffer(mStream, buffer.get()) != 0) {
+      spdlog::error("[camera_plugin] Failed to create request");
+      mRequests.clear();
+      return false;
+    }
+    mRequests.emplace_back(std::move(request));
+  }
+  mRequestRefs = std::make_unique<std::atomic<int>[]>(mRequests.size());
+
+  if (StillEncoder::IsSupported()) {
+    mStillEncoder = std::make_unique<StillEncoder>();
+  }
+  if (mStillStream) {
+    if (mAllocator->allocate(mStillStream) < 0) {
+      spdlog::error("[camera_plugin] Failed to allocate still buffers");
+      return false;
+    }
+    for (const auto& buffer : mAllocator->buffers(mStillStream)) {
+      mMappedBuffers[buffer.get()] =
+          std::make_unique<MappedBuffer>(buffer.get());
+      mFreeStillBuffers.push_back(buffer.get());
+    }
+  }
+
+  libcamera::ControlList controls;
+  if (mFps > 0 &&
+      mCamera->controls().count(&libcamera::controls::FrameDurationLimits)) {
+    const int64_t frame_time = 1000000 / mFps;
+    controls.set(libcamera::controls::FrameDurationLimits,
+                 libcamera::Span<const int64_t, 2>({frame_time, frame_time}));
+  }
+
+  mCamera->requestCompleted.connect(this, &CameraContext::OnRequestCompleted);
+  mRenderThread = std::thread(&CameraContext::RenderLoop, this);
+
+  auto res = mCamera->start(&controls);
+  if (res != 0) {
+    spdlog::error("[camera_plugin] Failed to start camera: {}", res);
+    StopCapture();
+    return false;
+  }
+  mCameraState = CAM_STATE_RUNNING;
+  mCapturing = true;
+
+  for (auto& request : mRequests) {
+    res = mCamera->queueRequest(request.get());
+    if (res != 0) {
+      spdlog::error("[camera_plugin] Failed to queue request: {}", res);
+    }
+  }
+  return true;
+}
+
+void CameraContext::StopCapture() {
+  mCapturing = false;
+#if defined(ENABLE_RECORDER)
+  {
+    std::unique_ptr<VideoRecorder> recorder;
+    {
+      std::lock_guard<std::mutex> lock(mRecorderMutex);
+      recorder = std::move(mRecorder);
+    }
+    // Finalizes the file; requests it held are not queued again.
+    recorder.reset();
+  }
+#endif
+  {
+    std::unique_ptr<ImageStreamer> streamer;
+    {
+      std::lock_guard<std::mutex> lock(mImageStreamMutex);
+      streamer = std::move(mImageStreamer);
+    }
+    // Joins the worker; a request it converted is not queued again.
+    streamer.reset();
+  }
+  if (mCameraState == CAM_STATE_RUNNING) {
+    mCameraState = CAM_STATE_STOPPING;
+    // Completes all queued requests as cancelled.
+    mCamera->stop();
+    mCameraState = CAM_STATE_CONFIGURED;
+  }
+  mCamera->requestCompleted.disconnect(this);
+
+  if (mRenderThread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mRenderMutex);
+      mRenderExit = true;
+    }
+    mRenderCv.notify_one();
+    mRenderThread.join();
+  }
+  mPendingRequest = nullptr;
+  mDisplayedRequest = nullptr;
+
+  std::deque<PendingStill> stills;
+  {
+    std::lock_guard<std::mutex> lock(mStillMutex);
+    stills.swap(mPendingStills);
+    mStillsAttached = 0;
+  }
+  for (auto& still : stills) {
+    still.result(FlutterError("cameraStopped", "Camera stopped"));
+  }
+  // Finishes queued stills before their buffers go away.
+  mStillEncoder.reset();
+
+  if (mStats.completed) {
+    spdlog::debug(
+        "[camera_plugin] preview: {} completed, {} rendered, {} dropped, "
+        "{} us average completion to texture",
+        mStats.completed, mStats.rendered, mStats.dropped,
+        mStats.rendered ? mStats.latency_us /
+                              static_cast<int64_t>(mStats.rendered)
+                        : 0);
+  }
+}
+
+void CameraContext::ReleaseRequest(libcamera::Request* request) {
+  if (mRequestRefs[request->cookie()].fetch_sub(1) == 1) {
+    RequeueRequest(request);
+  }
+}
+
+void CameraContext::RequeueRequest(libcamera::Request* request) {
+  if (!mCapturing) {
+    return;
+  }
+  if (!mStillStream) {
+    request->reuse(libcamera::Request::ReuseBuffers);
+    mCamera->queueRequest(request);
+    return;
+  }
+
+  // Drop the still buffer of the last capture, add one for a waiting still.
+  libcamera::FrameBuffer* viewfinder = request->findBuffer(mStream);
+  request->reuse();
+  request->addBuffer(mStream, viewfinder);
+  {
+    std::lock_guard<std::mutex> lock(mStillMutex);
+    if (mStillsAttached < mPendingStills.size() &&
+        !mFreeStillBuffers.empty()) {
+      request->addBuffer(mStillStream, mFreeStillBuffers.back());
+      mFreeStillBuffers.pop_back();
+      mStillsAttached++;
+    }
+  }
+  mCamera->queueRequest(request);
+}
+
+void CameraContext::OnRequestCompleted(libcamera::Request* request) {
+  if (request->status() == libcamera::Request::RequestCancelled) {
+    return;
+  }
+  // Before the request can be requeued, which releases its still buffer.
+  CaptureStill(request);
+
+  // Held by the preview path, and by the recorder while it reads the frame.
+  mRequestRefs[request->cookie()] = 1;
+#if defined(ENABLE_RECORDER)
+  {
+    std::lock_guard<std::mutex> lock(mRecorderMutex);
+    if (mRecorder) {
+      mRequestRefs[request->cookie()]++;
+      if (!mRecorder->Push(request->findBuffer(mStream),
+                           [this, request] { ReleaseRequest(request); })) {
+        mRequestRefs[request->cookie()]--;
+      }
+    }
+  }
+#endif
+  {
+    std::lock_guard<std::mutex> lock(mImageStreamMutex);
+    if (mImageStreamer) {
+      const libcamera::FrameBuffer* buffer = request->findBuffer(mStream);
+      const uint8_t* data = GetMapping(buffer)->data();
+      if (data) {
+        mRequestRefs[request->cookie()]++;
+        if (!mImageStreamer->Push(
+                data, static_cast<int64_t>(buffer->metadata().timestamp),
+                [this, request] { ReleaseRequest(request); })) {
+          mRequestRefs[request->cookie()]--;
+        }
+      }
+    }
+  }
+
+  if (mPreviewPaused) {
+    ReleaseRequest(request);
+    return;
+  }
+
+  libcamera::Request* dropped;
+  {
+    std::lock_guard<std::mutex> lock(mRenderMutex);
+    mStats.completed++;
+    dropped = mPendingRequest;
+    if (dropped) {
+      mStats.dropped++;
+    }
+    mPendingRequest = request;
+    mPendingCompletedAt = NowUs();
+  }
+  mRenderCv.notify_one();
+  if (dropped) {
+    ReleaseRequest(dropped);
+  }
+}
+
+void CameraContext::CaptureStill(libcamera::Request* request) {
+  const libcamera::StreamConfiguration* cfg;
+  libcamera::FrameBuffer* buffer;
+  PendingStill still;
+  {
+    std::lock_guard<std::mutex> lock(mStillMutex);
+    if (mStillStream) {
+      buffer = request->findBuffer(mStillStream);
+      if (!buffer) {
+        return;
+      }
+      mStillsAttached--;
+      cfg = &mConfig->at(1);
+    } else {
+      if (mPendingStills.empty()) {
+        return;
+      }
+      buffer = request->findBuffer(mStream);
+      cfg = &mConfig->at(0);
+    }
+    still = std::move(mPendingStills.front());
+    mPendingStills.pop_front();
+  }
+
+  MappedBuffer* mapping = GetMapping(buffer);
+
+  StillEncoder::Job job;
+  job.width = cfg->size.width;
+  job.height = cfg->size.height;
+  job.stride = cfg->stride;
+  job.format = cfg->pixelFormat;
+  job.path = std::move(still.path);
+  job.requested_at = still.requested_at;
+  job.result = std::move(still.result);
+  if (mStillStream) {
+    // Encoded in place; the buffer is out of rotation until then.
+    job.data = mapping->data();
+    job.release = [this, buffer] {
+      std::lock_guard<std::mutex> lock(mStillMutex);
+      mFreeStillBuffers.push_back(buffer);
+    };
+  } else if (mapping->data()) {
+    // The viewfinder buffer has to go back to the camera right away.
+    job.pixels.assign(mapping->data(),
+                      mapping->data() + static_cast<size_t>(job.stride) *
+                                            job.height);
+    job.data = job.pixels.data();
+  }
+
+  // Submit() leaves the job untouched when it is refused.
+  if (job.data && mStillEncoder->Submit(std::move(job))) {
+    return;
+  }
+  if (job.release) {
+    job.release();
+  }
+  job.result(job.data
+                 ? FlutterError("captureBusy", "Too many pictures pending")
+                 : FlutterError("IOError", "Failed to map capture buffer"));
+}
+
+MappedBuffer* CameraContext::GetMapping(const libcamera::FrameBuffer* buffer) {
+  auto& mapping = mMappedBuffers[buffer];
+  if (!mapping) {
+    mapping = std::make_unique<MappedBuffer>(buffer);
+  }
+  return mapping.get();
+}
+
+void CameraContext::RenderLoop() {
+  std::unique_lock<std::mutex> lock(mRenderMutex);
+  while (true) {
+    // Wait until Flutter took the last frame; the texture is not
+    // double buffered.
+    mRenderCv.wait(lock, [this] {
+      return mRenderExit || (mFramePulled && mPendingRequest);
+    });
+    if (mRenderExit) {
+      break;
+    }
+    libcamera::Request* request = mPendingRequest;
+    const int64_t completed_at = mPendingCompletedAt;
+    mPendingRequest = nullptr;
+    mFramePulled = false;
+    lock.unlock();
+
+    texture_registrar_->TextureMakeCurrent();
+    const bool referenced =
+        mFrameSink->Present(request->findBuffer(mStream));
+    texture_registrar_->TextureClearCurrent();
+    texture_registrar_->MarkTextureFrameAvailable(mPreview.textureId);
+
+    // An imported buffer stays in use until the next one replaces it.
+    if (referenced) {
+      std::swap(request, mDisplayedRequest);
+    }
+    if (request) {
+      ReleaseRequest(request);
+    }
+
+    lock.lock();
+    mStats.rendered++;
+    mStats.latency_us += NowUs() - completed_at;
+  }
+}
+
 std::optional<std::string> CameraContext::GetFilePathForPicture() {
-  std::ostringstream oss;
-  oss << "xdg-user-dir PICTURES";
-  std::string picture_path;
-  if (!Command::Execute(oss.str().c_str(), picture_path)) {
+  auto dir = GetUserDir("PICTURES");
+  if (!dir.has_value()) {
     return std::nullopt;
   }
-  std::filesystem::path path(StringTools::trim(picture_path, "\n"));
+  std::filesystem::path path(dir.value());
   path /= "PhotoCapture_" + TimeTools::GetCurrentTimeString() + "." +
           kPictureCaptureExtension;
   return path;
 }
 
 std::optional<std::string> CameraContext::GetFilePathForVideo() {
-  std::ostringstream oss;
-  oss << "xdg-user-dir VIDEOS";
-  std::string video_path;
-  if (!Command::Execute(oss.str().c_str(), video_path)) {
+  auto dir = GetUserDir("VIDEOS");
+  if (!dir.has_value()) {
     return std::nullopt;
   }
-  std::filesystem::path path(StringTools::trim(video_path, "\n"));
+  std::filesystem::path path(dir.value());
   path /= "VideoCapture_" + TimeTools::GetCurrentTimeString() + "." +
           kVideoCaptureExtension;
   return path;
 }
 
-std::string CameraContext::takePicture() {
-  auto filename = GetFilePathForPicture();
-  if (filename.has_value()) {
-    return filename.value();
+void CameraContext::takePicture(
+    std::function<void(ErrorOr<std::string> reply)> result) {
+  if (!StillEncoder::IsSupported()) {
+    result(FlutterError("jpegNotSupported", "Built without libjpeg"));
+    return;
+  }
+  const auto& format =
+      mConfig ? mConfig->at(mStillStream ? 1 : 0).pixelFormat
+              : libcamera::PixelFormat();
+  if (!mCapturing || !StillEncoder::IsSupported(format)) {
+    result(FlutterError("cameraNotReady", "Camera is not capturing"));
+    return;
+  }
+  auto path = GetFilePathForPicture();
+  if (!path.has_value()) {
+    result(FlutterError("IOError", "Failed to get the pictures directory"));
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mStillMutex);
+    if (mPendingStills.size() + mStillEncoder->Pending() <
+        StillEncoder::kMaxQueued) {
+      // Answered from the libcamera thread or an encoder worker; the reply
+      // is sent from the main loop, like the other plugin messages.
+      mPendingStills.push_back(
+          {std::move(path.value()), NowUs(),
+           [result = std::move(result)](ErrorOr<std::string> reply) {
+             plugin_common_glib::MainLoop::Post(
+                 [result, reply = std::move(reply)]() mutable {
+                   result(std::move(reply));
+                 });
+           }});
+      return;
+    }
+  }
+  result(FlutterError("captureBusy", "Too many pictures pending"));
+}
+
+std::optional<FlutterError> CameraContext::startVideoRecording(
+    bool enableStream) {
+#if defined(ENABLE_RECORDER)
+  if (!mCapturing) {
+    return FlutterError("cameraNotReady", "Camera is not capturing");
+  }
+  const auto& cfg = mConfig->at(0);
+  if (!VideoRecorder::IsSupported(cfg.pixelFormat)) {
+    return FlutterError("recordingNotSupported",
+                        "Cannot record " + cfg.pixelFormat.toString());
+  }
+  auto path = GetFilePathForVideo();
+  if (!path.has_value()) {
+    return FlutterError("IOError", "Failed to get the videos directory");
+  }
+
+  std::lock_guard<std::mutex> lock(mRecorderMutex);
+  if (mRecorder) {
+    return FlutterError("recordingInProgress", "Already recording");
+  }
+  auto recorder = std::make_unique<VideoRecorder>(
+      GetEncoderRegistry(),
+      VideoRecorder::Settings{path.value(), cfg.size.width, cfg.size.height,
+                              cfg.stride, cfg.pixelFormat, mFps,
+                              mVideoBitrate, mAudioBitrate, mEnableAudio});
+  auto error = recorder->Start();
+  if (error.has_value()) {
+    return FlutterError("recordingFailed", error.value());
+  }
+  mRecorder = std::move(recorder);
+
+  if (enableStream) {
+    auto stream_error = startImageStream(0);
+    if (stream_error.has_value()) {
+      spdlog::warn("[camera_plugin] recording without image stream: {}",
+                   stream_error->message());
+    }
+  }
+  return std::nullopt;
+#else
+  return FlutterError("recordingNotSupported", "Built without GStreamer");
+#endif
+}
+
+std::optional<FlutterError> CameraContext::pauseVideoRecording() {
+#if defined(ENABLE_RECORDER)
+  std::lock_guard<std::mutex> lock(mRecorderMutex);
+  if (!mRecorder) {
+    return FlutterError("noRecording", "Not recording");
   }
-  return {};
+  mRecorder->Pause();
+  return std::nullopt;
+#else
+  return FlutterError("recordingNotSupported", "Built without GStreamer");
+#endif
 }
 
-void CameraContext::startVideoRecording(bool /* enableStream */) {
-  SPDLOG_DEBUG("[camera_plugin] startVideoRecording");
+std::optional<FlutterError> CameraContext::resumeVideoRecording() {
+#if defined(ENABLE_RECORDER)
+  std::lock_guard<std::mutex> lock(mRecorderMutex);
+  if (!mRecorder) {
+    return FlutterError("noRecording", "Not recording");
+  }
+  mRecorder->Resume();
+  return std::nullopt;
+#else
+  return FlutterError("recordingNotSupported", "Built without GStreamer");
+#endif
 }
 
-void CameraContext::pauseVideoRecording() {
-  SPDLOG_DEBUG("[camera_plugin] pauseVideoRecording");
+ErrorOr<std::string> CameraContext::stopVideoRecording() {
+#if defined(ENABLE_RECORDER)
+  std::unique_ptr<VideoRecorder> recorder;
+  {
+    std::lock_guard<std::mutex> lock(mRecorderMutex);
+    recorder = std::move(mRecorder);
+  }
+  if (!recorder) {
+    return FlutterError("noRecording", "Not recording");
+  }
+  // Waits for the muxer outside the lock; frames are no longer pushed.
+  auto error = recorder->Stop();
+  if (error.has_value()) {
+    return FlutterError("recordingFailed", error.value());
+  }
+  SPDLOG_DEBUG("[camera_plugin] stopVideoRecording: [{}]", recorder->path());
+  return recorder->path();
+#else
+  return FlutterError("recordingNotSupported", "Built without GStreamer");
+#endif
 }
 
-void CameraContext::resumeVideoRecording() {
-  SPDLOG_DEBUG("[camera_plugin] resumeVideoRecording");
+std::optional<FlutterError> CameraContext::startImageStream(
+    double maxFrameRate) {
+  if (!mCapturing || !messenger_) {
+    return FlutterError("cameraNotReady", "Camera is not capturing");
+  }
+  const auto& cfg = mConfig->at(0);
+  if (!ImageStreamer::IsSupported(cfg.pixelFormat)) {
+    return FlutterError("imageStreamNotSupported",
+                        "Cannot stream " + cfg.pixelFormat.toString());
+  }
+
+  const auto layout = mImageFormatGroup == "yuv420"
+                          ? ImageStreamer::Layout::kI420
+                          : ImageStreamer::Layout::kNV12;
+
+  std::lock_guard<std::mutex> lock(mImageStreamMutex);
+  if (mImageStreamer) {
+    return FlutterError("imageStreamInProgress", "Already streaming");
+  }
+  mImageStreamer = std::make_unique<ImageStreamer>(
+      messenger_,
+      std::string("flutter.io/cameraPlugin/imageStream") +
+          std::to_string(camera_id_),
+      cfg.size.width, cfg.size.height, cfg.stride, cfg.pixelFormat, layout,
+      maxFrameRate);
+  return std::nullopt;
 }
 
-std::string CameraContext::stopVideoRecording() {
-  auto filename = GetFilePathForVideo();
-  if (filename.has_value()) {
-    SPDLOG_DEBUG("[camera_plugin] stopVideoRecording: [{}]", filename.value());
-    return filename.value();
+std::optional<FlutterError> CameraContext::stopImageStream() {
+  std::unique_ptr<ImageStreamer> streamer;
+  {
+    std::lock_guard<std::mutex> lock(mImageStreamMutex);
+    streamer = std::move(mImageStreamer);
+  }
+  if (!streamer) {
+    return FlutterError("noImageStream", "Not streaming");
   }
-  SPDLOG_DEBUG("[camera_plugin] stopVideoRecording: []");
-  return {};
+  return std::nullopt;
 }
 
 }  // namespace camera_plugin
\ No newline at end of file
@@ -16,6 +16,16 @@
 #ifndef FLUTTER_PLUGIN_CAMERA_CONTEXT_H_
 #define FLUTTER_PLUGIN_CAMERA_CONTEXT_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <flutter/basic_message_channel.h>
 #include <flutter/event_channel.h>
 #include <shell/platform/embedder/embedder.h>
@@ -23,6 +33,14 @@
 #include <libcamera/libcamera.h>
 
 #include "engine.h"
+#include "frame_sink.h"
+#include "image_streamer.h"
+#include "mapped_buffer.h"
+#include "messages.h"
+#include "still_encoder.h"
+#if defined(ENABLE_RECORDER)
+#include "video_recorder.h"
+#endif
 
 namespace camera_plugin {
 
@@ -59,15 +77,63 @@ class CameraContext : public flutter::Plugin {
 
   static std::optional<std::string> GetFilePathForVideo();
 
-  static std::string takePicture();
+  /**
+   * @brief Capture a still and write it as JPEG.  Returns right away; the
+   * frame is encoded on a worker and result is called from there.
+   * @param[in] result Receives the file path or an error
+   * @return void
+   * @relation
+   * libcamera
+   */
+  void takePicture(std::function<void(ErrorOr<std::string> reply)> result);
+
+  /**
+   * @brief Stop or restart updating the preview texture.  Capture keeps
+   * running so resuming shows a current frame right away.
+   * @param[in] paused Whether completed frames are discarded
+   * @return void
+   * @relation
+   * libcamera
+   */
+  void setPreviewPaused(bool paused) { mPreviewPaused = paused; }
+
+  /**
+   * @brief Record the viewfinder stream to an MP4 file in the videos folder
+   * @param[in] enableStream Also start the image stream
+   * @return std::optional<FlutterError>
+   * @retval std::nullopt Recording
+   * @relation
+   * libcamera, gstreamer
+   */
+  std::optional<FlutterError> startVideoRecording(bool enableStream);
+  std::optional<FlutterError> pauseVideoRecording();
+  std::optional<FlutterError> resumeVideoRecording();
 
-  void startVideoRecording(bool enableStream);
-  void pauseVideoRecording();
-  void resumeVideoRecording();
-  std::string stopVideoRecording();
+  /**
+   * @brief Finish the recording
+   * @return ErrorOr<std::string>
+   * @retval Path of the written file
+   * @relation
+   * libcamera, gstreamer
+   */
+  ErrorOr<std::string> stopVideoRecording();
+
+  /**
+   * @brief Deliver viewfinder frames as YUV 4:2:0 on the image stream
+   * channel, I420 for the yuv420 format group and NV12 otherwise
+   * @param[in] maxFrameRate Frames per second delivered at most, 0 for the
+   * capture rate
+   * @return std::optional<FlutterError>
+   * @retval std::nullopt Streaming
+   * @relation
+   * libcamera
+   */
+  std::optional<FlutterError> startImageStream(double maxFrameRate);
+  std::optional<FlutterError> stopImageStream();
 
  private:
   flutter::TextureRegistrar* texture_registrar_{};
+  flutter::BinaryMessenger* messenger_{};
   std::unique_ptr<flutter::MethodChannel<>> camera_channel_;
   int64_t camera_id_ = -1;
   CAM_STATE_T mCameraState;
@@ -110,6 +176,104 @@ class CameraContext : public flutter::Plugin {
     FlutterDesktopGpuSurfaceDescriptor descriptor{};
   } mPreview;
 
+  // Capture
+  std::unique_ptr<libcamera::CameraConfiguration> mConfig;
+  libcamera::Stream* mStream{};
+  std::unique_ptr<libcamera::FrameBufferAllocator> mAllocator;
+  std::vector<std::unique_ptr<libcamera::Request>> mRequests;
+  // Holders of each completed request; it is queued again at zero
+  std::unique_ptr<std::atomic<int>[]> mRequestRefs;
+  std::atomic<bool> mCapturing{};
+  std::atomic<bool> mPreviewPaused{};
+
+  // Stills.  With a still stream, a free still buffer is added to the next
+  // requeued request for each waiting picture; without one, the next
+  // viewfinder frame is copied.
+  libcamera::Stream* mStillStream{};
+  std::unique_ptr<StillEncoder> mStillEncoder;
+  struct PendingStill {
+    std::string path;
+    int64_t requested_at;
+    std::function<void(ErrorOr<std::string> reply)> result;
+  };
+  std::mutex mStillMutex;
+  std::deque<PendingStill> mPendingStills;
+  // Leading entries of mPendingStills that have a buffer in a request
+  size_t mStillsAttached{};
+  std::vector<libcamera::FrameBuffer*> mFreeStillBuffers;
+  // CPU mappings, used by the libcamera thread and the encoder
+  std::map<const libcamera::FrameBuffer*, std::unique_ptr<MappedBuffer>>
+      mMappedBuffers;
+
+  std::mutex mImageStreamMutex;
+  std::unique_ptr<ImageStreamer> mImageStreamer;
+
+#if defined(ENABLE_RECORDER)
+  std::mutex mRecorderMutex;
+  std::unique_ptr<VideoRecorder> mRecorder;
+#endif
+
+  // Preview rendering.  The newest completed request waits in
+  // mPendingRequest; an older one that was not rendered yet is requeued.
+  std::unique_ptr<FrameSink> mFrameSink;
+  std::thread mRenderThread;
+  std::mutex mRenderMutex;
+  std::condition_variable mRenderCv;
+  libcamera::Request* mPendingRequest{};
+  int64_t mPendingCompletedAt{};
+  bool mFramePulled = true;
+  bool mRenderExit{};
+  // Request whose buffer the texture references, render thread only
+  libcamera::Request* mDisplayedRequest{};
+
+  struct {
+    uint64_t completed;
+    uint64_t rendered;
+    uint64_t dropped;
+    int64_t latency_us;
+  } mStats{};
+
+  /**
+   * @brief Configure a viewfinder stream for the resolution preset, and
+   * optionally a full resolution still stream
+   * @param[in] withStill Add a StillCapture stream
+   * @return bool
+   * @retval true Camera is configured and mStream is valid
+   * @retval false No usable configuration
+   * @relation
+   * libcamera
+   */
+  bool ConfigureStreams(bool withStill);
+
+  /**
+   * @brief Allocate buffers, start the camera and queue all requests
+   * @return bool
+   * @retval true Frames are being captured
+   * @retval false Capture could not be started
+   * @relation
+   * libcamera
+   */
+  bool StartCapture();
+
+  void StopCapture();
+
+  void RequeueRequest(libcamera::Request* request);
+
+  // Drop one hold of a completed request, requeue it after the last.
+  void ReleaseRequest(libcamera::Request* request);
+
+  // Runs on the libcamera thread.
+  void OnRequestCompleted(libcamera::Request* request);
+
+  // Hand the still of a completed request to the encoder, if one waits.
+  void CaptureStill(libcamera::Request* request);
+
+  // CPU mapping of a capture buffer, created on first use.  libcamera
+  // thread only.
+  MappedBuffer* GetMapping(const libcamera::FrameBuffer* buffer);
+
+  void RenderLoop();
+
   flutter::MethodChannel<>* GetMethodChannel();
 };
 }  // namespace camera_plugin
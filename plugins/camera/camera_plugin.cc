@@ -30,13 +30,6 @@ namespace camera_plugin {
 
 // TODO static constexpr char kKeyMaxVideoDuration[] = "maxVideoDuration";
 
-// TODO static constexpr char kResolutionPresetValueLow[] = "low";
-// TODO static constexpr char kResolutionPresetValueMedium[] = "medium";
-// TODO static constexpr char kResolutionPresetValueHigh[] = "high";
-// TODO static constexpr char kResolutionPresetValueVeryHigh[] = "veryHigh";
-// TODO static constexpr char kResolutionPresetValueUltraHigh[] = "ultraHigh";
-// TODO static constexpr char kResolutionPresetValueMax[] = "max";
-
 static std::unique_ptr<libcamera::CameraManager> g_camera_manager;
 static std::vector<std::shared_ptr<CameraContext>> g_cameras;
 
@@ -233,7 +226,7 @@ void CameraPlugin::takePicture(
   }
 
   auto camera = g_cameras[static_cast<unsigned long>(cameraId - 1)];
-  result(camera->takePicture());
+  camera->takePicture(std::move(result));
 }
 
 void CameraPlugin::startVideoRecording(
@@ -256,9 +249,7 @@ void CameraPlugin::startVideoRecording(
   }
 
   auto camera = g_cameras[static_cast<unsigned long>(cameraId - 1)];
-  camera->startVideoRecording(enableStream);
-
-  result(std::nullopt);
+  result(camera->startVideoRecording(enableStream));
 }
 
 void CameraPlugin::pauseVideoRecording(
@@ -277,9 +268,7 @@ void CameraPlugin::pauseVideoRecording(
   }
 
   auto camera = g_cameras[static_cast<unsigned long>(cameraId - 1)];
-  camera->pauseVideoRecording();
-
-  result(std::nullopt);
+  result(camera->pauseVideoRecording());
 }
 
 void CameraPlugin::resumeVideoRecording(
@@ -298,9 +287,7 @@ void CameraPlugin::resumeVideoRecording(
   }
 
   auto camera = g_cameras[static_cast<unsigned long>(cameraId - 1)];
-  camera->resumeVideoRecording();
-
-  result(std::nullopt);
+  result(camera->resumeVideoRecording());
 }
 
 void CameraPlugin::stopVideoRecording(
@@ -322,6 +309,49 @@ void CameraPlugin::stopVideoRecording(
   result(camera->stopVideoRecording());
 }
 
+void CameraPlugin::startImageStream(
+    const flutter::EncodableMap& args,
+    std::function<void(std::optional<FlutterError> reply)> result) {
+  plugin_common::Encodable::PrintFlutterEncodableMap("startImageStream", args);
+  // method arguments
+  int32_t cameraId = 0;
+  double maxFrameRate = 0;
+
+  for (auto& it : args) {
+    auto key = std::get<std::string>(it.first);
+    if (key == "cameraId" && std::holds_alternative<int32_t>(it.second)) {
+      cameraId = std::get<int32_t>(it.second);
+    } else if (key == "maxFrameRate" &&
+               std::holds_alternative<double>(it.second)) {
+      maxFrameRate = std::get<double>(it.second);
+    } else if (key == "maxFrameRate" &&
+               std::holds_alternative<int32_t>(it.second)) {
+      maxFrameRate = std::get<int32_t>(it.second);
+    }
+  }
+
+  auto camera = g_cameras[static_cast<unsigned long>(cameraId - 1)];
+  result(camera->startImageStream(maxFrameRate));
+}
+
+void CameraPlugin::stopImageStream(
+    const flutter::EncodableMap& args,
+    std::function<void(std::optional<FlutterError> reply)> result) {
+  plugin_common::Encodable::PrintFlutterEncodableMap("stopImageStream", args);
+  // method arguments
+  int32_t cameraId = 0;
+
+  for (auto& it : args) {
+    auto key = std::get<std::string>(it.first);
+    if (key == "cameraId" && std::holds_alternative<int32_t>(it.second)) {
+      cameraId = std::get<int32_t>(it.second);
+    }
+  }
+
+  auto camera = g_cameras[static_cast<unsigned long>(cameraId - 1)];
+  result(camera->stopImageStream());
+}
+
 void CameraPlugin::pausePreview(
     const flutter::EncodableMap& args,
     std::function<void(ErrorOr<double> reply)> result) {
@@ -337,6 +367,7 @@ void CameraPlugin::pausePreview(
 
   auto camera = g_cameras[static_cast<unsigned long>(cameraId - 1)];
   SPDLOG_DEBUG("[camera_plugin] pausePreview: camera_id: {}", cameraId);
+  camera->setPreviewPaused(true);
   result(1);
 }
 
@@ -355,6 +386,7 @@ void CameraPlugin::resumePreview(
 
   auto camera = g_cameras[static_cast<unsigned long>(cameraId - 1)];
   SPDLOG_DEBUG("[camera_plugin] resumePreview: camera_id: {}", cameraId);
+  camera->setPreviewPaused(false);
   result(1);
 }
 
@@ -63,6 +63,12 @@ class CameraPlugin final : public flutter::Plugin, public CameraApi {
   void stopVideoRecording(
       const flutter::EncodableMap& args,
       std::function<void(ErrorOr<std::string> reply)> result) override;
+  void startImageStream(
+      const flutter::EncodableMap& args,
+      std::function<void(std::optional<FlutterError> reply)> result) override;
+  void stopImageStream(
+      const flutter::EncodableMap& args,
+      std::function<void(std::optional<FlutterError> reply)> result) override;
   void pausePreview(const flutter::EncodableMap& args,
                     std::function<void(ErrorOr<double> reply)> result) override;
   void resumePreview(
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "encoder_registry.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <plugins/common/common.h>
+
+namespace camera_plugin {
+
+EncoderRegistry::EncoderRegistry() {
+  GList* encoders = gst_element_factory_list_get_elements(
+      GST_ELEMENT_FACTORY_TYPE_ENCODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+      GST_RANK_NONE);
+  for (GList* l = encoders; l != nullptr; l = l->next) {
+    auto factory = GST_ELEMENT_FACTORY(gst_object_ref(l->data));
+    candidates_.push_back(
+        {factory, Classify(factory),
+         gst_plugin_feature_get_rank(GST_PLUGIN_FEATURE(factory))});
+  }
+  gst_plugin_feature_list_free(encoders);
+
+  std::stable_sort(candidates_.begin(), candidates_.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     if (a.tier != b.tier) {
+                       return a.tier > b.tier;
+                     }
+                     return a.rank > b.rank;
+                   });
+
+  SPDLOG_DEBUG("[camera_plugin] {} video encoders", candidates_.size());
+}
+
+EncoderRegistry::~EncoderRegistry() {
+  for (auto& candidate : candidates_) {
+    gst_object_unref(candidate.factory);
+  }
+}
+
+EncoderRegistry::Tier EncoderRegistry::Classify(GstElementFactory* factory) {
+  const std::string name = GST_OBJECT_NAME(factory);
+  const gchar* klass =
+      gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
+
+  // Encoders rank NONE or MARGINAL, so hardware is recognised by name too.
+  if ((klass && strstr(klass, "Hardware")) || name.rfind("va", 0) == 0 ||
+      name.rfind("v4l2", 0) == 0 || name.rfind("omx", 0) == 0 ||
+      name.rfind("msdk", 0) == 0) {
+    return Tier::kHardware;
+  }
+  return Tier::kSoftware;
+}
+
+bool EncoderRegistry::Validate(GstElementFactory* factory) {
+  GstElement* element = gst_element_factory_create(factory, nullptr);
+  if (!element) {
+    return false;
+  }
+  gst_object_ref_sink(element);
+  const GstStateChangeReturn ret =
+      gst_element_set_state(element, GST_STATE_READY);
+  gst_element_set_state(element, GST_STATE_NULL);
+  gst_object_unref(element);
+  return ret != GST_STATE_CHANGE_FAILURE;
+}
+
+GstElementFactory* EncoderRegistry::Select(const std::string& caps) {
+  GstCaps* src_caps = gst_caps_from_string(caps.c_str());
+  if (!src_caps) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  GstElementFactory* selected = nullptr;
+  for (const auto& candidate : candidates_) {
+    const std::string name = GST_OBJECT_NAME(candidate.factory);
+    if (failed_.count(name) ||
+        !gst_element_factory_can_src_any_caps(candidate.factory, src_caps)) {
+      continue;
+    }
+    auto it = validated_.find(name);
+    if (it == validated_.end()) {
+      it = validated_.emplace(name, Validate(candidate.factory)).first;
+      SPDLOG_DEBUG("[camera_plugin] encoder {}: {}", name,
+                   it->second ? "usable" : "unusable");
+    }
+    if (!it->second) {
+      continue;
+    }
+    selected = GST_ELEMENT_FACTORY(gst_object_ref(candidate.factory));
+    break;
+  }
+  gst_caps_unref(src_caps);
+  return selected;
+}
+
+void EncoderRegistry::MarkFailed(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  spdlog::warn("[camera_plugin] encoder {} failed, falling back", name);
+  failed_.insert(name);
+}
+
+}  // namespace camera_plugin
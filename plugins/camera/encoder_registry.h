@@ -0,0 +1,94 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FLUTTER_PLUGIN_CAMERA_ENCODER_REGISTRY_H_
+#define FLUTTER_PLUGIN_CAMERA_ENCODER_REGISTRY_H_
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <gst/gst.h>
+}
+
+namespace camera_plugin {
+
+/**
+ * H.264 encoders available on the system, ranked hardware first.
+ *
+ * Factories are enumerated once.  The first time a factory is selected an
+ * instance is brought to READY, which opens the VA display or V4L2 device of
+ * hardware encoders; factories that fail there, or later fail while
+ * recording, are not selected again.  x264enc and openh264enc remain as
+ * software fallback.
+ */
+class EncoderRegistry {
+ public:
+  enum class Tier {
+    kSoftware = 0,
+    kHardware = 1,
+  };
+
+  EncoderRegistry();
+  ~EncoderRegistry();
+
+  // Prevent copying.
+  EncoderRegistry(EncoderRegistry const&) = delete;
+  EncoderRegistry& operator=(EncoderRegistry const&) = delete;
+
+  /**
+   * @brief Select the best usable encoder producing caps
+   * @param[in] caps Caps of the encoded stream
+   * @return GstElementFactory*
+   * @retval Encoder factory, caller owns the reference
+   * @retval nullptr No usable encoder
+   * @relation
+   * gstreamer
+   */
+  GstElementFactory* Select(const std::string& caps);
+
+  /**
+   * @brief Exclude an encoder after it failed at runtime
+   * @param[in] name Name of the encoder factory that failed
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void MarkFailed(const std::string& name);
+
+ private:
+  struct Candidate {
+    GstElementFactory* factory;
+    Tier tier;
+    guint rank;
+  };
+
+  std::mutex mutex_;
+  std::vector<Candidate> candidates_;
+  // Factory name -> passed validation
+  std::map<std::string, bool> validated_;
+  std::set<std::string> failed_;
+
+  static Tier Classify(GstElementFactory* factory);
+
+  static bool Validate(GstElementFactory* factory);
+};
+
+}  // namespace camera_plugin
+
+#endif  // FLUTTER_PLUGIN_CAMERA_ENCODER_REGISTRY_H_
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_sink.h"
+
+#include <cstring>
+
+#include <plugins/common/common.h>
+
+namespace camera_plugin {
+
+namespace {
+
+// Formats whose memory layout is R, G, B, A/X and upload without conversion.
+bool IsRgbaLayout(const libcamera::PixelFormat& format) {
+  return format == libcamera::formats::ABGR8888 ||
+         format == libcamera::formats::XBGR8888;
+}
+
+bool HasPaddingAlpha(const libcamera::PixelFormat& format) {
+  return format == libcamera::formats::XBGR8888 ||
+         format == libcamera::formats::XRGB8888;
+}
+
+}  // namespace
+
+const std::vector<libcamera::PixelFormat>& FrameSink::SupportedFormats() {
+  static const std::vector<libcamera::PixelFormat> formats = {
+      libcamera::formats::ABGR8888, libcamera::formats::XBGR8888,
+      libcamera::formats::ARGB8888, libcamera::formats::XRGB8888,
+      libcamera::formats::BGR888,   libcamera::formats::RGB888,
+  };
+  return formats;
+}
+
+FrameSink::FrameSink(GLuint texture,
+                     const libcamera::StreamConfiguration& config)
+    : texture_(texture),
+      width_(static_cast<GLsizei>(config.size.width)),
+      height_(static_cast<GLsizei>(config.size.height)),
+      stride_(config.stride),
+      format_(config.pixelFormat) {
+  if (HasPaddingAlpha(format_)) {
+    // The padding byte is undefined; the preview must stay opaque.
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_ONE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+#if defined(ENABLE_DMABUF)
+  const EGLDisplay display = eglGetCurrentDisplay();
+  const char* egl_extensions =
+      display != EGL_NO_DISPLAY ? eglQueryString(display, EGL_EXTENSIONS)
+                                : nullptr;
+  const auto gl_extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (egl_extensions &&
+      strstr(egl_extensions, "EGL_EXT_image_dma_buf_import") &&
+      gl_extensions && strstr(gl_extensions, "GL_OES_EGL_image")) {
+    display_ = display;
+    create_image_ = reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(
+        eglGetProcAddress("eglCreateImageKHR"));
+    destroy_image_ = reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(
+        eglGetProcAddress("eglDestroyImageKHR"));
+    image_target_texture_ =
+        reinterpret_cast<PFNGLEGLIMAGETARGETTEXTURE2DOESPROC>(
+            eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+  }
+  import_failed_ = !create_image_ || !destroy_image_ || !image_target_texture_;
+  spdlog::debug("[camera_plugin] FrameSink: {}x{} {} stride {}, {}", width_,
+                height_, format_.toString(), stride_,
+                import_failed_ ? "upload" : "dmabuf import");
+#else
+  spdlog::debug("[camera_plugin] FrameSink: {}x{} {} stride {}, upload",
+                width_, height_, format_.toString(), stride_);
+#endif
+}
+
+FrameSink::~FrameSink() {
+#if defined(ENABLE_DMABUF)
+  for (const auto& [buffer, image] : images_) {
+    destroy_image_(display_, image);
+  }
+#endif
+}
+
+bool FrameSink::Present(const libcamera::FrameBuffer* buffer) {
+#if defined(ENABLE_DMABUF)
+  if (!import_failed_) {
+    if (Import(buffer)) {
+      return true;
+    }
+    // Drivers reject formats or layouts per device; do not retry each frame.
+    spdlog::warn("[camera_plugin] dmabuf import failed, uploading frames");
+    import_failed_ = true;
+    // Detach the last imported image so the texture has its own storage.
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_, height_, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+#endif
+  Upload(buffer);
+  return false;
+}
+
+#if defined(ENABLE_DMABUF)
+bool FrameSink::Import(const libcamera::FrameBuffer* buffer) {
+  auto it = images_.find(buffer);
+  if (it == images_.end()) {
+    const auto& plane = buffer->planes()[0];
+    const EGLint attributes[] = {
+        EGL_WIDTH,
+        width_,
+        EGL_HEIGHT,
+        height_,
+        EGL_LINUX_DRM_FOURCC_EXT,
+        static_cast<EGLint>(format_.fourcc()),
+        EGL_DMA_BUF_PLANE0_FD_EXT,
+        plane.fd.get(),
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+        static_cast<EGLint>(plane.offset),
+        EGL_DMA_BUF_PLANE0_PITCH_EXT,
+        static_cast<EGLint>(stride_),
+        EGL_NONE,
+    };
+    EGLImageKHR image = create_image_(display_, EGL_NO_CONTEXT,
+                                      EGL_LINUX_DMA_BUF_EXT, nullptr,
+                                      attributes);
+    if (image == EGL_NO_IMAGE_KHR) {
+      SPDLOG_DEBUG("[camera_plugin] eglCreateImageKHR: 0x{:X}", eglGetError());
+      return false;
+    }
+    it = images_.emplace(buffer, image).first;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  image_target_texture_(GL_TEXTURE_2D, it->second);
+  const bool bound = glGetError() == GL_NO_ERROR;
+  glBindTexture(GL_TEXTURE_2D, 0);
+  // Make the new binding visible to the raster context.
+  glFlush();
+  return bound;
+}
+#endif
+
+void FrameSink::Upload(const libcamera::FrameBuffer* buffer) {
+  auto& mapping = mappings_[buffer];
+  if (!mapping) {
+    mapping = std::make_unique<MappedBuffer>(buffer);
+  }
+  const uint8_t* src = mapping->data();
+  if (!src) {
+    return;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  if (IsRgbaLayout(format_)) {
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride_ / 4));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA,
+                    GL_UNSIGNED_BYTE, src);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  } else {
+    // Byte offsets of R, G and B in a source pixel; alpha is set opaque.
+    size_t bpp = 4, r = 2, g = 1, b = 0;
+    if (format_ == libcamera::formats::BGR888) {
+      bpp = 3;
+      r = 0;
+      b = 2;
+    } else if (format_ == libcamera::formats::RGB888) {
+      bpp = 3;
+    }
+    const auto width = static_cast<size_t>(width_);
+    staging_.resize(width * static_cast<size_t>(height_) * 4);
+    uint8_t* dst = staging_.data();
+    for (GLsizei y = 0; y < height_; y++) {
+      const uint8_t* row = src + static_cast<size_t>(y) * stride_;
+      for (size_t x = 0; x < width; x++, row += bpp, dst += 4) {
+        dst[0] = row[r];
+        dst[1] = row[g];
+        dst[2] = row[b];
+        dst[3] = 0xFF;
+      }
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA,
+                    GL_UNSIGNED_BYTE, staging_.data());
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+}  // namespace camera_plugin
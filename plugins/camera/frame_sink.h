@@ -0,0 +1,105 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FLUTTER_PLUGIN_CAMERA_FRAME_SINK_H_
+#define FLUTTER_PLUGIN_CAMERA_FRAME_SINK_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#if defined(ENABLE_DMABUF)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2ext.h>
+#endif
+#include <GLES3/gl3.h>
+
+#include <libcamera/libcamera.h>
+
+#include "mapped_buffer.h"
+
+namespace camera_plugin {
+
+/**
+ * Puts completed libcamera buffers into the preview texture.
+ *
+ * Buffers from the FrameBufferAllocator are dmabufs.  When EGL can import
+ * them, every buffer gets one EGLImage, created on first use and rebound to
+ * the texture for each frame, so nothing is copied.  Otherwise the buffer is
+ * mapped once and uploaded, converting to RGBA where the layout differs.
+ *
+ * All methods need the GL context of the texture to be current.
+ */
+class FrameSink {
+ public:
+  /**
+   * @brief Create a sink for a configured stream
+   * @param[in] texture Preview texture
+   * @param[in] config Validated configuration of the stream
+   * @relation
+   * libcamera, flutter
+   */
+  FrameSink(GLuint texture, const libcamera::StreamConfiguration& config);
+  ~FrameSink();
+
+  // Prevent copying.
+  FrameSink(FrameSink const&) = delete;
+  FrameSink& operator=(FrameSink const&) = delete;
+
+  // Pixel formats the preview can show, in order of preference.
+  static const std::vector<libcamera::PixelFormat>& SupportedFormats();
+
+  /**
+   * @brief Show a buffer in the texture
+   * @param[in] buffer Completed buffer of the stream
+   * @return bool
+   * @retval true The texture references the buffer; it must not be queued
+   * again before the next buffer was presented
+   * @retval false The buffer was copied and can be queued right away
+   * @relation
+   * libcamera, flutter
+   */
+  bool Present(const libcamera::FrameBuffer* buffer);
+
+ private:
+  GLuint texture_;
+  GLsizei width_;
+  GLsizei height_;
+  unsigned int stride_;
+  libcamera::PixelFormat format_;
+  // RGBA copy for layouts GL cannot upload directly
+  std::vector<uint8_t> staging_;
+  std::map<const libcamera::FrameBuffer*, std::unique_ptr<MappedBuffer>>
+      mappings_;
+
+#if defined(ENABLE_DMABUF)
+  EGLDisplay display_{EGL_NO_DISPLAY};
+  PFNEGLCREATEIMAGEKHRPROC create_image_{};
+  PFNEGLDESTROYIMAGEKHRPROC destroy_image_{};
+  PFNGLEGLIMAGETARGETTEXTURE2DOESPROC image_target_texture_{};
+  std::map<const libcamera::FrameBuffer*, EGLImageKHR> images_;
+  bool import_failed_{};
+
+  bool Import(const libcamera::FrameBuffer* buffer);
+#endif
+
+  void Upload(const libcamera::FrameBuffer* buffer);
+};
+
+}  // namespace camera_plugin
+
+#endif  // FLUTTER_PLUGIN_CAMERA_FRAME_SINK_H_
@@ -0,0 +1,385 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "image_streamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <plugins/common/common.h>
+#include <plugins/common/glib/main_loop.h>
+
+namespace camera_plugin {
+
+namespace {
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// BT.601 limited range, as expected by most vision libraries.
+inline uint8_t Luma(int r, int g, int b) {
+  return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+inline uint8_t ChromaU(int r, int g, int b) {
+  return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) +
+                              128);
+}
+
+inline uint8_t ChromaV(int r, int g, int b) {
+  return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// Converts two rows per pass; chroma is the average of each 2x2 block.
+// u and v advance by uv_step, 2 for interleaved NV12 and 1 for I420.
+template <int kBpp, int kR, int kG, int kB>
+void ConvertRgb(const uint8_t* src,
+                unsigned int src_stride,
+                unsigned int width,
+                unsigned int height,
+                uint8_t* y,
+                unsigned int y_stride,
+                uint8_t* u,
+                uint8_t* v,
+                unsigned int uv_stride,
+                unsigned int uv_step) {
+  for (unsigned int row = 0; row < height; row += 2) {
+    const bool pair = row + 1 < height;
+    const uint8_t* s0 = src + static_cast<size_t>(row) * src_stride;
+    const uint8_t* s1 = pair ? s0 + src_stride : s0;
+    uint8_t* y0 = y + static_cast<size_t>(row) * y_stride;
+    uint8_t* y1 = y0 + y_stride;
+    uint8_t* u_row = u + static_cast<size_t>(row / 2) * uv_stride;
+    uint8_t* v_row = v + static_cast<size_t>(row / 2) * uv_stride;
+
+    for (unsigned int col = 0; col < width; col += 2) {
+      const unsigned int next = col + 1 < width ? col + 1 : col;
+      const uint8_t* p[4] = {s0 + col * kBpp, s0 + next * kBpp,
+                             s1 + col * kBpp, s1 + next * kBpp};
+      int r = 0;
+      int g = 0;
+      int b = 0;
+      for (int i = 0; i < 4; i++) {
+        r += p[i][kR];
+        g += p[i][kG];
+        b += p[i][kB];
+      }
+
+      y0[col] = Luma(p[0][kR], p[0][kG], p[0][kB]);
+      if (next != col) {
+        y0[next] = Luma(p[1][kR], p[1][kG], p[1][kB]);
+      }
+      if (pair) {
+        y1[col] = Luma(p[2][kR], p[2][kG], p[2][kB]);
+        if (next != col) {
+          y1[next] = Luma(p[3][kR], p[3][kG], p[3][kB]);
+        }
+      }
+
+      r = (r + 2) >> 2;
+      g = (g + 2) >> 2;
+      b = (b + 2) >> 2;
+      u_row[(col / 2) * uv_step] = ChromaU(r, g, b);
+      v_row[(col / 2) * uv_step] = ChromaV(r, g, b);
+    }
+  }
+}
+
+unsigned int ChromaWidth(unsigned int width) {
+  return (width + 1) / 2;
+}
+
+unsigned int ChromaHeight(unsigned int height) {
+  return (height + 1) / 2;
+}
+
+}  // namespace
+
+ImageStreamer::ImageStreamer(flutter::BinaryMessenger* messenger,
+                             std::string channel,
+                             unsigned int width,
+                             unsigned int height,
+                             unsigned int stride,
+                             const libcamera::PixelFormat& format,
+                             Layout layout,
+                             double max_rate)
+    : width_(width),
+      height_(height),
+      stride_(stride),
+      format_(format),
+      layout_(layout),
+      min_interval_ns_(max_rate > 0 ? static_cast<int64_t>(1e9 / max_rate)
+                                    : 0),
+      shared_(std::make_shared<Shared>()) {
+  shared_->messenger = messenger;
+  shared_->channel = std::move(channel);
+  for (auto& message : shared_->pool) {
+    message.resize(MessageSize(width, height, layout));
+  }
+  worker_ = std::thread(&ImageStreamer::Run, this);
+
+  spdlog::debug("[camera_plugin] image stream {}x{} {} on {}, max {} fps",
+                width, height, layout == Layout::kNV12 ? "NV12" : "I420",
+                shared_->channel, max_rate);
+}
+
+ImageStreamer::~ImageStreamer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+  }
+  cv_.notify_one();
+  worker_.join();
+
+  uint64_t delivered;
+  double fps = 0;
+  {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    shared_->closed = true;
+    delivered = shared_->delivered;
+    if (delivered > 1) {
+      fps = static_cast<double>(delivered - 1) * 1e9 /
+            static_cast<double>(shared_->last_delivery_ns -
+                                shared_->first_delivery_ns);
+    }
+  }
+  spdlog::debug(
+      "[camera_plugin] image stream: {} offered, {} delivered ({:.1f} fps), "
+      "{} skipped by rate, {} skipped while Dart was busy, {} us average "
+      "conversion",
+      offered_, delivered, fps, skipped_rate_, skipped_busy_,
+      converted_ ? convert_us_ / static_cast<int64_t>(converted_) : 0);
+}
+
+bool ImageStreamer::IsSupported(const libcamera::PixelFormat& format) {
+  return format == libcamera::formats::ABGR8888 ||
+         format == libcamera::formats::XBGR8888 ||
+         format == libcamera::formats::ARGB8888 ||
+         format == libcamera::formats::XRGB8888 ||
+         format == libcamera::formats::BGR888 ||
+         format == libcamera::formats::RGB888;
+}
+
+size_t ImageStreamer::MessageSize(unsigned int width,
+                                  unsigned int height,
+                                  Layout /* layout */) {
+  // Both layouts carry one byte of U and V per 2x2 block.
+  return sizeof(Header) + static_cast<size_t>(width) * height +
+         static_cast<size_t>(ChromaWidth(width)) * 2 * ChromaHeight(height);
+}
+
+void ImageStreamer::Convert(const uint8_t* src,
+                            unsigned int src_stride,
+                            const libcamera::PixelFormat& format,
+                            unsigned int width,
+                            unsigned int height,
+                            Layout layout,
+                            uint8_t* dst) {
+  uint8_t* y = dst + sizeof(Header);
+  uint8_t* chroma = y + static_cast<size_t>(width) * height;
+  const unsigned int cw = ChromaWidth(width);
+  const unsigned int ch = ChromaHeight(height);
+
+  uint8_t* u;
+  uint8_t* v;
+  unsigned int uv_stride;
+  unsigned int uv_step;
+  if (layout == Layout::kNV12) {
+    u = chroma;
+    v = chroma + 1;
+    uv_stride = cw * 2;
+    uv_step = 2;
+  } else {
+    u = chroma;
+    v = chroma + static_cast<size_t>(cw) * ch;
+    uv_stride = cw;
+    uv_step = 1;
+  }
+
+  // DRM fourccs name the components from the most significant byte.
+  if (format == libcamera::formats::ABGR8888 ||
+      format == libcamera::formats::XBGR8888) {
+    ConvertRgb<4, 0, 1, 2>(src, src_stride, width, height, y, width, u, v,
+                           uv_stride, uv_step);
+  } else if (format == libcamera::formats::ARGB8888 ||
+             format == libcamera::formats::XRGB8888) {
+    ConvertRgb<4, 2, 1, 0>(src, src_stride, width, height, y, width, u, v,
+                           uv_stride, uv_step);
+  } else if (format == libcamera::formats::BGR888) {
+    ConvertRgb<3, 0, 1, 2>(src, src_stride, width, height, y, width, u, v,
+                           uv_stride, uv_step);
+  } else if (format == libcamera::formats::RGB888) {
+    ConvertRgb<3, 2, 1, 0>(src, src_stride, width, height, y, width, u, v,
+                           uv_stride, uv_step);
+  }
+
+  Header header{};
+  header.width = width;
+  header.height = height;
+  header.strides[0] = width;
+  if (layout == Layout::kNV12) {
+    header.fourcc = libcamera::formats::NV12.fourcc();
+    header.plane_count = 2;
+    header.strides[1] = uv_stride;
+  } else {
+    header.fourcc = libcamera::formats::YUV420.fourcc();
+    header.plane_count = 3;
+    header.strides[1] = uv_stride;
+    header.strides[2] = uv_stride;
+  }
+  memcpy(dst, &header, sizeof(header));
+}
+
+bool ImageStreamer::Push(const uint8_t* data,
+                         int64_t timestamp_ns,
+                         std::function<void()> release) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto sequence = static_cast<uint32_t>(offered_++);
+  if (exit_) {
+    return false;
+  }
+  // Small tolerance, so sensor jitter does not skip every other frame at a
+  // limit equal to the capture rate.
+  if (accepted_any_ &&
+      timestamp_ns - last_accepted_ns_ < min_interval_ns_ * 7 / 8) {
+    skipped_rate_++;
+    return false;
+  }
+
+  int slot = -1;
+  if (!job_) {
+    std::lock_guard<std::mutex> shared_lock(shared_->mutex);
+    // A converted frame waits for Dart, a newer one would only replace it.
+    if (shared_->ready < 0) {
+      for (size_t i = 0; i < kPoolSize; i++) {
+        if (!shared_->busy[i]) {
+          shared_->busy[i] = true;
+          slot = static_cast<int>(i);
+          break;
+        }
+      }
+    }
+  }
+  if (slot < 0) {
+    skipped_busy_++;
+    return false;
+  }
+
+  accepted_any_ = true;
+  last_accepted_ns_ = timestamp_ns;
+  job_ = Job{slot, sequence, data, timestamp_ns, std::move(release)};
+  cv_.notify_one();
+  return true;
+}
+
+void ImageStreamer::Run() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return exit_ || job_.has_value(); });
+      if (exit_) {
+        if (job_) {
+          job_->release();
+          job_.reset();
+        }
+        return;
+      }
+      job = std::move(job_.value());
+    }
+
+    const int64_t start = NowNs();
+    uint8_t* message = shared_->pool[static_cast<size_t>(job.slot)].data();
+    Convert(job.data, stride_, format_, width_, height_, layout_, message);
+    job.release();
+
+    auto* header = reinterpret_cast<Header*>(message);
+    header->sequence = job.sequence;
+    header->timestamp_ns = job.timestamp_ns;
+
+    int send = -1;
+    {
+      std::lock_guard<std::mutex> lock(shared_->mutex);
+      if (shared_->in_dart < 0) {
+        shared_->in_dart = job.slot;
+        send = job.slot;
+      } else {
+        shared_->ready = job.slot;
+      }
+    }
+
+    {
+      // Cleared last, Push() starts the next job once job_ is empty.
+      std::lock_guard<std::mutex> lock(mutex_);
+      convert_us_ += (NowNs() - start) / 1000;
+      converted_++;
+      job_.reset();
+    }
+
+    if (send >= 0) {
+      Send(shared_, send);
+    }
+  }
+}
+
+void ImageStreamer::Send(const std::shared_ptr<Shared>& shared, int slot) {
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    const int64_t now = NowNs();
+    if (shared->delivered++ == 0) {
+      shared->first_delivery_ns = now;
+    }
+    shared->last_delivery_ns = now;
+  }
+  // Sent from the main loop rather than the worker.  The slot is not
+  // written again before Dart replied.
+  plugin_common_glib::MainLoop::Post([shared, slot] {
+    const auto& message = shared->pool[static_cast<size_t>(slot)];
+    shared->messenger->Send(
+        shared->channel, message.data(), message.size(),
+        [shared, slot](const uint8_t* /* reply */, size_t /* reply_size */) {
+          OnConsumed(shared, slot);
+        });
+  });
+}
+
+void ImageStreamer::OnConsumed(const std::shared_ptr<Shared>& shared,
+                               int slot) {
+  int send = -1;
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->busy[static_cast<size_t>(slot)] = false;
+    shared->in_dart = -1;
+    if (shared->ready >= 0) {
+      if (shared->closed) {
+        shared->busy[static_cast<size_t>(shared->ready)] = false;
+      } else {
+        shared->in_dart = shared->ready;
+        send = shared->ready;
+      }
+      shared->ready = -1;
+    }
+  }
+  if (send >= 0) {
+    Send(shared, send);
+  }
+}
+
+}  // namespace camera_plugin
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FLUTTER_PLUGIN_CAMERA_IMAGE_STREAMER_H_
+#define FLUTTER_PLUGIN_CAMERA_IMAGE_STREAMER_H_
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <flutter/binary_messenger.h>
+
+#include <libcamera/libcamera.h>
+
+namespace camera_plugin {
+
+/**
+ * Delivers camera frames as YUV 4:2:0 over a binary message channel.
+ *
+ * Each message is a Header followed by the planes, tightly packed.  Frames
+ * are converted straight into one of kPoolSize preallocated messages, which
+ * is the only copy made by the plugin; the engine copies the message once
+ * more into the Dart heap.  Dart acknowledges a frame by replying to the
+ * message.  While a frame waits for that reply and the next one is being
+ * converted, further frames are skipped, as are frames arriving faster than
+ * the maximum rate.
+ */
+class ImageStreamer {
+ public:
+  // One frame with Dart, one being converted.
+  static constexpr size_t kPoolSize = 2;
+
+  enum class Layout {
+    // Y plane, interleaved UV plane
+    kNV12,
+    // Y, U and V planes
+    kI420,
+  };
+
+  // Native byte order, followed by the planes in order.
+  struct Header {
+    // DRM fourcc of the layout, NV12 or YU12
+    uint32_t fourcc;
+    uint32_t width;
+    uint32_t height;
+    uint32_t plane_count;
+    // Bytes per row of each plane, 0 for unused planes
+    uint32_t strides[3];
+    // Number of the camera frame since the stream started, gaps are
+    // skipped frames
+    uint32_t sequence;
+    // Sensor timestamp, CLOCK_MONOTONIC
+    int64_t timestamp_ns;
+  };
+
+  /**
+   * @param[in] messenger Messenger of the engine
+   * @param[in] channel Name of the binary channel
+   * @param[in] width Frame width
+   * @param[in] height Frame height
+   * @param[in] stride Bytes per row of source frames
+   * @param[in] format Pixel format of source frames
+   * @param[in] layout Layout of delivered frames
+   * @param[in] max_rate Frames per second delivered at most, 0 for no limit
+   */
+  ImageStreamer(flutter::BinaryMessenger* messenger,
+                std::string channel,
+                unsigned int width,
+                unsigned int height,
+                unsigned int stride,
+                const libcamera::PixelFormat& format,
+                Layout layout,
+                double max_rate);
+  ~ImageStreamer();
+
+  // Prevent copying.
+  ImageStreamer(ImageStreamer const&) = delete;
+  ImageStreamer& operator=(ImageStreamer const&) = delete;
+
+  // Whether frames of this format can be streamed.
+  static bool IsSupported(const libcamera::PixelFormat& format);
+
+  /**
+   * @brief Offer a captured frame
+   * @param[in] data Mapped source frame
+   * @param[in] timestamp_ns Sensor timestamp of the frame
+   * @param[in] release Called once data is no longer read
+   * @return bool
+   * @retval true Frame is converted, release will be called
+   * @retval false Frame was skipped, release is not called
+   * @relation
+   * libcamera
+   */
+  bool Push(const uint8_t* data,
+            int64_t timestamp_ns,
+            std::function<void()> release);
+
+  const std::string& channel() const { return shared_->channel; }
+
+  /**
+   * @brief Convert a frame into a message buffer
+   * @param[in] src Source frame
+   * @param[in] src_stride Bytes per row of src
+   * @param[in] format Pixel format of src
+   * @param[in] width Frame width
+   * @param[in] height Frame height
+   * @param[in] layout Layout of the destination
+   * @param[out] dst Message, Header included
+   * @return void
+   * @relation
+   * libcamera
+   */
+  static void Convert(const uint8_t* src,
+                      unsigned int src_stride,
+                      const libcamera::PixelFormat& format,
+                      unsigned int width,
+                      unsigned int height,
+                      Layout layout,
+                      uint8_t* dst);
+
+  // Size of a message, Header included.
+  static size_t MessageSize(unsigned int width,
+                            unsigned int height,
+                            Layout layout);
+
+ private:
+  // State shared with replies from Dart, which may arrive after the
+  // streamer is gone.
+  struct Shared {
+    flutter::BinaryMessenger* messenger;
+    std::string channel;
+    std::mutex mutex;
+    std::array<std::vector<uint8_t>, kPoolSize> pool;
+    std::array<bool, kPoolSize> busy{};
+    // Slot waiting for Dart to reply, -1 for none
+    int in_dart = -1;
+    // Converted slot waiting for in_dart to be released, -1 for none
+    int ready = -1;
+    bool closed{};
+
+    uint64_t delivered{};
+    int64_t first_delivery_ns{};
+    int64_t last_delivery_ns{};
+  };
+
+  struct Job {
+    int slot;
+    uint32_t sequence;
+    const uint8_t* data;
+    int64_t timestamp_ns;
+    std::function<void()> release;
+  };
+
+  unsigned int width_;
+  unsigned int height_;
+  unsigned int stride_;
+  libcamera::PixelFormat format_;
+  Layout layout_;
+  int64_t min_interval_ns_;
+
+  std::shared_ptr<Shared> shared_;
+
+  // Hands jobs to the worker, guards the counters below
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::optional<Job> job_;
+  bool exit_{};
+  int64_t last_accepted_ns_{};
+  bool accepted_any_{};
+  uint64_t offered_{};
+  uint64_t skipped_rate_{};
+  uint64_t skipped_busy_{};
+  int64_t convert_us_{};
+  uint64_t converted_{};
+
+  // Started last, after the members it uses.
+  std::thread worker_;
+
+  void Run();
+
+  // Hand slot to Dart, called without the shared lock held.
+  static void Send(const std::shared_ptr<Shared>& shared, int slot);
+
+  // Dart replied to the message of slot.
+  static void OnConsumed(const std::shared_ptr<Shared>& shared, int slot);
+};
+
+}  // namespace camera_plugin
+
+#endif  // FLUTTER_PLUGIN_CAMERA_IMAGE_STREAMER_H_
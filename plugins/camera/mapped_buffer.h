@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FLUTTER_PLUGIN_CAMERA_MAPPED_BUFFER_H_
+#define FLUTTER_PLUGIN_CAMERA_MAPPED_BUFFER_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/mman.h>
+
+#include <libcamera/libcamera.h>
+
+#include <plugins/common/common.h>
+
+namespace camera_plugin {
+
+/**
+ * Read-only CPU mapping of the first plane of a capture buffer.  Buffers
+ * live as long as their allocator, so mappings are made once and kept.
+ */
+class MappedBuffer {
+ public:
+  explicit MappedBuffer(const libcamera::FrameBuffer* buffer) {
+    const auto& plane = buffer->planes()[0];
+    length_ = plane.offset + plane.length;
+    address_ =
+        mmap(nullptr, length_, PROT_READ, MAP_SHARED, plane.fd.get(), 0);
+    if (address_ == MAP_FAILED) {
+      spdlog::error("[camera_plugin] Failed to map buffer: {}",
+                    strerror(errno));
+      address_ = nullptr;
+      return;
+    }
+    data_ = static_cast<const uint8_t*>(address_) + plane.offset;
+    size_ = plane.length;
+  }
+
+  ~MappedBuffer() {
+    if (address_) {
+      munmap(address_, length_);
+    }
+  }
+
+  // Prevent copying.
+  MappedBuffer(MappedBuffer const&) = delete;
+  MappedBuffer& operator=(MappedBuffer const&) = delete;
+
+  // nullptr when mapping failed
+  const uint8_t* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+ private:
+  void* address_{};
+  size_t length_{};
+  const uint8_t* data_{};
+  size_t size_{};
+};
+
+}  // namespace camera_plugin
+
+#endif  // FLUTTER_PLUGIN_CAMERA_MAPPED_BUFFER_H_
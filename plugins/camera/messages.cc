@@ -25,6 +25,7 @@
 #include <flutter/method_channel.h>
 #include <flutter/standard_method_codec.h>
 
+#include <memory>
 #include <optional>
 
 #include "camera_plugin.h"
@@ -93,8 +94,11 @@ void CameraApi::SetUp(flutter::BinaryMessenger* binary_messenger,
             });
       } else if (methodCall.method_name() == "takePicture") {
         const auto& args = std::get_if<EncodableMap>(methodCall.arguments());
+        // Answered from the encoder thread once the file is written.
         api->takePicture(
-            *args, [reply = result.get()](ErrorOr<std::string>&& output) {
+            *args,
+            [reply = std::shared_ptr<MethodResult<EncodableValue>>(
+                 std::move(result))](ErrorOr<std::string>&& output) {
               if (output.has_error()) {
                 reply->Error(output.error().code(), output.error().message(),
                              output.error().details());
@@ -149,6 +153,30 @@ void CameraApi::SetUp(flutter::BinaryMessenger* binary_messenger,
               }
               reply->Success(EncodableValue(std::move(output).TakeValue()));
             });
+      } else if (methodCall.method_name() == "startImageStream") {
+        const auto& args = std::get_if<EncodableMap>(methodCall.arguments());
+        api->startImageStream(
+            *args,
+            [reply = result.get()](std::optional<FlutterError>&& output) {
+              if (output.has_value()) {
+                reply->Error(output.value().code(), output.value().message(),
+                             output.value().details());
+                return;
+              }
+              reply->Success();
+            });
+      } else if (methodCall.method_name() == "stopImageStream") {
+        const auto& args = std::get_if<EncodableMap>(methodCall.arguments());
+        api->stopImageStream(
+            *args,
+            [reply = result.get()](std::optional<FlutterError>&& output) {
+              if (output.has_value()) {
+                reply->Error(output.value().code(), output.value().message(),
+                             output.value().details());
+                return;
+              }
+              reply->Success();
+            });
       } else if (methodCall.method_name() == "pausePreview") {
         const auto& args = std::get_if<EncodableMap>(methodCall.arguments());
         api->pausePreview(
@@ -99,6 +99,12 @@ class CameraApi {
   virtual void stopVideoRecording(
       const flutter::EncodableMap& args,
       std::function<void(ErrorOr<std::string> reply)> result) = 0;
+  virtual void startImageStream(
+      const flutter::EncodableMap& args,
+      std::function<void(std::optional<FlutterError> reply)> result) = 0;
+  virtual void stopImageStream(
+      const flutter::EncodableMap& args,
+      std::function<void(std::optional<FlutterError> reply)> result) = 0;
   virtual void pausePreview(
       const flutter::EncodableMap& args,
       std::function<void(ErrorOr<double> reply)> result) = 0;
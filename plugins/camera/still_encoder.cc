@@ -0,0 +1,238 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "still_encoder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+
+#if defined(ENABLE_JPEG)
+#include <jpeglib.h>
+#endif
+
+#include <plugins/common/common.h>
+
+namespace camera_plugin {
+
+namespace {
+
+int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+#if defined(ENABLE_JPEG)
+// Input colour space matching the memory layout of a format.  libjpeg-turbo
+// reads BGR and padded layouts directly; plain libjpeg only takes R, G, B.
+std::optional<J_COLOR_SPACE> ColorSpace(const libcamera::PixelFormat& format,
+                                        int* components) {
+  if (format == libcamera::formats::BGR888) {
+    *components = 3;
+    return JCS_RGB;
+  }
+#if defined(JCS_EXTENSIONS)
+  if (format == libcamera::formats::RGB888) {
+    *components = 3;
+    return JCS_EXT_BGR;
+  }
+  if (format == libcamera::formats::ABGR8888 ||
+      format == libcamera::formats::XBGR8888) {
+    *components = 4;
+    return JCS_EXT_RGBX;
+  }
+  if (format == libcamera::formats::ARGB8888 ||
+      format == libcamera::formats::XRGB8888) {
+    *components = 4;
+    return JCS_EXT_BGRX;
+  }
+#endif
+  return std::nullopt;
+}
+
+struct ErrorManager {
+  jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+  char message[JMSG_LENGTH_MAX];
+};
+
+// The default handler calls exit().
+void OnJpegError(j_common_ptr cinfo) {
+  auto* err = reinterpret_cast<ErrorManager*>(cinfo->err);
+  (*cinfo->err->format_message)(cinfo, err->message);
+  longjmp(err->setjmp_buffer, 1);
+}
+#endif
+
+}  // namespace
+
+StillEncoder::StillEncoder() {
+  for (size_t i = 0; i < kWorkers; i++) {
+    workers_.emplace_back(&StillEncoder::Run, this);
+  }
+}
+
+StillEncoder::~StillEncoder() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+  }
+  cv_.notify_all();
+  // Workers finish the queue first; every caller gets its result.
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  if (written_) {
+    spdlog::debug(
+        "[camera_plugin] stills: {} written, {} ms average, {} ms max "
+        "capture to file",
+        written_, latency_us_ / static_cast<int64_t>(written_) / 1000,
+        max_latency_us_ / 1000);
+  }
+}
+
+bool StillEncoder::IsSupported() {
+#if defined(ENABLE_JPEG)
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool StillEncoder::IsSupported(const libcamera::PixelFormat& format) {
+#if defined(ENABLE_JPEG)
+  int components;
+  return ColorSpace(format, &components).has_value();
+#else
+  (void)format;
+  return false;
+#endif
+}
+
+bool StillEncoder::Submit(Job&& job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() >= kMaxQueued) {
+      return false;
+    }
+    queue_.emplace_back(std::move(job));
+  }
+  cv_.notify_one();
+  return true;
+}
+
+size_t StillEncoder::Pending() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size() + active_;
+}
+
+void StillEncoder::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return exit_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      break;
+    }
+    Job job = std::move(queue_.front());
+    queue_.pop_front();
+    active_++;
+    lock.unlock();
+
+    auto error = Encode(job);
+    job.pixels.clear();
+    job.pixels.shrink_to_fit();
+    if (job.release) {
+      job.release();
+    }
+    const int64_t latency = NowUs() - job.requested_at;
+    if (error.has_value()) {
+      spdlog::error("[camera_plugin] Failed to write {}: {}", job.path,
+                    error.value());
+      job.result(FlutterError("IOError", error.value()));
+    } else {
+      SPDLOG_DEBUG("[camera_plugin] {} written {} ms after capture request",
+                   job.path, latency / 1000);
+      job.result(job.path);
+    }
+
+    lock.lock();
+    active_--;
+    if (!error.has_value()) {
+      written_++;
+      latency_us_ += latency;
+      max_latency_us_ = std::max(max_latency_us_, latency);
+    }
+  }
+}
+
+std::optional<std::string> StillEncoder::Encode(const Job& job) {
+#if defined(ENABLE_JPEG)
+  int components = 0;
+  auto color_space = ColorSpace(job.format, &components);
+  if (!color_space.has_value()) {
+    return "unsupported pixel format " + job.format.toString();
+  }
+
+  FILE* file = fopen(job.path.c_str(), "wb");
+  if (!file) {
+    return std::string(strerror(errno));
+  }
+
+  jpeg_compress_struct cinfo{};
+  ErrorManager err{};
+  cinfo.err = jpeg_std_error(&err.pub);
+  err.pub.error_exit = OnJpegError;
+  if (setjmp(err.setjmp_buffer)) {
+    jpeg_destroy_compress(&cinfo);
+    fclose(file);
+    remove(job.path.c_str());
+    return std::string(err.message);
+  }
+
+  jpeg_create_compress(&cinfo);
+  jpeg_stdio_dest(&cinfo, file);
+  cinfo.image_width = job.width;
+  cinfo.image_height = job.height;
+  cinfo.input_components = components;
+  cinfo.in_color_space = color_space.value();
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, kQuality, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+
+  while (cinfo.next_scanline < cinfo.image_height) {
+    auto row = const_cast<JSAMPROW>(job.data + static_cast<size_t>(
+                                                   cinfo.next_scanline) *
+                                                   job.stride);
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  if (fclose(file) != 0) {
+    return std::string(strerror(errno));
+  }
+  return std::nullopt;
+#else
+  (void)job;
+  return "JPEG support not built";
+#endif
+}
+
+}  // namespace camera_plugin
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FLUTTER_PLUGIN_CAMERA_STILL_ENCODER_H_
+#define FLUTTER_PLUGIN_CAMERA_STILL_ENCODER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libcamera/libcamera.h>
+
+#include "messages.h"
+
+namespace camera_plugin {
+
+/**
+ * Encodes captured frames to JPEG files on a small pool of worker threads,
+ * so neither the platform thread nor the libcamera thread waits for the
+ * encoder or the file system.
+ */
+class StillEncoder {
+ public:
+  static constexpr size_t kWorkers = 2;
+  // Frames waiting for a worker; further pictures are refused.
+  static constexpr size_t kMaxQueued = 8;
+  static constexpr int kQuality = 90;
+
+  struct Job {
+    // RGB frame; points into pixels or into a mapped capture buffer
+    const uint8_t* data{};
+    std::vector<uint8_t> pixels;
+    unsigned int width{};
+    unsigned int height{};
+    unsigned int stride{};
+    libcamera::PixelFormat format;
+
+    std::string path;
+    // Time takePicture was called, in microseconds
+    int64_t requested_at{};
+    std::function<void(ErrorOr<std::string> reply)> result;
+    // Called once data is no longer read, before result
+    std::function<void()> release;
+  };
+
+  StillEncoder();
+  ~StillEncoder();
+
+  // Prevent copying.
+  StillEncoder(StillEncoder const&) = delete;
+  StillEncoder& operator=(StillEncoder const&) = delete;
+
+  // Whether JPEG encoding was built in.
+  static bool IsSupported();
+
+  // Whether a job of this format can be encoded.
+  static bool IsSupported(const libcamera::PixelFormat& format);
+
+  /**
+   * @brief Queue a frame for encoding
+   * @param[in] job Frame, destination and completion
+   * @return bool
+   * @retval true Job queued, result will be called from a worker
+   * @retval false Queue is full, job was not taken
+   * @relation
+   * libcamera
+   */
+  bool Submit(Job&& job);
+
+  // Number of jobs queued or being encoded.
+  size_t Pending();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Job> queue_;
+  size_t active_{};
+  bool exit_{};
+
+  uint64_t written_{};
+  int64_t latency_us_{};
+  int64_t max_latency_us_{};
+
+  // Started last, after the members they use.
+  std::vector<std::thread> workers_;
+
+  void Run();
+
+  static std::optional<std::string> Encode(const Job& job);
+};
+
+}  // namespace camera_plugin
+
+#endif  // FLUTTER_PLUGIN_CAMERA_STILL_ENCODER_H_
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "image_streamer.h"
+#include "plugins/common/testing/testing.h"
+
+using camera_plugin::ImageStreamer;
+using Layout = ImageStreamer::Layout;
+
+namespace {
+
+struct Format {
+  libcamera::PixelFormat format;
+  int bpp;
+  // Byte offsets of R, G and B within a pixel
+  int r;
+  int g;
+  int b;
+};
+
+// DRM fourccs name the components from the most significant byte.
+const Format kFormats[] = {
+    {libcamera::formats::ABGR8888, 4, 0, 1, 2},
+    {libcamera::formats::XBGR8888, 4, 0, 1, 2},
+    {libcamera::formats::ARGB8888, 4, 2, 1, 0},
+    {libcamera::formats::XRGB8888, 4, 2, 1, 0},
+    {libcamera::formats::BGR888, 3, 0, 1, 2},
+    {libcamera::formats::RGB888, 3, 2, 1, 0},
+};
+
+// Straightforward BT.601 limited range conversion, one pixel at a time.
+int Luma(int r, int g, int b) {
+  return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+
+int ChromaU(int r, int g, int b) {
+  return ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+}
+
+int ChromaV(int r, int g, int b) {
+  return ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+// Converts src to Y, U and V planes, edge pixels repeated for odd sizes.
+void Reference(const std::vector<uint8_t>& src,
+               unsigned int stride,
+               const Format& f,
+               unsigned int width,
+               unsigned int height,
+               std::vector<uint8_t>& y,
+               std::vector<uint8_t>& u,
+               std::vector<uint8_t>& v) {
+  const unsigned int cw = (width + 1) / 2;
+  const unsigned int ch = (height + 1) / 2;
+  y.assign(width * height, 0);
+  u.assign(cw * ch, 0);
+  v.assign(cw * ch, 0);
+  auto px = [&](unsigned int col, unsigned int row) {
+    return &src[std::min(row, height - 1) * stride +
+                std::min(col, width - 1) * f.bpp];
+  };
+  for (unsigned int row = 0; row < height; row++) {
+    for (unsigned int col = 0; col < width; col++) {
+      const uint8_t* p = px(col, row);
+      y[row * width + col] = Luma(p[f.r], p[f.g], p[f.b]);
+    }
+  }
+  for (unsigned int row = 0; row < ch; row++) {
+    for (unsigned int col = 0; col < cw; col++) {
+      int r = 2, g = 2, b = 2;
+      for (unsigned int i = 0; i < 4; i++) {
+        const uint8_t* p = px(col * 2 + i % 2, row * 2 + i / 2);
+        r += p[f.r];
+        g += p[f.g];
+        b += p[f.b];
+      }
+      r >>= 2;
+      g >>= 2;
+      b >>= 2;
+      u[row * cw + col] = ChromaU(r, g, b);
+      v[row * cw + col] = ChromaV(r, g, b);
+    }
+  }
+}
+
+void TestConvert(const Format& f,
+                 unsigned int width,
+                 unsigned int height,
+                 Layout layout,
+                 std::mt19937& rng) {
+  // Padded rows, as delivered by most pipelines
+  const unsigned int stride = width * f.bpp + 7;
+  std::vector<uint8_t> src(stride * height);
+  for (auto& byte : src) {
+    byte = static_cast<uint8_t>(rng());
+  }
+
+  const size_t size = ImageStreamer::MessageSize(width, height, layout);
+  const unsigned int cw = (width + 1) / 2;
+  const unsigned int ch = (height + 1) / 2;
+  EXPECT(size == sizeof(ImageStreamer::Header) + width * height + cw * ch * 2);
+
+  // Guard byte past the end catches overruns
+  std::vector<uint8_t> dst(size + 1, 0xa5);
+  ImageStreamer::Convert(src.data(), stride, f.format, width, height, layout,
+                         dst.data());
+  EXPECT(dst[size] == 0xa5);
+
+  ImageStreamer::Header header{};
+  memcpy(&header, dst.data(), sizeof(header));
+  EXPECT(header.width == width);
+  EXPECT(header.height == height);
+  EXPECT(header.strides[0] == width);
+
+  std::vector<uint8_t> y, u, v;
+  Reference(src, stride, f, width, height, y, u, v);
+  const uint8_t* planes = dst.data() + sizeof(header);
+  EXPECT(memcmp(planes, y.data(), y.size()) == 0);
+
+  const uint8_t* chroma = planes + y.size();
+  bool chroma_ok = true;
+  if (layout == Layout::kNV12) {
+    EXPECT(header.fourcc == libcamera::formats::NV12.fourcc());
+    EXPECT(header.plane_count == 2);
+    EXPECT(header.strides[1] == cw * 2);
+    for (size_t i = 0; i < u.size(); i++) {
+      chroma_ok = chroma_ok && chroma[i * 2] == u[i] &&
+                  chroma[i * 2 + 1] == v[i];
+    }
+  } else {
+    EXPECT(header.fourcc == libcamera::formats::YUV420.fourcc());
+    EXPECT(header.plane_count == 3);
+    EXPECT(header.strides[1] == cw);
+    EXPECT(header.strides[2] == cw);
+    chroma_ok = memcmp(chroma, u.data(), u.size()) == 0 &&
+                memcmp(chroma + u.size(), v.data(), v.size()) == 0;
+  }
+  if (!chroma_ok) {
+    fprintf(stderr, "chroma differs: format %s, %ux%u, %s\n",
+            f.format.toString().c_str(), width, height,
+            layout == Layout::kNV12 ? "NV12" : "I420");
+  }
+  EXPECT(chroma_ok);
+}
+
+// A known colour, to catch the reference and Convert agreeing on swapped
+// components.
+void TestColour() {
+  // R=200 G=100 B=50 as RGB888, which is stored B, G, R
+  const std::vector<uint8_t> src = {50, 100, 200, 50, 100, 200,
+                                    50, 100, 200, 50, 100, 200};
+  std::vector<uint8_t> dst(ImageStreamer::MessageSize(2, 2, Layout::kI420));
+  ImageStreamer::Convert(src.data(), 6, libcamera::formats::RGB888, 2, 2,
+                         Layout::kI420, dst.data());
+  const uint8_t* planes = dst.data() + sizeof(ImageStreamer::Header);
+  for (int i = 0; i < 4; i++) {
+    EXPECT(planes[i] == 123);
+  }
+  EXPECT(planes[4] == 91);
+  EXPECT(planes[5] == 175);
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 rng(1);
+  const unsigned int sizes[][2] = {{1, 1}, {2, 2}, {3, 1}, {1, 3},
+                                   {5, 3}, {16, 9}, {33, 17}};
+  for (const auto& f : kFormats) {
+    EXPECT(ImageStreamer::IsSupported(f.format));
+    for (const auto& size : sizes) {
+      TestConvert(f, size[0], size[1], Layout::kNV12, rng);
+      TestConvert(f, size[0], size[1], Layout::kI420, rng);
+    }
+  }
+  EXPECT(!ImageStreamer::IsSupported(libcamera::formats::NV12));
+  TestColour();
+
+  return plugin_common_testing::TestResult();
+}
@@ -0,0 +1,385 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "video_recorder.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <plugins/common/common.h>
+
+namespace camera_plugin {
+
+namespace {
+
+// Attempts with the next ranked encoder when one fails to start.
+constexpr int kMaxEncoderAttempts = 3;
+
+// AAC encoders in order of preference.
+constexpr const char* kAudioEncoders[] = {"fdkaacenc", "avenc_aac",
+                                          "voaacenc", "faac"};
+
+GstVideoFormat ToVideoFormat(const libcamera::PixelFormat& format) {
+  if (format == libcamera::formats::ABGR8888) {
+    return GST_VIDEO_FORMAT_RGBA;
+  } else if (format == libcamera::formats::XBGR8888) {
+    return GST_VIDEO_FORMAT_RGBx;
+  } else if (format == libcamera::formats::ARGB8888) {
+    return GST_VIDEO_FORMAT_BGRA;
+  } else if (format == libcamera::formats::XRGB8888) {
+    return GST_VIDEO_FORMAT_BGRx;
+  } else if (format == libcamera::formats::BGR888) {
+    return GST_VIDEO_FORMAT_RGB;
+  } else if (format == libcamera::formats::RGB888) {
+    return GST_VIDEO_FORMAT_BGR;
+  }
+  return GST_VIDEO_FORMAT_UNKNOWN;
+}
+
+std::string ErrorMessage(GstMessage* msg) {
+  GError* err = nullptr;
+  gchar* debug = nullptr;
+  gst_message_parse_error(msg, &err, &debug);
+  std::string message(err ? err->message : "unknown error");
+  spdlog::error("[camera_plugin] recorder: {} ({})",
+                message, debug ? debug : "");
+  g_clear_error(&err);
+  g_free(debug);
+  return message;
+}
+
+}  // namespace
+
+VideoRecorder::VideoRecorder(EncoderRegistry* registry, Settings settings)
+    : registry_(registry), settings_(std::move(settings)) {}
+
+VideoRecorder::~VideoRecorder() {
+  if (pipeline_) {
+    Stop();
+  }
+}
+
+bool VideoRecorder::IsSupported(const libcamera::PixelFormat& format) {
+  return ToVideoFormat(format) != GST_VIDEO_FORMAT_UNKNOWN;
+}
+
+std::optional<std::string> VideoRecorder::Start() {
+  video_format_ = ToVideoFormat(settings_.format);
+  if (video_format_ == GST_VIDEO_FORMAT_UNKNOWN) {
+    return "Unsupported pixel format " + settings_.format.toString();
+  }
+
+  for (int attempt = 0; attempt < kMaxEncoderAttempts; attempt++) {
+    GstElementFactory* factory = registry_->Select("video/x-h264");
+    if (!factory) {
+      return "No H.264 encoder available";
+    }
+    encoder_name_ = GST_OBJECT_NAME(factory);
+    const bool built = Build(factory);
+    gst_object_unref(factory);
+    if (built && gst_element_set_state(pipeline_, GST_STATE_PLAYING) !=
+                     GST_STATE_CHANGE_FAILURE) {
+      running_ = true;
+      spdlog::debug("[camera_plugin] recording {}x{} {} with {} to {}",
+                    settings_.width, settings_.height,
+                    gst_video_format_to_string(video_format_), encoder_name_,
+                    settings_.path);
+      return std::nullopt;
+    }
+    TearDown();
+    if (!built) {
+      break;
+    }
+    registry_->MarkFailed(encoder_name_);
+  }
+  return "Failed to start the recording pipeline";
+}
+
+bool VideoRecorder::Build(GstElementFactory* encoder_factory) {
+  pipeline_ = gst_pipeline_new("camera-recorder");
+  // Sensor timestamps are CLOCK_MONOTONIC, like the system clock; do not let
+  // an audio source provide the clock.
+  GstClock* clock = gst_system_clock_obtain();
+  gst_pipeline_use_clock(GST_PIPELINE(pipeline_), clock);
+  gst_object_unref(clock);
+
+  appsrc_ = gst_element_factory_make("appsrc", nullptr);
+  GstElement* queue = gst_element_factory_make("queue", nullptr);
+  GstElement* convert = gst_element_factory_make("videoconvert", nullptr);
+  GstElement* encoder = gst_element_factory_create(encoder_factory, nullptr);
+  GstElement* parse = gst_element_factory_make("h264parse", nullptr);
+  GstElement* mux = gst_element_factory_make("mp4mux", nullptr);
+  GstElement* sink = gst_element_factory_make("filesink", nullptr);
+  const auto elements = {appsrc_, queue, convert, encoder, parse, mux, sink};
+  if (std::find(elements.begin(), elements.end(), nullptr) != elements.end()) {
+    spdlog::error("[camera_plugin] recorder: missing GStreamer element");
+    for (GstElement* element : elements) {
+      if (element) {
+        gst_object_unref(gst_object_ref_sink(element));
+      }
+    }
+    appsrc_ = nullptr;
+    return false;
+  }
+  for (GstElement* element : elements) {
+    gst_bin_add(GST_BIN(pipeline_), element);
+  }
+
+  GstCaps* caps = gst_caps_new_simple(
+      "video/x-raw", "format", G_TYPE_STRING,
+      gst_video_format_to_string(video_format_), "width", G_TYPE_INT,
+      static_cast<gint>(settings_.width), "height", G_TYPE_INT,
+      static_cast<gint>(settings_.height), "framerate", GST_TYPE_FRACTION,
+      static_cast<gint>(std::max<int64_t>(settings_.fps, 0)), 1, nullptr);
+  g_object_set(G_OBJECT(appsrc_), "caps", caps, "is-live", TRUE, "format",
+               GST_FORMAT_TIME, "do-timestamp", FALSE, nullptr);
+  gst_caps_unref(caps);
+  g_object_set(G_OBJECT(sink), "location", settings_.path.c_str(), nullptr);
+  ConfigureEncoder(encoder);
+
+  if (!gst_element_link_many(appsrc_, queue, convert, encoder, parse, mux,
+                             sink, nullptr)) {
+    spdlog::error("[camera_plugin] recorder: failed to link {}", encoder_name_);
+    return false;
+  }
+  if (settings_.enable_audio && !AddAudio(mux)) {
+    spdlog::warn("[camera_plugin] recorder: recording without audio");
+  }
+
+  bus_ = gst_element_get_bus(pipeline_);
+  allocator_ = gst_dmabuf_allocator_new();
+  return true;
+}
+
+bool VideoRecorder::AddAudio(GstElement* mux) {
+  GstElement* encoder = nullptr;
+  for (const auto* name : kAudioEncoders) {
+    encoder = gst_element_factory_make(name, nullptr);
+    if (encoder) {
+      break;
+    }
+  }
+  GstElement* source = gst_element_factory_make("autoaudiosrc", nullptr);
+  GstElement* convert = gst_element_factory_make("audioconvert", nullptr);
+  GstElement* resample = gst_element_factory_make("audioresample", nullptr);
+  GstElement* queue = gst_element_factory_make("queue", nullptr);
+  if (!encoder || !source || !convert || !resample || !queue) {
+    for (GstElement* element : {encoder, source, convert, resample, queue}) {
+      if (element) {
+        gst_object_unref(gst_object_ref_sink(element));
+      }
+    }
+    return false;
+  }
+
+  if (settings_.audio_bitrate > 0 &&
+      g_object_class_find_property(G_OBJECT_GET_CLASS(encoder), "bitrate")) {
+    gst_util_set_object_arg(G_OBJECT(encoder), "bitrate",
+                            std::to_string(settings_.audio_bitrate).c_str());
+  }
+
+  gst_bin_add_many(GST_BIN(pipeline_), source, convert, resample, encoder,
+                   queue, nullptr);
+  if (!gst_element_link_many(source, convert, resample, encoder, queue, mux,
+                             nullptr)) {
+    for (GstElement* element : {source, convert, resample, encoder, queue}) {
+      gst_element_set_state(element, GST_STATE_NULL);
+      gst_bin_remove(GST_BIN(pipeline_), element);
+    }
+    return false;
+  }
+  return true;
+}
+
+void VideoRecorder::ConfigureEncoder(GstElement* encoder) const {
+  GObjectClass* klass = G_OBJECT_GET_CLASS(encoder);
+  if (settings_.video_bitrate > 0) {
+    if (encoder_name_.rfind("v4l2", 0) == 0) {
+      GstStructure* controls =
+          gst_structure_new("controls", "video_bitrate", G_TYPE_INT,
+                            static_cast<gint>(settings_.video_bitrate),
+                            nullptr);
+      g_object_set(G_OBJECT(encoder), "extra-controls", controls, nullptr);
+      gst_structure_free(controls);
+    } else if (g_object_class_find_property(klass, "bitrate")) {
+      // openh264enc takes bit/s, the others kbit/s.
+      const int64_t bitrate = encoder_name_ == "openh264enc"
+                                  ? settings_.video_bitrate
+                                  : settings_.video_bitrate / 1000;
+      gst_util_set_object_arg(G_OBJECT(encoder), "bitrate",
+                              std::to_string(bitrate).c_str());
+    }
+  }
+
+  if (encoder_name_ == "x264enc") {
+    // Keep up with the camera on CPU-only machines.
+    gst_util_set_object_arg(G_OBJECT(encoder), "speed-preset", "superfast");
+  }
+  if (settings_.fps > 0) {
+    for (const char* property : {"key-int-max", "keyframe-period"}) {
+      if (g_object_class_find_property(klass, property)) {
+        gst_util_set_object_arg(G_OBJECT(encoder), property,
+                                std::to_string(settings_.fps * 2).c_str());
+        break;
+      }
+    }
+  }
+}
+
+bool VideoRecorder::Push(const libcamera::FrameBuffer* buffer,
+                         std::function<void()> release) {
+  if (!running_ || paused_ || in_flight_ >= kMaxInFlight) {
+    skipped_++;
+    return false;
+  }
+  if (GstMessage* msg = gst_bus_pop_filtered(bus_, GST_MESSAGE_ERROR)) {
+    if (GST_MESSAGE_SRC(msg) &&
+        g_str_has_prefix(GST_OBJECT_NAME(GST_MESSAGE_SRC(msg)),
+                         encoder_name_.c_str())) {
+      registry_->MarkFailed(encoder_name_);
+    }
+    error_ = ErrorMessage(msg);
+    gst_message_unref(msg);
+    running_ = false;
+    return false;
+  }
+
+  const GstClockTime base_time = gst_element_get_base_time(pipeline_);
+  GstClockTime timestamp = buffer->metadata().timestamp;
+  if (timestamp == 0) {
+    GstClock* clock = gst_element_get_clock(pipeline_);
+    if (!clock) {
+      return false;
+    }
+    timestamp = gst_clock_get_time(clock);
+    gst_object_unref(clock);
+  }
+  // Frames captured before the last resume belong to the paused period.
+  if (timestamp < base_time ||
+      (GST_CLOCK_TIME_IS_VALID(last_pts_) &&
+       timestamp - base_time <= last_pts_)) {
+    skipped_++;
+    return false;
+  }
+  last_pts_ = timestamp - base_time;
+
+  const auto& plane = buffer->planes()[0];
+  GstMemory* memory = gst_dmabuf_allocator_alloc_with_flags(
+      allocator_, plane.fd.get(), plane.offset + plane.length,
+      GST_FD_MEMORY_FLAG_DONT_CLOSE);
+  if (!memory) {
+    return false;
+  }
+  in_flight_++;
+  gst_mini_object_weak_ref(GST_MINI_OBJECT(memory), OnMemoryReleased,
+                           new Release{this, std::move(release)});
+
+  GstBuffer* gst_buffer = gst_buffer_new();
+  gst_buffer_append_memory(gst_buffer, memory);
+  gsize offset[GST_VIDEO_MAX_PLANES] = {plane.offset};
+  gint stride[GST_VIDEO_MAX_PLANES] = {static_cast<gint>(settings_.stride)};
+  gst_buffer_add_video_meta_full(gst_buffer, GST_VIDEO_FRAME_FLAG_NONE,
+                                 video_format_, settings_.width,
+                                 settings_.height, 1, offset, stride);
+  GST_BUFFER_PTS(gst_buffer) = last_pts_;
+
+  // Takes the buffer; on failure it is freed and release runs from here.
+  const GstFlowReturn ret =
+      gst_app_src_push_buffer(GST_APP_SRC(appsrc_), gst_buffer);
+  if (ret != GST_FLOW_OK) {
+    SPDLOG_DEBUG("[camera_plugin] recorder: push: {}", gst_flow_get_name(ret));
+  }
+  pushed_++;
+  return true;
+}
+
+void VideoRecorder::OnMemoryReleased(gpointer data,
+                                     GstMiniObject* /* memory */) {
+  auto* release = static_cast<Release*>(data);
+  release->callback();
+  release->recorder->in_flight_--;
+  delete release;
+}
+
+void VideoRecorder::Pause() {
+  if (!running_ || paused_) {
+    return;
+  }
+  // Live pipeline: the time spent PAUSED is left out of the running time.
+  gst_element_set_state(pipeline_, GST_STATE_PAUSED);
+  paused_ = true;
+}
+
+void VideoRecorder::Resume() {
+  if (!running_ || !paused_) {
+    return;
+  }
+  gst_element_set_state(pipeline_, GST_STATE_PLAYING);
+  paused_ = false;
+}
+
+std::optional<std::string> VideoRecorder::Stop() {
+  if (!pipeline_) {
+    return "Not recording";
+  }
+  running_ = false;
+  if (paused_) {
+    gst_element_set_state(pipeline_, GST_STATE_PLAYING);
+    paused_ = false;
+  }
+
+  // mp4mux writes the index on EOS; a failed pipeline never gets there.
+  std::optional<std::string> error = error_;
+  if (!error.has_value()) {
+    gst_element_send_event(pipeline_, gst_event_new_eos());
+    GstMessage* msg = gst_bus_timed_pop_filtered(
+        bus_, kStopTimeout,
+        static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    if (!msg) {
+      error = "Timed out finishing the recording";
+    } else {
+      if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        error = ErrorMessage(msg);
+      }
+      gst_message_unref(msg);
+    }
+  }
+
+  spdlog::debug("[camera_plugin] recorded {} with {}: {} frames, {} skipped",
+                settings_.path, encoder_name_, pushed_, skipped_);
+  TearDown();
+  return error;
+}
+
+void VideoRecorder::TearDown() {
+  if (pipeline_) {
+    // Frees queued buffers, which hands their requests back.
+    gst_element_set_state(pipeline_, GST_STATE_NULL);
+    gst_object_unref(pipeline_);
+    pipeline_ = nullptr;
+    appsrc_ = nullptr;
+  }
+  if (bus_) {
+    gst_object_unref(bus_);
+    bus_ = nullptr;
+  }
+  if (allocator_) {
+    gst_object_unref(allocator_);
+    allocator_ = nullptr;
+  }
+}
+
+}  // namespace camera_plugin
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2023-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FLUTTER_PLUGIN_CAMERA_VIDEO_RECORDER_H_
+#define FLUTTER_PLUGIN_CAMERA_VIDEO_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+extern "C" {
+#include <gst/allocators/gstdmabuf.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+}
+
+#include <libcamera/libcamera.h>
+
+#include "encoder_registry.h"
+
+namespace camera_plugin {
+
+/**
+ * Records capture buffers to an MP4 file.
+ *
+ * appsrc ! queue ! videoconvert ! <h264 encoder> ! h264parse ! mp4mux !
+ * filesink, with autoaudiosrc ! audioconvert ! audioresample ! <aac encoder>
+ * into the same muxer when audio is enabled.
+ *
+ * Buffers are not copied into the pipeline: their dmabuf is wrapped in a
+ * GstBuffer and the capture request is handed back through the release
+ * callback once GStreamer dropped the last reference.  Timestamps are the
+ * sensor timestamps in running time of the pipeline, so pausing the
+ * pipeline leaves no gap in the file.
+ */
+class VideoRecorder {
+ public:
+  // Frames held by the pipeline at a time; further frames are skipped.
+  static constexpr int kMaxInFlight = 2;
+  static constexpr GstClockTime kStopTimeout = 5 * GST_SECOND;
+
+  struct Settings {
+    std::string path;
+    unsigned int width;
+    unsigned int height;
+    unsigned int stride;
+    libcamera::PixelFormat format;
+    int64_t fps;
+    // bits per second, 0 for the encoder default
+    int64_t video_bitrate;
+    int64_t audio_bitrate;
+    bool enable_audio;
+  };
+
+  VideoRecorder(EncoderRegistry* registry, Settings settings);
+  ~VideoRecorder();
+
+  // Prevent copying.
+  VideoRecorder(VideoRecorder const&) = delete;
+  VideoRecorder& operator=(VideoRecorder const&) = delete;
+
+  // Whether capture buffers of this format can be recorded.
+  static bool IsSupported(const libcamera::PixelFormat& format);
+
+  /**
+   * @brief Build the pipeline and start recording
+   * @return std::optional<std::string>
+   * @retval std::nullopt Recording
+   * @retval Error message
+   * @relation
+   * gstreamer
+   */
+  std::optional<std::string> Start();
+
+  /**
+   * @brief Record a captured frame
+   * @param[in] buffer Completed capture buffer
+   * @param[in] release Called once the pipeline no longer reads buffer
+   * @return bool
+   * @retval true Frame is recorded, release will be called
+   * @retval false Frame was skipped, release is not called
+   * @relation
+   * libcamera, gstreamer
+   */
+  bool Push(const libcamera::FrameBuffer* buffer,
+            std::function<void()> release);
+
+  void Pause();
+
+  void Resume();
+
+  /**
+   * @brief Finish the file and tear down the pipeline
+   * @return std::optional<std::string>
+   * @retval std::nullopt File was finalized
+   * @retval Error message
+   * @relation
+   * gstreamer
+   */
+  std::optional<std::string> Stop();
+
+  const std::string& path() const { return settings_.path; }
+
+ private:
+  struct Release {
+    VideoRecorder* recorder;
+    std::function<void()> callback;
+  };
+
+  EncoderRegistry* registry_;
+  Settings settings_;
+  GstVideoFormat video_format_{GST_VIDEO_FORMAT_UNKNOWN};
+
+  GstElement* pipeline_{};
+  GstElement* appsrc_{};
+  GstBus* bus_{};
+  GstAllocator* allocator_{};
+  std::string encoder_name_;
+
+  std::atomic<bool> running_{};
+  std::atomic<bool> paused_{};
+  std::atomic<int> in_flight_{};
+  GstClockTime last_pts_{GST_CLOCK_TIME_NONE};
+  // Error posted while recording
+  std::optional<std::string> error_;
+  uint64_t pushed_{};
+  uint64_t skipped_{};
+
+  bool Build(GstElementFactory* encoder_factory);
+
+  bool AddAudio(GstElement* mux);
+
+  void ConfigureEncoder(GstElement* encoder) const;
+
+  void TearDown();
+
+  static void OnMemoryReleased(gpointer data, GstMiniObject* memory);
+};
+
+}  // namespace camera_plugin
+
+#endif  // FLUTTER_PLUGIN_CAMERA_VIDEO_RECORDER_H_
@@ -18,6 +18,8 @@
 
 #include <curl/curl.h>
 #include <curl/easy.h>
+#include <algorithm>
+#include <cctype>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -29,13 +31,14 @@
 
 namespace plugin_common_curl {
 
-CurlClient::CurlClient() : mCode(CURLE_OK) {
+CurlClient::CurlClient()
+    : mCode(CURLE_OK), mErrorBuffer(std::make_unique<char[]>(CURL_ERROR_SIZE)) {
   curl_global_init(CURL_GLOBAL_DEFAULT);
-  std::make_unique<char>(CURL_ERROR_SIZE);
 }
 
 CurlClient::~CurlClient() {
   curl_easy_cleanup(mConn);
+  curl_slist_free_all(mHeaders);
   mErrorBuffer.reset();
 }
 
@@ -57,6 +60,69 @@ int CurlClient::VectorWriter(char* data,
   return static_cast<int>(size * num_mem_block);
 }
 
+size_t CurlClient::HeaderWriter(char* data,
+                                size_t size,
+                                size_t num_items,
+                                std::map<std::string, std::string>* headers) {
+  const size_t length = size * num_items;
+  std::string line(data, length);
+  // A new status line starts the headers of a redirect or final response.
+  if (line.rfind("HTTP/", 0) == 0) {
+    headers->clear();
+    return length;
+  }
+  const auto colon = line.find(':');
+  if (colon == std::string::npos) {
+    return length;
+  }
+  std::string name = line.substr(0, colon);
+  std::transform(name.begin(), name.end(), name.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  const auto begin = line.find_first_not_of(" \t", colon + 1);
+  const auto end = line.find_last_not_of(" \t\r\n");
+  (*headers)[name] = begin == std::string::npos || end < begin
+                         ? std::string()
+                         : line.substr(begin, end - begin + 1);
+  return length;
+}
+
+bool CurlClient::SetHeaderWriter() {
+  mResponseHeaders.clear();
+  mCode = curl_easy_setopt(mConn, CURLOPT_HEADERFUNCTION, HeaderWriter);
+  if (mCode != CURLE_OK) {
+    spdlog::error("[CurlClient] Failed to set header writer [{}]",
+                  mErrorBuffer.get());
+    return false;
+  }
+  mCode = curl_easy_setopt(mConn, CURLOPT_HEADERDATA, &mResponseHeaders);
+  if (mCode != CURLE_OK) {
+    spdlog::error("[CurlClient] Failed to set header data [{}]",
+                  mErrorBuffer.get());
+    return false;
+  }
+  return true;
+}
+
+long CurlClient::GetResponseCode() const {
+  long code = 0;
+  if (mConn) {
+    curl_easy_getinfo(mConn, CURLINFO_RESPONSE_CODE, &code);
+  }
+  return code;
+}
+
+std::optional<std::string> CurlClient::GetResponseHeader(
+    const std::string& name) const {
+  std::string key = name;
+  std::transform(key.begin(), key.end(), key.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  auto it = mResponseHeaders.find(key);
+  if (it == mResponseHeaders.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
 bool CurlClient::Init(
     const std::string& url,
     const std::vector<std::string>& headers,
@@ -103,12 +169,13 @@ bool CurlClient::Init(
   }
 
   if (!headers.empty()) {
-    struct curl_slist* curl_headers{};
+    curl_slist_free_all(mHeaders);
+    mHeaders = nullptr;
     for (const auto& header : headers) {
       spdlog::trace("[CurlClient] Header: {}", header);
-      curl_headers = curl_slist_append(curl_headers, header.c_str());
+      mHeaders = curl_slist_append(mHeaders, header.c_str());
     }
-    mCode = curl_easy_setopt(mConn, CURLOPT_HTTPHEADER, curl_headers);
+    mCode = curl_easy_setopt(mConn, CURLOPT_HTTPHEADER, mHeaders);
     if (mCode != CURLE_OK) {
       spdlog::error("[CurlClient] Failed to set headers option [{}]",
                     mErrorBuffer.get());
@@ -149,6 +216,9 @@ std::string CurlClient::RetrieveContentAsString(bool verbose) {
   }
 
   mStringBuffer.clear();
+  if (!SetHeaderWriter()) {
+    return {};
+  }
 
   mCode = curl_easy_perform(mConn);
   if (mCode != CURLE_OK) {
@@ -184,6 +254,9 @@ const std::vector<uint8_t>& CurlClient::RetrieveContentAsVector(bool verbose) {
   }
 
   std::vector<uint8_t>().swap(mVectorBuffer);
+  if (!SetHeaderWriter()) {
+    return mVectorBuffer;
+  }
 
   mCode = curl_easy_perform(mConn);
   if (mCode != CURLE_OK) {
@@ -19,7 +19,9 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -78,18 +80,41 @@ class CurlClient {
    */
   [[nodiscard]] CURLcode GetCode() const { return mCode; }
 
+  /**
+   * @brief Function to return the HTTP status of the last response
+   * @return long
+   * @retval HTTP status code, 0 if no response was received
+   * @relation
+   * filament_view
+   */
+  [[nodiscard]] long GetResponseCode() const;
+
+  /**
+   * @brief Function to return a header of the last response
+   * @param name case-insensitive header name
+   * @return std::optional<std::string>
+   * @retval header value without surrounding whitespace, if present
+   * @relation
+   * filament_view
+   */
+  [[nodiscard]] std::optional<std::string> GetResponseHeader(
+      const std::string& name) const;
+
   // Prevent copying.
   CurlClient(CurlClient const&) = delete;
   CurlClient& operator=(CurlClient const&) = delete;
 
  private:
   CURL* mConn{};
+  struct curl_slist* mHeaders{};
   CURLcode mCode;
   std::string mUrl;
   std::string mPostFields;
-  std::unique_ptr<char> mErrorBuffer;
+  std::unique_ptr<char[]> mErrorBuffer;
   std::string mStringBuffer;
   std::vector<uint8_t> mVectorBuffer;
+  // Headers of the final response, lowercase names
+  std::map<std::string, std::string> mResponseHeaders;
 
   /**
    * @brief Callback function for curl client
@@ -122,6 +147,25 @@ class CurlClient {
                           size_t size,
                           size_t num_mem_block,
                           std::vector<uint8_t>* writerData);
+
+  /**
+   * @brief Callback function for response headers
+   * @param data one header line, not terminated
+   * @param size always 1
+   * @param num_items length of data
+   * @param headers map receiving the header
+   * @return size_t
+   * @retval returns back to curl size of write
+   * @relation
+   * filament_view
+   */
+  static size_t HeaderWriter(char* data,
+                             size_t size,
+                             size_t num_items,
+                             std::map<std::string, std::string>* headers);
+
+  // Capture response headers of the next transfer.
+  bool SetHeaderWriter();
 };
 }  // namespace plugin_common_curl
 
@@ -29,6 +29,28 @@ const MainLoop& MainLoop::GetInstance() {
   return sInstance;
 };
 
+void MainLoop::Post(std::function<void()> task) {
+  // start the main loop if not already running
+  GetInstance();
+
+  // An idle source is always dispatched by the loop thread.
+  // g_main_context_invoke would run the task on the calling thread when the
+  // context is not owned at that moment, as between iterations.
+  GSource* source = g_idle_source_new();
+  g_source_set_priority(source, G_PRIORITY_DEFAULT);
+  g_source_set_callback(
+      source,
+      [](gpointer user_data) -> gboolean {
+        (*static_cast<std::function<void()>*>(user_data))();
+        return G_SOURCE_REMOVE;
+      },
+      new std::function<void()>(std::move(task)), [](gpointer user_data) {
+        delete static_cast<std::function<void()>*>(user_data);
+      });
+  g_source_attach(source, g_main_context_default());
+  g_source_unref(source);
+}
+
 void MainLoop::main_loop(MainLoop* data) {
   data->context_ = g_main_context_default();
 
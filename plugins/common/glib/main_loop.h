@@ -17,6 +17,7 @@
 #ifndef PLUGINS_COMMON_GLIB_MAIN_LOOP_H_
 #define PLUGINS_COMMON_GLIB_MAIN_LOOP_H_
 
+#include <functional>
 #include <memory>
 #include <thread>
 
@@ -35,6 +36,17 @@ class MainLoop {
 
   void ExitLoop() { exit_loop_ = true; }
 
+  /**
+   * @brief Run a task on the main loop thread.  Tasks run in the order they
+   * were posted, so plugins can hand channel messages from their worker
+   * threads to the one thread that sends them.
+   * @param[in] task Task, run once
+   * @return void
+   * @relation
+   * glib
+   */
+  static void Post(std::function<void()> task);
+
   // Prevent copying.
   MainLoop(MainLoop const&) = delete;
   MainLoop& operator=(MainLoop const&) = delete;
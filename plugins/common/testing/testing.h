@@ -0,0 +1,65 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_COMMON_TESTING_TESTING_H_
+#define PLUGINS_COMMON_TESTING_TESTING_H_
+
+#include <atomic>
+#include <cstdio>
+
+/**
+ * Minimal support for the plugin unit tests, which are plain executables
+ * run by ctest.  A test checks with EXPECT, which logs a failing condition
+ * and carries on, and returns TestResult() from main.
+ */
+
+namespace plugin_common_testing {
+
+// Returned from main when the test cannot run here, e.g. without the
+// GStreamer elements it needs.  ctest reports the test as skipped.
+inline constexpr int kSkipped = 77;
+
+// Checks failed so far, by any thread.
+inline std::atomic<int> failures{0};
+
+/**
+ * @brief Report the outcome of the checks
+ * @return int
+ * @retval 0 All checks passed
+ * @retval 1 Some check failed
+ * @relation
+ * testing
+ */
+inline int TestResult() {
+  if (failures) {
+    fprintf(stderr, "%d checks failed\n", failures.load());
+    return 1;
+  }
+  printf("ok\n");
+  return 0;
+}
+
+}  // namespace plugin_common_testing
+
+#define EXPECT(cond)                                             \
+  do {                                                           \
+    if (!(cond)) {                                               \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      plugin_common_testing::failures++;                         \
+    }                                                            \
+  } while (0)
+
+#endif  // PLUGINS_COMMON_TESTING_TESTING_H_
@@ -19,10 +19,12 @@
 #include <vector>
 #include "plugins/common/common.h"
 
+#include <cctype>
 #include <filesystem>
-#include <fstream>
-#include <optional>
-#include <vector>
+#include <memory>
+#include <string>
+
+#include "core/utils/asset_buffer.h"
 #include "plugins/common/common.h"
 
 namespace plugin_filament_view {
@@ -42,65 +44,55 @@ inline bool isValidFilePath(const std::filesystem::path& path) {
   return true;
 }
 
-inline std::vector<uint8_t> createBuffer(std::ifstream& file,
-                                         const std::size_t size) {
-  std::vector<uint8_t> buffer(size);
-  if (!file.read(reinterpret_cast<char*>(buffer.data()),
-                 static_cast<long>(buffer.size()))) {
-    buffer.clear();
-  }
-  return buffer;
-}
-
-inline std::optional<std::ifstream> readFileContent(
-    const std::filesystem::path& path) {
-  std::ifstream file(path, std::ios::binary | std::ios::ate);
-  if (!file.is_open()) {
-    spdlog::error("[{}] Failed to open", path.c_str());
-    return {};
-  }
-  return file;
-}
-
-inline std::vector<uint8_t> returnErrorMessageAndBuffer(
-    const std::filesystem::path& path,
-    const std::string& message) {
-  spdlog::error("[{}] {}", path.c_str(), message);
-  return {};
-}
-
-inline std::vector<uint8_t> readBinaryFile(const std::string& dependent_path,
-                                           const std::string& main_path) {
+/**
+ * @brief Maps an asset read-only, without copying it to the heap
+ * @param dependent_path Path relative to main_path
+ * @param main_path Assets directory
+ * @return std::shared_ptr<const AssetBuffer>
+ * @retval nullptr File is missing, empty or could not be mapped
+ * @relation
+ * filament_view
+ */
+inline std::shared_ptr<const AssetBuffer> readBinaryFile(
+    const std::string& dependent_path,
+    const std::string& main_path) {
   const std::filesystem::path filePath =
       getAbsolutePath(dependent_path, main_path);
 
   if (!isValidFilePath(filePath)) {
-    return returnErrorMessageAndBuffer(filePath, "Invalid path");
-  }
-
-  std::optional<std::ifstream> optionalFile = readFileContent(filePath);
-  if (!optionalFile.has_value()) {
-    return returnErrorMessageAndBuffer(filePath, "Failed to open");
+    return nullptr;
   }
 
   SPDLOG_DEBUG("Reading: {}/{}", main_path, dependent_path);
-
-  std::ifstream& file = optionalFile.value();
-  const auto end = file.tellg();
-  file.seekg(0, std::ios::beg);
-  const auto size = static_cast<std::size_t>(end - file.tellg());
-
-  SPDLOG_DEBUG("Read: {} bytes", size);
-  if (size == 0) {
-    return returnErrorMessageAndBuffer(filePath, "Empty file");
+  auto buffer = AssetBuffer::Map(filePath);
+  if (buffer) {
+    SPDLOG_DEBUG("Read: {} bytes", buffer->size());
   }
+  return buffer;
+}
 
-  std::vector<uint8_t> buffer = createBuffer(file, size);
-  if (buffer.empty()) {
-    return returnErrorMessageAndBuffer(filePath, "Failed to read");
+/**
+ * @brief Decodes the percent escapes of a relative URI into a file name.
+ * Malformed escapes are kept as they are.
+ * @param uri Relative URI, as found in a glTF buffer or image
+ * @return std::string
+ * @relation
+ * filament_view
+ */
+inline std::string decodeUri(const std::string& uri) {
+  std::string name;
+  name.reserve(uri.size());
+  for (size_t i = 0; i < uri.size(); i++) {
+    if (uri[i] == '%' && i + 2 < uri.size() &&
+        std::isxdigit(static_cast<unsigned char>(uri[i + 1])) &&
+        std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+      name += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+      i += 2;
+    } else {
+      name += uri[i];
+    }
   }
-
-  return buffer;
+  return name;
 }
 
 }  // namespace plugin_filament_view
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace plugin_filament_view {
+
+/**
+ * Copies of shared assets, keyed by id, and the assets, keyed by source.
+ *
+ * A gltfio instance lives as long as its asset; there is no call to destroy
+ * a single one.  A removed copy is therefore kept hidden and reused by the
+ * next copy of the same source, so placing and removing copies does not
+ * grow the asset.  The asset goes with its last copy, and with it all
+ * instances it created.
+ *
+ * Shared is the data kept per asset, Placement per copy.  Not thread safe,
+ * ModelLoader only uses it on its strand.
+ */
+template <typename Shared, typename Instance, typename Placement>
+class InstanceTable {
+ public:
+  struct Copy {
+    std::string source;
+    // nullptr while the asset is fetched
+    Instance* instance;
+    Placement placement;
+  };
+
+  struct Source {
+    Shared data;
+    // Copies placed, including those waiting for the asset
+    std::vector<uint32_t> copies;
+    // Instances of removed copies, hidden until reused
+    std::vector<Instance*> released;
+  };
+
+  /**
+   * @brief Adds a copy without an instance
+   * @param source Key of the asset
+   * @param placement Data of the copy
+   * @param created Set when the source had no copies, the asset is then to
+   * be fetched
+   * @return uint32_t Id of the copy
+   * @relation
+   * filament_view
+   */
+  uint32_t add(const std::string& source, Placement placement, bool& created) {
+    const auto id = nextId_++;
+    copies_.emplace(id, Copy{source, nullptr, std::move(placement)});
+    auto [it, inserted] = sources_.try_emplace(source);
+    it->second.copies.push_back(id);
+    created = inserted;
+    return id;
+  }
+
+  // nullptr for an unknown id
+  Copy* find(uint32_t id) {
+    auto it = copies_.find(id);
+    return it == copies_.end() ? nullptr : &it->second;
+  }
+
+  // nullptr for an unknown source
+  Source* findSource(const std::string& source) {
+    auto it = sources_.find(source);
+    return it == sources_.end() ? nullptr : &it->second;
+  }
+
+  /**
+   * @brief Takes the instance of a removed copy for a new one
+   * @param source Entry of the asset
+   * @return Instance*
+   * @retval nullptr No removed copy left
+   * @relation
+   * filament_view
+   */
+  static Instance* takeReleased(Source& source) {
+    if (source.released.empty()) {
+      return nullptr;
+    }
+    auto instance = source.released.back();
+    source.released.pop_back();
+    return instance;
+  }
+
+  /**
+   * @brief Removes a copy, its instance is kept for reuse
+   * @param id Id of the copy
+   * @return Source*
+   * @retval nullptr The source has copies left, or the id is unknown
+   * @retval Source* Entry of the source of the last copy.  Its asset, once
+   * loaded, is to be destroyed and the entry erased with eraseSource.
+   * @relation
+   * filament_view
+   */
+  Source* remove(uint32_t id) {
+    auto it = copies_.find(id);
+    if (it == copies_.end()) {
+      return nullptr;
+    }
+    auto source_it = sources_.find(it->second.source);
+    auto& source = source_it->second;
+    source.copies.erase(
+        std::find(source.copies.begin(), source.copies.end(), id));
+    if (it->second.instance) {
+      source.released.push_back(it->second.instance);
+    }
+    copies_.erase(it);
+    return source.copies.empty() ? &source : nullptr;
+  }
+
+  // Drops a copy whose instance could not be created.
+  void erase(uint32_t id) {
+    auto it = copies_.find(id);
+    if (it == copies_.end()) {
+      return;
+    }
+    auto& copies = sources_.at(it->second.source).copies;
+    copies.erase(std::find(copies.begin(), copies.end(), id));
+    copies_.erase(it);
+  }
+
+  // Drops a source with the copies left, their instances went with the
+  // asset.
+  void eraseSource(const std::string& source) {
+    auto it = sources_.find(source);
+    if (it == sources_.end()) {
+      return;
+    }
+    for (auto id : it->second.copies) {
+      copies_.erase(id);
+    }
+    sources_.erase(it);
+  }
+
+  std::map<std::string, Source>& sources() { return sources_; }
+
+  [[nodiscard]] size_t size() const { return copies_.size(); }
+
+ private:
+  std::map<uint32_t, Copy> copies_;
+  std::map<std::string, Source> sources_;
+  uint32_t nextId_ = 1;
+};
+
+}  // namespace plugin_filament_view
@@ -17,6 +17,8 @@
 #include "model_loader.h"
 
 #include <algorithm>  // for max
+#include <cstring>
+#include <filesystem>
 #include <sstream>
 
 #include <filament/DebugRegistry.h>
@@ -31,10 +33,25 @@
 #include "gltfio/materials/uberarchive.h"
 
 #include "core/include/file_utils.h"
-#include "plugins/common/curl_client/curl_client.h"
+#include "core/utils/asset_cache.h"
 
 namespace plugin_filament_view {
 
+namespace {
+
+// Fits bounds into a unit cube at position, then scales it.
+::filament::math::mat4f placementTransform(const ::filament::Aabb& bounds,
+                                           float scale,
+                                           ::filament::math::float3 position) {
+  const auto maxExtent = max(bounds.extent()) * 2;
+  const auto scaleFactor = maxExtent > 0 ? scale * 2.0f / maxExtent : scale;
+  return ::filament::math::mat4f::translation(position) *
+         ::filament::math::mat4f::scaling(scaleFactor) *
+         ::filament::math::mat4f::translation(-bounds.center());
+}
+
+}  // namespace
+
 using ::filament::gltfio::AssetConfiguration;
 using ::filament::gltfio::AssetLoader;
 using ::filament::gltfio::ResourceConfiguration;
@@ -74,13 +91,19 @@ ModelLoader::~ModelLoader() {
   delete resourceLoader_;
   resourceLoader_ = nullptr;
 
+  for (auto& [source, entry] : instances_.sources()) {
+    delete entry.data.resourceLoader;
+    delete entry.data.textureProvider;
+  }
+
   if (assetLoader_) {
     AssetLoader::destroy(&assetLoader_);
   }
 }
 
 void ModelLoader::destroyModel() {
-  // fetchResourcesJob?.cancel()
+  // Resources of a glTF still being fetched are dropped when they arrive.
+  generation_++;
   resourceLoader_->asyncCancelLoad();
   resourceLoader_->evictResourceData();
 
@@ -96,7 +119,7 @@ void ModelLoader::destroyModel() {
 /**
  * Loads a monolithic binary glb and populates the Filament scene.
  */
-void ModelLoader::loadModelGlb(const std::vector<uint8_t>& buffer,
+void ModelLoader::loadModelGlb(const AssetBuffer& buffer,
                                const ::filament::float3* centerPosition,
                                float scale,
                                bool autoScaleEnabled) {
@@ -118,39 +141,105 @@ void ModelLoader::loadModelGlb(const std::vector<uint8_t>& buffer,
 }
 
 void ModelLoader::loadModelGltf(
-    const std::vector<uint8_t>& buffer,
-    const ::filament::float3* centerPosition,
+    const AssetBuffer& buffer,
+    const std::string& fileSource,
+    const ResourceFetcher& fetch,
     float scale,
-    std::function<const ::filament::backend::BufferDescriptor&(
-        std::string uri)>& /* callback */,
-    bool transform) {
+    const ::filament::float3* centerPosition,
+    bool isFallback,
+    const std::shared_ptr<std::promise<Resource<std::string_view>>>& promise) {
   destroyModel();
-  asset_ = assetLoader_->createAsset(buffer.data(),
-                                     static_cast<uint32_t>(buffer.size()));
+  if (!buffer.empty()) {
+    asset_ = assetLoader_->createAsset(buffer.data(),
+                                       static_cast<uint32_t>(buffer.size()));
+  }
+  auto load = std::make_shared<GltfLoad>(GltfLoad{
+      generation_, fileSource, 0, false, scale, centerPosition, isFallback,
+      promise});
   if (!asset_) {
+    spdlog::error("[ModelLoader] Couldn't parse glTF {}", fileSource);
+    finishGltf(*load, "Couldn't load glTF model");
     return;
   }
 
-  auto uri_data = asset_->getResourceUris();
-  auto uris = std::vector<const char*>(
-      uri_data, uri_data + asset_->getResourceUriCount());
-  for (const auto uri : uris) {
-    SPDLOG_DEBUG("resource uri: {}", uri);
-#if 0   // TODO
-              auto resourceBuffer = callback(uri);
-              if (!resourceBuffer) {
-                  this->asset_ = nullptr;
-                  return;
-              }
-              resourceLoader_->addResourceData(uri, resourceBuffer);
-#endif  // TODO
+  std::vector<std::string> uris;
+  const auto uri_data = asset_->getResourceUris();
+  for (size_t i = 0; i < asset_->getResourceUriCount(); i++) {
+    // Embedded data is decoded by the resource loader itself.
+    if (std::strncmp(uri_data[i], "data:", 5) != 0) {
+      uris.emplace_back(uri_data[i]);
+    }
   }
-  resourceLoader_->asyncBeginLoad(asset_);
+  if (uris.empty()) {
+    finishGltf(*load, nullptr);
+    return;
+  }
+
+  load->pending = uris.size();
+  for (auto& uri : uris) {
+    SPDLOG_DEBUG("[ModelLoader] fetching {}", uri);
+    asio::post(modelViewer_->getLoaderContext(),
+               [&, load, uri = std::move(uri), fetch] {
+                 auto data = fetch(uri);
+                 asio::post(strand_, [&, load, uri, data = std::move(data)] {
+                   addGltfResource(*load, uri, data);
+                 });
+               });
+  }
+}
+
+void ModelLoader::addGltfResource(
+    GltfLoad& load,
+    const std::string& uri,
+    const std::shared_ptr<const AssetBuffer>& data) {
+  if (load.done) {
+    return;
+  }
+  if (load.generation != generation_) {
+    // Another model was loaded meanwhile, asset_ is no longer ours.
+    load.done = true;
+    load.promise->set_value(
+        Resource<std::string_view>::Error("glTF load was superseded"));
+    return;
+  }
+  if (!data) {
+    spdlog::error("[ModelLoader] Couldn't load {} of {}", uri, load.source);
+    destroyModel();
+    finishGltf(load, "Couldn't load glTF resource");
+    return;
+  }
+
+  // The loader keeps the descriptor until evictResourceData().
+  resourceLoader_->addResourceData(
+      uri.c_str(), ::filament::backend::BufferDescriptor(
+                       data->data(), data->size(), AssetBuffer::Release,
+                       AssetBuffer::Retain(data)));
+
+  if (--load.pending == 0) {
+    finishGltf(load, nullptr);
+  }
+}
+
+void ModelLoader::finishGltf(GltfLoad& load, const char* error) {
+  load.done = true;
+  if (!error && !resourceLoader_->asyncBeginLoad(asset_)) {
+    spdlog::error("[ModelLoader] Couldn't load resources of {}", load.source);
+    destroyModel();
+    error = "Couldn't load glTF resources";
+  }
+  if (error) {
+    modelViewer_->setModelState(ModelState::ERROR);
+    load.promise->set_value(Resource<std::string_view>::Error(error));
+    return;
+  }
+
   modelViewer_->setAnimator(asset_->getInstance()->getAnimator());
   asset_->releaseSourceData();
-  if (transform) {
-    transformToUnitCube(centerPosition, scale);
-  }
+  transformToUnitCube(load.centerPosition, load.scale);
+  modelViewer_->setModelState(load.isFallback ? ModelState::FALLBACK_LOADED
+                                              : ModelState::LOADED);
+  load.promise->set_value(
+      Resource<std::string_view>::Success("Loaded glTF model successfully"));
 }
 
 void ModelLoader::transformToUnitCube(
@@ -198,6 +287,13 @@ void ModelLoader::updateScene() {
   if (asset_) {
     populateScene(asset_);
   }
+
+  for (auto& [source, entry] : instances_.sources()) {
+    if (entry.data.asset) {
+      entry.data.resourceLoader->asyncUpdateLoad();
+      populateScene(entry.data.asset);
+    }
+  }
 }
 
 void ModelLoader::removeAsset() {
@@ -234,9 +330,19 @@ std::future<Resource<std::string_view>> ModelLoader::loadGlbFromAsset(
       std::make_shared<std::promise<Resource<std::string_view>>>());
   auto promise_future(promise->get_future());
   modelViewer_->setModelState(ModelState::LOADING);
-  asio::post(strand_, [&, promise, path, scale, centerPosition, isFallback] {
+  asio::post(modelViewer_->getLoaderContext(), [&, promise, path, scale,
+                                                centerPosition, isFallback] {
     auto buffer = readBinaryFile(path, assetPath_);
-    handleFile(buffer, path, scale, centerPosition, isFallback, promise);
+    if (!buffer) {
+      modelViewer_->setModelState(ModelState::ERROR);
+      promise->set_value(Resource<std::string_view>::Error(
+          "Couldn't load glb model from " + path));
+      return;
+    }
+    asio::post(strand_, [&, promise, buffer = std::move(buffer), path, scale,
+                         centerPosition, isFallback] {
+      handleFile(*buffer, path, scale, centerPosition, isFallback, promise);
+    });
   });
   return promise_future;
 }
@@ -250,23 +356,26 @@ std::future<Resource<std::string_view>> ModelLoader::loadGlbFromUrl(
       std::make_shared<std::promise<Resource<std::string_view>>>());
   auto promise_future(promise->get_future());
   modelViewer_->setModelState(ModelState::LOADING);
-  asio::post(strand_, [&, promise, url = std::move(url), scale, centerPosition,
-                       isFallback] {
-    plugin_common_curl::CurlClient client;
-    // TODO client.Init(url);
-    auto buffer = client.RetrieveContentAsVector();
-    if (client.GetCode() != CURLE_OK) {
+  asio::post(modelViewer_->getLoaderContext(), [&, promise,
+                                                url = std::move(url), scale,
+                                                centerPosition, isFallback] {
+    auto buffer = AssetCache::Get().Fetch(url);
+    if (!buffer) {
       modelViewer_->setModelState(ModelState::ERROR);
       promise->set_value(
           Resource<std::string_view>::Error("Couldn't load Glb from " + url));
+      return;
     }
-    handleFile(buffer, url, scale, centerPosition, isFallback, promise);
+    asio::post(strand_, [&, promise, buffer = std::move(buffer), url, scale,
+                         centerPosition, isFallback] {
+      handleFile(*buffer, url, scale, centerPosition, isFallback, promise);
+    });
   });
   return promise_future;
 }
 
 void ModelLoader::handleFile(
-    const std::vector<uint8_t>& buffer,
+    const AssetBuffer& buffer,
     const std::string& fileSource,
     float scale,
     const ::filament::math::float3* centerPosition,
@@ -286,29 +395,301 @@ void ModelLoader::handleFile(
 }
 
 std::future<Resource<std::string_view>> ModelLoader::loadGltfFromAsset(
-    const std::string& /* path */,
-    const std::string& /* pre_path */,
-    const std::string& /* post_path */,
-    float /* scale */,
-    const ::filament::math::float3* /* centerPosition */,
-    bool /* isFallback */) {
+    const std::string& path,
+    const std::string& pre_path,
+    const std::string& post_path,
+    float scale,
+    const ::filament::math::float3* centerPosition,
+    bool isFallback) {
   const auto promise(
       std::make_shared<std::promise<Resource<std::string_view>>>());
   auto future(promise->get_future());
-  promise->set_value(Resource<std::string_view>::Error("Not implemented yet"));
+  modelViewer_->setModelState(ModelState::LOADING);
+
+  // Resources are named prefix + uri + postfix, relative to the assets.  The
+  // prefix defaults to the directory of the glTF.
+  std::string prefix = pre_path;
+  if (prefix.empty()) {
+    auto directory = std::filesystem::path(path).parent_path();
+    if (!directory.empty()) {
+      prefix = (directory / "").string();
+    }
+  }
+  ResourceFetcher fetch = [assetPath = assetPath_, prefix,
+                           post_path](const std::string& uri) {
+    return readBinaryFile(prefix + decodeUri(uri) + post_path, assetPath);
+  };
+
+  asio::post(modelViewer_->getLoaderContext(), [&, promise, path, fetch, scale,
+                                                centerPosition, isFallback] {
+    auto buffer = readBinaryFile(path, assetPath_);
+    if (!buffer) {
+      modelViewer_->setModelState(ModelState::ERROR);
+      promise->set_value(
+          Resource<std::string_view>::Error("Couldn't load glTF model"));
+      return;
+    }
+    asio::post(strand_, [&, promise, buffer = std::move(buffer), path, fetch,
+                         scale, centerPosition, isFallback] {
+      loadModelGltf(*buffer, path, fetch, scale, centerPosition, isFallback,
+                    promise);
+    });
+  });
   return future;
 }
 
 std::future<Resource<std::string_view>> ModelLoader::loadGltfFromUrl(
-    const std::string& /* url */,
-    float /* scale */,
-    const ::filament::math::float3* /* centerPosition */,
-    bool /* isFallback */) {
+    const std::string& url,
+    float scale,
+    const ::filament::math::float3* centerPosition,
+    bool isFallback) {
   const auto promise(
       std::make_shared<std::promise<Resource<std::string_view>>>());
   auto future(promise->get_future());
-  promise->set_value(Resource<std::string_view>::Error("Not implemented yet"));
+  modelViewer_->setModelState(ModelState::LOADING);
+
+  // Relative resources are resolved against the directory of the glTF.
+  const auto base = url.substr(0, url.find_first_of("?#"));
+  ResourceFetcher fetch = [base = base.substr(0, base.rfind('/') + 1)](
+                              const std::string& uri) {
+    const bool absolute = uri.find("://") != std::string::npos;
+    return AssetCache::Get().Fetch(absolute ? uri : base + uri);
+  };
+
+  asio::post(modelViewer_->getLoaderContext(), [&, promise, url, fetch, scale,
+                                                centerPosition, isFallback] {
+    auto buffer = AssetCache::Get().Fetch(url);
+    if (!buffer) {
+      modelViewer_->setModelState(ModelState::ERROR);
+      promise->set_value(
+          Resource<std::string_view>::Error("Couldn't load glTF model"));
+      return;
+    }
+    asio::post(strand_, [&, promise, buffer = std::move(buffer), url, fetch,
+                         scale, centerPosition, isFallback] {
+      loadModelGltf(*buffer, url, fetch, scale, centerPosition, isFallback,
+                    promise);
+    });
+  });
+  return future;
+}
+
+std::future<Resource<uint32_t>> ModelLoader::addGlbInstanceFromAsset(
+    const std::string& path,
+    float scale,
+    const ::filament::float3* centerPosition) {
+  return addGlbInstance(
+      getAbsolutePath(path, assetPath_).string(),
+      [path, assetPath = assetPath_] {
+        return readBinaryFile(path, assetPath);
+      },
+      scale, centerPosition);
+}
+
+std::future<Resource<uint32_t>> ModelLoader::addGlbInstanceFromUrl(
+    std::string url,
+    float scale,
+    const ::filament::float3* centerPosition) {
+  auto source = url;
+  return addGlbInstance(
+      std::move(source),
+      [url = std::move(url)] { return AssetCache::Get().Fetch(url); }, scale,
+      centerPosition);
+}
+
+std::future<Resource<uint32_t>> ModelLoader::addGlbInstance(
+    std::string source,
+    std::function<std::shared_ptr<const AssetBuffer>()> fetch,
+    float scale,
+    const ::filament::float3* centerPosition) {
+  const auto promise(std::make_shared<std::promise<Resource<uint32_t>>>());
+  auto future(promise->get_future());
+  const auto position =
+      centerPosition ? *centerPosition : ::filament::float3{0.0f};
+  asio::post(strand_, [&, promise, source = std::move(source),
+                       fetch = std::move(fetch), scale, position] {
+    bool created;
+    const auto id = instances_.add(
+        source, {std::nullopt, scale, position, promise}, created);
+
+    if (created) {
+      // The first copy fetches the glb, copies placed meanwhile wait for it.
+      asio::post(modelViewer_->getLoaderContext(), [&, source, fetch] {
+        auto buffer = fetch();
+        asio::post(strand_, [&, source, buffer = std::move(buffer)] {
+          createInstancedAsset(source, buffer);
+        });
+      });
+      return;
+    }
+    auto& shared = *instances_.findSource(source);
+    if (!shared.data.asset) {
+      return;
+    }
+
+    auto& entry = *instances_.find(id);
+    entry.instance = Instances::takeReleased(shared);
+    if (entry.instance) {
+      setInstanceVisible(entry.instance, true);
+    } else {
+      entry.instance = assetLoader_->createInstance(shared.data.asset);
+    }
+    if (!entry.instance) {
+      instances_.erase(id);
+      promise->set_value(
+          Resource<uint32_t>::Error("Couldn't add a copy of the glb model"));
+      return;
+    }
+    placeInstance(shared.data.asset, entry);
+    modelViewer_->getFilamentScene()->addEntities(
+        entry.instance->getEntities(), entry.instance->getEntityCount());
+    SPDLOG_DEBUG("[ModelLoader] {} copies of {}", shared.copies.size(), source);
+    promise->set_value(Resource<uint32_t>::Success(id));
+  });
+  return future;
+}
+
+void ModelLoader::createInstancedAsset(
+    const std::string& source,
+    const std::shared_ptr<const AssetBuffer>& buffer) {
+  auto found = instances_.findSource(source);
+  if (!found) {
+    return;
+  }
+  auto& shared = *found;
+  std::vector<::filament::gltfio::FilamentInstance*> instances(
+      shared.copies.size());
+  if (buffer && !instances.empty()) {
+    shared.data.asset = assetLoader_->createInstancedAsset(
+        buffer->data(), static_cast<uint32_t>(buffer->size()),
+        instances.data(), instances.size());
+  }
+  if (!shared.data.asset) {
+    if (!instances.empty()) {
+      spdlog::error("[ModelLoader] Couldn't load {}", source);
+    }
+    for (auto id : shared.copies) {
+      instances_.find(id)->placement.promise->set_value(
+          Resource<uint32_t>::Error("Couldn't load glb model"));
+    }
+    instances_.eraseSource(source);
+    return;
+  }
+
+  // Source data is kept, createInstance() needs it for later copies.
+  ResourceConfiguration resourceConfiguration{};
+  resourceConfiguration.engine = engine_;
+  resourceConfiguration.normalizeSkinningWeights = true;
+  auto& data = shared.data;
+  data.resourceLoader = new ResourceLoader(resourceConfiguration);
+  data.textureProvider = filament::gltfio::createStbProvider(engine_);
+  data.resourceLoader->addTextureProvider("image/png", data.textureProvider);
+  data.resourceLoader->addTextureProvider("image/jpeg", data.textureProvider);
+  data.resourceLoader->asyncBeginLoad(data.asset);
+
+  // Renderables are added by updateScene() as they become ready.
+  for (size_t i = 0; i < instances.size(); i++) {
+    const auto id = shared.copies[i];
+    auto& entry = *instances_.find(id);
+    entry.instance = instances[i];
+    placeInstance(data.asset, entry);
+    entry.placement.promise->set_value(Resource<uint32_t>::Success(id));
+  }
+  SPDLOG_DEBUG("[ModelLoader] {} copies of {}", instances.size(), source);
+}
+
+void ModelLoader::placeInstance(const ::filament::gltfio::FilamentAsset* asset,
+                                const Instances::Copy& copy) {
+  const auto& placement = copy.placement;
+  auto transform = placement.transform.has_value()
+                       ? placement.transform.value()
+                       : placementTransform(asset->getBoundingBox(),
+                                            placement.scale,
+                                            placement.position);
+  auto& tm = engine_->getTransformManager();
+  tm.setTransform(tm.getInstance(copy.instance->getRoot()), transform);
+}
+
+void ModelLoader::setInstanceVisible(
+    ::filament::gltfio::FilamentInstance* instance,
+    bool visible) {
+  // Layer 0 is where Filament puts renderables by default.
+  auto& rcm = engine_->getRenderableManager();
+  auto entities = instance->getEntities();
+  for (size_t i = 0; i < instance->getEntityCount(); i++) {
+    auto ri = rcm.getInstance(entities[i]);
+    if (ri) {
+      rcm.setLayerMask(ri, 0xff, visible ? 0x01 : 0x00);
+    }
+  }
+}
+
+std::future<Resource<std::string_view>> ModelLoader::setInstanceTransform(
+    uint32_t id,
+    const ::filament::math::mat4f& transform) {
+  const auto promise(
+      std::make_shared<std::promise<Resource<std::string_view>>>());
+  auto future(promise->get_future());
+  asio::post(strand_, [&, promise, id, transform] {
+    auto copy = instances_.find(id);
+    if (!copy) {
+      promise->set_value(
+          Resource<std::string_view>::Error("No model copy with this id"));
+      return;
+    }
+    copy->placement.transform = transform;
+    // Without an instance the transform is applied once the glb is loaded.
+    if (copy->instance) {
+      auto shared = instances_.findSource(copy->source);
+      if (!shared || !shared->data.asset) {
+        promise->set_value(
+            Resource<std::string_view>::Error("Model copy has no asset"));
+        return;
+      }
+      placeInstance(shared->data.asset, *copy);
+    }
+    promise->set_value(
+        Resource<std::string_view>::Success("Model copy placed successfully"));
+  });
   return future;
 }
 
+void ModelLoader::removeInstance(uint32_t id) {
+  asio::post(strand_, [&, id] {
+    auto copy = instances_.find(id);
+    if (!copy) {
+      return;
+    }
+    if (copy->instance) {
+      // Hidden as well, the copy may still be pending in populateScene().
+      setInstanceVisible(copy->instance, false);
+      modelViewer_->getFilamentScene()->removeEntities(
+          copy->instance->getEntities(), copy->instance->getEntityCount());
+    } else {
+      copy->placement.promise->set_value(
+          Resource<uint32_t>::Error("Model copy was removed"));
+    }
+    const auto source = copy->source;
+    auto last = instances_.remove(id);
+
+    // Without an asset the fetch is in flight, and drops the entry.
+    if (last && last->data.asset) {
+      destroyInstancedAsset(last->data);
+      instances_.eraseSource(source);
+    }
+  });
+}
+
+void ModelLoader::destroyInstancedAsset(InstancedAsset& shared) {
+  shared.resourceLoader->asyncCancelLoad();
+  modelViewer_->getFilamentScene()->removeEntities(
+      shared.asset->getEntities(), shared.asset->getEntityCount());
+  assetLoader_->destroyAsset(shared.asset);
+  shared.asset = nullptr;
+  delete shared.resourceLoader;
+  shared.resourceLoader = nullptr;
+  delete shared.textureProvider;
+  shared.textureProvider = nullptr;
+}
+
 }  // namespace plugin_filament_view
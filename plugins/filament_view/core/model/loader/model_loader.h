@@ -1,16 +1,26 @@
 
 #pragma once
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
 #include <filament/IndirectLight.h>
 #include <filament/MaterialInstance.h>
 #include <filament/TransformManager.h>
 #include <gltfio/AssetLoader.h>
 #include <gltfio/FilamentAsset.h>
 #include <gltfio/ResourceLoader.h>
+#include <gltfio/TextureProvider.h>
 #include <asio/io_context_strand.hpp>
 
 #include "core/include/resource.h"
+#include "core/model/loader/instance_table.h"
 #include "core/model/model.h"
+#include "core/utils/asset_buffer.h"
 #include "viewer/custom_model_viewer.h"
 #include "viewer/settings.h"
 
@@ -34,22 +44,11 @@ class ModelLoader {
   /**
    * Loads a monolithic binary glTF and populates the Filament scene.
    */
-  void loadModelGlb(const std::vector<uint8_t>& buffer,
+  void loadModelGlb(const AssetBuffer& buffer,
                     const ::filament::float3* centerPosition,
                     float scale,
                     bool transformToUnitCube = false);
 
-  /**
-   * Loads a JSON-style glTF file and populates the Filament scene.
-   * The given callback is triggered for each requested resource.
-   */
-  void loadModelGltf(const std::vector<uint8_t>& buffer,
-                     const ::filament::float3* centerPosition,
-                     float scale,
-                     std::function<const ::filament::backend::BufferDescriptor&(
-                         std::string uri)>& callback,
-                     bool transform = false);
-
   filament::gltfio::FilamentAsset* getAsset() const { return asset_; };
 
   std::optional<::filament::math::mat4f> getModelTransform();
@@ -89,13 +88,56 @@ class ModelLoader {
       const ::filament::float3* centerPosition,
       bool isFallback = false);
 
+  /**
+   * @brief Places a copy of a glb in the scene, next to the main model.  The
+   * first copy of a file creates it with createInstancedAsset, later copies
+   * are instances sharing its vertex buffers, textures and materials, so the
+   * file is fetched and uploaded once however many copies are placed.
+   * @param path Path of the glb, relative to the assets
+   * @param scale Scale of the copy, once fitted into a unit cube
+   * @param centerPosition Position of the copy, the origin when nullptr
+   * @return std::future<Resource<uint32_t>> Id of the copy
+   * @relation
+   * filament_view
+   */
+  std::future<Resource<uint32_t>> addGlbInstanceFromAsset(
+      const std::string& path,
+      float scale,
+      const ::filament::float3* centerPosition);
+
+  std::future<Resource<uint32_t>> addGlbInstanceFromUrl(
+      std::string url,
+      float scale,
+      const ::filament::float3* centerPosition);
+
+  /**
+   * @brief Replaces the placement of a copy
+   * @param id Id of the copy
+   * @param transform Transform of the root of the copy
+   * @return std::future<Resource<std::string_view>> Error for an unknown id
+   * @relation
+   * filament_view
+   */
+  std::future<Resource<std::string_view>> setInstanceTransform(
+      uint32_t id,
+      const ::filament::math::mat4f& transform);
+
+  /**
+   * @brief Removes a copy from the scene.  Its instance is hidden and reused
+   * by the next copy of the same glb, the shared asset is destroyed with its
+   * last copy.
+   * @param id Id of the copy
+   * @relation
+   * filament_view
+   */
+  void removeInstance(uint32_t id);
+
   friend class CustomModelViewer;
 
  private:
   CustomModelViewer* modelViewer_;
   ::filament::Engine* engine_;
   const asio::io_context::strand& strand_;
-  std::vector<filament::gltfio::FilamentInstance*> instances_;
 
   std::string assetPath_;
   utils::Entity sunlight_;
@@ -114,9 +156,88 @@ class ModelLoader {
   std::vector<float> morphWeights_;
   // TODO  ::filament::gltfio::NodeManager::SceneMask visibleScenes_;
 
-  void fetchResources(
-      ::filament::gltfio::FilamentAsset* asset,
-      const std::function<uint8_t*(std::string asset)> callback);
+  // Returns the contents of an external glTF resource, runs on the loader
+  // pool.  nullptr when the resource could not be read.
+  using ResourceFetcher =
+      std::function<std::shared_ptr<const AssetBuffer>(const std::string&)>;
+
+  // A glTF waiting for its external resources, only used on the strand.
+  struct GltfLoad {
+    // Value of generation_ when the load started
+    uint32_t generation;
+    std::string source;
+    size_t pending;
+    bool done;
+    float scale;
+    const ::filament::float3* centerPosition;
+    bool isFallback;
+    std::shared_ptr<std::promise<Resource<std::string_view>>> promise;
+  };
+
+  // Incremented by destroyModel(), resources of an older load are dropped.
+  uint32_t generation_{};
+
+  // A glb placed several times, keyed by its path or URL.
+  struct InstancedAsset {
+    // nullptr while the glb is fetched
+    ::filament::gltfio::FilamentAsset* asset{};
+    // Each asset has its own loader, so that several load at once.
+    ::filament::gltfio::ResourceLoader* resourceLoader{};
+    ::filament::gltfio::TextureProvider* textureProvider{};
+  };
+
+  struct InstancePlacement {
+    std::optional<::filament::math::mat4f> transform;
+    float scale;
+    ::filament::float3 position;
+    std::shared_ptr<std::promise<Resource<uint32_t>>> promise;
+  };
+
+  using Instances = InstanceTable<InstancedAsset,
+                                  ::filament::gltfio::FilamentInstance,
+                                  InstancePlacement>;
+
+  // Copies of glbs, only used on the strand.
+  Instances instances_;
+
+  std::future<Resource<uint32_t>> addGlbInstance(
+      std::string source,
+      std::function<std::shared_ptr<const AssetBuffer>()> fetch,
+      float scale,
+      const ::filament::float3* centerPosition);
+
+  void createInstancedAsset(const std::string& source,
+                            const std::shared_ptr<const AssetBuffer>& buffer);
+
+  void placeInstance(const ::filament::gltfio::FilamentAsset* asset,
+                     const Instances::Copy& copy);
+
+  // Hides or shows the renderables of an instance.
+  void setInstanceVisible(::filament::gltfio::FilamentInstance* instance,
+                          bool visible);
+
+  void destroyInstancedAsset(InstancedAsset& shared);
+
+  /**
+   * Loads a JSON-style glTF file.  All external resources are fetched at
+   * once on the loader pool and added as they arrive; the model is added to
+   * the scene when the last one is in, and its textures as they are decoded
+   * by updateScene().
+   */
+  void loadModelGltf(
+      const AssetBuffer& buffer,
+      const std::string& fileSource,
+      const ResourceFetcher& fetch,
+      float scale,
+      const ::filament::float3* centerPosition,
+      bool isFallback,
+      const std::shared_ptr<std::promise<Resource<std::string_view>>>& promise);
+
+  void addGltfResource(GltfLoad& load,
+                       const std::string& uri,
+                       const std::shared_ptr<const AssetBuffer>& data);
+
+  void finishGltf(GltfLoad& load, const char* error);
 
   ::filament::math::mat4f inline fitIntoUnitCube(
       const ::filament::Aabb& bounds,
@@ -134,9 +255,8 @@ class ModelLoader {
 
   void setTransform(::filament::mat4f mat);
 
-  std::vector<char> buffer_;
   void handleFile(
-      const std::vector<uint8_t>& buffer,
+      const AssetBuffer& buffer,
       const std::string& fileSource,
       float scale,
       const ::filament::float3* centerPosition,
@@ -23,6 +23,7 @@
 #include <asio/post.hpp>
 #include <utility>
 
+#include "core/utils/asset_cache.h"
 #include "core/utils/hdr_loader.h"
 #include "plugins/common/common.h"
 
@@ -105,15 +106,11 @@ IndirectLightManager::setIndirectLightFromKtxUrl(std::string url,
   return future;
 }
 
-Resource<std::string_view> IndirectLightManager::loadIndirectLightHdrFromFile(
-    const std::string& asset_path,
+Resource<std::string_view> IndirectLightManager::loadIndirectLightHdrFromImage(
+    const image::LinearImage& image,
     double intensity) {
-  modelViewer_->setLightState(SceneState::LOADING);
-
-  ::filament::Texture* texture;
-  try {
-    texture = HDRLoader::createTexture(engine_, asset_path);
-  } catch (...) {
+  auto texture = HDRLoader::createTexture(engine_, image);
+  if (!texture) {
     modelViewer_->setLightState(SceneState::ERROR);
     return Resource<std::string_view>::Error("Could not decode HDR file");
   }
@@ -144,24 +141,24 @@ IndirectLightManager::setIndirectLightFromHdrAsset(std::string path,
       std::make_shared<std::promise<Resource<std::string_view>>>());
   auto future(promise->get_future());
   modelViewer_->setLightState(SceneState::LOADING);
-  asio::post(modelViewer_->getStrandContext(),
-             [&, promise, path = std::move(path), intensity] {
-               std::filesystem::path asset_path(modelViewer_->getAssetPath());
-               asset_path /= path;
-               if (path.empty() || !std::filesystem::exists(asset_path)) {
-                 modelViewer_->setModelState(ModelState::ERROR);
+  std::filesystem::path asset_path(modelViewer_->getAssetPath());
+  asset_path /= path;
+  if (path.empty() || !std::filesystem::exists(asset_path)) {
+    modelViewer_->setLightState(SceneState::ERROR);
+    promise->set_value(
+        Resource<std::string_view>::Error("Asset path not valid"));
+    return future;
+  }
+  asio::post(modelViewer_->getLoaderContext(), [&, promise, asset_path,
+                                                intensity] {
+    auto hdr =
+        std::make_shared<image::LinearImage>(HDRLoader::decode(asset_path));
+    asio::post(modelViewer_->getStrandContext(),
+               [&, promise, hdr = std::move(hdr), intensity] {
                  promise->set_value(
-                     Resource<std::string_view>::Error("Asset path not valid"));
-               }
-               try {
-                 promise->set_value(loadIndirectLightHdrFromFile(
-                     asset_path.c_str(), intensity));
-               } catch (...) {
-                 modelViewer_->setLightState(SceneState::ERROR);
-                 promise->set_value(Resource<std::string_view>::Error(
-                     "Couldn't changed Light from asset"));
-               }
-             });
+                     loadIndirectLightHdrFromImage(*hdr, intensity));
+               });
+  });
   return future;
 }
 
@@ -171,11 +168,25 @@ IndirectLightManager::setIndirectLightFromHdrUrl(std::string url,
   const auto promise(
       std::make_shared<std::promise<Resource<std::string_view>>>());
   auto future(promise->get_future());
-  asio::post(modelViewer_->getStrandContext(),
-             [&, promise, url = std::move(url), intensity] {
-               promise->set_value(
-                   Resource<std::string_view>::Error("Not implemented"));
-             });
+  modelViewer_->setLightState(SceneState::LOADING);
+  asio::post(modelViewer_->getLoaderContext(), [&, promise,
+                                                url = std::move(url),
+                                                intensity] {
+    auto buffer = AssetCache::Get().Fetch(url);
+    if (!buffer) {
+      modelViewer_->setLightState(SceneState::ERROR);
+      promise->set_value(Resource<std::string_view>::Error(
+          "Couldn't load HDR file from " + url));
+      return;
+    }
+    auto hdr = std::make_shared<image::LinearImage>(
+        HDRLoader::decode(*buffer, url));
+    asio::post(modelViewer_->getStrandContext(),
+               [&, promise, hdr = std::move(hdr), intensity] {
+                 promise->set_value(
+                     loadIndirectLightHdrFromImage(*hdr, intensity));
+               });
+  });
   return future;
 }
 
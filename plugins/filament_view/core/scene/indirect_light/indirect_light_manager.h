@@ -19,6 +19,7 @@
 #include <filament/Engine.h>
 #include <filament/IndirectLight.h>
 #include <filament/LightManager.h>
+#include <image/LinearImage.h>
 
 #include "core/scene/geometry/direction.h"
 #include "core/scene/geometry/position.h"
@@ -64,8 +65,9 @@ class IndirectLightManager {
       std::string url,
       double intensity);
 
-  Resource<std::string_view> loadIndirectLightHdrFromFile(
-      const std::string& asset_path,
+  // Must run on the strand, image is decoded on the loader pool.
+  Resource<std::string_view> loadIndirectLightHdrFromImage(
+      const image::LinearImage& image,
       double intensity);
 
   std::future<Resource<std::string_view>> setIndirectLight(
@@ -2,7 +2,7 @@
 #include "core/scene/material/loader/material_loader.h"
 
 #include "core/include/file_utils.h"
-#include "plugins/common/curl_client/curl_client.h"
+#include "core/utils/asset_cache.h"
 
 namespace plugin_filament_view {
 MaterialLoader::MaterialLoader(CustomModelViewer* modelViewer,
@@ -16,9 +16,10 @@ Resource<::filament::Material*> MaterialLoader::loadMaterialFromAsset(
     const std::string& path) {
   auto buffer = readBinaryFile(path, assetPath_);
 
-  if (!buffer.empty()) {
+  if (buffer) {
+    // Parsed during build(), the mapping is not needed afterwards.
     auto material = ::filament::Material::Builder()
-                        .package(buffer.data(), buffer.size())
+                        .package(buffer->data(), buffer->size())
                         .build(*engine_);
     return Resource<::filament::Material*>::Success(material);
   } else {
@@ -29,22 +30,15 @@ Resource<::filament::Material*> MaterialLoader::loadMaterialFromAsset(
 
 Resource<::filament::Material*> MaterialLoader::loadMaterialFromUrl(
     const std::string& url) {
-  plugin_common_curl::CurlClient client;
-  // TODO client.Init(url);
-  std::vector<uint8_t> buffer = client.RetrieveContentAsVector();
-  if (client.GetCode() != CURLE_OK) {
+  auto buffer = AssetCache::Get().Fetch(url);
+  if (!buffer) {
     return Resource<::filament::Material*>::Error(
         "Failed to load material from " + url);
   }
 
-  if (!buffer.empty()) {
-    auto material = ::filament::Material::Builder()
-                        .package(buffer.data(), buffer.size())
-                        .build(*engine_);
-    return Resource<::filament::Material*>::Success(material);
-  } else {
-    return Resource<::filament::Material*>::Error(
-        "Could not load material from asset.");
-  }
+  auto material = ::filament::Material::Builder()
+                      .package(buffer->data(), buffer->size())
+                      .build(*engine_);
+  return Resource<::filament::Material*>::Success(material);
 }
 }  // namespace plugin_filament_view
@@ -3,7 +3,7 @@
 #include <imageio/ImageDecoder.h>
 #include <memory>
 #include "core/include/file_utils.h"
-#include "plugins/common/curl_client/curl_client.h"
+#include "core/utils/asset_cache.h"
 
 
 namespace plugin_filament_view {
@@ -77,8 +77,12 @@ inline ::filament::backend::TextureFormat internalFormat(
       spdlog::error("Texture Asset path is invalid: {}", file_path.c_str());
       return nullptr;
     }
-    return loadTextureFromStream(new std::ifstream(file_path, std::ios::binary),
-                                 texture->type_, texture->assetPath_);
+    auto buffer = AssetBuffer::Map(file_path);
+    if (!buffer) {
+      return nullptr;
+    }
+    AssetStream stream(*buffer);
+    return loadTextureFromStream(stream, texture->type_, texture->assetPath_);
   } else if (!texture->url_.empty()) {
     return loadTextureFromUrl(texture->url_, texture->type_);
   } else {
@@ -88,10 +92,10 @@ inline ::filament::backend::TextureFormat internalFormat(
 }
 
 ::filament::Texture* TextureLoader::loadTextureFromStream(
-    std::istream* ins,
+    std::istream& ins,
     Texture::TextureType type,
     const std::string& name) {
-  auto* image = new image::LinearImage(image::ImageDecoder::decode(*ins, name));
+  auto* image = new image::LinearImage(image::ImageDecoder::decode(ins, name));
   return createTextureFromImage(type,
                                 std::unique_ptr<image::LinearImage>(image));
 }
@@ -99,15 +103,13 @@ inline ::filament::backend::TextureFormat internalFormat(
 ::filament::Texture* TextureLoader::loadTextureFromUrl(
     std::string url,
     Texture::TextureType type) {
-  plugin_common_curl::CurlClient client;
-  client.Init(url, {}, {});
-  std::vector<uint8_t> buffer = client.RetrieveContentAsVector();
-  if (client.GetCode() != CURLE_OK) {
+  auto buffer = AssetCache::Get().Fetch(url);
+  if (!buffer) {
     spdlog::error("Failed to load texture from {}", url);
     return nullptr;
   }
-  std::string str(buffer.begin(), buffer.end());
-  return loadTextureFromStream(new std::istringstream(str), type, url);
+  AssetStream stream(*buffer);
+  return loadTextureFromStream(stream, type, url);
 }
 
 }  // namespace plugin_filament_view
@@ -4,6 +4,7 @@
 #include "viewer/custom_model_viewer.h"
 
 #include <future>
+#include <istream>
 
 #include <filament/Texture.h>
 #include <image/LinearImage.h>
@@ -39,7 +40,7 @@ class TextureLoader {
       Texture::TextureType type,
       std::unique_ptr<image::LinearImage> image);
 
-  ::filament::Texture* loadTextureFromStream(std::istream* ins,
+  ::filament::Texture* loadTextureFromStream(std::istream& ins,
                                              Texture::TextureType type,
                                              const std::string& name);
 
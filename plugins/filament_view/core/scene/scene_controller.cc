@@ -16,6 +16,7 @@
 
 #include "scene_controller.h"
 
+#include <algorithm>
 #include <asio/post.hpp>
 #include <utility>
 
@@ -27,6 +28,7 @@ SceneController::SceneController(PlatformView* platformView,
                                  FlutterDesktopEngineState* state,
                                  std::string flutterAssetsPath,
                                  Model* model,
+                                 std::vector<std::unique_ptr<Model>>* models,
                                  Scene* scene,
                                  std::vector<std::unique_ptr<Shape>>* shapes,
                                  int32_t id)
@@ -34,10 +36,12 @@ SceneController::SceneController(PlatformView* platformView,
       flutterAssetsPath_(std::move(flutterAssetsPath)),
       scene_(scene),
       model_(model),
+      models_(models),
       shapes_(shapes) {
   SPDLOG_TRACE("++SceneController::SceneController");
   setUpViewer(platformView, state);
   setUpLoadingModel();
+  setUpModels();
   setUpGround();
   setUpCamera();
   setUpSkybox();
@@ -223,6 +227,10 @@ void SceneController::setUpAnimation(std::optional<Animation*> animation) {
 void SceneController::setUpLoadingModel() {
   SPDLOG_TRACE("++SceneController::setUpLoadingModel");
   animationManager_ = std::make_unique<AnimationManager>(modelViewer_.get());
+  if (!model_) {
+    SPDLOG_TRACE("--SceneController::setUpLoadingModel");
+    return;
+  }
 
   auto result = loadModel(model_);
   if (result.getStatus() != Status::Success && model_->GetFallback()) {
@@ -240,6 +248,76 @@ void SceneController::setUpLoadingModel() {
   SPDLOG_TRACE("--SceneController::setUpLoadingModel");
 }
 
+void SceneController::setUpModels() {
+  if (!models_ || models_->empty()) {
+    return;
+  }
+  // Requested at once, copies of the same glb wait for a single fetch.
+  std::vector<std::future<Resource<uint32_t>>> futures;
+  futures.reserve(models_->size());
+  for (const auto& model : *models_) {
+    futures.emplace_back(requestModelInstance(model.get()));
+  }
+  for (auto& f : futures) {
+    auto result = f.get();
+    if (result.getStatus() != Status::Success) {
+      spdlog::error("[SceneController] {}", result.getMessage());
+      continue;
+    }
+    modelInstanceIds_.push_back(result.getData().value());
+  }
+}
+
+std::future<Resource<uint32_t>> SceneController::requestModelInstance(
+    Model* model) {
+  auto loader = modelViewer_->getModelLoader();
+  auto glb_model = dynamic_cast<GlbModel*>(model);
+  if (glb_model && !glb_model->assetPath_.empty()) {
+    return loader->addGlbInstanceFromAsset(glb_model->assetPath_,
+                                           glb_model->scale_,
+                                           glb_model->center_position_);
+  }
+  if (glb_model && !glb_model->url_.empty()) {
+    return loader->addGlbInstanceFromUrl(glb_model->url_, glb_model->scale_,
+                                         glb_model->center_position_);
+  }
+  std::promise<Resource<uint32_t>> promise;
+  promise.set_value(Resource<uint32_t>::Error(
+      glb_model ? "Glb model needs an assetPath or a url"
+                : "Only glb models can be copied"));
+  return promise.get_future();
+}
+
+Resource<uint32_t> SceneController::addModelInstance(Model* model) {
+  auto result = requestModelInstance(model).get();
+  if (result.getStatus() == Status::Success) {
+    modelInstanceIds_.push_back(result.getData().value());
+  }
+  return result;
+}
+
+Resource<std::string_view> SceneController::setModelInstanceTransform(
+    uint32_t id,
+    const ::filament::math::mat4f& transform) {
+  if (std::find(modelInstanceIds_.begin(), modelInstanceIds_.end(), id) ==
+      modelInstanceIds_.end()) {
+    return Resource<std::string_view>::Error("No model instance with this id");
+  }
+  return modelViewer_->getModelLoader()
+      ->setInstanceTransform(id, transform)
+      .get();
+}
+
+bool SceneController::removeModelInstance(uint32_t id) {
+  auto it = std::find(modelInstanceIds_.begin(), modelInstanceIds_.end(), id);
+  if (it == modelInstanceIds_.end()) {
+    return false;
+  }
+  modelInstanceIds_.erase(it);
+  modelViewer_->getModelLoader()->removeInstance(id);
+  return true;
+}
+
 void SceneController::setUpShapes() {
   shapeManager_ = std::make_unique<ShapeManager>(modelViewer_.get(),
                                                  materialManager_.get());
@@ -68,6 +68,7 @@ class SceneController {
                   FlutterDesktopEngineState* state,
                   std::string flutterAssetsPath,
                   Model* model,
+                  std::vector<std::unique_ptr<Model>>* models,
                   Scene* scene,
                   std::vector<std::unique_ptr<Shape>>* shapes,
                   int32_t id);
@@ -87,11 +88,50 @@ class SceneController {
     return cameraManager_.get();
   }
 
+  /**
+   * @brief Places a copy of a glb model next to the main model, copies of
+   * the same file share its GPU resources.  Waits until the copy is created.
+   * @param model Glb model, from an asset or a URL
+   * @return Resource<uint32_t> Id of the copy
+   * @relation
+   * filament_view
+   */
+  Resource<uint32_t> addModelInstance(Model* model);
+
+  /**
+   * @brief Replaces the placement of a copy
+   * @param id Id of the copy
+   * @param transform Transform of the root of the copy
+   * @return Resource<std::string_view> Error for an unknown id
+   * @relation
+   * filament_view
+   */
+  Resource<std::string_view> setModelInstanceTransform(
+      uint32_t id,
+      const ::filament::math::mat4f& transform);
+
+  /**
+   * @brief Removes a copy from the scene
+   * @param id Id of the copy
+   * @return bool
+   * @retval false No copy with this id
+   * @relation
+   * filament_view
+   */
+  bool removeModelInstance(uint32_t id);
+
+  // Ids of the copies in the scene, those of "models" first.
+  [[nodiscard]] const std::vector<uint32_t>& getModelInstanceIds() const {
+    return modelInstanceIds_;
+  }
+
  private:
   int32_t id_;
   std::string flutterAssetsPath_;
 
   Model* model_;
+  std::vector<std::unique_ptr<Model>>* models_;
+  std::vector<uint32_t> modelInstanceIds_;
   Scene* scene_;
   std::vector<std::unique_ptr<Shape>>* shapes_;
 
@@ -139,6 +179,10 @@ class SceneController {
 
   Resource<std::string_view> loadModel(Model* model);
 
+  void setUpModels();
+
+  std::future<Resource<uint32_t>> requestModelInstance(Model* model);
+
   void setUpAnimation(std::optional<Animation*> animation);
 
   void makeSurfaceViewTransparent();
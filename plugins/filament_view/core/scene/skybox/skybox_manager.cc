@@ -22,8 +22,8 @@
 #include <asio/post.hpp>
 
 #include "core/include/color.h"
+#include "core/utils/asset_cache.h"
 #include "core/utils/hdr_loader.h"
-#include "plugins/common/curl_client/curl_client.h"
 
 
 namespace plugin_filament_view {
@@ -85,13 +85,20 @@ std::future<Resource<std::string_view>> SkyboxManager::setSkyboxFromHdrAsset(
     modelViewer_->setSkyboxState(SceneState::ERROR);
     promise->set_value(
         Resource<std::string_view>::Error("Skybox Asset path is not valid"));
+    return future;
   }
 
-  asio::post(modelViewer_->getStrandContext(),
-             [&, promise, asset_path, showSun, shouldUpdateLight, intensity] {
-               promise->set_value(loadSkyboxFromHdrFile(
-                   asset_path, showSun, shouldUpdateLight, intensity));
-             });
+  asio::post(modelViewer_->getLoaderContext(), [&, promise, asset_path, showSun,
+                                                shouldUpdateLight, intensity] {
+    auto hdr =
+        std::make_shared<image::LinearImage>(HDRLoader::decode(asset_path));
+    asio::post(modelViewer_->getStrandContext(),
+               [&, promise, hdr = std::move(hdr), showSun,
+                shouldUpdateLight, intensity] {
+                 promise->set_value(loadSkyboxFromHdrImage(
+                     *hdr, showSun, shouldUpdateLight, intensity));
+               });
+  });
 
   SPDLOG_TRACE("--SkyboxManager::setSkyboxFromHdrAsset");
   return future;
@@ -116,25 +123,24 @@ std::future<Resource<std::string_view>> SkyboxManager::setSkyboxFromHdrUrl(
   }
 
   SPDLOG_DEBUG("Skybox downloading HDR Asset: {}", url.c_str());
-  asio::post(modelViewer_->getStrandContext(),
-             [&, promise, url, showSun, shouldUpdateLight, intensity] {
-               plugin_common_curl::CurlClient client;
-               //todo client.Init(url, {}, {});
-               auto buffer = client.RetrieveContentAsVector();
-               if (client.GetCode() != CURLE_OK) {
-                 modelViewer_->setSkyboxState(SceneState::ERROR);
-                 promise->set_value(Resource<std::string_view>::Error(
-                     "Couldn't load skybox from " + url));
-               }
-               if (!buffer.empty()) {
-                 promise->set_value(loadSkyboxFromHdrBuffer(
-                     buffer, showSun, shouldUpdateLight, intensity));
-               } else {
-                 modelViewer_->setSkyboxState(SceneState::ERROR);
-                 promise->set_value(Resource<std::string_view>::Error(
-                     "Couldn't load HDR file from " + url));
-               }
-             });
+  asio::post(modelViewer_->getLoaderContext(), [&, promise, url, showSun,
+                                                shouldUpdateLight, intensity] {
+    auto buffer = AssetCache::Get().Fetch(url);
+    if (!buffer) {
+      modelViewer_->setSkyboxState(SceneState::ERROR);
+      promise->set_value(Resource<std::string_view>::Error(
+          "Couldn't load HDR file from " + url));
+      return;
+    }
+    auto hdr = std::make_shared<image::LinearImage>(
+        HDRLoader::decode(*buffer, url));
+    asio::post(modelViewer_->getStrandContext(),
+               [&, promise, hdr = std::move(hdr), showSun,
+                shouldUpdateLight, intensity] {
+                 promise->set_value(loadSkyboxFromHdrImage(
+                     *hdr, showSun, shouldUpdateLight, intensity));
+               });
+  });
   SPDLOG_TRACE("--SkyboxManager::setSkyboxFromHdrUrl");
   return future;
 }
@@ -153,10 +159,11 @@ std::future<Resource<std::string_view>> SkyboxManager::setSkyboxFromKTXAsset(
     modelViewer_->setSkyboxState(SceneState::ERROR);
     promise->set_value(
         Resource<std::string_view>::Error("KTX Asset path is not valid"));
+    return future;
   }
 
   SPDLOG_DEBUG("Skybox loading KTX Asset: {}", asset_path.c_str());
-  asio::post(modelViewer_->getStrandContext(), [&, promise, asset_path] {
+  asio::post(modelViewer_->getLoaderContext(), [&, promise, asset_path] {
     std::ifstream stream(asset_path, std::ios::in | std::ios::binary);
     std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(stream)),
                                 std::istreambuf_iterator<char>());
@@ -194,18 +201,9 @@ std::future<Resource<std::string_view>> SkyboxManager::setSkyboxFromKTXUrl(
     return future;
   }
 
-  asio::post(modelViewer_->getStrandContext(), [&, promise, url] {
-    plugin_common_curl::CurlClient client;
-    //TODO client.Init(url, {}, {});
-    auto buffer = client.RetrieveContentAsVector();
-    if (client.GetCode() != CURLE_OK) {
-      modelViewer_->setSkyboxState(SceneState::ERROR);
-      std::stringstream ss;
-      ss << "Couldn't load skybox from " << url;
-      promise->set_value(Resource<std::string_view>::Error(ss.str()));
-    }
-
-    if (!buffer.empty()) {
+  asio::post(modelViewer_->getLoaderContext(), [&, promise, url] {
+    auto buffer = AssetCache::Get().Fetch(url);
+    if (buffer) {
 #if 0  // TODO
                 auto skybox = KTX1Loader.createSkybox(*engine, buffer);
                 modelViewer_->destroySkybox();
@@ -254,66 +252,12 @@ std::future<Resource<std::string_view>> SkyboxManager::setSkyboxFromColor(
   return future;
 }
 
-Resource<std::string_view> SkyboxManager::loadSkyboxFromHdrFile(
-    const std::string& assetPath,
-    bool showSun,
-    bool shouldUpdateLight,
-    float intensity) {
-  ::filament::Texture* texture;
-  try {
-    texture = HDRLoader::createTexture(engine_, assetPath);
-  } catch (...) {
-    modelViewer_->setSkyboxState(SceneState::ERROR);
-    return Resource<std::string_view>::Error("Could not decode HDR buffer");
-  }
-  if (texture) {
-    auto skyboxTexture = ibl_profiler_->createCubeMapTexture(texture);
-    engine_->destroy(texture);
-
-    if (skyboxTexture) {
-      auto sky = ::filament::Skybox::Builder()
-                     .environment(skyboxTexture)
-                     .showSun(showSun)
-                     .build(*engine_);
-
-      // updates scene light with skybox when loaded with the same hdr file
-      if (shouldUpdateLight) {
-        auto reflections = ibl_profiler_->getLightReflection(skyboxTexture);
-        auto ibl = ::filament::IndirectLight::Builder()
-                       .reflections(reflections)
-                       .intensity(intensity)
-                       .build(*engine_);
-        // destroy the previous IBl
-        auto indirectLight =
-            modelViewer_->getFilamentScene()->getIndirectLight();
-        engine_->destroy(indirectLight);
-        modelViewer_->getFilamentScene()->setIndirectLight(ibl);
-      }
-
-      modelViewer_->destroySkybox();
-      modelViewer_->getFilamentScene()->setSkybox(sky);
-    }
-    modelViewer_->setSkyboxState(SceneState::LOADED);
-    return Resource<std::string_view>::Success(
-        "Loaded hdr skybox successfully");
-  } else {
-    modelViewer_->setSkyboxState(SceneState::ERROR);
-    return Resource<std::string_view>::Error("Could not decode HDR file");
-  }
-}
-
-Resource<std::string_view> SkyboxManager::loadSkyboxFromHdrBuffer(
-    const std::vector<uint8_t>& buffer,
+Resource<std::string_view> SkyboxManager::loadSkyboxFromHdrImage(
+    const image::LinearImage& image,
     bool showSun,
     bool shouldUpdateLight,
     float intensity) {
-  ::filament::Texture* texture;
-  try {
-    texture = HDRLoader::createTexture(engine_, buffer);
-  } catch (...) {
-    modelViewer_->setSkyboxState(SceneState::ERROR);
-    return Resource<std::string_view>::Error("Could not decode HDR buffer");
-  }
+  auto texture = HDRLoader::createTexture(engine_, image);
   if (texture) {
     auto skyboxTexture = ibl_profiler_->createCubeMapTexture(texture);
     engine_->destroy(texture);
@@ -18,6 +18,8 @@
 
 #include <future>
 
+#include <image/LinearImage.h>
+
 #include "shell/platform/common/client_wrapper/include/flutter/encodable_value.h"
 
 #include "core/scene/geometry/direction.h"
@@ -57,17 +59,13 @@ class SkyboxManager {
   std::future<Resource<std::string_view>> setSkyboxFromColor(
       const std::string& color);
 
-  Resource<std::string_view> loadSkyboxFromHdrBuffer(
-      const std::vector<uint8_t>& buffer,
+  // Must run on the strand, image is decoded on the loader pool.
+  Resource<std::string_view> loadSkyboxFromHdrImage(
+      const image::LinearImage& image,
       bool showSun,
       bool shouldUpdateLight,
       float intensity);
 
-  Resource<std::string_view> loadSkyboxFromHdrFile(const std::string& assetPath,
-                                                   bool showSun,
-                                                   bool shouldUpdateLight,
-                                                   float intensity);
-
   void destroySkybox();
 
   // Disallow copy and assign.
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "asset_buffer.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "plugins/common/common.h"
+
+namespace plugin_filament_view {
+
+AssetBuffer::AssetBuffer(std::vector<uint8_t> bytes)
+    : bytes_(std::move(bytes)), data_(bytes_.data()), size_(bytes_.size()) {}
+
+AssetBuffer::~AssetBuffer() {
+  if (address_) {
+    munmap(address_, size_);
+  }
+}
+
+std::shared_ptr<const AssetBuffer> AssetBuffer::Map(
+    const std::filesystem::path& path) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    spdlog::error("[AssetBuffer] Failed to open {}: {}", path.c_str(),
+                  strerror(errno));
+    return nullptr;
+  }
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    spdlog::error("[AssetBuffer] Empty or unreadable file {}", path.c_str());
+    close(fd);
+    return nullptr;
+  }
+  const auto size = static_cast<size_t>(st.st_size);
+  void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file referenced.
+  close(fd);
+  if (address == MAP_FAILED) {
+    spdlog::error("[AssetBuffer] Failed to map {}: {}", path.c_str(),
+                  strerror(errno));
+    return nullptr;
+  }
+
+  std::shared_ptr<AssetBuffer> buffer(new AssetBuffer());
+  buffer->address_ = address;
+  buffer->data_ = static_cast<const uint8_t*>(address);
+  buffer->size_ = size;
+  return buffer;
+}
+
+void* AssetBuffer::Retain(std::shared_ptr<const AssetBuffer> buffer) {
+  return new std::shared_ptr<const AssetBuffer>(std::move(buffer));
+}
+
+void AssetBuffer::Release(void* /* data */, size_t /* size */, void* user) {
+  delete static_cast<std::shared_ptr<const AssetBuffer>*>(user);
+}
+
+AssetStream::AssetStream(const AssetBuffer& buffer)
+    : std::istream(nullptr), buf_(buffer) {
+  rdbuf(&buf_);
+}
+
+AssetStream::StreamBuf::StreamBuf(const AssetBuffer& buffer) {
+  // The get area is only read, the mapping may be read-only.
+  auto* begin = reinterpret_cast<char*>(const_cast<uint8_t*>(buffer.data()));
+  setg(begin, begin, begin + buffer.size());
+}
+
+AssetStream::StreamBuf::pos_type AssetStream::StreamBuf::seekoff(
+    off_type off,
+    std::ios_base::seekdir dir,
+    std::ios_base::openmode which) {
+  if (!(which & std::ios_base::in)) {
+    return {off_type(-1)};
+  }
+  off_type base = 0;
+  if (dir == std::ios_base::cur) {
+    base = gptr() - eback();
+  } else if (dir == std::ios_base::end) {
+    base = egptr() - eback();
+  }
+  const off_type pos = base + off;
+  if (pos < 0 || pos > egptr() - eback()) {
+    return {off_type(-1)};
+  }
+  setg(eback(), eback() + pos, egptr());
+  return {pos};
+}
+
+AssetStream::StreamBuf::pos_type AssetStream::StreamBuf::seekpos(
+    pos_type pos,
+    std::ios_base::openmode which) {
+  return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+}  // namespace plugin_filament_view
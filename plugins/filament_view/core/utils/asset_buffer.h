@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace plugin_filament_view {
+
+/**
+ * Immutable bytes of an asset, either owned in memory or a read-only
+ * mapping of a file.  Mapped assets are backed by the page cache, so they
+ * cost no heap and can be dropped by the kernel under memory pressure.
+ */
+class AssetBuffer {
+ public:
+  explicit AssetBuffer(std::vector<uint8_t> bytes);
+  ~AssetBuffer();
+
+  // Prevent copying.
+  AssetBuffer(AssetBuffer const&) = delete;
+  AssetBuffer& operator=(AssetBuffer const&) = delete;
+
+  /**
+   * @brief Map a file read-only
+   * @param path File to map
+   * @return std::shared_ptr<const AssetBuffer>
+   * @retval nullptr File is missing, empty or could not be mapped
+   * @relation
+   * filament_view
+   */
+  static std::shared_ptr<const AssetBuffer> Map(
+      const std::filesystem::path& path);
+
+  [[nodiscard]] const uint8_t* data() const { return data_; }
+
+  [[nodiscard]] size_t size() const { return size_; }
+
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  [[nodiscard]] bool mapped() const { return address_ != nullptr; }
+
+  /**
+   * @brief Reference to buffer for a consumer that drops it through a C
+   * callback, such as a Filament BufferDescriptor:
+   *   BufferDescriptor(buffer->data(), buffer->size(), AssetBuffer::Release,
+   *                    AssetBuffer::Retain(buffer))
+   * @param buffer Buffer to keep alive until Release
+   * @return void* user data for Release
+   * @relation
+   * filament_view
+   */
+  static void* Retain(std::shared_ptr<const AssetBuffer> buffer);
+
+  static void Release(void* data, size_t size, void* user);
+
+ private:
+  AssetBuffer() = default;
+
+  std::vector<uint8_t> bytes_;
+  void* address_{};
+  const uint8_t* data_{};
+  size_t size_{};
+};
+
+/**
+ * Reads an AssetBuffer in place, for decoders that take a std::istream.
+ * The buffer must outlive the stream.
+ */
+class AssetStream : public std::istream {
+ public:
+  explicit AssetStream(const AssetBuffer& buffer);
+
+ private:
+  class StreamBuf : public std::streambuf {
+   public:
+    explicit StreamBuf(const AssetBuffer& buffer);
+
+   protected:
+    pos_type seekoff(off_type off,
+                     std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override;
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+  };
+
+  StreamBuf buf_;
+};
+
+}  // namespace plugin_filament_view
@@ -0,0 +1,460 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "asset_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+#include <unistd.h>
+
+#include "plugins/common/common.h"
+#include "plugins/common/curl_client/curl_client.h"
+
+namespace plugin_filament_view {
+
+namespace {
+
+constexpr char kIndexName[] = "index";
+
+// Age after which a temporary object is taken as left by a crash rather
+// than being written by another process sharing the directory.
+constexpr auto kTempObjectGrace = std::chrono::hours(1);
+
+int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::filesystem::path DefaultDirectory() {
+  if (const char* xdg = getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    return std::filesystem::path(xdg) / "filament_view";
+  }
+  if (const char* home = getenv("HOME"); home && *home) {
+    return std::filesystem::path(home) / ".cache" / "filament_view";
+  }
+  return std::filesystem::temp_directory_path() / "filament_view";
+}
+
+// Content address of data: hash and size.  Not collision free, objects
+// with the same name are compared before they are shared.
+std::string ObjectName(const std::vector<uint8_t>& data) {
+  const size_t hash = std::hash<std::string_view>{}(std::string_view(
+      reinterpret_cast<const char*>(data.data()), data.size()));
+  std::stringstream ss;
+  ss << std::hex << hash << '-' << std::dec << data.size();
+  return ss.str();
+}
+
+// Seconds a response may be used without revalidation, nullopt when it
+// must not be stored.
+std::optional<int64_t> FreshFor(const std::optional<std::string>& header) {
+  if (!header) {
+    return AssetCache::kDefaultFreshSeconds;
+  }
+  std::string value = *header;
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (value.find("no-store") != std::string::npos) {
+    return std::nullopt;
+  }
+  if (value.find("no-cache") != std::string::npos) {
+    return 0;
+  }
+  const auto max_age = value.find("max-age=");
+  if (max_age != std::string::npos) {
+    return std::strtoll(value.c_str() + max_age + 8, nullptr, 10);
+  }
+  return AssetCache::kDefaultFreshSeconds;
+}
+
+}  // namespace
+
+AssetCache& AssetCache::Get() {
+  static AssetCache cache(DefaultDirectory());
+  return cache;
+}
+
+AssetCache::AssetCache(std::filesystem::path directory,
+                       uint64_t max_disk_bytes,
+                       size_t max_memory_bytes)
+    : directory_(std::move(directory)),
+      objects_(directory_ / "objects"),
+      max_disk_bytes_(max_disk_bytes),
+      max_memory_bytes_(max_memory_bytes) {
+  std::error_code ec;
+  std::filesystem::create_directories(objects_, ec);
+  if (ec) {
+    spdlog::error("[AssetCache] Caching in memory only, {}: {}",
+                  objects_.c_str(), ec.message());
+    return;
+  }
+  disk_ = true;
+  LoadIndex();
+}
+
+AssetCache::~AssetCache() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (index_dirty_) {
+    SaveIndexLocked();
+  }
+}
+
+std::shared_ptr<const AssetBuffer> AssetCache::Fetch(const std::string& url) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (auto pending = in_flight_.find(url); pending != in_flight_.end()) {
+    auto future = pending->second;
+    lock.unlock();
+    return future.get();
+  }
+
+  const int64_t now = Now();
+  std::optional<Entry> cached;
+  if (auto it = index_.find(url); it != index_.end()) {
+    std::error_code ec;
+    if (now - it->second.checked < it->second.fresh_for) {
+      if (auto buffer = LoadLocked(it->second)) {
+        // Only orders eviction, so it is not worth a write on every hit.
+        it->second.last_used = now;
+        index_dirty_ = true;
+        if (now - index_saved_at_ >= kIndexSaveSeconds) {
+          SaveIndexLocked();
+        }
+        SPDLOG_DEBUG("[AssetCache] hit {}", url);
+        return buffer;
+      }
+      index_.erase(it);
+    } else if (std::filesystem::file_size(objects_ / it->second.object, ec) ==
+               it->second.size) {
+      cached = it->second;
+    } else {
+      index_.erase(it);
+    }
+  }
+
+  std::promise<BufferPtr> promise;
+  in_flight_[url] = promise.get_future().share();
+  stats_.requests++;
+  lock.unlock();
+
+  auto response = Request(url, cached ? &cached.value() : nullptr);
+
+  lock.lock();
+  BufferPtr buffer;
+  if (!response.ok) {
+    stats_.failures++;
+    if (cached) {
+      stats_.stale++;
+      spdlog::warn("[AssetCache] Using stale {}", url);
+      buffer = LoadLocked(cached.value());
+    }
+  } else if (response.not_modified) {
+    stats_.not_modified++;
+    auto& entry = index_[url];
+    entry = cached.value();
+    entry.last_used = now;
+    entry.checked = now;
+    entry.fresh_for = response.fresh_for;
+    buffer = LoadLocked(entry);
+    SaveIndexLocked();
+    SPDLOG_DEBUG("[AssetCache] not modified {}", url);
+  } else {
+    stats_.bytes_downloaded += response.size;
+    if (!response.object.empty()) {
+      Entry entry{response.object,
+                  response.size,
+                  now,
+                  now,
+                  response.fresh_for,
+                  std::move(response.etag),
+                  std::move(response.last_modified)};
+      // The object may be an existing one no entry referenced, which
+      // another fetch could have evicted since it was stored.  Mapped and
+      // indexed under the lock, so it cannot be evicted in between.
+      buffer = LoadLocked(entry);
+      if (buffer) {
+        index_[url] = std::move(entry);
+        EvictLocked();
+        SaveIndexLocked();
+      }
+    }
+    if (!buffer && !response.body.empty()) {
+      buffer = std::make_shared<AssetBuffer>(std::move(response.body));
+    }
+    SPDLOG_DEBUG("[AssetCache] downloaded {} bytes from {}", response.size,
+                 url);
+  }
+  in_flight_.erase(url);
+  lock.unlock();
+
+  promise.set_value(buffer);
+  return buffer;
+}
+
+AssetCache::Stats AssetCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+AssetCache::Response AssetCache::Request(const std::string& url,
+                                         const Entry* cached) {
+  Response response{};
+  std::vector<std::string> headers;
+  if (cached && !cached->etag.empty()) {
+    headers.push_back("If-None-Match: " + cached->etag);
+  }
+  if (cached && !cached->last_modified.empty()) {
+    headers.push_back("If-Modified-Since: " + cached->last_modified);
+  }
+
+  plugin_common_curl::CurlClient client;
+  if (!client.Init(url, headers, {})) {
+    return response;
+  }
+  auto& body = client.RetrieveContentAsVector();
+  if (client.GetCode() != CURLE_OK) {
+    return response;
+  }
+
+  // Non-HTTP URLs, such as file://, have no status.
+  const long status = client.GetResponseCode();
+  const auto fresh_for = FreshFor(client.GetResponseHeader("Cache-Control"));
+  response.store = fresh_for.has_value();
+  response.fresh_for = fresh_for.value_or(0);
+  if (status == 304 && cached) {
+    response.ok = true;
+    response.not_modified = true;
+    return response;
+  }
+  if ((status != 0 && status != 200) || body.empty()) {
+    spdlog::error("[AssetCache] Failed to get {}: HTTP {}", url, status);
+    return response;
+  }
+
+  response.ok = true;
+  response.etag = client.GetResponseHeader("ETag").value_or("");
+  response.last_modified =
+      client.GetResponseHeader("Last-Modified").value_or("");
+  response.size = body.size();
+  if (response.store && disk_) {
+    response.object = StoreObject(body);
+  }
+  // Only kept until the stored object is mapped.
+  response.body = body;
+  return response;
+}
+
+std::string AssetCache::StoreObject(const std::vector<uint8_t>& data) {
+  const auto hashed = ObjectName(data);
+  std::string name;
+  std::filesystem::path path;
+  std::error_code ec;
+  // Colliding contents get the next free suffix.
+  for (int i = 0;; i++) {
+    name = i ? hashed + "." + std::to_string(i) : hashed;
+    path = objects_ / name;
+    if (std::filesystem::file_size(path, ec) != data.size()) {
+      break;
+    }
+    auto existing = AssetBuffer::Map(path);
+    if (existing && existing->size() == data.size() &&
+        memcmp(existing->data(), data.data(), data.size()) == 0) {
+      // Same content from another URL
+      return name;
+    }
+  }
+
+  // Written aside and renamed, so that a crash leaves no partial object.
+  auto temp = path;
+  temp += ".tmp" + std::to_string(getpid()) + "-" +
+          std::to_string(std::hash<std::thread::id>{}(
+              std::this_thread::get_id()));
+  {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+    if (!file) {
+      spdlog::error("[AssetCache] Failed to write {}", temp.c_str());
+      file.close();
+      std::filesystem::remove(temp, ec);
+      return {};
+    }
+  }
+  std::filesystem::rename(temp, path, ec);
+  if (ec) {
+    spdlog::error("[AssetCache] Failed to store {}: {}", path.c_str(),
+                  ec.message());
+    std::filesystem::remove(temp, ec);
+    return {};
+  }
+  return name;
+}
+
+AssetCache::BufferPtr AssetCache::LoadLocked(const Entry& entry) {
+  if (auto it = memory_index_.find(entry.object); it != memory_index_.end()) {
+    memory_.splice(memory_.begin(), memory_, it->second);
+    stats_.memory_hits++;
+    return it->second->second;
+  }
+
+  auto buffer = AssetBuffer::Map(objects_ / entry.object);
+  if (!buffer || buffer->size() != entry.size) {
+    return nullptr;
+  }
+  stats_.disk_hits++;
+  RememberLocked(entry.object, buffer);
+  return buffer;
+}
+
+void AssetCache::RememberLocked(const std::string& object,
+                                const BufferPtr& buffer) {
+  memory_.emplace_front(object, buffer);
+  memory_index_[object] = memory_.begin();
+  memory_bytes_ += buffer->size();
+  while (memory_bytes_ > max_memory_bytes_ && memory_.size() > 1) {
+    memory_bytes_ -= memory_.back().second->size();
+    memory_index_.erase(memory_.back().first);
+    memory_.pop_back();
+  }
+}
+
+void AssetCache::EvictLocked() {
+  // Size and most recent use of each object
+  std::map<std::string, std::pair<uint64_t, int64_t>> objects;
+  uint64_t total = 0;
+  for (const auto& [url, entry] : index_) {
+    auto [it, inserted] =
+        objects.try_emplace(entry.object, entry.size, entry.last_used);
+    if (inserted) {
+      total += entry.size;
+    } else {
+      it->second.second = std::max(it->second.second, entry.last_used);
+    }
+  }
+  while (total > max_disk_bytes_ && !objects.empty()) {
+    auto oldest = std::min_element(
+        objects.begin(), objects.end(), [](const auto& a, const auto& b) {
+          return a.second.second < b.second.second;
+        });
+    const std::string object = oldest->first;
+    total -= oldest->second.first;
+    objects.erase(oldest);
+
+    for (auto it = index_.begin(); it != index_.end();) {
+      it = it->second.object == object ? index_.erase(it) : std::next(it);
+    }
+    if (auto it = memory_index_.find(object); it != memory_index_.end()) {
+      memory_bytes_ -= it->second->second->size();
+      memory_.erase(it->second);
+      memory_index_.erase(it);
+    }
+    // Mappings handed out stay valid.
+    std::error_code ec;
+    std::filesystem::remove(objects_ / object, ec);
+    SPDLOG_DEBUG("[AssetCache] evicted {}", object);
+  }
+}
+
+void AssetCache::LoadIndex() {
+  std::ifstream file(directory_ / kIndexName);
+  std::string line;
+  while (std::getline(file, line)) {
+    // object, size, last used, checked, fresh for, etag, last modified, url
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, '\t')) {
+      fields.push_back(field);
+    }
+    if (fields.size() != 8) {
+      continue;
+    }
+    Entry entry{fields[0],
+                std::strtoull(fields[1].c_str(), nullptr, 10),
+                std::strtoll(fields[2].c_str(), nullptr, 10),
+                std::strtoll(fields[3].c_str(), nullptr, 10),
+                std::strtoll(fields[4].c_str(), nullptr, 10),
+                fields[5],
+                fields[6]};
+    std::error_code ec;
+    if (std::filesystem::file_size(objects_ / entry.object, ec) ==
+        entry.size) {
+      index_[fields[7]] = std::move(entry);
+    }
+  }
+
+  // Objects no longer indexed, and writes that never finished
+  std::set<std::string> referenced;
+  for (const auto& [url, entry] : index_) {
+    referenced.insert(entry.object);
+  }
+  std::error_code ec;
+  const auto now = std::filesystem::file_time_type::clock::now();
+  for (const auto& file_entry :
+       std::filesystem::directory_iterator(objects_, ec)) {
+    const auto name = file_entry.path().filename().string();
+    if (referenced.count(name)) {
+      continue;
+    }
+    if (name.find(".tmp") != std::string::npos) {
+      const auto written = file_entry.last_write_time(ec);
+      if (ec || now - written < kTempObjectGrace) {
+        continue;
+      }
+    }
+    std::filesystem::remove(file_entry.path(), ec);
+  }
+  EvictLocked();
+  SPDLOG_DEBUG("[AssetCache] {} entries in {}", index_.size(),
+               directory_.c_str());
+}
+
+void AssetCache::SaveIndexLocked() {
+  if (!disk_) {
+    return;
+  }
+  const auto path = directory_ / kIndexName;
+  auto temp = path;
+  temp += ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream file(temp, std::ios::trunc);
+    for (const auto& [url, entry] : index_) {
+      file << entry.object << '\t' << entry.size << '\t' << entry.last_used
+           << '\t' << entry.checked << '\t' << entry.fresh_for << '\t'
+           << entry.etag << '\t' << entry.last_modified << '\t' << url
+           << '\n';
+    }
+    if (!file) {
+      spdlog::error("[AssetCache] Failed to write {}", temp.c_str());
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(temp, path, ec);
+  index_dirty_ = false;
+  index_saved_at_ = Now();
+}
+
+}  // namespace plugin_filament_view
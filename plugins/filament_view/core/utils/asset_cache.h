@@ -0,0 +1,173 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "core/utils/asset_buffer.h"
+
+namespace plugin_filament_view {
+
+/**
+ * Cache of remote assets shared by all filament loaders and views, kept on
+ * disk across restarts.
+ *
+ * Entries are keyed by URL and point at content addressed objects, so the
+ * same file served from several URLs is stored once.  An entry is used
+ * without touching the network while it is fresh, for the max-age the
+ * server sent or kDefaultFreshSeconds; afterwards it is revalidated with
+ * If-None-Match / If-Modified-Since, and still used when the server cannot
+ * be reached.  Objects are read through read-only mappings, the most
+ * recently used ones are kept mapped up to kMaxMemoryBytes, and the least
+ * recently used are evicted beyond kMaxDiskBytes.  Concurrent fetches of
+ * the same URL share one download.
+ */
+class AssetCache {
+ public:
+  static constexpr uint64_t kMaxDiskBytes = 512ull * 1024 * 1024;
+  static constexpr size_t kMaxMemoryBytes = 128 * 1024 * 1024;
+  // Freshness of responses without a max-age.
+  static constexpr int64_t kDefaultFreshSeconds = 7 * 24 * 60 * 60;
+  // Cache hits only update the index in memory; it is written at most this
+  // often for them, and when the cache is destroyed.
+  static constexpr int64_t kIndexSaveSeconds = 60;
+
+  struct Stats {
+    uint64_t memory_hits;
+    uint64_t disk_hits;
+    // Requests sent, downloads and revalidations
+    uint64_t requests;
+    uint64_t not_modified;
+    uint64_t bytes_downloaded;
+    // Network failed, a stale entry was used
+    uint64_t stale;
+    uint64_t failures;
+  };
+
+  /**
+   * @brief Process wide cache, in $XDG_CACHE_HOME/filament_view
+   * @return AssetCache&
+   * @relation
+   * filament_view
+   */
+  static AssetCache& Get();
+
+  /**
+   * @param[in] directory Cache directory, created when missing
+   * @param[in] max_disk_bytes Size of cached objects on disk at most
+   * @param[in] max_memory_bytes Size of objects kept mapped at most
+   */
+  explicit AssetCache(std::filesystem::path directory,
+                      uint64_t max_disk_bytes = kMaxDiskBytes,
+                      size_t max_memory_bytes = kMaxMemoryBytes);
+
+  ~AssetCache();
+
+  // Prevent copying.
+  AssetCache(AssetCache const&) = delete;
+  AssetCache& operator=(AssetCache const&) = delete;
+
+  /**
+   * @brief Contents of a URL, from the cache or the network.  Blocks while
+   * downloading.
+   * @param[in] url URL of the asset
+   * @return std::shared_ptr<const AssetBuffer>
+   * @retval nullptr Asset is neither cached nor could be downloaded
+   * @relation
+   * filament_view
+   */
+  std::shared_ptr<const AssetBuffer> Fetch(const std::string& url);
+
+  [[nodiscard]] Stats GetStats() const;
+
+ private:
+  struct Entry {
+    // File name in objects/
+    std::string object;
+    uint64_t size;
+    // Unix time in seconds
+    int64_t last_used;
+    int64_t checked;
+    int64_t fresh_for;
+    std::string etag;
+    std::string last_modified;
+  };
+
+  // Outcome of a request, made without the lock held
+  struct Response {
+    bool ok;
+    bool not_modified;
+    bool store;
+    int64_t fresh_for;
+    std::string etag;
+    std::string last_modified;
+    uint64_t size;
+    // Object the body was written to, empty when not stored
+    std::string object;
+    // Body, used when the object is not stored or was evicted before it
+    // could be indexed
+    std::vector<uint8_t> body;
+  };
+
+  using BufferPtr = std::shared_ptr<const AssetBuffer>;
+
+  const std::filesystem::path directory_;
+  const std::filesystem::path objects_;
+  const uint64_t max_disk_bytes_;
+  const size_t max_memory_bytes_;
+  bool disk_{};
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Entry> index_;
+  std::map<std::string, std::shared_future<BufferPtr>> in_flight_;
+  // Mapped objects, most recently used first
+  std::list<std::pair<std::string, BufferPtr>> memory_;
+  std::map<std::string, std::list<std::pair<std::string, BufferPtr>>::iterator>
+      memory_index_;
+  size_t memory_bytes_{};
+  Stats stats_{};
+  // Index changed in memory since it was last written
+  bool index_dirty_{};
+  int64_t index_saved_at_{};
+
+  Response Request(const std::string& url, const Entry* cached);
+
+  // Returns the object of entry, mapping it if needed.
+  BufferPtr LoadLocked(const Entry& entry);
+
+  void RememberLocked(const std::string& object, const BufferPtr& buffer);
+
+  void EvictLocked();
+
+  void LoadIndex();
+
+  void SaveIndexLocked();
+
+  // Writes data as a content addressed object, returns its name.
+  std::string StoreObject(const std::vector<uint8_t>& data);
+};
+
+}  // namespace plugin_filament_view
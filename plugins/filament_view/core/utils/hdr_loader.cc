@@ -1,8 +1,5 @@
 #include "hdr_loader.h"
 
-#include <fstream>
-#include <sstream>
-
 #include <imageio/ImageDecoder.h>
 
 #include "plugins/common/common.h"
@@ -20,6 +17,13 @@ using namespace utils;
   return nullptr;
 }
 
+::filament::Texture* HDRLoader::createTexture(::filament::Engine* engine,
+                                              const LinearImage& image) {
+  // Shares the pixels of image until the upload has completed.
+  auto* owned = new LinearImage(image);
+  return createTextureFromImage(engine, owned);
+}
+
 ::filament::Texture* HDRLoader::createTextureFromImage(
     ::filament::Engine* engine,
     image::LinearImage* image) {
@@ -56,22 +60,28 @@ using namespace utils;
   return texture;
 }
 
-::filament::Texture* HDRLoader::createTexture(::filament::Engine* engine,
-                                              const std::string& asset_path,
-                                              const std::string& name) {
+LinearImage HDRLoader::decode(const std::string& asset_path,
+                              const std::string& name) {
   SPDLOG_DEBUG("Loading {}", asset_path.c_str());
-  std::ifstream ins(asset_path, std::ios::binary);
-  auto* image = new LinearImage(image::ImageDecoder::decode(ins, name));
-  return createTextureFromImage(engine, image);
+  auto buffer = AssetBuffer::Map(asset_path);
+  if (!buffer) {
+    return {};
+  }
+  return decode(*buffer, name);
 }
 
-::filament::Texture* HDRLoader::createTexture(
-    ::filament::Engine* engine,
-    const std::vector<uint8_t>& buffer,
-    const std::string& name) {
-  std::string str(buffer.begin(), buffer.end());
-  std::istringstream ins(str);
-  auto* image = new LinearImage(image::ImageDecoder::decode(ins, name));
-  return createTextureFromImage(engine, image);
+LinearImage HDRLoader::decode(const AssetBuffer& buffer,
+                              const std::string& name) {
+  AssetStream ins(buffer);
+  return decode(ins, name);
+}
+
+LinearImage HDRLoader::decode(std::istream& ins, const std::string& name) {
+  try {
+    return ImageDecoder::decode(ins, name);
+  } catch (...) {
+    spdlog::error("Could not decode HDR image {}", name);
+    return {};
+  }
 }
 }  // namespace plugin_filament_view
\ No newline at end of file
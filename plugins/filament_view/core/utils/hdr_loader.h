@@ -1,26 +1,48 @@
 #pragma once
 
-#include <vector>
+#include <istream>
+#include <string>
 
 #include <filament/Engine.h>
 #include <filament/Texture.h>
 #include <image/LinearImage.h>
 
+#include "core/utils/asset_buffer.h"
+
 namespace plugin_filament_view {
 
 class HDRLoader {
  public:
-  static ::filament::Texture* createTexture(
-      ::filament::Engine* engine,
-      const std::string& asset_path,
-      const std::string& name = "memory.hdr");
-
-  static ::filament::Texture* createTexture(
-      ::filament::Engine* engine,
-      const std::vector<uint8_t>& buffer,
-      const std::string& name = "memory.hdr");
+  /**
+   * @brief Decodes an HDR file.  Does not use the engine, so may run on a
+   * loader thread.
+   * @param asset_path Path of the file
+   * @param name Name for the decoder, its extension selects the format
+   * @return image::LinearImage, without channels when decoding failed
+   * @relation
+   * filament_view
+   */
+  static image::LinearImage decode(const std::string& asset_path,
+                                   const std::string& name = "memory.hdr");
+
+  static image::LinearImage decode(const AssetBuffer& buffer,
+                                   const std::string& name = "memory.hdr");
+
+  /**
+   * @brief Creates an RGB texture from a decoded image, on the engine thread
+   * @param engine Engine to create the texture with
+   * @param image Decoded image, shared until uploaded
+   * @return ::filament::Texture*
+   * @retval nullptr image is not RGB or the texture could not be created
+   * @relation
+   * filament_view
+   */
+  static ::filament::Texture* createTexture(::filament::Engine* engine,
+                                            const image::LinearImage& image);
 
  private:
+  static image::LinearImage decode(std::istream& ins, const std::string& name);
+
   static ::filament::Texture* deleteImageAndLogError(image::LinearImage* image);
 
   static ::filament::Texture* createTextureFromImage(::filament::Engine* engine,
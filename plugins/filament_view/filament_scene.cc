@@ -41,6 +41,13 @@ FilamentScene::FilamentScene(PlatformView* platformView,
 
     if (key == "model") {
       model_ = Model::Deserialize(flutterAssetsPath, it.second);
+    } else if (key == "models" &&
+               std::holds_alternative<flutter::EncodableList>(it.second)) {
+      for (const auto& it_ : std::get<flutter::EncodableList>(it.second)) {
+        if (std::holds_alternative<flutter::EncodableMap>(it_)) {
+          models_.emplace_back(Model::Deserialize(flutterAssetsPath, it_));
+        }
+      }
     } else if (key == "scene") {
       scene_ = std::make_unique<Scene>(flutterAssetsPath, it.second);
     } else if (key == "shapes" &&
@@ -61,8 +68,8 @@ FilamentScene::FilamentScene(PlatformView* platformView,
     }
   }
   sceneController_ = std::make_unique<SceneController>(
-      platformView, state, flutterAssetsPath, model_.get(), scene_.get(),
-      shapes_.get(), id);
+      platformView, state, flutterAssetsPath, model_.get(), &models_,
+      scene_.get(), shapes_.get(), id);
   SPDLOG_TRACE("--FilamentScene::FilamentScene");
 }
 
@@ -47,6 +47,8 @@ class FilamentScene {
   std::unique_ptr<SceneController> sceneController_;
 
   std::unique_ptr<Model> model_;
+  // Placed next to model_, copies of the same glb share GPU resources.
+  std::vector<std::unique_ptr<Model>> models_;
   std::unique_ptr<Scene> scene_;
   std::unique_ptr<std::vector<std::unique_ptr<Shape>>> shapes_{};
 };
@@ -175,6 +175,79 @@ void FilamentViewPlugin::ChangeToDefaultIndirectLight(
     const std::function<void(std::optional<FlutterError> reply)> /* result */) {
 }
 
+void FilamentViewPlugin::AddModelInstance(
+    const flutter::EncodableMap& model,
+    const std::function<void(ErrorOr<int64_t> reply)> result) {
+  if (!filamentScene_) {
+    result(FlutterError("disposed", "Scene was disposed"));
+    return;
+  }
+  auto copy = Model::Deserialize(flutterAssetsPath_,
+                                 flutter::EncodableValue(model));
+  auto res =
+      filamentScene_->getSceneController()->addModelInstance(copy.get());
+  if (res.getStatus() != Status::Success) {
+    result(FlutterError("addModelInstance", std::string(res.getMessage())));
+    return;
+  }
+  result(static_cast<int64_t>(res.getData().value()));
+}
+
+void FilamentViewPlugin::SetModelInstanceTransform(
+    int64_t id,
+    std::vector<double> transform,
+    const std::function<void(std::optional<FlutterError> reply)> result) {
+  if (!filamentScene_) {
+    result(FlutterError("disposed", "Scene was disposed"));
+    return;
+  }
+  if (transform.size() != 16) {
+    result(FlutterError("invalid_arguments",
+                        "Expected a column-major 4x4 transform"));
+    return;
+  }
+  ::filament::math::mat4f matrix;
+  for (size_t col = 0; col < 4; col++) {
+    for (size_t row = 0; row < 4; row++) {
+      matrix[col][row] = static_cast<float>(transform[col * 4 + row]);
+    }
+  }
+  auto res = filamentScene_->getSceneController()->setModelInstanceTransform(
+      static_cast<uint32_t>(id), matrix);
+  if (res.getStatus() != Status::Success) {
+    result(FlutterError("invalid_arguments", std::string(res.getMessage())));
+    return;
+  }
+  result(std::nullopt);
+}
+
+void FilamentViewPlugin::RemoveModelInstance(
+    int64_t id,
+    const std::function<void(std::optional<FlutterError> reply)> result) {
+  if (!filamentScene_) {
+    result(FlutterError("disposed", "Scene was disposed"));
+    return;
+  }
+  if (!filamentScene_->getSceneController()->removeModelInstance(
+          static_cast<uint32_t>(id))) {
+    result(FlutterError("invalid_arguments", "No model instance with this id"));
+    return;
+  }
+  result(std::nullopt);
+}
+
+void FilamentViewPlugin::GetModelInstanceIds(
+    const std::function<void(ErrorOr<flutter::EncodableList> reply)> result) {
+  flutter::EncodableList ids;
+  if (filamentScene_) {
+    for (auto id :
+         filamentScene_->getSceneController()->getModelInstanceIds()) {
+      ids.emplace_back(static_cast<int64_t>(id));
+    }
+  }
+  result(ids);
+}
+
 void FilamentViewPlugin::on_resize(double width, double height, void* data) {
   auto plugin = static_cast<FilamentViewPlugin*>(data);
   if (plugin && plugin->filamentScene_) {
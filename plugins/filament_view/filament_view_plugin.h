@@ -154,6 +154,25 @@ class FilamentViewPlugin : public flutter::Plugin,
       const std::function<void(std::optional<FlutterError> reply)> result)
       override;
 
+  void AddModelInstance(
+      const flutter::EncodableMap& model,
+      const std::function<void(ErrorOr<int64_t> reply)> result) override;
+
+  void SetModelInstanceTransform(
+      int64_t id,
+      std::vector<double> transform,
+      const std::function<void(std::optional<FlutterError> reply)> result)
+      override;
+
+  void RemoveModelInstance(
+      int64_t id,
+      const std::function<void(std::optional<FlutterError> reply)> result)
+      override;
+
+  void GetModelInstanceIds(
+      const std::function<void(ErrorOr<flutter::EncodableList> reply)> result)
+      override;
+
   // Disallow copy and assign.
   FilamentViewPlugin(const FilamentViewPlugin&) = delete;
 
@@ -51,10 +51,81 @@ void FilamentViewApi::SetUp(flutter::BinaryMessenger* binary_messenger,
           [api](const MethodCall<EncodableValue>& methodCall,
                 std::unique_ptr<MethodResult<EncodableValue>> result) {
             SPDLOG_DEBUG("[{}]", methodCall.method_name());
-            if (methodCall.method_name() == "CHANGE_ANIMATION_BY_INDEX") {
-              result->Success();
+            const auto& method = methodCall.method_name();
+            const auto* args =
+                std::get_if<flutter::EncodableMap>(methodCall.arguments());
+            const auto arg = [args](const char* key) -> const EncodableValue* {
+              if (!args) {
+                return nullptr;
+              }
+              auto it = args->find(EncodableValue(key));
+              return it == args->end() ? nullptr : &it->second;
+            };
+            const auto* id = arg("id");
+            const bool has_id =
+                id && (std::holds_alternative<int32_t>(*id) ||
+                       std::holds_alternative<int64_t>(*id));
+            std::shared_ptr<MethodResult<EncodableValue>> reply(
+                std::move(result));
+            const auto done = [reply](std::optional<FlutterError> error) {
+              if (error.has_value()) {
+                reply->Error(error->code(), error->message(),
+                             error->details());
+                return;
+              }
+              reply->Success();
+            };
+
+            if (method == "CHANGE_ANIMATION_BY_INDEX") {
+              reply->Success();
+            } else if (method == "ADD_MODEL_INSTANCE") {
+              const auto* model = arg("model");
+              if (!model || !std::holds_alternative<flutter::EncodableMap>(
+                                *model)) {
+                reply->Error("invalid_arguments", "Expected a model map");
+                return;
+              }
+              api->AddModelInstance(
+                  std::get<flutter::EncodableMap>(*model),
+                  [reply](ErrorOr<int64_t> output) {
+                    if (output.has_error()) {
+                      reply->Error(output.error().code(),
+                                   output.error().message(),
+                                   output.error().details());
+                      return;
+                    }
+                    reply->Success(EncodableValue(output.value()));
+                  });
+            } else if (method == "SET_MODEL_INSTANCE_TRANSFORM") {
+              const auto* transform = arg("transform");
+              if (!has_id || !transform ||
+                  !std::holds_alternative<std::vector<double>>(*transform)) {
+                reply->Error("invalid_arguments",
+                             "Expected an id and a transform");
+                return;
+              }
+              api->SetModelInstanceTransform(
+                  id->LongValue(), std::get<std::vector<double>>(*transform),
+                  done);
+            } else if (method == "REMOVE_MODEL_INSTANCE") {
+              if (!has_id) {
+                reply->Error("invalid_arguments", "Expected an id");
+                return;
+              }
+              api->RemoveModelInstance(id->LongValue(), done);
+            } else if (method == "GET_MODEL_INSTANCE_IDS") {
+              api->GetModelInstanceIds(
+                  [reply](ErrorOr<flutter::EncodableList> output) {
+                    if (output.has_error()) {
+                      reply->Error(output.error().code(),
+                                   output.error().message(),
+                                   output.error().details());
+                      return;
+                    }
+                    reply->Success(EncodableValue(output.value()));
+                  });
             } else {
-              result->NotImplemented();
+              reply->NotImplemented();
             }
 #if 0
                             try {
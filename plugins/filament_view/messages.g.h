@@ -25,6 +25,7 @@
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <flutter/standard_method_codec.h>
 
@@ -163,6 +164,23 @@ class FilamentViewApi {
   virtual void ChangeToDefaultIndirectLight(
       const std::function<void(std::optional<FlutterError> reply)> result) = 0;
 
+  virtual void AddModelInstance(
+      const flutter::EncodableMap& model,
+      const std::function<void(ErrorOr<int64_t> reply)> result) = 0;
+
+  virtual void SetModelInstanceTransform(
+      int64_t id,
+      std::vector<double> transform,
+      const std::function<void(std::optional<FlutterError> reply)> result) = 0;
+
+  virtual void RemoveModelInstance(
+      int64_t id,
+      const std::function<void(std::optional<FlutterError> reply)> result) = 0;
+
+  virtual void GetModelInstanceIds(
+      const std::function<void(ErrorOr<flutter::EncodableList> reply)>
+          result) = 0;
+
 #if 0
         kMethodChangeLight
         kMethodChangeToDefaultLight
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/utils/asset_cache.h"
+#include "plugins/common/testing/testing.h"
+
+using plugin_filament_view::AssetBuffer;
+using plugin_filament_view::AssetCache;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Assets are served from files; file:// responses carry no headers, so
+// they are cached with the default freshness.
+fs::path www;
+
+std::string Url(const char* name) {
+  return "file://" + (www / name).string();
+}
+
+std::vector<uint8_t> Write(const char* name, size_t size, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> data(size);
+  for (auto& byte : data) {
+    byte = static_cast<uint8_t>(rng());
+  }
+  std::ofstream file(www / name, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(data.data()),
+             static_cast<std::streamsize>(data.size()));
+  return data;
+}
+
+bool Same(const std::shared_ptr<const AssetBuffer>& buffer,
+          const std::vector<uint8_t>& data) {
+  return buffer && buffer->size() == data.size() &&
+         memcmp(buffer->data(), data.data(), data.size()) == 0;
+}
+
+size_t Objects(const fs::path& cache) {
+  size_t count = 0;
+  for (const auto& file : fs::directory_iterator(cache / "objects")) {
+    count += file.is_regular_file();
+  }
+  return count;
+}
+
+// Downloads are stored once per content and shared by concurrent fetches.
+void TestFetch(const fs::path& cache,
+               const std::vector<uint8_t>& a,
+               const std::vector<uint8_t>& c) {
+  AssetCache assets(cache);
+
+  auto buffer = assets.Fetch(Url("a"));
+  EXPECT(Same(buffer, a));
+  EXPECT(buffer && buffer->mapped());
+  EXPECT(assets.Fetch(Url("a")) == buffer);
+
+  // Same content from another URL
+  EXPECT(Same(assets.Fetch(Url("copy_of_a")), a));
+  EXPECT(Objects(cache) == 1);
+
+  std::vector<std::thread> threads;
+  std::atomic<int> same{0};
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&] { same += Same(assets.Fetch(Url("c")), c); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT(same == 8);
+  EXPECT(Objects(cache) == 2);
+
+  EXPECT(assets.Fetch(Url("missing")) == nullptr);
+
+  const auto stats = assets.GetStats();
+  EXPECT(stats.requests == 4);
+  EXPECT(stats.failures == 1);
+  EXPECT(stats.memory_hits >= 1);
+}
+
+// A new cache reads the index, so fresh entries need no request, even when
+// the source is gone.
+void TestRestart(const fs::path& cache,
+                 const std::vector<uint8_t>& a,
+                 const std::vector<uint8_t>& c) {
+  fs::remove(www / "a");
+  AssetCache assets(cache);
+  EXPECT(Same(assets.Fetch(Url("a")), a));
+  EXPECT(Same(assets.Fetch(Url("copy_of_a")), a));
+  EXPECT(Same(assets.Fetch(Url("c")), c));
+  const auto stats = assets.GetStats();
+  EXPECT(stats.requests == 0);
+  EXPECT(stats.disk_hits == 2);
+  EXPECT(stats.memory_hits == 1);
+}
+
+// The least recently used object goes once the disk limit is exceeded.
+void TestEvict(const fs::path& cache,
+               const std::vector<uint8_t>& c,
+               const std::vector<uint8_t>& d) {
+  AssetCache assets(cache, c.size() + d.size() - 1, 1024 * 1024);
+  EXPECT(Same(assets.Fetch(Url("c")), c));
+  // Last use is kept in seconds
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  EXPECT(Same(assets.Fetch(Url("d")), d));
+  EXPECT(Objects(cache) == 1);
+  EXPECT(Same(assets.Fetch(Url("d")), d));
+  EXPECT(assets.GetStats().requests == 2);
+  EXPECT(Same(assets.Fetch(Url("c")), c));
+  EXPECT(assets.GetStats().requests == 3);
+}
+
+// Unreferenced objects are removed on start, temporary ones only once they
+// are old enough not to be another process's write in progress.
+void TestCleanup(const fs::path& cache) {
+  fs::create_directories(cache / "objects");
+  for (const char* name : {"orphan", "fresh.tmp1-2", "stale.tmp1-2"}) {
+    std::ofstream(cache / "objects" / name) << name;
+  }
+  fs::last_write_time(cache / "objects" / "stale.tmp1-2",
+                      fs::file_time_type::clock::now() - std::chrono::hours(2));
+
+  AssetCache assets(cache);
+  EXPECT(!fs::exists(cache / "objects" / "orphan"));
+  EXPECT(fs::exists(cache / "objects" / "fresh.tmp1-2"));
+  EXPECT(!fs::exists(cache / "objects" / "stale.tmp1-2"));
+}
+
+}  // namespace
+
+int main() {
+  char temp[] = "/tmp/asset_cache_test.XXXXXX";
+  if (!mkdtemp(temp)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  const fs::path root(temp);
+  www = root / "www";
+  fs::create_directories(www);
+
+  const auto a = Write("a", 10000, 1);
+  Write("copy_of_a", 10000, 1);
+  const auto c = Write("c", 20000, 2);
+  const auto d = Write("d", 30000, 3);
+
+  TestFetch(root / "cache", a, c);
+  TestRestart(root / "cache", a, c);
+  TestEvict(root / "small", c, d);
+  TestCleanup(root / "cleanup");
+
+  std::error_code ec;
+  fs::remove_all(root, ec);
+  return plugin_common_testing::TestResult();
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include "core/include/file_utils.h"
+#include "plugins/common/testing/testing.h"
+
+using plugin_filament_view::decodeUri;
+
+int main() {
+  EXPECT(decodeUri("").empty());
+  EXPECT(decodeUri("scene.bin") == "scene.bin");
+  EXPECT(decodeUri("textures/base%20color.png") == "textures/base color.png");
+  EXPECT(decodeUri("%41%62%2fc") == "Ab/c");
+  EXPECT(decodeUri("a%2Bb%2bc") == "a+b+c");
+  EXPECT(decodeUri("caf%C3%A9.png") == "caf\xc3\xa9.png");
+  EXPECT(decodeUri("%00") == std::string(1, '\0'));
+  // Malformed escapes are kept
+  EXPECT(decodeUri("100%") == "100%");
+  EXPECT(decodeUri("a%4") == "a%4");
+  EXPECT(decodeUri("%zz%4g") == "%zz%4g");
+  EXPECT(decodeUri("%%41") == "%A");
+  // Decoded once
+  EXPECT(decodeUri("%2541") == "%41");
+
+  return plugin_common_testing::TestResult();
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "core/model/loader/instance_table.h"
+#include "plugins/common/testing/testing.h"
+
+namespace {
+
+struct Asset {
+  int* asset{};
+};
+
+struct Instance {
+  int n;
+};
+
+using Table = plugin_filament_view::InstanceTable<Asset, Instance, float>;
+
+// Copies of one source share its entry, ids are never reused.
+void TestAdd() {
+  Table table;
+  bool created;
+  const auto a = table.add("a.glb", 1.0f, created);
+  EXPECT(created);
+  const auto b = table.add("a.glb", 2.0f, created);
+  EXPECT(!created);
+  const auto c = table.add("c.glb", 3.0f, created);
+  EXPECT(created);
+  EXPECT(a != b && b != c && a != c);
+  EXPECT(table.size() == 3);
+  EXPECT(table.sources().size() == 2);
+
+  auto copy = table.find(b);
+  EXPECT(copy && copy->source == "a.glb" && copy->placement == 2.0f);
+  EXPECT(copy && copy->instance == nullptr);
+  EXPECT(table.find(99) == nullptr);
+  EXPECT(table.findSource("missing.glb") == nullptr);
+  auto source = table.findSource("a.glb");
+  EXPECT(source && (source->copies == std::vector<uint32_t>{a, b}));
+
+  table.remove(c);
+  const auto d = table.add("c.glb", 4.0f, created);
+  EXPECT(d > c);
+}
+
+// A removed copy's instance is reused by the next copy of its source, the
+// source goes with its last copy.
+void TestRemove() {
+  Table table;
+  int asset;
+  Instance instances[2]{{0}, {1}};
+  bool created;
+  const auto a = table.add("a.glb", 1.0f, created);
+  const auto b = table.add("a.glb", 1.0f, created);
+  auto& source = *table.findSource("a.glb");
+  source.data.asset = &asset;
+  table.find(a)->instance = &instances[0];
+  table.find(b)->instance = &instances[1];
+
+  EXPECT(table.remove(a) == nullptr);
+  EXPECT(table.find(a) == nullptr);
+  EXPECT((source.copies == std::vector<uint32_t>{b}));
+  EXPECT((source.released == std::vector<Instance*>{&instances[0]}));
+  EXPECT(table.remove(a) == nullptr);
+
+  const auto c = table.add("a.glb", 1.0f, created);
+  EXPECT(!created);
+  EXPECT(Table::takeReleased(source) == &instances[0]);
+  EXPECT(Table::takeReleased(source) == nullptr);
+  table.find(c)->instance = &instances[0];
+
+  EXPECT(table.remove(b) == nullptr);
+  EXPECT(table.remove(c) == &source);
+  EXPECT(source.copies.empty());
+  EXPECT(source.released.size() == 2);
+  EXPECT(source.data.asset == &asset);
+  table.eraseSource("a.glb");
+  EXPECT(table.findSource("a.glb") == nullptr);
+  EXPECT(table.size() == 0);
+}
+
+// Copies waiting for the asset have no instance to keep.
+void TestPending() {
+  Table table;
+  bool created;
+  const auto a = table.add("a.glb", 1.0f, created);
+  const auto b = table.add("a.glb", 1.0f, created);
+  const auto c = table.add("a.glb", 1.0f, created);
+  EXPECT(table.remove(a) == nullptr);
+  EXPECT(table.findSource("a.glb")->released.empty());
+
+  // A copy whose instance could not be created
+  table.erase(b);
+  EXPECT(table.find(b) == nullptr);
+  EXPECT((table.findSource("a.glb")->copies == std::vector<uint32_t>{c}));
+
+  // The fetch failed
+  table.eraseSource("a.glb");
+  EXPECT(table.find(c) == nullptr);
+  EXPECT(table.sources().empty());
+  EXPECT(table.size() == 0);
+
+  // The last copy went while the glb was fetched, the entry is left for
+  // the fetch to drop.
+  const auto d = table.add("d.glb", 1.0f, created);
+  auto last = table.remove(d);
+  EXPECT(last && last->data.asset == nullptr);
+  EXPECT(table.findSource("d.glb") != nullptr);
+}
+
+}  // namespace
+
+int main() {
+  TestAdd();
+  TestRemove();
+  TestPending();
+  return plugin_common_testing::TestResult();
+}
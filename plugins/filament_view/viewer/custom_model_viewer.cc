@@ -16,9 +16,12 @@
 
 #include "custom_model_viewer.h"
 
+#include <algorithm>
+#include <thread>
+#include <utility>
+
 #include <wayland-client.h>
 #include <asio/post.hpp>
-#include <utility>
 
 #include "plugins/common/common.h"
 #include "view/flutter_view.h"
@@ -42,6 +45,9 @@ CustomModelViewer::CustomModelViewer(PlatformView* platformView,
       io_context_(std::make_unique<asio::io_context>(ASIO_CONCURRENCY_HINT_1)),
       work_(io_context_->get_executor()),
       strand_(std::make_unique<asio::io_context::strand>(*io_context_)),
+      // Mostly waiting on I/O, glTF resources are all fetched at once.
+      loader_pool_(std::make_unique<asio::thread_pool>(
+          std::clamp(std::thread::hardware_concurrency(), 4u, 8u))),
       callback_(nullptr),
       fanimator_(nullptr),
       currentModelState_(ModelState::NONE),
@@ -77,6 +83,11 @@ CustomModelViewer::CustomModelViewer(PlatformView* platformView,
 CustomModelViewer::~CustomModelViewer() {
   SPDLOG_TRACE("++CustomModelViewer::~CustomModelViewer");
 
+  // Loads still queued are dropped, running ones finish before the engine
+  // goes away.
+  loader_pool_->stop();
+  loader_pool_->join();
+
   if (callback_) {
     wl_callback_destroy(callback_);
     callback_ = nullptr;
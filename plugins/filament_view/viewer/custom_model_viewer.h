@@ -34,6 +34,7 @@
 #include <gltfio/ResourceLoader.h>
 #include <wayland-client.h>
 #include <asio/io_context_strand.hpp>
+#include <asio/thread_pool.hpp>
 
 #include "core/model/loader/model_loader.h"
 #include "core/model/model.h"
@@ -122,6 +123,18 @@ class CustomModelViewer {
     return *strand_;
   }
 
+  /**
+   * @brief Pool for loader work that does not touch the Filament API, such
+   * as fetching, reading and decoding assets.  Only the creation of Filament
+   * objects is posted back to the strand, so loads do not stall frames.
+   * @return asio::thread_pool&
+   * @relation
+   * filament_view
+   */
+  [[nodiscard]] asio::thread_pool& getLoaderContext() const {
+    return *loader_pool_;
+  }
+
   filament::viewer::Settings& getSettings() { return settings_; }
 
   filament::gltfio::FilamentAsset* getAsset() { return asset_; }
@@ -163,6 +176,7 @@ class CustomModelViewer {
   std::unique_ptr<asio::io_context> io_context_;
   asio::executor_work_guard<decltype(io_context_->get_executor())> work_;
   std::unique_ptr<asio::io_context::strand> strand_;
+  std::unique_ptr<asio::thread_pool> loader_pool_;
 
   wl_display* display_{};
   wl_surface* surface_{};
@@ -48,6 +48,7 @@ void PrintingApi::SetUp(flutter::BinaryMessenger* binary_messenger,
                   {EncodableValue("canPrint"), EncodableValue(false)},
                   {EncodableValue("canShare"), EncodableValue(true)},
                   {EncodableValue("canRaster"), EncodableValue(true)},
+                  {EncodableValue("canRasterTiles"), EncodableValue(true)},
                   {EncodableValue("canListPrinters"), EncodableValue(false)},
                   {EncodableValue("directPrint"), EncodableValue(false)},
                   {EncodableValue("dynamicLayout"), EncodableValue(false)},
@@ -93,6 +94,59 @@ void PrintingApi::SetUp(flutter::BinaryMessenger* binary_messenger,
               }
               api->RasterPdf(std::move(doc), std::move(pages), scale, job_id);
               result->Success();
+            } else if ("rasterTiles" == call.method_name()) {
+              const auto& args = std::get_if<EncodableMap>(call.arguments());
+              std::vector<uint8_t> doc;
+              std::vector<int32_t> held;
+              int32_t page = 0;
+              int32_t job_id = 0;
+              double scale = 1;
+              double x = 0;
+              double y = 0;
+              double width = 0;
+              double height = 0;
+              for (auto& it : *args) {
+                const auto& key = std::get<std::string>(it.first);
+                if ("doc" == key &&
+                    std::holds_alternative<std::vector<uint8_t>>(it.second)) {
+                  doc = std::get<std::vector<uint8_t>>(it.second);
+                } else if ("held" == key &&
+                           std::holds_alternative<std::vector<int32_t>>(
+                               it.second)) {
+                  held = std::get<std::vector<int32_t>>(it.second);
+                } else if ("page" == key &&
+                           std::holds_alternative<int32_t>(it.second)) {
+                  page = std::get<int32_t>(it.second);
+                } else if ("job" == key &&
+                           std::holds_alternative<int32_t>(it.second)) {
+                  job_id = std::get<int32_t>(it.second);
+                } else if (std::holds_alternative<double>(it.second)) {
+                  const auto value = std::get<double>(it.second);
+                  if ("scale" == key) {
+                    scale = value;
+                  } else if ("x" == key) {
+                    x = value;
+                  } else if ("y" == key) {
+                    y = value;
+                  } else if ("width" == key) {
+                    width = value;
+                  } else if ("height" == key) {
+                    height = value;
+                  }
+                }
+              }
+              api->RasterTiles(std::move(doc), page, scale, x, y, width,
+                               height, std::move(held), job_id);
+              result->Success();
+            } else if ("cancelRaster" == call.method_name()) {
+              const auto& args = std::get_if<EncodableMap>(call.arguments());
+              for (auto& it : *args) {
+                if ("job" == std::get<std::string>(it.first) &&
+                    std::holds_alternative<int32_t>(it.second)) {
+                  api->CancelRaster(std::get<int32_t>(it.second));
+                }
+              }
+              result->Success();
             } else {
               result->NotImplemented();
             }
@@ -73,6 +73,16 @@ class PrintingApi {
                                                 std::vector<int32_t> pages,
                                                 double scale,
                                                 int job_id) = 0;
+  virtual std::optional<FlutterError> RasterTiles(std::vector<uint8_t> doc,
+                                                  int32_t page,
+                                                  double scale,
+                                                  double x,
+                                                  double y,
+                                                  double width,
+                                                  double height,
+                                                  std::vector<int32_t> held,
+                                                  int job_id) = 0;
+  virtual std::optional<FlutterError> CancelRaster(int job_id) = 0;
   virtual bool SharePdf(std::vector<uint8_t> buffer,
                         const std::string& name) = 0;
 
@@ -18,19 +18,67 @@
 
 #include <sys/wait.h>
 #include <unistd.h>
+#include <condition_variable>
 #include <memory>
-#include <numeric>
+#include <mutex>
 
 #include <flutter/plugin_registrar.h>
-#include <fpdfview.h>
 
 #include "messages.h"
 #include "plugins/common/common.h"
+#include "plugins/common/glib/main_loop.h"
 
 namespace plugin_pdf {
 
 std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel;
 
+struct Outbox {
+  std::mutex mutex;
+  std::condition_variable cv;
+  // Messages posted and not yet sent
+  size_t pending{};
+  // Set when the plugin is destroyed, later messages are dropped
+  bool closed{};
+};
+
+namespace {
+
+// Sends from the main loop thread, which sends the channel messages of the
+// plugins, rather than from the delivery thread of the raster queue.  Waits
+// while kMaxPendingPages messages are unsent, so rendering stays close to
+// Dart, but never once the plugin is being destroyed.
+void SendFromMainLoop(const std::shared_ptr<Outbox>& outbox,
+                      const char* method,
+                      flutter::EncodableValue args) {
+  {
+    std::unique_lock<std::mutex> lock(outbox->mutex);
+    outbox->cv.wait(lock, [&outbox] {
+      return outbox->closed || outbox->pending < RasterQueue::kMaxPendingPages;
+    });
+    if (outbox->closed) {
+      return;
+    }
+    outbox->pending++;
+  }
+
+  // std::function needs a copyable task, the pixels are not copied.
+  auto value = std::make_shared<flutter::EncodableValue>(std::move(args));
+  plugin_common_glib::MainLoop::Post([outbox, method, value] {
+    {
+      std::lock_guard<std::mutex> lock(outbox->mutex);
+      if (outbox->closed) {
+        return;
+      }
+      outbox->pending--;
+      channel->InvokeMethod(
+          method, std::make_unique<flutter::EncodableValue>(std::move(*value)));
+    }
+    outbox->cv.notify_all();
+  });
+}
+
+}  // namespace
+
 // static
 void PdfPlugin::RegisterWithRegistrar(flutter::PluginRegistrar* registrar) {
   auto plugin = std::make_unique<PdfPlugin>();
@@ -40,116 +88,57 @@ void PdfPlugin::RegisterWithRegistrar(flutter::PluginRegistrar* registrar) {
   registrar->AddPlugin(std::move(plugin));
 }
 
-PdfPlugin::PdfPlugin() = default;
-
-PdfPlugin::~PdfPlugin() = default;
+PdfPlugin::PdfPlugin()
+    : outbox_(std::make_shared<Outbox>()),
+      raster_queue_(std::make_unique<RasterQueue>(
+          [outbox = outbox_](std::vector<uint8_t> data,
+                             int width,
+                             int height,
+                             int job_id) {
+            on_page_rasterized(outbox, std::move(data), width, height, job_id);
+          },
+          [outbox = outbox_](RasterQueue::Tile tile) {
+            on_tile_rasterized(outbox, std::move(tile));
+          },
+          [outbox = outbox_](int job_id, const std::string& error) {
+            on_page_raster_end(outbox, job_id, error);
+          })) {}
+
+PdfPlugin::~PdfPlugin() {
+  // Releases the delivery thread, which the raster queue joins.
+  {
+    std::lock_guard<std::mutex> lock(outbox_->mutex);
+    outbox_->closed = true;
+  }
+  outbox_->cv.notify_all();
+}
 
 std::optional<FlutterError> PdfPlugin::RasterPdf(std::vector<uint8_t> data,
                                                  std::vector<int32_t> pages,
                                                  double scale,
                                                  int job_id) {
-  SPDLOG_DEBUG("\tdoc_size: {}", data.size());
-  SPDLOG_DEBUG("\tpages_count: {}", pages.size());
-  SPDLOG_DEBUG("\tscale: {}", scale);
-  SPDLOG_DEBUG("\tjob: {}", job_id);
-  FPDF_LIBRARY_CONFIG config;
-  config.version = 2;
-  config.m_pUserFontPaths = nullptr;
-  config.m_pIsolate = nullptr;
-  config.m_v8EmbedderSlot = 0;
-  // requires a PDFium build with skia enabled
-  config.m_RendererType = FPDF_RENDERERTYPE_SKIA;
-
-  FPDF_InitLibraryWithConfig(&config);
-
-  auto doc = FPDF_LoadMemDocument64(data.data(), data.size(), nullptr);
-  if (!doc) {
-    unsigned long err = FPDF_GetLastError();
-    SPDLOG_DEBUG("[pdf] Load unsuccessful: job: {}", job_id);
-    switch (err) {
-      case FPDF_ERR_SUCCESS:
-        on_page_raster_end(job_id, "Success");
-        break;
-      case FPDF_ERR_UNKNOWN:
-        on_page_raster_end(job_id, "Unknown error");
-        break;
-      case FPDF_ERR_FILE:
-        on_page_raster_end(job_id, "File not found or could not be opened");
-        break;
-      case FPDF_ERR_FORMAT:
-        on_page_raster_end(job_id, "File not in PDF format or corrupted");
-        break;
-      case FPDF_ERR_PASSWORD:
-        on_page_raster_end(job_id, "Password required or incorrect password");
-        break;
-      case FPDF_ERR_SECURITY:
-        on_page_raster_end(job_id, "Unsupported security scheme");
-        break;
-      case FPDF_ERR_PAGE:
-        on_page_raster_end(job_id, "Page not found or content error");
-        break;
-      default:
-        on_page_raster_end(job_id, "Unknown error " + std::to_string(err));
-    }
-    FPDF_DestroyLibrary();
-    return std::nullopt;
-  }
-
-  auto pageCount = FPDF_GetPageCount(doc);
-
-  if (pages.empty()) {
-    // Use all pages
-    pages.resize(static_cast<size_t>(pageCount));
-    std::iota(std::begin(pages), std::end(pages), 0);
-  }
-
-  for (auto n : pages) {
-    if (n >= pageCount) {
-      continue;
-    }
-
-    auto page = FPDF_LoadPage(doc, n);
-    if (!page) {
-      continue;
-    }
-
-    auto width = FPDF_GetPageWidth(page);
-    auto height = FPDF_GetPageHeight(page);
-
-    auto bWidth = static_cast<int>(width * scale);
-    auto bHeight = static_cast<int>(height * scale);
-
-    auto bitmap = FPDFBitmap_Create(bWidth, bHeight, 1);
-    FPDFBitmap_FillRect(bitmap, 0, 0, bWidth, bHeight, 0x00ffffff);
-
-    FPDF_RenderPageBitmap(bitmap, page, 0, 0, bWidth, bHeight, 0,
-                          FPDF_ANNOT | FPDF_LCD_TEXT);
-
-    auto* p = static_cast<uint8_t*>(FPDFBitmap_GetBuffer(bitmap));
-    auto stride = FPDFBitmap_GetStride(bitmap);
-    auto l = bHeight * stride;
-
-    // BGRA to RGBA conversion
-    for (auto y = 0; y < bHeight; y++) {
-      auto offset = y * stride;
-      for (auto x = 0; x < bWidth; x++) {
-        auto t = p[offset];
-        p[offset] = p[offset + 2];
-        p[offset + 2] = t;
-        offset += 4;
-      }
-    }
-
-    on_page_rasterized(std::vector<uint8_t>{p, p + l}, bWidth, bHeight, job_id);
-
-    FPDFBitmap_Destroy(bitmap);
-    FPDF_ClosePage(page);
-  }
+  // Pages are sent from the raster queue as they are rendered.
+  raster_queue_->Submit(std::move(data), std::move(pages), scale, job_id);
+  return std::nullopt;
+}
 
-  FPDF_CloseDocument(doc);
-  FPDF_DestroyLibrary();
+std::optional<FlutterError> PdfPlugin::RasterTiles(std::vector<uint8_t> data,
+                                                   int32_t page,
+                                                   double scale,
+                                                   double x,
+                                                   double y,
+                                                   double width,
+                                                   double height,
+                                                   std::vector<int32_t> held,
+                                                   int job_id) {
+  // Tiles are sent from the raster queue as they are rendered.
+  raster_queue_->SubmitTiles(std::move(data), page, scale, x, y, width, height,
+                             std::move(held), job_id);
+  return std::nullopt;
+}
 
-  on_page_raster_end(job_id, "");
+std::optional<FlutterError> PdfPlugin::CancelRaster(int job_id) {
+  raster_queue_->Cancel(job_id);
   return std::nullopt;
 }
 
@@ -176,26 +165,45 @@ bool PdfPlugin::SharePdf(std::vector<uint8_t> buffer, const std::string& name) {
   return status == 0;
 }
 
-void PdfPlugin::on_page_rasterized(std::vector<uint8_t> data,
+void PdfPlugin::on_page_rasterized(const std::shared_ptr<Outbox>& outbox,
+                                   std::vector<uint8_t> data,
                                    int width,
                                    int height,
                                    int job_id) {
   SPDLOG_DEBUG("on_page_rasterized: {}", job_id);
-  channel->InvokeMethod(
-      "onPageRasterized",
-      std::make_unique<flutter::EncodableValue>(
-          flutter::EncodableValue(flutter::EncodableMap{
-              {flutter::EncodableValue("image"),
-               flutter::EncodableValue(std::move(data))},
-              {flutter::EncodableValue("width"),
-               flutter::EncodableValue(width)},
-              {flutter::EncodableValue("height"),
-               flutter::EncodableValue(height)},
-              {flutter::EncodableValue("job"), flutter::EncodableValue(job_id)},
-          })));
+  auto args = flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("image"),
+       flutter::EncodableValue(std::move(data))},
+      {flutter::EncodableValue("width"), flutter::EncodableValue(width)},
+      {flutter::EncodableValue("height"), flutter::EncodableValue(height)},
+      {flutter::EncodableValue("job"), flutter::EncodableValue(job_id)},
+  });
+  SendFromMainLoop(outbox, "onPageRasterized", std::move(args));
+}
+
+void PdfPlugin::on_tile_rasterized(const std::shared_ptr<Outbox>& outbox,
+                                   RasterQueue::Tile tile) {
+  SPDLOG_DEBUG("on_tile_rasterized: {}", tile.job_id);
+  auto args = flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("image"),
+       flutter::EncodableValue(std::move(tile.pixels))},
+      {flutter::EncodableValue("page"), flutter::EncodableValue(tile.page)},
+      {flutter::EncodableValue("scale"), flutter::EncodableValue(tile.scale)},
+      {flutter::EncodableValue("bucket"), flutter::EncodableValue(tile.bucket)},
+      {flutter::EncodableValue("column"), flutter::EncodableValue(tile.column)},
+      {flutter::EncodableValue("row"), flutter::EncodableValue(tile.row)},
+      {flutter::EncodableValue("x"), flutter::EncodableValue(tile.x)},
+      {flutter::EncodableValue("y"), flutter::EncodableValue(tile.y)},
+      {flutter::EncodableValue("width"), flutter::EncodableValue(tile.width)},
+      {flutter::EncodableValue("height"), flutter::EncodableValue(tile.height)},
+      {flutter::EncodableValue("job"), flutter::EncodableValue(tile.job_id)},
+  });
+  SendFromMainLoop(outbox, "onTileRasterized", std::move(args));
 }
 
-void PdfPlugin::on_page_raster_end(int job_id, const std::string& error) {
+void PdfPlugin::on_page_raster_end(const std::shared_ptr<Outbox>& outbox,
+                                   int job_id,
+                                   const std::string& error) {
   SPDLOG_DEBUG("on_page_raster_end: {}", job_id);
   auto map = flutter::EncodableMap{
       {flutter::EncodableValue("job"), flutter::EncodableValue(job_id)},
@@ -205,9 +213,8 @@ void PdfPlugin::on_page_raster_end(int job_id, const std::string& error) {
     map[flutter::EncodableValue("error")] = flutter::EncodableValue(error);
   }
 
-  channel->InvokeMethod(
-      "onPageRasterEnd",
-      std::make_unique<flutter::EncodableValue>(flutter::EncodableValue(map)));
+  SendFromMainLoop(outbox, "onPageRasterEnd",
+                   flutter::EncodableValue(std::move(map)));
 }
 
 }  // namespace plugin_pdf
@@ -20,10 +20,16 @@
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar.h>
 
+#include <memory>
+
 #include "messages.h"
+#include "raster_queue.h"
 
 namespace plugin_pdf {
 
+// Messages handed to the main loop, shared with the tasks that send them
+struct Outbox;
+
 class PdfPlugin final : public flutter::Plugin, public PrintingApi {
  public:
   static void RegisterWithRegistrar(flutter::PluginRegistrar* registrar);
@@ -32,12 +38,18 @@ class PdfPlugin final : public flutter::Plugin, public PrintingApi {
 
   ~PdfPlugin() override;
 
-  static void on_page_rasterized(std::vector<uint8_t> data,
+  static void on_page_rasterized(const std::shared_ptr<Outbox>& outbox,
+                                 std::vector<uint8_t> data,
                                  int width,
                                  int height,
                                  int job_id);
 
-  static void on_page_raster_end(int job_id, const std::string& error);
+  static void on_tile_rasterized(const std::shared_ptr<Outbox>& outbox,
+                                 RasterQueue::Tile tile);
+
+  static void on_page_raster_end(const std::shared_ptr<Outbox>& outbox,
+                                 int job_id,
+                                 const std::string& error);
 
   // Disallow copy and assign.
   PdfPlugin(const PdfPlugin&) = delete;
@@ -49,7 +61,23 @@ class PdfPlugin final : public flutter::Plugin, public PrintingApi {
                                         double scale,
                                         int job_id) override;
 
+  std::optional<FlutterError> RasterTiles(std::vector<uint8_t> doc,
+                                          int32_t page,
+                                          double scale,
+                                          double x,
+                                          double y,
+                                          double width,
+                                          double height,
+                                          std::vector<int32_t> held,
+                                          int job_id) override;
+
+  std::optional<FlutterError> CancelRaster(int job_id) override;
+
   bool SharePdf(std::vector<uint8_t> buffer, const std::string& name) override;
+
+ private:
+  std::shared_ptr<Outbox> outbox_;
+  std::unique_ptr<RasterQueue> raster_queue_;
 };
 
 }  // namespace plugin_pdf
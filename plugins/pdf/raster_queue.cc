@@ -0,0 +1,604 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "raster_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <string_view>
+
+#include <fpdf_edit.h>
+
+#include "plugins/common/common.h"
+#include "swizzle.h"
+
+namespace plugin_pdf {
+
+namespace {
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t Hash(const std::vector<uint8_t>& data) {
+  return std::hash<std::string_view>{}(std::string_view(
+      reinterpret_cast<const char*>(data.data()), data.size()));
+}
+
+}  // namespace
+
+RasterQueue::RasterQueue(PageCallback on_page,
+                         TileCallback on_tile,
+                         EndCallback on_end)
+    : on_page_(std::move(on_page)),
+      on_tile_(std::move(on_tile)),
+      on_end_(std::move(on_end)) {
+  render_thread_ = std::thread(&RasterQueue::RenderLoop, this);
+  deliver_thread_ = std::thread(&RasterQueue::DeliverLoop, this);
+}
+
+RasterQueue::~RasterQueue() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+  }
+  jobs_cv_.notify_all();
+  output_cv_.notify_all();
+  render_thread_.join();
+  deliver_thread_.join();
+}
+
+void RasterQueue::Submit(std::vector<uint8_t> doc,
+                         std::vector<int32_t> pages,
+                         double scale,
+                         int job_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back({std::move(doc), std::move(pages), scale, job_id});
+  }
+  jobs_cv_.notify_one();
+}
+
+void RasterQueue::SubmitTiles(std::vector<uint8_t> doc,
+                              int page,
+                              double scale,
+                              double x,
+                              double y,
+                              double width,
+                              double height,
+                              std::vector<int32_t> held,
+                              int job_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back({std::move(doc), {}, scale, job_id, true, page, x, y,
+                     width, height, std::move(held)});
+  }
+  jobs_cv_.notify_one();
+}
+
+void RasterQueue::Cancel(int job_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (rendering_ && current_job_ == job_id) {
+    cancelled_.insert(job_id);
+    cancel_current_ = true;
+    return;
+  }
+  if (std::any_of(jobs_.begin(), jobs_.end(),
+                  [job_id](const Job& job) { return job.job_id == job_id; })) {
+    // Ends when the render thread gets to it, keeping the order of ends.
+    cancelled_.insert(job_id);
+  }
+}
+
+void RasterQueue::RenderLoop() {
+  FPDF_LIBRARY_CONFIG config;
+  config.version = 2;
+  config.m_pUserFontPaths = nullptr;
+  config.m_pIsolate = nullptr;
+  config.m_v8EmbedderSlot = 0;
+  // requires a PDFium build with skia enabled
+  config.m_RendererType = FPDF_RENDERERTYPE_SKIA;
+
+  FPDF_InitLibraryWithConfig(&config);
+  reverse_byte_order_ = ProbeReverseByteOrder();
+  spdlog::debug("[pdf] pages rendered as {}",
+                reverse_byte_order_ ? "RGBA" : "BGRA, swapped on delivery");
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      jobs_cv_.wait(lock, [this] { return exit_ || !jobs_.empty(); });
+      if (exit_) {
+        break;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+      current_job_ = job.job_id;
+      rendering_ = true;
+      cancel_current_ = cancelled_.count(job.job_id) != 0;
+    }
+    Render(job);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      rendering_ = false;
+      cancelled_.erase(job.job_id);
+      cancel_current_ = false;
+    }
+  }
+
+  for (auto& document : documents_) {
+    FPDF_CloseDocument(document.handle);
+  }
+  documents_.clear();
+  FPDF_DestroyLibrary();
+}
+
+void RasterQueue::Render(Job& job) {
+  SPDLOG_DEBUG("\tdoc_size: {}", job.doc.size());
+  SPDLOG_DEBUG("\tpages_count: {}", job.pages.size());
+  SPDLOG_DEBUG("\tscale: {}", job.scale);
+  SPDLOG_DEBUG("\tjob: {}", job.job_id);
+  if (cancel_current_) {
+    Emit({job.job_id, true, false, {}, 0, 0, 0, kCancelled});
+    return;
+  }
+  const int64_t start = NowMs();
+
+  std::string error;
+  bool cached = false;
+  auto doc = Open(job.doc, &error, &cached);
+  if (!doc) {
+    SPDLOG_DEBUG("[pdf] Load unsuccessful: job: {}", job.job_id);
+    Emit({job.job_id, true, false, {}, 0, 0, 0, std::move(error)});
+    return;
+  }
+  const int64_t loaded = NowMs();
+
+  int from_cache = 0;
+  int held = 0;
+  const int rendered = job.tiles ? RenderTiles(job, *doc, &from_cache, &held)
+                                 : RenderPages(job, doc->handle);
+  if (rendered < 0) {
+    return;
+  }
+
+  if (job.tiles) {
+    spdlog::debug(
+        "[pdf] job {}: {} tiles, {} cached, {} held, in {} ms, document {} "
+        "in {} ms{}",
+        job.job_id, rendered, from_cache, held, NowMs() - start,
+        cached ? "cached" : "loaded", loaded - start,
+        cancel_current_ ? ", cancelled" : "");
+  } else {
+    spdlog::debug("[pdf] job {}: {} pages in {} ms, document {} in {} ms{}",
+                  job.job_id, rendered, NowMs() - start,
+                  cached ? "cached" : "loaded", loaded - start,
+                  cancel_current_ ? ", cancelled" : "");
+  }
+  Emit({job.job_id, true, false, {}, 0, 0, 0,
+        cancel_current_ ? kCancelled : ""});
+}
+
+int RasterQueue::RenderPages(Job& job, FPDF_DOCUMENT doc) {
+  auto pageCount = FPDF_GetPageCount(doc);
+
+  auto& pages = job.pages;
+  if (pages.empty()) {
+    // Use all pages
+    pages.resize(static_cast<size_t>(pageCount));
+    std::iota(std::begin(pages), std::end(pages), 0);
+  }
+
+  int rendered = 0;
+  for (auto n : pages) {
+    if (cancel_current_) {
+      break;
+    }
+    if (n >= pageCount) {
+      continue;
+    }
+
+    auto page = FPDF_LoadPage(doc, n);
+    if (!page) {
+      continue;
+    }
+
+    auto width = FPDF_GetPageWidth(page);
+    auto height = FPDF_GetPageHeight(page);
+
+    auto bWidth = static_cast<int>(width * job.scale);
+    auto bHeight = static_cast<int>(height * job.scale);
+
+    // Rendered into memory owned by the output, which outlives the bitmap
+    // handle and is handed to the delivery thread without a copy.
+    Output output{};
+    output.job_id = job.job_id;
+    output.bgra = !reverse_byte_order_;
+    output.width = bWidth;
+    output.height = bHeight;
+    output.stride = bWidth * 4;
+    output.pixels.resize(static_cast<size_t>(output.stride) *
+                         static_cast<size_t>(bHeight));
+    auto bitmap = FPDFBitmap_CreateEx(bWidth, bHeight, FPDFBitmap_BGRA,
+                                      output.pixels.data(), output.stride);
+    if (!bitmap) {
+      FPDF_ClosePage(page);
+      continue;
+    }
+    FPDFBitmap_FillRect(bitmap, 0, 0, bWidth, bHeight, 0x00ffffff);
+
+    FPDF_RenderPageBitmap(
+        bitmap, page, 0, 0, bWidth, bHeight, 0,
+        FPDF_ANNOT | FPDF_LCD_TEXT |
+            (reverse_byte_order_ ? FPDF_REVERSE_BYTE_ORDER : 0));
+
+    FPDFBitmap_Destroy(bitmap);
+    FPDF_ClosePage(page);
+
+    if (!Emit(std::move(output))) {
+      return -1;
+    }
+    rendered++;
+  }
+  return rendered;
+}
+
+int RasterQueue::RenderTiles(const Job& job,
+                             const Document& doc,
+                             int* from_cache,
+                             int* held) {
+  FS_SIZEF size;
+  if (job.scale <= 0 || job.page < 0 ||
+      job.page >= FPDF_GetPageCount(doc.handle) ||
+      !FPDF_GetPageSizeByIndexF(doc.handle, job.page, &size)) {
+    return 0;
+  }
+
+  // Rounded to a bucket so that small zoom steps reuse cached tiles; Dart
+  // draws them scaled by the requested scale over the tile scale.
+  const int bucket = static_cast<int>(
+      std::lround(std::log2(job.scale) * kScaleBucketsPerOctave));
+  const double scale =
+      std::exp2(static_cast<double>(bucket) / kScaleBucketsPerOctave);
+  const double to_bucket = scale / job.scale;
+
+  const int page_width = static_cast<int>(size.width * scale);
+  const int page_height = static_cast<int>(size.height * scale);
+  // Viewport in pixels at the tile scale, within the page
+  auto clamp = [](double value, int max) {
+    return static_cast<int>(std::clamp(value, 0.0, static_cast<double>(max)));
+  };
+  const int left = clamp(std::floor(job.x * to_bucket), page_width);
+  const int top = clamp(std::floor(job.y * to_bucket), page_height);
+  const int right =
+      clamp(std::ceil((job.x + job.width) * to_bucket), page_width);
+  const int bottom =
+      clamp(std::ceil((job.y + job.height) * to_bucket), page_height);
+  if (right <= left || bottom <= top) {
+    return 0;
+  }
+
+  std::set<std::pair<int, int>> in_dart;
+  for (size_t i = 0; i + 2 < job.held.size(); i += 3) {
+    if (job.held[i] == bucket) {
+      in_dart.emplace(job.held[i + 1], job.held[i + 2]);
+    }
+  }
+
+  std::vector<std::pair<int, int>> order;
+  for (int row = top / kTileSize; row <= (bottom - 1) / kTileSize; row++) {
+    for (int column = left / kTileSize; column <= (right - 1) / kTileSize;
+         column++) {
+      if (in_dart.count({column, row})) {
+        (*held)++;
+      } else {
+        order.emplace_back(column, row);
+      }
+    }
+  }
+  // Centre of the viewport first, where the user is looking.
+  const double cx = (left + right) / 2.0 / kTileSize - 0.5;
+  const double cy = (top + bottom) / 2.0 / kTileSize - 0.5;
+  std::stable_sort(order.begin(), order.end(),
+                   [cx, cy](const auto& a, const auto& b) {
+                     return std::hypot(a.first - cx, a.second - cy) <
+                            std::hypot(b.first - cx, b.second - cy);
+                   });
+
+  // Loaded on the first tile that is not cached
+  FPDF_PAGE page = nullptr;
+  int delivered = 0;
+  for (const auto& [column, row] : order) {
+    if (cancel_current_) {
+      break;
+    }
+
+    Output output{};
+    output.job_id = job.job_id;
+    output.bgra = !reverse_byte_order_;
+    output.tile = true;
+    output.page = job.page;
+    output.scale = scale;
+    output.bucket = bucket;
+    output.column = column;
+    output.row = row;
+    const int x = column * kTileSize;
+    const int y = row * kTileSize;
+    output.width = std::min(kTileSize, page_width - x);
+    output.height = std::min(kTileSize, page_height - y);
+    output.stride = output.width * 4;
+
+    const TileKey key{doc.id, job.page, bucket, column, row};
+    if (FindTile(key, &output.pixels)) {
+      (*from_cache)++;
+    } else {
+      if (!page) {
+        page = FPDF_LoadPage(doc.handle, job.page);
+        if (!page) {
+          break;
+        }
+      }
+      if (!RenderTile(page, scale, x, y, page_width, page_height, output)) {
+        continue;
+      }
+      StoreTile(key, output.pixels);
+    }
+
+    if (!Emit(std::move(output))) {
+      delivered = -1;
+      break;
+    }
+    delivered++;
+  }
+
+  if (page) {
+    FPDF_ClosePage(page);
+  }
+  return delivered;
+}
+
+bool RasterQueue::RenderTile(FPDF_PAGE page,
+                             double scale,
+                             int x,
+                             int y,
+                             int page_width,
+                             int page_height,
+                             Output& output) {
+  output.pixels.resize(static_cast<size_t>(output.stride) *
+                       static_cast<size_t>(output.height));
+  auto bitmap = FPDFBitmap_CreateEx(output.width, output.height,
+                                    FPDFBitmap_BGRA, output.pixels.data(),
+                                    output.stride);
+  if (!bitmap) {
+    return false;
+  }
+  FPDFBitmap_FillRect(bitmap, 0, 0, output.width, output.height, 0x00ffffff);
+
+  const int flags = FPDF_ANNOT | FPDF_LCD_TEXT |
+                    (reverse_byte_order_ ? FPDF_REVERSE_BYTE_ORDER : 0);
+
+  // The whole page is laid out with its origin up and left of the bitmap,
+  // PDFium only rasterizes what falls inside it.  The pause only asks to
+  // stop when the job is cancelled, then the tile is abandoned.
+  IFSDK_PAUSE pause{};
+  pause.version = 1;
+  pause.NeedToPauseNow = &RasterQueue::NeedToPauseNow;
+  pause.user = this;
+  int status = FPDF_RenderPageBitmap_Start(bitmap, page, -x, -y, page_width,
+                                           page_height, 0, flags, &pause);
+  while (status == FPDF_RENDER_TOBECONTINUED && !cancel_current_) {
+    status = FPDF_RenderPage_Continue(page, &pause);
+  }
+  FPDF_RenderPage_Close(page);
+
+  if (status == FPDF_RENDER_FAILED && !cancel_current_) {
+    // Renderer without progressive support, same tile in one go.
+    const FS_MATRIX matrix{static_cast<float>(scale),
+                           0,
+                           0,
+                           static_cast<float>(scale),
+                           static_cast<float>(-x),
+                           static_cast<float>(-y)};
+    const FS_RECTF clip{0, 0, static_cast<float>(output.width),
+                        static_cast<float>(output.height)};
+    FPDF_RenderPageBitmapWithMatrix(bitmap, page, &matrix, &clip, flags);
+    status = FPDF_RENDER_DONE;
+  }
+
+  FPDFBitmap_Destroy(bitmap);
+  return status == FPDF_RENDER_DONE;
+}
+
+FPDF_BOOL RasterQueue::NeedToPauseNow(IFSDK_PAUSE* pause) {
+  return static_cast<RasterQueue*>(pause->user)->cancel_current_.load(
+      std::memory_order_relaxed);
+}
+
+bool RasterQueue::FindTile(const TileKey& key, std::vector<uint8_t>* pixels) {
+  auto it = tile_index_.find(key);
+  if (it == tile_index_.end()) {
+    return false;
+  }
+  tiles_.splice(tiles_.begin(), tiles_, it->second);
+  *pixels = it->second->pixels;
+  return true;
+}
+
+void RasterQueue::StoreTile(const TileKey& key,
+                            const std::vector<uint8_t>& pixels) {
+  tiles_.push_front({key, pixels});
+  tile_index_[key] = tiles_.begin();
+  tile_bytes_ += pixels.size();
+  while (tile_bytes_ > kMaxTileBytes) {
+    tile_bytes_ -= tiles_.back().pixels.size();
+    tile_index_.erase(tiles_.back().key);
+    tiles_.pop_back();
+  }
+}
+
+void RasterQueue::DropTiles(uint64_t document_id) {
+  for (auto it = tiles_.begin(); it != tiles_.end();) {
+    if (std::get<0>(it->key) == document_id) {
+      tile_bytes_ -= it->pixels.size();
+      tile_index_.erase(it->key);
+      it = tiles_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+bool RasterQueue::Emit(Output&& output) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  output_cv_.wait(lock, [this] {
+    return exit_ || output_.size() < kMaxPendingPages;
+  });
+  if (exit_) {
+    return false;
+  }
+  output_.push_back(std::move(output));
+  output_cv_.notify_all();
+  return true;
+}
+
+void RasterQueue::DeliverLoop() {
+  while (true) {
+    Output output;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      output_cv_.wait(lock, [this] { return exit_ || !output_.empty(); });
+      if (exit_) {
+        return;
+      }
+      output = std::move(output_.front());
+      output_.pop_front();
+    }
+    // Room for the next page.
+    output_cv_.notify_all();
+
+    if (output.end) {
+      on_end_(output.job_id, output.error);
+      continue;
+    }
+
+    if (output.bgra) {
+      // Rows are tightly packed.
+      SwapRedBlue(output.pixels.data(),
+                  static_cast<size_t>(output.width) *
+                      static_cast<size_t>(output.height));
+    }
+
+    if (output.tile) {
+      on_tile_({output.job_id, output.page, output.scale, output.bucket,
+                output.column, output.row, output.column * kTileSize,
+                output.row * kTileSize, output.width, output.height,
+                std::move(output.pixels)});
+      continue;
+    }
+
+    on_page_(std::move(output.pixels), output.width, output.height,
+             output.job_id);
+  }
+}
+
+RasterQueue::Document* RasterQueue::Open(std::vector<uint8_t>& data,
+                                         std::string* error,
+                                         bool* cached) {
+  const size_t hash = Hash(data);
+  for (auto it = documents_.begin(); it != documents_.end(); ++it) {
+    if (it->hash == hash && it->data.size() == data.size() &&
+        memcmp(it->data.data(), data.data(), data.size()) == 0) {
+      documents_.splice(documents_.begin(), documents_, it);
+      *cached = true;
+      return &documents_.front();
+    }
+  }
+
+  auto handle = FPDF_LoadMemDocument64(data.data(), data.size(), nullptr);
+  if (!handle) {
+    *error = LoadError(FPDF_GetLastError());
+    return nullptr;
+  }
+  documents_.push_front({next_document_id_++, hash, std::move(data), handle});
+  if (documents_.size() > kMaxDocuments) {
+    DropTiles(documents_.back().id);
+    FPDF_CloseDocument(documents_.back().handle);
+    documents_.pop_back();
+  }
+  return &documents_.front();
+}
+
+bool RasterQueue::ProbeReverseByteOrder() {
+  constexpr int kSize = 4;
+  auto doc = FPDF_CreateNewDocument();
+  if (!doc) {
+    return false;
+  }
+  bool rgba = false;
+  auto page = FPDFPage_New(doc, 0, kSize, kSize);
+  if (page) {
+    auto rect = FPDFPageObj_CreateNewRect(0, 0, kSize, kSize);
+    FPDFPageObj_SetFillColor(rect, 255, 0, 0, 255);
+    FPDFPath_SetDrawMode(rect, FPDF_FILLMODE_ALTERNATE, false);
+    FPDFPage_InsertObject(page, rect);
+    FPDFPage_GenerateContent(page);
+
+    uint8_t pixels[kSize * kSize * 4] = {};
+    auto bitmap = FPDFBitmap_CreateEx(kSize, kSize, FPDFBitmap_BGRA, pixels,
+                                      kSize * 4);
+    if (bitmap) {
+      FPDFBitmap_FillRect(bitmap, 0, 0, kSize, kSize, 0xffffffff);
+      FPDF_RenderPageBitmap(bitmap, page, 0, 0, kSize, kSize, 0,
+                            FPDF_REVERSE_BYTE_ORDER);
+      FPDFBitmap_Destroy(bitmap);
+      // Centre pixel, clear of anti-aliased edges
+      const uint8_t* p = pixels + ((kSize / 2) * kSize + kSize / 2) * 4;
+      rgba = p[0] > 200 && p[2] < 50;
+    }
+    FPDF_ClosePage(page);
+  }
+  FPDF_CloseDocument(doc);
+  return rgba;
+}
+
+std::string RasterQueue::LoadError(unsigned long err) {
+  switch (err) {
+    case FPDF_ERR_SUCCESS:
+      return "Success";
+    case FPDF_ERR_UNKNOWN:
+      return "Unknown error";
+    case FPDF_ERR_FILE:
+      return "File not found or could not be opened";
+    case FPDF_ERR_FORMAT:
+      return "File not in PDF format or corrupted";
+    case FPDF_ERR_PASSWORD:
+      return "Password required or incorrect password";
+    case FPDF_ERR_SECURITY:
+      return "Unsupported security scheme";
+    case FPDF_ERR_PAGE:
+      return "Page not found or content error";
+    default:
+      return "Unknown error " + std::to_string(err);
+  }
+}
+
+}  // namespace plugin_pdf
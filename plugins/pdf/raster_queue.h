@@ -0,0 +1,336 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLUTTER_PLUGIN_PDF_RASTER_QUEUE_H_
+#define FLUTTER_PLUGIN_PDF_RASTER_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <fpdf_progressive.h>
+#include <fpdfview.h>
+
+namespace plugin_pdf {
+
+/**
+ * Rasterizes PDF pages off the platform thread.
+ *
+ * PDFium keeps process wide state that is not thread-safe, also across
+ * documents, so all PDFium calls are made from one render thread which
+ * initializes the library once.  Open documents are kept in a small LRU
+ * cache keyed by their content, so rastering the same document again, as
+ * the viewer does on every zoom step, does not parse it again.
+ *
+ * Pages are rendered straight into the buffer that is sent to Dart, in RGBA
+ * order when the renderer honours FPDF_REVERSE_BYTE_ORDER, which is probed
+ * once; otherwise the delivery thread swaps red and blue.  Rendering
+ * overlaps with delivery: while the render thread renders the next page,
+ * the delivery thread sends the previous one.  Pages are delivered in the
+ * requested order, followed by the end of the job.
+ *
+ * For deep zoom, a viewport of one page can be requested instead.  It is
+ * covered with kTileSize tiles at the requested scale rounded to one of
+ * kScaleBucketsPerOctave steps per doubling, so small zoom steps reuse
+ * tiles, which stay cached up to kMaxTileBytes.  Tiles Dart still holds
+ * from an earlier job are not sent again.  Tiles are rendered
+ * progressively, so a job that is cancelled because the viewport moved
+ * stops within the tile being rendered.
+ */
+class RasterQueue {
+ public:
+  // Documents kept open between jobs.
+  static constexpr size_t kMaxDocuments = 4;
+  // Rendered pages waiting for delivery; rendering waits beyond this.
+  static constexpr size_t kMaxPendingPages = 2;
+  // Edge of a tile in pixels.
+  static constexpr int kTileSize = 512;
+  // Tile scales per doubling of the scale.
+  static constexpr int kScaleBucketsPerOctave = 4;
+  // Pixels of cached tiles, 64 full tiles.
+  static constexpr size_t kMaxTileBytes = 64 * 1024 * 1024;
+
+  // Error a cancelled job ends with.
+  static constexpr char kCancelled[] = "Cancelled";
+
+  // A rendered tile, RGBA
+  struct Tile {
+    int job_id;
+    int page;
+    // Scale the tile was rendered at, the bucket of the requested scale
+    double scale;
+    // Identify the tile in a later job's held tiles
+    int bucket;
+    int column;
+    int row;
+    // Position on the page, in pixels at scale
+    int x;
+    int y;
+    int width;
+    int height;
+    std::vector<uint8_t> pixels;
+  };
+
+  using PageCallback = std::function<
+      void(std::vector<uint8_t> data, int width, int height, int job_id)>;
+  using TileCallback = std::function<void(Tile tile)>;
+  using EndCallback =
+      std::function<void(int job_id, const std::string& error)>;
+
+  /**
+   * @param[in] on_page Receives each page as RGBA, on the delivery thread
+   * @param[in] on_tile Receives each tile, on the delivery thread
+   * @param[in] on_end Receives the end of a job, on the delivery thread
+   */
+  RasterQueue(PageCallback on_page, TileCallback on_tile, EndCallback on_end);
+  ~RasterQueue();
+
+  // Prevent copying.
+  RasterQueue(RasterQueue const&) = delete;
+  RasterQueue& operator=(RasterQueue const&) = delete;
+
+  /**
+   * @brief Queue a raster job
+   * @param[in] doc PDF file contents
+   * @param[in] pages Page indices to render, all pages when empty
+   * @param[in] scale Pixels per PDF point
+   * @param[in] job_id Job identifier passed back to Dart
+   * @return void
+   * @relation
+   * pdfium
+   */
+  void Submit(std::vector<uint8_t> doc,
+              std::vector<int32_t> pages,
+              double scale,
+              int job_id);
+
+  /**
+   * @brief Queue a tile job, rendering the tiles that cover a viewport
+   * @param[in] doc PDF file contents
+   * @param[in] page Page index
+   * @param[in] scale Pixels per PDF point
+   * @param[in] x Left of the viewport, in pixels at scale
+   * @param[in] y Top of the viewport, in pixels at scale
+   * @param[in] width Width of the viewport, in pixels at scale
+   * @param[in] height Height of the viewport, in pixels at scale
+   * @param[in] held Tiles Dart holds, bucket, column and row of each
+   * @param[in] job_id Job identifier passed back to Dart
+   * @return void
+   * @relation
+   * pdfium
+   */
+  void SubmitTiles(std::vector<uint8_t> doc,
+                   int page,
+                   double scale,
+                   double x,
+                   double y,
+                   double width,
+                   double height,
+                   std::vector<int32_t> held,
+                   int job_id);
+
+  /**
+   * @brief Cancel a queued or running job, which ends with kCancelled.
+   * Output already rendered may still be delivered before the end.
+   * @param[in] job_id Job identifier
+   * @return void
+   * @relation
+   * pdfium
+   */
+  void Cancel(int job_id);
+
+ private:
+  struct Job {
+    std::vector<uint8_t> doc;
+    std::vector<int32_t> pages;
+    double scale;
+    int job_id;
+    // Tile jobs only, the viewport of page in pixels at scale
+    bool tiles;
+    int page;
+    double x;
+    double y;
+    double width;
+    double height;
+    std::vector<int32_t> held;
+  };
+
+  struct Document {
+    // Identifies the document in the tile cache, not reused
+    uint64_t id;
+    size_t hash;
+    // Must outlive handle, PDFium reads from it lazily
+    std::vector<uint8_t> data;
+    FPDF_DOCUMENT handle;
+  };
+
+  // A rendered page, or the end of a job
+  struct Output {
+    int job_id;
+    bool end;
+    // Pixels are in BGRA order and still need swapping
+    bool bgra;
+    std::vector<uint8_t> pixels;
+    int width;
+    int height;
+    int stride;
+    std::string error;
+    // A tile rather than a page
+    bool tile;
+    int page;
+    double scale;
+    int bucket;
+    int column;
+    int row;
+  };
+
+  // Document id, page, scale bucket, tile column, tile row
+  using TileKey = std::tuple<uint64_t, int, int, int, int>;
+
+  struct CachedTile {
+    TileKey key;
+    std::vector<uint8_t> pixels;
+  };
+
+  PageCallback on_page_;
+  TileCallback on_tile_;
+  EndCallback on_end_;
+
+  std::mutex mutex_;
+  std::condition_variable jobs_cv_;
+  std::condition_variable output_cv_;
+  std::deque<Job> jobs_;
+  std::deque<Output> output_;
+  bool exit_{};
+  // Job on the render thread, valid while rendering_
+  int current_job_{};
+  bool rendering_{};
+  // Cancelled jobs that are queued or rendering
+  std::set<int> cancelled_;
+  // Set when the job being rendered is cancelled, polled while rendering
+  std::atomic<bool> cancel_current_{};
+
+  // Render thread only, most recently used first
+  std::list<Document> documents_;
+  uint64_t next_document_id_{};
+  // Render thread only, whether pages can be rendered as RGBA
+  bool reverse_byte_order_{};
+  // Render thread only, most recently used first
+  std::list<CachedTile> tiles_;
+  std::map<TileKey, std::list<CachedTile>::iterator> tile_index_;
+  size_t tile_bytes_{};
+
+  // Started last, after the members they use.
+  std::thread render_thread_;
+  std::thread deliver_thread_;
+
+  void RenderLoop();
+
+  void DeliverLoop();
+
+  void Render(Job& job);
+
+  // Renders the pages of a job, returns the number of pages rendered or -1
+  // when the queue is shutting down.
+  int RenderPages(Job& job, FPDF_DOCUMENT doc);
+
+  // Renders the tiles of a job, returns the number of tiles delivered or -1
+  // when the queue is shutting down.
+  int RenderTiles(const Job& job,
+                  const Document& doc,
+                  int* from_cache,
+                  int* held);
+
+  /**
+   * @brief Render one tile of a page, progressively so that cancelling the
+   * job interrupts it
+   * @param[in] page Loaded page
+   * @param[in] scale Pixels per PDF point
+   * @param[in] x Left of the tile on the page, in pixels at scale
+   * @param[in] y Top of the tile on the page, in pixels at scale
+   * @param[in] page_width Width of the page in pixels at scale
+   * @param[in] page_height Height of the page in pixels at scale
+   * @param[in,out] output Tile, sized, receives the pixels
+   * @return bool
+   * @retval false Not rendered, cancelled or out of memory
+   * @relation
+   * pdfium
+   */
+  bool RenderTile(FPDF_PAGE page,
+                  double scale,
+                  int x,
+                  int y,
+                  int page_width,
+                  int page_height,
+                  Output& output);
+
+  // IFSDK_PAUSE callback, user is the queue.
+  static FPDF_BOOL NeedToPauseNow(IFSDK_PAUSE* pause);
+
+  // Copies a cached tile into pixels, returns whether it was cached.
+  bool FindTile(const TileKey& key, std::vector<uint8_t>* pixels);
+
+  // Caches a copy of a rendered tile, evicting beyond kMaxTileBytes.
+  void StoreTile(const TileKey& key, const std::vector<uint8_t>& pixels);
+
+  // Drops the cached tiles of a closed document.
+  void DropTiles(uint64_t document_id);
+
+  // Queue output for delivery, waits while kMaxPendingPages are queued.
+  // Returns false when the queue is shutting down.
+  bool Emit(Output&& output);
+
+  /**
+   * @brief Find a cached document with these contents or open it
+   * @param[in] data PDF file contents, taken when the document is opened
+   * @param[out] error Reason the document could not be opened
+   * @param[out] cached Whether the document was already open
+   * @return Document*
+   * @retval nullptr Document could not be opened
+   * @relation
+   * pdfium
+   */
+  Document* Open(std::vector<uint8_t>& data,
+                 std::string* error,
+                 bool* cached);
+
+  static std::string LoadError(unsigned long err);
+
+  /**
+   * @brief Render a red square with FPDF_REVERSE_BYTE_ORDER to find out
+   * whether the renderer writes RGBA.  Not all renderer backends honour
+   * the flag.
+   * @return bool
+   * @retval true Pages can be rendered directly as RGBA
+   * @relation
+   * pdfium
+   */
+  static bool ProbeReverseByteOrder();
+};
+
+}  // namespace plugin_pdf
+
+#endif  // FLUTTER_PLUGIN_PDF_RASTER_QUEUE_H_
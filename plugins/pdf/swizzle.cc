@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "swizzle.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace plugin_pdf {
+
+void SwapRedBlue(uint8_t* pixels, size_t count) {
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  // Four pixels per step as 32 bit lanes: 0xAARRGGBB -> 0xAABBGGRR.
+  const __m128i keep = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+  const __m128i low = _mm_set1_epi32(0x000000ff);
+  for (; i + 4 <= count; i += 4) {
+    auto* p = reinterpret_cast<__m128i*>(pixels + i * 4);
+    const __m128i v = _mm_loadu_si128(p);
+    const __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+    const __m128i b = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+    _mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(v, keep),
+                                     _mm_or_si128(r, b)));
+  }
+#elif defined(__ARM_NEON)
+  // Sixteen pixels per step, deinterleaved into one register per channel.
+  for (; i + 16 <= count; i += 16) {
+    uint8_t* p = pixels + i * 4;
+    uint8x16x4_t v = vld4q_u8(p);
+    const uint8x16_t t = v.val[0];
+    v.val[0] = v.val[2];
+    v.val[2] = t;
+    vst4q_u8(p, v);
+  }
+#endif
+
+  for (; i < count; i++) {
+    uint8_t* p = pixels + i * 4;
+    const uint8_t t = p[0];
+    p[0] = p[2];
+    p[2] = t;
+  }
+}
+
+}  // namespace plugin_pdf
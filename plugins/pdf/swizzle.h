@@ -0,0 +1,39 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLUTTER_PLUGIN_PDF_SWIZZLE_H_
+#define FLUTTER_PLUGIN_PDF_SWIZZLE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace plugin_pdf {
+
+/**
+ * @brief Swap the first and third byte of each 4 byte pixel in place,
+ * converting BGRA to RGBA and back.  Uses SSE2 or NEON when the target has
+ * them.
+ * @param[in,out] pixels Tightly packed pixels
+ * @param[in] count Number of pixels
+ * @return void
+ * @relation
+ * pdfium
+ */
+void SwapRedBlue(uint8_t* pixels, size_t count);
+
+}  // namespace plugin_pdf
+
+#endif  // FLUTTER_PLUGIN_PDF_SWIZZLE_H_
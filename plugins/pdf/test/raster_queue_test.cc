@@ -0,0 +1,165 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "plugins/common/testing/testing.h"
+#include "raster_queue.h"
+
+using plugin_pdf::RasterQueue;
+
+namespace {
+
+// One empty A4 page, 595 x 842 points.
+constexpr char kDocument[] =
+    "%PDF-1.4\n"
+    "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n"
+    "2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n"
+    "3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 595 842] >>\n"
+    "endobj\n"
+    "xref\n0 4\n"
+    "0000000000 65535 f \n"
+    "0000000009 00000 n \n"
+    "0000000058 00000 n \n"
+    "0000000115 00000 n \n"
+    "trailer\n<< /Size 4 /Root 1 0 R >>\nstartxref\n186\n%%EOF\n";
+
+// Output of the queue, collected from the delivery thread
+struct Results {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::map<int, std::vector<RasterQueue::Tile>> tiles;
+  std::map<int, std::vector<std::pair<int, int>>> pages;
+  std::map<int, std::string> ended;
+  std::vector<int> end_order;
+
+  void Wait(int job_id) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this, job_id] { return ended.count(job_id) != 0; });
+  }
+};
+
+std::vector<uint8_t> Document() {
+  return {kDocument, kDocument + strlen(kDocument)};
+}
+
+}  // namespace
+
+int main() {
+  Results results;
+  {
+    RasterQueue queue(
+        [&](std::vector<uint8_t> data, int width, int height, int job_id) {
+          std::lock_guard<std::mutex> lock(results.mutex);
+          EXPECT(data.size() == static_cast<size_t>(width) * height * 4);
+          results.pages[job_id].emplace_back(width, height);
+        },
+        [&](RasterQueue::Tile tile) {
+          std::lock_guard<std::mutex> lock(results.mutex);
+          EXPECT(tile.pixels.size() ==
+                 static_cast<size_t>(tile.width) * tile.height * 4);
+          EXPECT(results.ended.count(tile.job_id) == 0);
+          results.tiles[tile.job_id].push_back(std::move(tile));
+        },
+        [&](int job_id, const std::string& error) {
+          std::lock_guard<std::mutex> lock(results.mutex);
+          results.ended[job_id] = error;
+          results.end_order.push_back(job_id);
+          results.cv.notify_all();
+        });
+
+    // The whole page at scale 1, four tiles, the one under the centre
+    // of the viewport first.
+    queue.SubmitTiles(Document(), 0, 1.0, 0, 0, 595, 842, {}, 1);
+    results.Wait(1);
+    auto& page = results.tiles[1];
+    EXPECT(results.ended[1].empty());
+    EXPECT(page.size() == 4);
+    std::set<std::pair<int, int>> sizes;
+    for (const auto& tile : page) {
+      sizes.emplace(tile.width, tile.height);
+      EXPECT(tile.scale == 1.0);
+      EXPECT(tile.bucket == 0);
+      EXPECT(tile.page == 0);
+      EXPECT(tile.x == tile.column * RasterQueue::kTileSize);
+      EXPECT(tile.y == tile.row * RasterQueue::kTileSize);
+    }
+    EXPECT((sizes == std::set<std::pair<int, int>>{
+                         {512, 512}, {83, 512}, {512, 330}, {83, 330}}));
+    EXPECT(!page.empty() && page[0].column == 0 && page[0].row == 0);
+
+    // Scales are rounded to a quarter octave, the viewport scaled along.
+    queue.SubmitTiles(Document(), 0, 1.1, 600, 600, 10, 10, {}, 2);
+    results.Wait(2);
+    EXPECT(results.tiles[2].size() == 1);
+    if (results.tiles[2].size() == 1) {
+      const auto& tile = results.tiles[2][0];
+      EXPECT(std::abs(tile.scale - std::exp2(0.25)) < 1e-9);
+      EXPECT(tile.bucket == 1);
+      EXPECT(tile.column == 1 && tile.row == 1);
+      EXPECT(tile.x == 512 && tile.y == 512);
+    }
+
+    // Tiles Dart holds are not sent again.
+    std::vector<int32_t> held;
+    for (const auto& tile : page) {
+      if (tile.column != 0 || tile.row != 0) {
+        held.insert(held.end(), {tile.bucket, tile.column, tile.row});
+      }
+    }
+    queue.SubmitTiles(Document(), 0, 1.0, 0, 0, 595, 842, held, 3);
+    results.Wait(3);
+    EXPECT(results.tiles[3].size() == 1);
+    EXPECT(!results.tiles[3].empty() && results.tiles[3][0].column == 0 &&
+           results.tiles[3][0].row == 0);
+
+    // Nothing to render ends the job without an error.
+    queue.SubmitTiles(Document(), 99, 1.0, 0, 0, 10, 10, {}, 4);
+    queue.SubmitTiles(Document(), 0, 1.0, 700, 0, 10, 10, {}, 5);
+    queue.SubmitTiles(Document(), 0, 0.0, 0, 0, 10, 10, {}, 6);
+    results.Wait(6);
+    for (int job_id : {4, 5, 6}) {
+      EXPECT(results.tiles[job_id].empty());
+      EXPECT(results.ended[job_id].empty());
+    }
+
+    // Whole pages are truncated to the scale.
+    queue.Submit(Document(), {0, 99}, 0.5, 7);
+    results.Wait(7);
+    EXPECT((results.pages[7] ==
+            std::vector<std::pair<int, int>>{{297, 421}}));
+    EXPECT(results.ended[7].empty());
+
+    // A document PDFium cannot load ends the job with an error.
+    queue.Submit({'n', 'o', 'p', 'e', '\n'}, {}, 1.0, 8);
+    results.Wait(8);
+    EXPECT(!results.ended[8].empty());
+    EXPECT(results.pages[8].empty());
+
+    EXPECT((results.end_order == std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8}));
+  }
+
+  return plugin_common_testing::TestResult();
+}
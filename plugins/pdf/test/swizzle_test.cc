@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "plugins/common/testing/testing.h"
+#include "swizzle.h"
+
+using plugin_pdf::SwapRedBlue;
+
+static void Scalar(uint8_t* pixels, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t t = pixels[i * 4];
+    pixels[i * 4] = pixels[i * 4 + 2];
+    pixels[i * 4 + 2] = t;
+  }
+}
+
+// Counts around the vector widths exercise the tails, the byte offsets
+// unaligned pointers.  Bytes past the pixels must be left alone.
+static void TestMatchesScalar() {
+  for (size_t count : {0, 1, 3, 4, 5, 15, 16, 17, 33, 1001}) {
+    for (size_t offset : {0, 1, 4}) {
+      std::vector<uint8_t> a(offset + count * 4 + 4);
+      for (size_t i = 0; i < a.size(); i++) {
+        a[i] = static_cast<uint8_t>(i * 31 + 7);
+      }
+      std::vector<uint8_t> b = a;
+      SwapRedBlue(a.data() + offset, count);
+      Scalar(b.data() + offset, count);
+      if (a != b) {
+        fprintf(stderr, "mismatch: %zu pixels at offset %zu\n", count,
+                offset);
+      }
+      EXPECT(a == b);
+    }
+  }
+}
+
+// Swapping twice restores the input.
+static void TestRoundTrip() {
+  std::vector<uint8_t> a(257 * 4);
+  for (size_t i = 0; i < a.size(); i++) {
+    a[i] = static_cast<uint8_t>(i);
+  }
+  const std::vector<uint8_t> original = a;
+  SwapRedBlue(a.data(), 257);
+  EXPECT(a[0] == 2 && a[1] == 1 && a[2] == 0 && a[3] == 3);
+  SwapRedBlue(a.data(), 257);
+  EXPECT(a == original);
+}
+
+int main() {
+  TestMatchesScalar();
+  TestRoundTrip();
+  return plugin_common_testing::TestResult();
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decoder_registry.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <plugins/common/common.h>
+
+namespace video_player_linux {
+
+DecoderRegistry::DecoderRegistry() {
+  GList* decoders = gst_element_factory_list_get_elements(
+      GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+      GST_RANK_MARGINAL);
+  for (GList* l = decoders; l != nullptr; l = l->next) {
+    auto factory = GST_ELEMENT_FACTORY(gst_object_ref(l->data));
+    candidates_.push_back(
+        {factory, Classify(factory),
+         gst_plugin_feature_get_rank(GST_PLUGIN_FEATURE(factory))});
+  }
+  gst_plugin_feature_list_free(decoders);
+
+  std::stable_sort(candidates_.begin(), candidates_.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     if (a.tier != b.tier) {
+                       return a.tier > b.tier;
+                     }
+                     return a.rank > b.rank;
+                   });
+
+  SPDLOG_DEBUG("[VideoPlayer] {} video decoders", candidates_.size());
+}
+
+DecoderRegistry::~DecoderRegistry() {
+  for (auto& candidate : candidates_) {
+    gst_object_unref(candidate.factory);
+  }
+}
+
+DecoderRegistry::Tier DecoderRegistry::Classify(GstElementFactory* factory) {
+  const std::string name = GST_OBJECT_NAME(factory);
+  const gchar* klass =
+      gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
+
+  if (name.rfind("va", 0) == 0 || name.rfind("v4l2sl", 0) == 0) {
+    return Tier::kPreferredHardware;
+  }
+  if ((klass && strstr(klass, "Hardware")) || name.rfind("v4l2", 0) == 0) {
+    return Tier::kHardware;
+  }
+  return Tier::kSoftware;
+}
+
+bool DecoderRegistry::Validate(GstElementFactory* factory) {
+  GstElement* element = gst_element_factory_create(factory, nullptr);
+  if (!element) {
+    return false;
+  }
+  gst_object_ref_sink(element);
+  const GstStateChangeReturn ret =
+      gst_element_set_state(element, GST_STATE_READY);
+  gst_element_set_state(element, GST_STATE_NULL);
+  gst_object_unref(element);
+  return ret != GST_STATE_CHANGE_FAILURE;
+}
+
+GstElementFactory* DecoderRegistry::Select(const std::string& caps) {
+  GstCaps* sink_caps = gst_caps_from_string(caps.c_str());
+  if (!sink_caps) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  GstElementFactory* selected = nullptr;
+  for (const auto& candidate : candidates_) {
+    const std::string name = GST_OBJECT_NAME(candidate.factory);
+    if (failed_.count(name) ||
+        !gst_element_factory_can_sink_any_caps(candidate.factory, sink_caps)) {
+      continue;
+    }
+    auto it = validated_.find(name);
+    if (it == validated_.end()) {
+      it = validated_.emplace(name, Validate(candidate.factory)).first;
+      SPDLOG_DEBUG("[VideoPlayer] decoder {}: {}", name,
+                   it->second ? "usable" : "unusable");
+    }
+    if (!it->second) {
+      continue;
+    }
+    selected = GST_ELEMENT_FACTORY(gst_object_ref(candidate.factory));
+    break;
+  }
+  gst_caps_unref(sink_caps);
+  return selected;
+}
+
+void DecoderRegistry::MarkFailed(GstElementFactory* factory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  spdlog::warn("[VideoPlayer] decoder {} failed, falling back",
+               GST_OBJECT_NAME(factory));
+  failed_.insert(GST_OBJECT_NAME(factory));
+}
+
+}  // namespace video_player_linux
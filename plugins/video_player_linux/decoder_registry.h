@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <gst/gst.h>
+}
+
+namespace video_player_linux {
+
+/**
+ * Video decoders available on the system, ranked hardware first.
+ *
+ * Factories are enumerated once.  The first time a factory is selected an
+ * instance is brought to READY, which opens the VA display or V4L2 device of
+ * hardware decoders; factories that fail there, or later report an error
+ * while decoding, are not selected again.
+ */
+class DecoderRegistry {
+ public:
+  enum class Tier {
+    kSoftware = 0,
+    kHardware = 1,
+    // VA-API and V4L2 stateless decoders
+    kPreferredHardware = 2,
+  };
+
+  DecoderRegistry();
+  ~DecoderRegistry();
+
+  // Prevent copying.
+  DecoderRegistry(DecoderRegistry const&) = delete;
+  DecoderRegistry& operator=(DecoderRegistry const&) = delete;
+
+  /**
+   * @brief Select the best usable decoder for stream caps
+   * @param[in] caps Caps of the video stream
+   * @return GstElementFactory*
+   * @retval Decoder factory, caller owns the reference
+   * @retval nullptr No usable decoder
+   * @relation
+   * gstreamer
+   */
+  GstElementFactory* Select(const std::string& caps);
+
+  /**
+   * @brief Exclude a decoder after it failed at runtime
+   * @param[in] factory Decoder factory that failed
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void MarkFailed(GstElementFactory* factory);
+
+ private:
+  struct Candidate {
+    GstElementFactory* factory;
+    Tier tier;
+    guint rank;
+  };
+
+  std::mutex mutex_;
+  std::vector<Candidate> candidates_;
+  // Factory name -> passed validation
+  std::map<std::string, bool> validated_;
+  std::set<std::string> failed_;
+
+  static Tier Classify(GstElementFactory* factory);
+
+  static bool Validate(GstElementFactory* factory);
+};
+
+}  // namespace video_player_linux
@@ -0,0 +1,214 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+
+extern "C" {
+#include <gst/allocators/gstdmabuf.h>
+#include <gst/video/video.h>
+}
+
+#include <plugins/common/common.h>
+
+namespace video_player_linux::dmabuf {
+
+static constexpr uint32_t fourcc_code(char a, char b, char c, char d) {
+  return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) |
+         (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+// Single plane formats used to sample the Y and interleaved UV planes of an
+// NV12 dmabuf as two independent textures.
+static constexpr uint32_t kDrmFormatR8 = fourcc_code('R', '8', ' ', ' ');
+static constexpr uint32_t kDrmFormatGR88 = fourcc_code('G', 'R', '8', '8');
+
+class Importer {
+ public:
+  /**
+   * @brief Create an importer for the current EGL context
+   * @return std::unique_ptr<Importer>
+   * @retval nullptr EGL display cannot import dmabuf memory
+   * @relation
+   * flutter
+   */
+  static std::unique_ptr<Importer> Create() {
+    const EGLDisplay display = eglGetCurrentDisplay();
+    if (display == EGL_NO_DISPLAY) {
+      return nullptr;
+    }
+    const char* egl_extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!egl_extensions ||
+        !strstr(egl_extensions, "EGL_EXT_image_dma_buf_import")) {
+      SPDLOG_DEBUG("[VideoPlayer] EGL_EXT_image_dma_buf_import not supported");
+      return nullptr;
+    }
+    const auto gl_extensions =
+        reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (!gl_extensions || !strstr(gl_extensions, "GL_OES_EGL_image")) {
+      SPDLOG_DEBUG("[VideoPlayer] GL_OES_EGL_image not supported");
+      return nullptr;
+    }
+
+    auto importer = std::unique_ptr<Importer>(new Importer(display));
+    if (!importer->create_image_ || !importer->destroy_image_ ||
+        !importer->image_target_texture_) {
+      return nullptr;
+    }
+    return importer;
+  }
+
+  ~Importer() { release(); }
+
+  Importer(const Importer&) = delete;
+  Importer& operator=(const Importer&) = delete;
+
+  /**
+   * @brief Check if buffer is backed by dmabuf memory
+   * @param[in] buffer Decoded frame
+   * @return bool
+   * @retval true Every memory block is a dmabuf
+   * @retval false Frame must be mapped and uploaded
+   * @relation
+   * flutter
+   */
+  static bool is_dmabuf(GstBuffer* buffer) {
+    const guint n_memory = gst_buffer_n_memory(buffer);
+    if (n_memory == 0) {
+      return false;
+    }
+    for (guint i = 0; i < n_memory; i++) {
+      if (!gst_is_dmabuf_memory(gst_buffer_peek_memory(buffer, i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Import NV12 dmabuf planes into textures
+   * @param[in] buffer Decoded frame backed by dmabuf memory
+   * @param[in] info Video info negotiated on the sink
+   * @param[in] textures Y and UV texture names
+   * @return bool
+   * @retval true Textures now reference the frame
+   * @retval false Import failed, frame must be uploaded
+   * @relation
+   * flutter
+   */
+  bool import(GstBuffer* buffer,
+              const GstVideoInfo* info,
+              const GLuint textures[2]) {
+    release();
+
+    if (GST_VIDEO_INFO_FORMAT(info) != GST_VIDEO_FORMAT_NV12) {
+      return false;
+    }
+
+    // Decoders commonly pad planes, the video meta holds the real layout.
+    const GstVideoMeta* meta = gst_buffer_get_video_meta(buffer);
+
+    for (guint plane = 0; plane < 2; plane++) {
+      const gsize offset = meta ? meta->offset[plane]
+                                : GST_VIDEO_INFO_PLANE_OFFSET(info, plane);
+      const gint stride = meta ? meta->stride[plane]
+                               : GST_VIDEO_INFO_PLANE_STRIDE(info, plane);
+
+      guint mem_idx, length;
+      gsize skip;
+      if (!gst_buffer_find_memory(buffer, offset, 1, &mem_idx, &length,
+                                  &skip)) {
+        SPDLOG_ERROR("[VideoPlayer] dmabuf plane {} not found", plane);
+        release();
+        return false;
+      }
+      GstMemory* mem = gst_buffer_peek_memory(buffer, mem_idx);
+
+      const EGLint width = GST_VIDEO_INFO_COMP_WIDTH(info, plane);
+      const EGLint height = GST_VIDEO_INFO_COMP_HEIGHT(info, plane);
+      const EGLint attribs[] = {
+          EGL_WIDTH,
+          width,
+          EGL_HEIGHT,
+          height,
+          EGL_LINUX_DRM_FOURCC_EXT,
+          static_cast<EGLint>(plane == 0 ? kDrmFormatR8 : kDrmFormatGR88),
+          EGL_DMA_BUF_PLANE0_FD_EXT,
+          gst_dmabuf_memory_get_fd(mem),
+          EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+          static_cast<EGLint>(mem->offset + skip),
+          EGL_DMA_BUF_PLANE0_PITCH_EXT,
+          stride,
+          EGL_NONE,
+      };
+
+      images_[plane] = create_image_(display_, EGL_NO_CONTEXT,
+                                     EGL_LINUX_DMA_BUF_EXT, nullptr, attribs);
+      if (images_[plane] == EGL_NO_IMAGE_KHR) {
+        SPDLOG_ERROR("[VideoPlayer] eglCreateImageKHR failed: 0x{:X}",
+                     eglGetError());
+        release();
+        return false;
+      }
+
+      glBindTexture(GL_TEXTURE_2D, textures[plane]);
+      image_target_texture_(GL_TEXTURE_2D, images_[plane]);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+  }
+
+  /**
+   * @brief Destroy the images of the last imported frame
+   * @return void
+   * @relation
+   * flutter
+   */
+  void release() {
+    for (auto& image : images_) {
+      if (image != EGL_NO_IMAGE_KHR) {
+        destroy_image_(display_, image);
+        image = EGL_NO_IMAGE_KHR;
+      }
+    }
+  }
+
+ private:
+  EGLDisplay display_;
+  PFNEGLCREATEIMAGEKHRPROC create_image_;
+  PFNEGLDESTROYIMAGEKHRPROC destroy_image_;
+  PFNGLEGLIMAGETARGETTEXTURE2DOESPROC image_target_texture_;
+  EGLImageKHR images_[2]{EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR};
+
+  explicit Importer(EGLDisplay display)
+      : display_(display),
+        create_image_(reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(
+            eglGetProcAddress("eglCreateImageKHR"))),
+        destroy_image_(reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(
+            eglGetProcAddress("eglDestroyImageKHR"))),
+        image_target_texture_(
+            reinterpret_cast<PFNGLEGLIMAGETARGETTEXTURE2DOESPROC>(
+                eglGetProcAddress("glEGLImageTargetTexture2DOES"))) {}
+};
+
+}  // namespace video_player_linux::dmabuf
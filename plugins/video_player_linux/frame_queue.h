@@ -0,0 +1,160 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+extern "C" {
+#include <gst/gst.h>
+}
+
+namespace video_player_linux {
+
+/**
+ * Single producer / single consumer frame mailbox.
+ *
+ * The streaming thread pushes decoded buffers, the render step pops the most
+ * recent one.  A frame that is replaced before it was popped is dropped.  Three
+ * slots rotate between producer, consumer and the ready position so neither
+ * side ever blocks.
+ */
+class FrameQueue {
+ public:
+  struct Frame {
+    GstBuffer* buffer{};
+    // Caps the buffer was negotiated with, may be nullptr
+    GstCaps* caps{};
+    // g_get_monotonic_time() when the frame was pushed
+    gint64 queued_at{};
+  };
+
+  struct Stats {
+    uint64_t queued;
+    uint64_t dropped;
+    uint64_t late;
+  };
+
+  FrameQueue() = default;
+  ~FrameQueue() { clear(); }
+
+  FrameQueue(const FrameQueue&) = delete;
+  FrameQueue& operator=(const FrameQueue&) = delete;
+
+  /**
+   * @brief Queue a frame, replacing a pending one (producer only)
+   * @param[in] buffer Decoded frame, a reference is taken
+   * @param[in] caps Caps of the frame, a reference is taken
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void push(GstBuffer* buffer, GstCaps* caps) {
+    Frame& frame = slots_[back_];
+    release(frame);
+    frame.buffer = gst_buffer_ref(buffer);
+    frame.caps = caps ? gst_caps_ref(caps) : nullptr;
+    frame.queued_at = g_get_monotonic_time();
+
+    const int prev =
+        ready_.exchange(back_ | kNewFrame, std::memory_order_acq_rel);
+    back_ = prev & kIndexMask;
+
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    if (prev & kNewFrame) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Take the latest frame (consumer only)
+   * @return Frame
+   * @retval buffer nullptr if nothing new was queued, otherwise buffer and
+   * caps are owned by the caller
+   * @relation
+   * flutter
+   */
+  Frame pop() {
+    if (!has_frame()) {
+      return {};
+    }
+    const int prev = ready_.exchange(front_, std::memory_order_acq_rel);
+    front_ = prev & kIndexMask;
+
+    Frame frame = slots_[front_];
+    slots_[front_] = {};
+    return frame;
+  }
+
+  bool has_frame() const {
+    return (ready_.load(std::memory_order_acquire) & kNewFrame) != 0;
+  }
+
+  void mark_late() { late_.fetch_add(1, std::memory_order_relaxed); }
+
+  Stats stats() const {
+    return {queued_.load(std::memory_order_relaxed),
+            dropped_.load(std::memory_order_relaxed),
+            late_.load(std::memory_order_relaxed)};
+  }
+
+  /**
+   * @brief Release pending frames, neither side may be running
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void clear() {
+    for (auto& frame : slots_) {
+      release(frame);
+    }
+    ready_.store(ready_.load(std::memory_order_relaxed) & kIndexMask,
+                 std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Drop the references held by a frame
+   * @param[in,out] frame Frame to reset
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  static void release(Frame& frame) {
+    if (frame.buffer) {
+      gst_buffer_unref(frame.buffer);
+    }
+    if (frame.caps) {
+      gst_caps_unref(frame.caps);
+    }
+    frame = {};
+  }
+
+ private:
+  static constexpr int kIndexMask = 0x3;
+  static constexpr int kNewFrame = 0x4;
+
+  Frame slots_[3]{};
+  int back_ = 0;
+  int front_ = 1;
+  std::atomic<int> ready_{2};
+
+  std::atomic<uint64_t> queued_{};
+  std::atomic<uint64_t> dropped_{};
+  std::atomic<uint64_t> late_{};
+};
+
+}  // namespace video_player_linux
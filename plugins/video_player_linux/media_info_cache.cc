@@ -0,0 +1,205 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "media_info_cache.h"
+
+#include <sys/stat.h>
+
+#include <plugins/common/common.h>
+
+namespace video_player_linux {
+
+MediaInfoCache::MediaInfoCache(size_t capacity) : capacity_(capacity) {
+  GError* error = nullptr;
+  discoverer_ = gst_discoverer_new(kDiscoverTimeout, &error);
+  if (!discoverer_) {
+    spdlog::error("[VideoPlayer] Failed to create discoverer: {}",
+                  error ? error->message : "");
+    g_clear_error(&error);
+    return;
+  }
+  discovered_id_ =
+      g_signal_connect(discoverer_, "discovered",
+                       reinterpret_cast<GCallback>(OnDiscovered), this);
+  // Results are dispatched on the thread default context, the shared GLib
+  // main loop.
+  gst_discoverer_start(discoverer_);
+}
+
+MediaInfoCache::~MediaInfoCache() {
+  if (discoverer_) {
+    gst_discoverer_stop(discoverer_);
+    g_signal_handler_disconnect(discoverer_, discovered_id_);
+    g_object_unref(discoverer_);
+  }
+}
+
+std::string MediaInfoCache::CacheKey(const std::string& uri) {
+  gchar* filename = g_filename_from_uri(uri.c_str(), nullptr, nullptr);
+  if (!filename) {
+    return uri;
+  }
+  struct stat st {};
+  const int res = stat(filename, &st);
+  g_free(filename);
+  if (res != 0) {
+    return uri;
+  }
+  return uri + "|" + std::to_string(st.st_mtim.tv_sec) + "." +
+         std::to_string(st.st_mtim.tv_nsec) + "|" + std::to_string(st.st_size);
+}
+
+std::optional<MediaInfo> MediaInfoCache::Lookup(const std::string& uri) {
+  const auto key = CacheKey(uri);
+  const bool is_network = key == uri && gst_uri_is_valid(uri.c_str()) &&
+                          !g_str_has_prefix(uri.c_str(), "file:");
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(uri);
+  if (it == index_.end()) {
+    return std::nullopt;
+  }
+  const auto& entry = *it->second;
+  if (entry.key != key ||
+      (is_network &&
+       g_get_monotonic_time() - entry.inserted_at > kNetworkEntryLifetimeUs)) {
+    SPDLOG_DEBUG("[VideoPlayer] media info stale: {}", uri);
+    lru_.erase(it->second);
+    index_.erase(it);
+    return std::nullopt;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second);
+  SPDLOG_DEBUG("[VideoPlayer] media info cache hit: {}", uri);
+  return entry.info;
+}
+
+void MediaInfoCache::Insert(const std::string& uri, const MediaInfo& info) {
+  const auto key = CacheKey(uri);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(uri);
+  if (it != index_.end()) {
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+  lru_.push_front({uri, key, info, g_get_monotonic_time()});
+  index_[uri] = lru_.begin();
+
+  while (lru_.size() > capacity_) {
+    index_.erase(lru_.back().uri);
+    lru_.pop_back();
+  }
+}
+
+void MediaInfoCache::Probe(const std::string& uri,
+                           int64_t request_id,
+                           Callback callback) {
+  bool start;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& requests = pending_[uri];
+    start = requests.empty();
+    requests.push_back({request_id, std::move(callback)});
+  }
+  if (!start) {
+    // Same URI is already being discovered.
+    return;
+  }
+
+  if (!discoverer_ ||
+      !gst_discoverer_discover_uri_async(discoverer_, uri.c_str())) {
+    spdlog::error("[VideoPlayer] Failed to queue discovery: {}", uri);
+    std::list<Request> requests;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests = std::move(pending_[uri]);
+      pending_.erase(uri);
+    }
+    std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex_);
+    for (auto& request : requests) {
+      request.callback(std::nullopt);
+    }
+  }
+}
+
+void MediaInfoCache::Cancel(int64_t request_id) {
+  std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+    it->second.remove_if(
+        [request_id](const Request& r) { return r.id == request_id; });
+  }
+}
+
+void MediaInfoCache::OnDiscovered(GstDiscoverer* /* discoverer */,
+                                  GstDiscovererInfo* info,
+                                  GError* error,
+                                  gpointer user_data) {
+  auto obj = static_cast<MediaInfoCache*>(user_data);
+  const std::string uri = gst_discoverer_info_get_uri(info);
+
+  std::optional<MediaInfo> result;
+  if (gst_discoverer_info_get_result(info) == GST_DISCOVERER_OK) {
+    GList* streams = gst_discoverer_info_get_video_streams(info);
+    if (streams) {
+      auto video = static_cast<GstDiscovererVideoInfo*>(streams->data);
+      MediaInfo media_info;
+      media_info.width =
+          static_cast<gint>(gst_discoverer_video_info_get_width(video));
+      media_info.height =
+          static_cast<gint>(gst_discoverer_video_info_get_height(video));
+      media_info.duration =
+          static_cast<gint64>(gst_discoverer_info_get_duration(info));
+      GstCaps* caps = gst_discoverer_stream_info_get_caps(
+          GST_DISCOVERER_STREAM_INFO(video));
+      if (caps) {
+        gchar* caps_str = gst_caps_to_string(caps);
+        media_info.video_caps = caps_str;
+        g_free(caps_str);
+        gst_caps_unref(caps);
+      }
+      gst_discoverer_stream_info_list_free(streams);
+
+      SPDLOG_DEBUG("[VideoPlayer] discovered: {}, {}x{}, duration: {}, {}",
+                   uri, media_info.width, media_info.height,
+                   media_info.duration, media_info.video_caps);
+      obj->Insert(uri, media_info);
+      result = std::move(media_info);
+    } else {
+      spdlog::error("[VideoPlayer] No video stream: {}", uri);
+    }
+  } else {
+    spdlog::error("[VideoPlayer] Discovery failed: {}: {}", uri,
+                  error ? error->message : "");
+  }
+
+  std::lock_guard<std::mutex> dispatch_lock(obj->dispatch_mutex_);
+  std::list<Request> requests;
+  {
+    std::lock_guard<std::mutex> lock(obj->mutex_);
+    auto it = obj->pending_.find(uri);
+    if (it == obj->pending_.end()) {
+      return;
+    }
+    requests = std::move(it->second);
+    obj->pending_.erase(it);
+  }
+  for (auto& request : requests) {
+    request.callback(result);
+  }
+}
+
+}  // namespace video_player_linux
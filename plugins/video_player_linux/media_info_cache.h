@@ -0,0 +1,133 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+extern "C" {
+#include <gst/gst.h>
+#include <gst/pbutils/pbutils.h>
+}
+
+namespace video_player_linux {
+
+struct MediaInfo {
+  gint width{};
+  gint height{};
+  // Duration in nanoseconds
+  gint64 duration{};
+  // Caps of the selected video stream
+  std::string video_caps;
+};
+
+/**
+ * Asynchronous media metadata probe backed by GstDiscoverer, with a least
+ * recently used cache of the results.
+ *
+ * Local files are keyed by URI, modification time and size so an edited file
+ * is probed again.  Network URIs are keyed by URI and expire after
+ * kNetworkEntryLifetimeUs.
+ */
+class MediaInfoCache {
+ public:
+  using Callback = std::function<void(const std::optional<MediaInfo>& info)>;
+
+  static constexpr size_t kDefaultCapacity = 64;
+  static constexpr gint64 kNetworkEntryLifetimeUs = 10 * G_TIME_SPAN_MINUTE;
+  static constexpr GstClockTime kDiscoverTimeout = 10 * GST_SECOND;
+
+  explicit MediaInfoCache(size_t capacity = kDefaultCapacity);
+  ~MediaInfoCache();
+
+  // Prevent copying.
+  MediaInfoCache(MediaInfoCache const&) = delete;
+  MediaInfoCache& operator=(MediaInfoCache const&) = delete;
+
+  /**
+   * @brief Look up cached metadata without probing
+   * @param[in] uri URI of the stream
+   * @return std::optional<MediaInfo>
+   * @retval std::nullopt Not cached or stale
+   * @relation
+   * flutter
+   */
+  std::optional<MediaInfo> Lookup(const std::string& uri);
+
+  /**
+   * @brief Probe a URI asynchronously
+   * @param[in] uri URI of the stream
+   * @param[in] request_id Caller chosen id, used to cancel
+   * @param[in] callback Invoked on the GLib main loop with the result
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void Probe(const std::string& uri, int64_t request_id, Callback callback);
+
+  /**
+   * @brief Cancel a pending probe.  When this returns the callback is not
+   * running and will not be invoked.
+   * @param[in] request_id Id passed to Probe
+   * @return void
+   * @relation
+   * flutter
+   */
+  void Cancel(int64_t request_id);
+
+ private:
+  struct Entry {
+    std::string uri;
+    std::string key;
+    MediaInfo info;
+    gint64 inserted_at;
+  };
+
+  struct Request {
+    int64_t id;
+    Callback callback;
+  };
+
+  size_t capacity_;
+  GstDiscoverer* discoverer_{};
+  gulong discovered_id_{};
+
+  // Guards the cache and the pending requests.
+  std::mutex mutex_;
+  // Held while callbacks run so Cancel can wait for them.
+  std::mutex dispatch_mutex_;
+
+  std::list<Entry> lru_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  std::map<std::string, std::list<Request>> pending_;
+
+  static std::string CacheKey(const std::string& uri);
+
+  void Insert(const std::string& uri, const MediaInfo& info);
+
+  static void OnDiscovered(GstDiscoverer* discoverer,
+                           GstDiscovererInfo* info,
+                           GError* error,
+                           gpointer user_data);
+};
+
+}  // namespace video_player_linux
@@ -18,6 +18,11 @@
 
 #include <GLES3/gl3.h>
 
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
 #include <plugins/common/common.h>
 
 namespace video_player_linux::nv12 {
@@ -37,47 +42,173 @@ static const GLchar* kVertexSource = R"glsl(
   }
 )glsl";
 
+// NV12: U and V interleaved in textureUV.
 static const GLchar* kFragmentSource = R"glsl(
   #version 300 es
   precision highp float;
   in vec2 Texcoord;
   uniform sampler2D textureY;
   uniform sampler2D textureUV;
+  uniform mat3 yuvMatrix;
+  uniform vec3 yuvOffset;
   layout(location = 0) out vec4 fragColor;
   void main() {
-    float r, g, b, y, u, v;
     vec2 coord = vec2(Texcoord.x, 1.0 - Texcoord.y);
-    y = texture(textureY, coord).r - 0.0625;
-    u = texture(textureUV, coord).r - 0.5;
-    v = texture(textureUV, coord).g - 0.5;
-    r = clamp(y + 1.370705 * v, 0.0, 1.0);
-    g = clamp(y - 0.337633 * u - 0.698001 * v, 0.0, 1.0);
-    b = clamp(y + 1.732446 * u, 0.0, 1.0);
-    fragColor = vec4(r, g, b, 1.0);
+    vec3 yuv = vec3(texture(textureY, coord).r, texture(textureUV, coord).rg);
+    vec3 rgb = yuvMatrix * (yuv - yuvOffset);
+    fragColor = vec4(clamp(rgb, 0.0, 1.0), 1.0);
   }
 )glsl";
 
+// I420: U in textureUV, V in textureV.
+static const GLchar* kPlanarFragmentSource = R"glsl(
+  #version 300 es
+  precision highp float;
+  in vec2 Texcoord;
+  uniform sampler2D textureY;
+  uniform sampler2D textureUV;
+  uniform sampler2D textureV;
+  uniform mat3 yuvMatrix;
+  uniform vec3 yuvOffset;
+  layout(location = 0) out vec4 fragColor;
+  void main() {
+    vec2 coord = vec2(Texcoord.x, 1.0 - Texcoord.y);
+    vec3 yuv = vec3(texture(textureY, coord).r, texture(textureUV, coord).r,
+                    texture(textureV, coord).r);
+    vec3 rgb = yuvMatrix * (yuv - yuvOffset);
+    fragColor = vec4(clamp(rgb, 0.0, 1.0), 1.0);
+  }
+)glsl";
+
+// Depth of the pixel buffer object ring used to stream plane uploads.
+static constexpr int kPixelBufferCount = 3;
+
+// Upper bound for waiting on a pixel buffer the GPU is still reading from.
+static constexpr GLuint64 kFenceTimeoutNs = 100000000;
+
+// Y, U and V planes of I420.
+static constexpr int kMaxPlanes = 3;
+
+// YCbCr to RGB conversion, selected from the stream colorimetry.
+enum class ColorMatrix {
+  kBT601,
+  kBT709,
+  kBT2020,
+};
+
+// One plane of a decoded frame in system memory.
+struct Plane {
+  const unsigned char* data;
+  // Bytes per row, may include padding
+  GLsizei stride;
+  // Bytes per texel, 1 for a single component, 2 for interleaved UV
+  GLsizei pixel_stride;
+  GLsizei width;
+  GLsizei height;
+};
+
+// Compiled NV12 and I420 programs.  Programs are context objects, so every
+// Shader created on the same context can share one set.
+class Programs {
+ public:
+  GLuint nv12{};
+  GLuint planar{};
+
+  Programs() {
+    // A branch on the plane layout in one shader costs more than switching
+    // programs per frame.
+    nv12 = load_shaders(kVertexSource, kFragmentSource);
+    planar = load_shaders(kVertexSource, kPlanarFragmentSource);
+    for (const GLuint p : {planar, nv12}) {
+      glUseProgram(p);
+      glUniform1i(glGetUniformLocation(p, "textureY"), 0);
+      glUniform1i(glGetUniformLocation(p, "textureUV"), 1);
+      glUniform1i(glGetUniformLocation(p, "textureV"), 2);
+    }
+  }
+
+  ~Programs() {
+    glDeleteProgram(nv12);
+    glDeleteProgram(planar);
+  }
+
+  Programs(const Programs&) = delete;
+  Programs& operator=(const Programs&) = delete;
+
+  static GLuint load_shaders(const GLchar* vsource, const GLchar* fsource) {
+    GLint result;
+    GLsizei length;
+    GLchar info[1000]{};
+
+    const GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex_shader, 1, &vsource, nullptr);
+    glCompileShader(vertex_shader);
+    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetShaderInfoLog(vertex_shader, sizeof(info), &length, info);
+      SPDLOG_ERROR("Failed to compile {}", info);
+      glDeleteShader(vertex_shader);
+      return 0;
+    }
+
+    const GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment_shader, 1, &fsource, nullptr);
+    glCompileShader(fragment_shader);
+    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetShaderInfoLog(fragment_shader, sizeof(info), &length, info);
+      SPDLOG_ERROR("Fail to compile {}", info);
+      glDeleteShader(vertex_shader);
+      glDeleteShader(fragment_shader);
+      return 0;
+    }
+
+    const GLuint shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertex_shader);
+    glAttachShader(shaderProgram, fragment_shader);
+    glBindAttribLocation(shaderProgram, 1, "texcoord");
+    glLinkProgram(shaderProgram);
+
+    glDetachShader(shaderProgram, vertex_shader);
+    glDetachShader(shaderProgram, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetProgramInfoLog(shaderProgram, sizeof(info), &length, info);
+      SPDLOG_ERROR("Fail to link {}", info);
+      return 0;
+    }
+    return shaderProgram;
+  }
+};
+
 class Shader {
  public:
   GLuint textureId{};
   GLuint framebuffer{};
-  GLuint program;
   GLsizei width, height;
   GLuint vertex_arr_id_{};
 
-  Shader(GLsizei _width, GLsizei _height) : width(_width), height(_height) {
+  Shader(GLsizei _width, GLsizei _height)
+      : Shader(_width, _height, std::make_shared<Programs>()) {}
+
+  Shader(GLsizei _width,
+         GLsizei _height,
+         std::shared_ptr<const Programs> programs)
+      : width(_width), height(_height), programs_(std::move(programs)) {
     glGenFramebuffers(1, &framebuffer);
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     glGenVertexArrays(1, &vertex_arr_id_);
     glBindVertexArray(vertex_arr_id_);
 
-    program = load_shaders();
-    texY = glGetUniformLocation(program, "textureY");
-    texUV = glGetUniformLocation(program, "textureUV");
-    glUseProgram(program);
+    glUseProgram(programs_->nv12);
+    set_color_space(ColorMatrix::kBT601, false);
 
-    glGenTextures(2, &innerTexture[0]);
+    glGenTextures(kMaxPlanes, &innerTexture[0]);
+    glGenTextures(2, &importTexture[0]);
     glGenTextures(1, &textureId);
     glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
@@ -147,126 +278,225 @@ class Shader {
   }
 
   ~Shader() {
+    for (auto& pixel_buffer : pixel_buffers_) {
+      if (pixel_buffer.fence) {
+        glDeleteSync(pixel_buffer.fence);
+      }
+      glDeleteBuffers(1, &pixel_buffer.buffer);
+    }
+    if (draw_fence_) {
+      glDeleteSync(draw_fence_);
+    }
     glDeleteBuffers(1, &coord_buffer_);
     glDeleteBuffers(1, &vertex_buffer_);
     glDeleteVertexArrays(1, &vertex_arr_id_);
-    glDeleteProgram(program);
     glDeleteTextures(1, &textureId);
-    glDeleteTextures(2, &innerTexture[0]);
+    glDeleteTextures(kMaxPlanes, &innerTexture[0]);
+    glDeleteTextures(2, &importTexture[0]);
     glDeleteFramebuffers(1, &framebuffer);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
   }
 
   /**
-   * @brief Load pixels
-   * @param[in] y_buf Pointer to image data for luminance signal
-   * @param[in] uv_buf Pointer to image data for color difference signal
-   * @param[in] y_p_s No use
-   * @param[in] y_s Texture image width for luminance signal
-   * @param[in] uv_p_s No use
-   * @param[in] uv_s Texture image width for color difference signal
+   * @brief Resize the output texture, the texture name is unchanged
+   * @param[in] _width Texture width
+   * @param[in] _height Texture height
    * @return void
    * @relation
    * flutter
    */
-  void load_pixels(unsigned char* y_buf,
-                   unsigned char* uv_buf,
-                   GLsizei y_p_s,
-                   GLsizei y_s,
-                   GLsizei uv_p_s,
-                   GLsizei uv_s) {
-    (void)y_p_s;
-    (void)uv_p_s;
-    SPDLOG_TRACE("[VideoPlayer] load_pixels");
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, innerTexture[0]);
-    glUniform1i(texY, 0);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, y_s, height, 0, GL_RED,
-                 GL_UNSIGNED_BYTE, y_buf);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, innerTexture[1]);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glUniform1i(texUV, 1);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  void resize(GLsizei _width, GLsizei _height) {
+    if (_width == width && _height == height) {
+      return;
+    }
+    width = _width;
+    height = _height;
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, uv_s / 2, height / 2, 0, GL_RG,
-                 GL_UNSIGNED_BYTE, uv_buf);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    auto fbo_status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-    if (fbo_status != GL_FRAMEBUFFER_COMPLETE)
-      spdlog::error("[VideoPlayer] Framebuffer is not complete: 0x{:X}",
-                    fbo_status);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+      spdlog::error("FramebufferStatus: 0x{:X}", status);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
 
+  /**
+   * @brief Clear the output texture to transparent black, used when the
+   * shader is recycled for another player
+   * @return void
+   * @relation
+   * flutter
+   */
+  void clear() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
   }
 
-  GLuint load_shaders(const GLchar* vsource = kVertexSource,
-                      const GLchar* fsource = kFragmentSource) {
-    GLint result;
-    GLsizei length;
-    GLchar* info{};
+  /**
+   * @brief Set the YCbCr to RGB conversion used by draw_core
+   * @param[in] matrix Color matrix of the stream
+   * @param[in] full_range true for 0-255 samples, false for 16-235/240
+   * @return void
+   * @relation
+   * flutter
+   */
+  void set_color_space(ColorMatrix matrix, bool full_range) {
+    float kr, kb;
+    switch (matrix) {
+      case ColorMatrix::kBT709:
+        kr = 0.2126f;
+        kb = 0.0722f;
+        break;
+      case ColorMatrix::kBT2020:
+        kr = 0.2627f;
+        kb = 0.0593f;
+        break;
+      case ColorMatrix::kBT601:
+      default:
+        kr = 0.299f;
+        kb = 0.114f;
+        break;
+    }
+    const float kg = 1.0f - kr - kb;
+    const float y_scale = full_range ? 1.0f : 255.0f / 219.0f;
+    const float c_scale = full_range ? 1.0f : 255.0f / 224.0f;
+
+    // Column major: the Y, Cb and Cr contributions to R, G, B.
+    const GLfloat yuv_matrix[9] = {
+        y_scale,
+        y_scale,
+        y_scale,
+        0.0f,
+        -2.0f * kb * (1.0f - kb) / kg * c_scale,
+        2.0f * (1.0f - kb) * c_scale,
+        2.0f * (1.0f - kr) * c_scale,
+        -2.0f * kr * (1.0f - kr) / kg * c_scale,
+        0.0f,
+    };
+    memcpy(yuv_matrix_, yuv_matrix, sizeof(yuv_matrix_));
+    yuv_offset_[0] = full_range ? 0.0f : 16.0f / 255.0f;
+    yuv_offset_[1] = 128.0f / 255.0f;
+    yuv_offset_[2] = 128.0f / 255.0f;
+  }
 
-    vertex_shader_ = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader_, 1, &vsource, nullptr);
-    glCompileShader(vertex_shader_);
-    glGetShaderiv(vertex_shader_, GL_COMPILE_STATUS, &result);
-    if (result == GL_FALSE) {
-      glGetShaderInfoLog(vertex_shader_, 1000, &length, info);
-      SPDLOG_ERROR("Failed to compile {}", info);
-      return 0;
+  /**
+   * @brief Upload the planes of an NV12 (2 planes) or I420 (3 planes) frame.
+   * Planes keep their decoded size, draw_core scales them to the texture.
+   * @param[in] planes Plane layout and data
+   * @param[in] count Number of planes
+   * @return void
+   * @relation
+   * flutter
+   */
+  void load_planes(const Plane* planes, int count) {
+    SPDLOG_TRACE("[VideoPlayer] load_planes");
+    planar_ = count == kMaxPlanes;
+    ensure_plane_storage(planes, count);
+
+    GLsizeiptr offsets[kMaxPlanes]{};
+    GLsizeiptr total_size = 0;
+    const void* sources[kMaxPlanes]{};
+    for (int i = 0; i < count; i++) {
+      offsets[i] = total_size;
+      total_size +=
+          static_cast<GLsizeiptr>(planes[i].stride) * planes[i].height;
+      sources[i] = planes[i].data;
     }
 
-    fragment_shader_ = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader_, 1, &fsource, nullptr);
-    glCompileShader(fragment_shader_);
-    glGetShaderiv(fragment_shader_, GL_COMPILE_STATUS, &result);
-    if (result == GL_FALSE) {
-      glGetShaderInfoLog(fragment_shader_, 1000, &length, info);
-      SPDLOG_ERROR("Fail to compile {}", info);
-      return 0;
+    // Stage the planes in the next pixel buffer of the ring.  The GPU copies
+    // into the textures asynchronously, the fence tells us when the buffer
+    // may be written again.
+    auto& pixel_buffer = pixel_buffers_[pixel_buffer_index_];
+    pixel_buffer_index_ = (pixel_buffer_index_ + 1) % kPixelBufferCount;
+    wait_fence(pixel_buffer.fence);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer.buffer);
+    if (pixel_buffer.size != total_size) {
+      pixel_buffer.size = total_size;
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, pixel_buffer.size, nullptr,
+                   GL_STREAM_DRAW);
+    }
+    auto mapped = static_cast<unsigned char*>(glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, pixel_buffer.size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+            GL_MAP_UNSYNCHRONIZED_BIT));
+    if (mapped) {
+      for (int i = 0; i < count; i++) {
+        memcpy(mapped + offsets[i], planes[i].data,
+               static_cast<size_t>(planes[i].stride) *
+                   static_cast<size_t>(planes[i].height));
+        sources[i] = reinterpret_cast<const void*>(offsets[i]);
+      }
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+      SPDLOG_ERROR("[VideoPlayer] Failed to map pixel buffer: 0x{:X}",
+                   glGetError());
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     }
 
-    const GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertex_shader_);
-    glAttachShader(shaderProgram, fragment_shader_);
-    glLinkProgram(shaderProgram);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < count; i++) {
+      // Row padding is skipped rather than sampled.
+      glPixelStorei(GL_UNPACK_ROW_LENGTH,
+                    planes[i].stride / planes[i].pixel_stride);
+      glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
+      glBindTexture(GL_TEXTURE_2D, innerTexture[i]);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, planes[i].width,
+                      planes[i].height,
+                      planes[i].pixel_stride == 2 ? GL_RG : GL_RED,
+                      GL_UNSIGNED_BYTE, sources[i]);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &result);
-    if (result == GL_FALSE) {
-      glGetProgramInfoLog(shaderProgram, 1000, &length, info);
-      SPDLOG_ERROR("Fail to link {}", info);
-      return 0;
+    if (mapped) {
+      pixel_buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     }
+  }
 
-    glDetachShader(shaderProgram, vertex_shader_);
-    glDetachShader(shaderProgram, fragment_shader_);
-    glDeleteShader(vertex_shader_);
-    glDeleteShader(fragment_shader_);
-    return shaderProgram;
+  /**
+   * @brief Bind plane textures without uploading pixels
+   * @return void
+   * @relation
+   * flutter
+   */
+  void bind_planes() {
+    SPDLOG_TRACE("[VideoPlayer] bind_planes");
+    planar_ = false;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    for (GLuint i = 0; i < 2; i++) {
+      glActiveTexture(GL_TEXTURE0 + i);
+      glBindTexture(GL_TEXTURE_2D, importTexture[i]);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
   }
 
-  void draw_core() const {
+  const GLuint* plane_textures() const { return importTexture; }
+
+  void draw_core() {
     SPDLOG_TRACE("[VideoPlayer] draw_core");
     glViewport(-width / 2, -height / 2, width * 2, height * 2);
     glClearColor(0, 0, 0, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(program);
+    const GLuint active_program = planar_ ? programs_->planar : programs_->nv12;
+    glUseProgram(active_program);
+    glUniformMatrix3fv(glGetUniformLocation(active_program, "yuvMatrix"), 1,
+                       GL_FALSE, yuv_matrix_);
+    glUniform3fv(glGetUniformLocation(active_program, "yuvOffset"), 1,
+                 yuv_offset_);
 
     glEnableVertexAttribArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
@@ -281,7 +511,22 @@ class Shader {
     glDisableVertexAttribArray(0);
     glDisableVertexAttribArray(1);
 
-    glFinish();
+    // Submit without stalling the streaming thread on the GPU.
+    if (draw_fence_) {
+      glDeleteSync(draw_fence_);
+    }
+    draw_fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+  }
+
+  /**
+   * @brief Wait until the last draw_core has been executed by the GPU
+   * @return void
+   * @relation
+   * flutter
+   */
+  void wait_draw() {
+    wait_fence(draw_fence_);
   }
 
   void load_rgb_pixels(const unsigned char* data) const {
@@ -301,12 +546,97 @@ class Shader {
   }
 
  private:
-  GLint texY{};
-  GLint texUV{};
-  GLuint innerTexture[2]{};
+  std::shared_ptr<const Programs> programs_;
+  GLuint innerTexture[kMaxPlanes]{};
+  GLuint importTexture[2]{};
+
+  bool planar_{};
+  GLfloat yuv_matrix_[9]{};
+  GLfloat yuv_offset_[3]{};
+
+  struct PixelBuffer {
+    GLuint buffer{};
+    GLsizeiptr size{};
+    GLsync fence{};
+  };
+  PixelBuffer pixel_buffers_[kPixelBufferCount]{};
+  int pixel_buffer_index_{};
+  GLsync draw_fence_{};
+
+  GLsizei plane_width_[kMaxPlanes]{};
+  GLsizei plane_height_[kMaxPlanes]{};
+  GLenum plane_format_[kMaxPlanes]{};
 
-  GLuint vertex_shader_{};
-  GLuint fragment_shader_{};
+  /**
+   * @brief Allocate immutable plane storage if the frame layout changed
+   * @param[in] planes Plane layout of the frame
+   * @param[in] count Number of planes
+   * @return void
+   * @relation
+   * flutter
+   */
+  void ensure_plane_storage(const Plane* planes, int count) {
+    bool changed = false;
+    for (int i = 0; i < count; i++) {
+      const GLenum format = planes[i].pixel_stride == 2 ? GL_RG8 : GL_R8;
+      changed |= plane_width_[i] != planes[i].width ||
+                 plane_height_[i] != planes[i].height ||
+                 plane_format_[i] != format;
+    }
+    if (!changed) {
+      return;
+    }
+    SPDLOG_DEBUG("[VideoPlayer] plane storage: {} planes, {}x{}", count,
+                 planes[0].width, planes[0].height);
+
+    if (pixel_buffers_[0].buffer == 0) {
+      for (auto& pixel_buffer : pixel_buffers_) {
+        glGenBuffers(1, &pixel_buffer.buffer);
+      }
+    }
+
+    // Immutable storage cannot be resized, replace the texture names.
+    if (plane_width_[0] != 0) {
+      glDeleteTextures(kMaxPlanes, &innerTexture[0]);
+      glGenTextures(kMaxPlanes, &innerTexture[0]);
+      memset(plane_width_, 0, sizeof(plane_width_));
+      memset(plane_height_, 0, sizeof(plane_height_));
+      memset(plane_format_, 0, sizeof(plane_format_));
+    }
+
+    for (int i = 0; i < count; i++) {
+      plane_format_[i] = planes[i].pixel_stride == 2 ? GL_RG8 : GL_R8;
+      plane_width_[i] = planes[i].width;
+      plane_height_[i] = planes[i].height;
+      glBindTexture(GL_TEXTURE_2D, innerTexture[i]);
+      glTexStorage2D(GL_TEXTURE_2D, 1, plane_format_[i], plane_width_[i],
+                     plane_height_[i]);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+  }
+
+  /**
+   * @brief Wait for and delete a fence
+   * @param[in,out] fence Fence to wait on, reset to nullptr
+   * @return void
+   * @relation
+   * flutter
+   */
+  static void wait_fence(GLsync& fence) {
+    if (!fence) {
+      return;
+    }
+    const GLenum result =
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+      SPDLOG_WARN("[VideoPlayer] fence wait: 0x{:X}", result);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
 
   GLuint vertex_buffer_{};
   GLuint coord_buffer_{};
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+extern "C" {
+#include <glib.h>
+}
+
+namespace video_player_linux {
+
+/**
+ * Playback counters and timings of one player.
+ *
+ * Written from the streaming, render, Flutter raster and GLib threads with
+ * relaxed atomics only, so recording never blocks the frame path.  A
+ * snapshot is not taken atomically as a whole; counters may be a frame
+ * apart.
+ */
+class PlaybackStats {
+ public:
+  // Upper bounds of the jitter histogram buckets in microseconds, the last
+  // bucket takes everything above.
+  static constexpr std::array<int64_t, 6> kJitterBucketsUs = {
+      1000, 2000, 4000, 8000, 16000, 32000};
+  static constexpr size_t kJitterBucketCount = kJitterBucketsUs.size() + 1;
+
+  // Count, sum and maximum of a duration in microseconds.
+  class Timing {
+   public:
+    struct Snapshot {
+      uint64_t count;
+      uint64_t sum_us;
+      uint64_t max_us;
+
+      uint64_t average_us() const { return count ? sum_us / count : 0; }
+    };
+
+    void add(int64_t us) {
+      if (us < 0) {
+        return;
+      }
+      const auto value = static_cast<uint64_t>(us);
+      count_.fetch_add(1, std::memory_order_relaxed);
+      sum_.fetch_add(value, std::memory_order_relaxed);
+      uint64_t max = max_.load(std::memory_order_relaxed);
+      while (value > max && !max_.compare_exchange_weak(
+                                max, value, std::memory_order_relaxed)) {
+      }
+    }
+
+    Snapshot snapshot() const {
+      return {count_.load(std::memory_order_relaxed),
+              sum_.load(std::memory_order_relaxed),
+              max_.load(std::memory_order_relaxed)};
+    }
+
+   private:
+    std::atomic<uint64_t> count_{};
+    std::atomic<uint64_t> sum_{};
+    std::atomic<uint64_t> max_{};
+  };
+
+  struct Snapshot {
+    // g_get_monotonic_time() when taken and of the first decoded frame
+    int64_t taken_at;
+    int64_t first_frame_at;
+    // Frames handed over by the sink
+    uint64_t frames_decoded;
+    // Frames drawn into the texture
+    uint64_t frames_rendered;
+    // Replaced in the frame queue before the render thread took them
+    uint64_t frames_dropped;
+    // Waited longer than their duration before being drawn
+    uint64_t frames_late;
+    // Dropped by decoders and the sink on QoS
+    uint64_t qos_dropped;
+    // Pipeline latency in microseconds
+    uint64_t latency_us;
+    // Push to the render thread taking the frame
+    Timing::Snapshot queue;
+    // Upload or import plus draw
+    Timing::Snapshot upload;
+    // Texture marked available to Flutter pulling it
+    Timing::Snapshot present;
+    // Deviation of present intervals from the frame duration
+    std::array<uint64_t, kJitterBucketCount> jitter;
+  };
+
+  /**
+   * @brief Count a frame received from the sink (streaming thread)
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void frame_decoded() {
+    int64_t expected = 0;
+    first_frame_at_.compare_exchange_strong(expected, g_get_monotonic_time(),
+                                            std::memory_order_relaxed);
+    frames_decoded_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Record a frame drawn into the texture (render thread)
+   * @param[in] queued_us Time the frame spent in the queue
+   * @param[in] upload_us Time spent uploading and drawing it
+   * @return void
+   * @relation
+   * flutter
+   */
+  void frame_rendered(int64_t queued_us, int64_t upload_us) {
+    frames_rendered_.fetch_add(1, std::memory_order_relaxed);
+    queue_.add(queued_us);
+    upload_.add(upload_us);
+    marked_at_.store(g_get_monotonic_time(), std::memory_order_release);
+  }
+
+  /**
+   * @brief Record Flutter pulling the texture, from the texture descriptor
+   * callback (raster thread)
+   * @return void
+   * @relation
+   * flutter
+   */
+  void frame_pulled() {
+    const int64_t marked = marked_at_.exchange(0, std::memory_order_acq_rel);
+    if (marked == 0) {
+      // No new frame since the last pull.
+      return;
+    }
+    const int64_t now = g_get_monotonic_time();
+    present_.add(now - marked);
+
+    const int64_t previous = last_pull_at_;
+    last_pull_at_ = now;
+    const int64_t duration = frame_duration_us_.load(std::memory_order_relaxed);
+    if (previous == 0 || duration <= 0) {
+      return;
+    }
+    const int64_t jitter = std::llabs((now - previous) - duration);
+    size_t bucket = 0;
+    while (bucket < kJitterBucketsUs.size() &&
+           jitter >= kJitterBucketsUs[bucket]) {
+      bucket++;
+    }
+    jitter_[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void set_frame_duration(int64_t us) {
+    frame_duration_us_.store(us, std::memory_order_relaxed);
+  }
+
+  void set_qos_dropped(uint64_t dropped) {
+    qos_dropped_.store(dropped, std::memory_order_relaxed);
+  }
+
+  void set_latency(uint64_t us) {
+    latency_us_.store(us, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Copy the current values
+   * @param[in] queue_dropped Frames dropped by the frame queue
+   * @param[in] queue_late Late frames counted by the frame queue
+   * @return Snapshot
+   * @relation
+   * flutter
+   */
+  Snapshot snapshot(uint64_t queue_dropped, uint64_t queue_late) const {
+    Snapshot snapshot{};
+    snapshot.taken_at = g_get_monotonic_time();
+    snapshot.first_frame_at = first_frame_at_.load(std::memory_order_relaxed);
+    snapshot.frames_decoded = frames_decoded_.load(std::memory_order_relaxed);
+    snapshot.frames_rendered =
+        frames_rendered_.load(std::memory_order_relaxed);
+    snapshot.frames_dropped = queue_dropped;
+    snapshot.frames_late = queue_late;
+    snapshot.qos_dropped = qos_dropped_.load(std::memory_order_relaxed);
+    snapshot.latency_us = latency_us_.load(std::memory_order_relaxed);
+    snapshot.queue = queue_.snapshot();
+    snapshot.upload = upload_.snapshot();
+    snapshot.present = present_.snapshot();
+    for (size_t i = 0; i < kJitterBucketCount; i++) {
+      snapshot.jitter[i] = jitter_[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+  }
+
+ private:
+  std::atomic<int64_t> first_frame_at_{};
+  std::atomic<uint64_t> frames_decoded_{};
+  std::atomic<uint64_t> frames_rendered_{};
+  std::atomic<uint64_t> qos_dropped_{};
+  std::atomic<uint64_t> latency_us_{};
+  std::atomic<int64_t> frame_duration_us_{};
+  // Set by the render thread, taken by the raster thread
+  std::atomic<int64_t> marked_at_{};
+  // Raster thread only
+  int64_t last_pull_at_{};
+
+  Timing queue_;
+  Timing upload_;
+  Timing present_;
+  std::array<std::atomic<uint64_t>, kJitterBucketCount> jitter_{};
+};
+
+}  // namespace video_player_linux
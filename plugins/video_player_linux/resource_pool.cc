@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "resource_pool.h"
+
+#include <plugins/common/common.h>
+
+namespace video_player_linux {
+
+ResourcePool::~ResourcePool() {
+  Clear();
+  SPDLOG_DEBUG(
+      "[VideoPlayer] pool shaders: {} hits, {} misses; pipelines: {} hits, "
+      "{} misses",
+      stats_.shader_hits, stats_.shader_misses, stats_.pipeline_hits,
+      stats_.pipeline_misses);
+}
+
+std::unique_ptr<nv12::Shader> ResourcePool::AcquireShader(GLsizei width,
+                                                          GLsizei height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!shaders_.empty()) {
+    auto it = shaders_.begin();
+    for (auto candidate = shaders_.begin(); candidate != shaders_.end();
+         ++candidate) {
+      if ((*candidate)->width == width && (*candidate)->height == height) {
+        it = candidate;
+        break;
+      }
+    }
+    auto shader = std::move(*it);
+    shaders_.erase(it);
+    stats_.shader_hits++;
+
+    // Left at its previous size: players acquire before the stream size is
+    // known and resize afterwards, which is free for same-size clips.
+    shader->clear();
+    return shader;
+  }
+
+  stats_.shader_misses++;
+  if (!programs_) {
+    programs_ = std::make_shared<nv12::Programs>();
+  }
+  return std::make_unique<nv12::Shader>(width, height, programs_);
+}
+
+void ResourcePool::ReleaseShader(std::unique_ptr<nv12::Shader> shader) {
+  if (!shader) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  shaders_.push_front(std::move(shader));
+  if (shaders_.size() > kMaxIdleShaders) {
+    shaders_.pop_back();
+  }
+}
+
+std::optional<ResourcePool::Pipeline> ResourcePool::AcquirePipeline(
+    const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = pipelines_.begin(); it != pipelines_.end(); ++it) {
+    if (it->key == key) {
+      Pipeline pipeline = *it;
+      pipelines_.erase(it);
+      stats_.pipeline_hits++;
+      return pipeline;
+    }
+  }
+  stats_.pipeline_misses++;
+  return std::nullopt;
+}
+
+void ResourcePool::ReleasePipeline(const Pipeline& pipeline) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pipelines_.push_front(pipeline);
+  if (pipelines_.size() > kMaxIdlePipelines) {
+    gst_object_unref(pipelines_.back().playbin);
+    pipelines_.pop_back();
+  }
+}
+
+void ResourcePool::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shaders_.clear();
+  programs_.reset();
+  for (auto& pipeline : pipelines_) {
+    gst_object_unref(pipeline.playbin);
+  }
+  pipelines_.clear();
+}
+
+ResourcePool::Stats ResourcePool::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace video_player_linux
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "nv12.h"
+
+extern "C" {
+#include <gst/gst.h>
+}
+
+namespace video_player_linux {
+
+/**
+ * GL and GStreamer objects recycled between players.
+ *
+ * All shaders share one set of compiled programs.  A disposed player hands
+ * back its shader (texture, framebuffer, buffers) and its playbin together
+ * with the video sink bin; the next player takes them instead of creating
+ * new ones, so only the URI and the handlers change.
+ */
+class ResourcePool {
+ public:
+  static constexpr size_t kMaxIdleShaders = 8;
+  static constexpr size_t kMaxIdlePipelines = 4;
+
+  // playbin and the elements of its video sink bin, in state NULL.
+  struct Pipeline {
+    GstElement* playbin;
+    GstElement* sink_bin;
+    GstElement* sink;
+    GstElement* decoder;
+    GstElement* video_convert;
+    GstElement* video_scale;
+    // Decoder and sink configuration the bin was built for
+    std::string key;
+  };
+
+  struct Stats {
+    uint64_t shader_hits;
+    uint64_t shader_misses;
+    uint64_t pipeline_hits;
+    uint64_t pipeline_misses;
+  };
+
+  ResourcePool() = default;
+
+  // The texture GL context must be current, idle shaders are freed.
+  ~ResourcePool();
+
+  // Prevent copying.
+  ResourcePool(ResourcePool const&) = delete;
+  ResourcePool& operator=(ResourcePool const&) = delete;
+
+  /**
+   * @brief Take an idle shader, preferring one of the same size, or create
+   * one.  A recycled shader keeps its size, call resize() as needed.  The
+   * texture GL context must be current.
+   * @param[in] width Texture width
+   * @param[in] height Texture height
+   * @return std::unique_ptr<nv12::Shader>
+   * @relation
+   * flutter
+   */
+  std::unique_ptr<nv12::Shader> AcquireShader(GLsizei width, GLsizei height);
+
+  /**
+   * @brief Return a shader for reuse.  The texture GL context must be current.
+   * @param[in] shader Shader no longer used by a player
+   * @return void
+   * @relation
+   * flutter
+   */
+  void ReleaseShader(std::unique_ptr<nv12::Shader> shader);
+
+  /**
+   * @brief Take an idle pipeline built for the same key
+   * @param[in] key Decoder and sink configuration
+   * @return std::optional<Pipeline>
+   * @retval std::nullopt No match, the caller builds a new pipeline
+   * @relation
+   * gstreamer
+   */
+  std::optional<Pipeline> AcquirePipeline(const std::string& key);
+
+  /**
+   * @brief Return a pipeline in state NULL with all handlers disconnected
+   * @param[in] pipeline Pipeline no longer used by a player
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void ReleasePipeline(const Pipeline& pipeline);
+
+  /**
+   * @brief Free idle shaders and pipelines.  The texture GL context must be
+   * current.
+   * @return void
+   * @relation
+   * flutter
+   */
+  void Clear();
+
+  Stats stats();
+
+ private:
+  std::mutex mutex_;
+  std::shared_ptr<const nv12::Programs> programs_;
+  // Most recently released first.
+  std::list<std::unique_ptr<nv12::Shader>> shaders_;
+  std::list<Pipeline> pipelines_;
+  Stats stats_{};
+};
+
+}  // namespace video_player_linux
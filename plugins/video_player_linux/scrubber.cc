@@ -0,0 +1,360 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scrubber.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <plugins/common/common.h>
+
+extern "C" {
+#include <gst/video/video.h>
+}
+
+namespace video_player_linux {
+
+Scrubber::Scrubber(std::string uri,
+                   std::map<std::string, std::string> http_headers,
+                   gint width,
+                   gint height)
+    : uri_(std::move(uri)),
+      http_headers_(std::move(http_headers)),
+      width_(width),
+      height_(height) {}
+
+Scrubber::~Scrubber() {
+  std::optional<PendingRequest> pending;
+  GstElement* playbin = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+    pending = std::move(pending_);
+    pending_.reset();
+    if (playbin_) {
+      playbin = GST_ELEMENT(gst_object_ref(playbin_));
+    }
+  }
+  cv_.notify_one();
+  // The thread may wait up to kPrerollTimeout for a preroll or seek, going
+  // to NULL aborts it.
+  if (playbin) {
+    gst_element_set_state(playbin, GST_STATE_NULL);
+    gst_object_unref(playbin);
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (pending) {
+    pending->callback(std::nullopt);
+  }
+  DestroyPipeline();
+
+  SPDLOG_DEBUG(
+      "[VideoPlayer] scrub requests: {}, cache hits: {}, superseded: {}, "
+      "seeks: {}, avg seek: {} ms, max seek: {} ms",
+      stats_.requests, stats_.cache_hits, stats_.superseded, stats_.seeks,
+      stats_.seeks ? GST_TIME_AS_MSECONDS(stats_.seek_time / stats_.seeks) : 0,
+      GST_TIME_AS_MSECONDS(stats_.max_seek_time));
+}
+
+void Scrubber::Request(GstClockTime position, Callback callback) {
+  std::optional<Thumbnail> cached;
+  std::optional<PendingRequest> superseded;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.requests++;
+    cached = Lookup(position);
+    if (cached) {
+      stats_.cache_hits++;
+    } else {
+      if (pending_) {
+        superseded = std::move(pending_);
+        stats_.superseded++;
+      }
+      pending_ = PendingRequest{position, std::move(callback)};
+      if (!thread_.joinable()) {
+        thread_ = std::thread(&Scrubber::Run, this);
+      }
+    }
+  }
+
+  if (cached) {
+    callback(cached);
+    return;
+  }
+  cv_.notify_one();
+  if (superseded) {
+    superseded->callback(std::nullopt);
+  }
+}
+
+Scrubber::Stats Scrubber::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void Scrubber::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return exit_ || pending_.has_value(); });
+    if (exit_) {
+      break;
+    }
+    PendingRequest request = std::move(*pending_);
+    pending_.reset();
+
+    // The previous decode may have filled in this position.
+    std::optional<Thumbnail> thumbnail = Lookup(request.position);
+    if (thumbnail) {
+      stats_.cache_hits++;
+    } else {
+      lock.unlock();
+      const gint64 start = g_get_monotonic_time();
+      thumbnail = Decode(request.position);
+      const GstClockTime elapsed =
+          static_cast<GstClockTime>(g_get_monotonic_time() - start) *
+          GST_USECOND;
+      lock.lock();
+
+      stats_.seeks++;
+      stats_.seek_time += elapsed;
+      stats_.max_seek_time = std::max(stats_.max_seek_time, elapsed);
+      if (thumbnail) {
+        Insert(request.position, *thumbnail);
+      }
+    }
+
+    lock.unlock();
+    request.callback(thumbnail);
+    lock.lock();
+  }
+}
+
+void Scrubber::OnSourceSetup(GstElement* /* playbin */,
+                             GstElement* source,
+                             gpointer user_data) {
+  auto obj = static_cast<Scrubber*>(user_data);
+  if (obj->http_headers_.empty() ||
+      !g_object_class_find_property(G_OBJECT_GET_CLASS(source),
+                                    "extra-headers")) {
+    return;
+  }
+  GstStructure* headers = gst_structure_new_empty("extra-headers");
+  for (const auto& [key, value] : obj->http_headers_) {
+    gst_structure_set(headers, key.c_str(), G_TYPE_STRING, value.c_str(),
+                      nullptr);
+  }
+  g_object_set(source, "extra-headers", headers, nullptr);
+  gst_structure_free(headers);
+}
+
+bool Scrubber::EnsurePipeline() {
+  if (playbin_) {
+    return true;
+  }
+  if (pipeline_failed_) {
+    return false;
+  }
+
+  GstElement* playbin = gst_element_factory_make("playbin", "scrubber");
+  GstElement* convert = gst_element_factory_make("videoconvert", nullptr);
+  GstElement* scale = gst_element_factory_make("videoscale", nullptr);
+  GstElement* sink = gst_element_factory_make("fakesink", nullptr);
+  if (!playbin || !convert || !scale || !sink) {
+    spdlog::error("[VideoPlayer] Failed to create scrubber pipeline");
+    for (GstElement* element : {playbin, convert, scale, sink}) {
+      if (element) {
+        gst_object_unref(gst_object_ref_sink(element));
+      }
+    }
+    pipeline_failed_ = true;
+    return false;
+  }
+
+  // No clock sync, the sink only holds on to the prerolled frame.
+  g_object_set(sink, "sync", FALSE, "enable-last-sample", TRUE, nullptr);
+
+  GstElement* bin = gst_bin_new(nullptr);
+  gst_bin_add_many(GST_BIN(bin), convert, scale, sink, nullptr);
+  gst_element_link(convert, scale);
+  GstCaps* caps = gst_caps_new_simple(
+      "video/x-raw", "format", G_TYPE_STRING, "RGBA", "width", G_TYPE_INT,
+      width_, "height", G_TYPE_INT, height_, "pixel-aspect-ratio",
+      GST_TYPE_FRACTION, 1, 1, nullptr);
+  if (!gst_element_link_filtered(scale, sink, caps)) {
+    SPDLOG_ERROR("[VideoPlayer] Failed to link scrubber videoscale");
+  }
+  gst_caps_unref(caps);
+  GstPad* pad = gst_element_get_static_pad(convert, "sink");
+  gst_element_add_pad(bin, gst_ghost_pad_new("sink", pad));
+  gst_object_unref(pad);
+
+  // Video only: no audio decoding or audio sink for previews.
+  g_object_set(playbin, "uri", uri_.c_str(), "video-sink", bin, "flags",
+               GST_PLAY_FLAG_VIDEO, nullptr);
+  g_signal_connect(playbin, "source-setup", G_CALLBACK(OnSourceSetup), this);
+
+  {
+    // Started with the lock held, so that the destructor either sees the
+    // pipeline and stops it, or the pipeline is never started.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (exit_) {
+      gst_object_unref(gst_object_ref_sink(playbin));
+      return false;
+    }
+    playbin_ = playbin;
+    sink_ = sink;
+    bus_ = gst_element_get_bus(playbin_);
+    gst_element_set_state(playbin_, GST_STATE_PAUSED);
+  }
+  if (gst_element_get_state(playbin_, nullptr, nullptr, kPrerollTimeout) !=
+      GST_STATE_CHANGE_SUCCESS) {
+    spdlog::error("[VideoPlayer] Scrubber failed to preroll: {}", uri_);
+    DestroyPipeline();
+    pipeline_failed_ = true;
+    return false;
+  }
+  return true;
+}
+
+void Scrubber::DestroyPipeline() {
+  GstElement* playbin;
+  GstBus* bus;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    playbin = std::exchange(playbin_, nullptr);
+    bus = std::exchange(bus_, nullptr);
+    sink_ = nullptr;
+  }
+  if (!playbin) {
+    return;
+  }
+  gst_element_set_state(playbin, GST_STATE_NULL);
+  gst_object_unref(bus);
+  gst_object_unref(playbin);
+}
+
+std::optional<Thumbnail> Scrubber::Decode(GstClockTime position) {
+  if (!EnsurePipeline()) {
+    return std::nullopt;
+  }
+
+  // KEY_UNIT | SNAP_BEFORE prerolls on the keyframe itself, nothing between
+  // the keyframe and the position is decoded.
+  if (!gst_element_seek_simple(
+          playbin_, GST_FORMAT_TIME,
+          static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH |
+                                    GST_SEEK_FLAG_KEY_UNIT |
+                                    GST_SEEK_FLAG_SNAP_BEFORE),
+          static_cast<gint64>(position))) {
+    SPDLOG_ERROR("[VideoPlayer] Scrub seek failed");
+    return std::nullopt;
+  }
+  const GstStateChangeReturn ret =
+      gst_element_get_state(playbin_, nullptr, nullptr, kPrerollTimeout);
+
+  // Nothing watches this bus, drain it here.
+  while (GstMessage* msg = gst_bus_pop(bus_)) {
+    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+      GError* err;
+      gst_message_parse_error(msg, &err, nullptr);
+      spdlog::error("[VideoPlayer] Scrubber error: {}:{}",
+                    GST_OBJECT_NAME(msg->src), err->message);
+      g_clear_error(&err);
+      pipeline_failed_ = true;
+    }
+    gst_message_unref(msg);
+  }
+  if (pipeline_failed_) {
+    DestroyPipeline();
+    return std::nullopt;
+  }
+  if (ret != GST_STATE_CHANGE_SUCCESS) {
+    return std::nullopt;
+  }
+
+  GstSample* sample = nullptr;
+  g_object_get(sink_, "last-sample", &sample, nullptr);
+  if (!sample) {
+    return std::nullopt;
+  }
+
+  std::optional<Thumbnail> thumbnail;
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  if (buffer && gst_video_info_from_caps(&info, gst_sample_get_caps(sample)) &&
+      gst_video_frame_map(&frame, &info, buffer, GST_MAP_READ)) {
+    thumbnail = Thumbnail{};
+    thumbnail->width = GST_VIDEO_FRAME_WIDTH(&frame);
+    thumbnail->height = GST_VIDEO_FRAME_HEIGHT(&frame);
+    thumbnail->timestamp = gst_segment_to_stream_time(
+        gst_sample_get_segment(sample), GST_FORMAT_TIME,
+        GST_BUFFER_PTS(buffer));
+    if (!GST_CLOCK_TIME_IS_VALID(thumbnail->timestamp)) {
+      thumbnail->timestamp = position;
+    }
+
+    // Tightly packed rows for Dart.
+    const size_t row = static_cast<size_t>(thumbnail->width) * 4;
+    thumbnail->pixels.resize(row * thumbnail->height);
+    const auto src =
+        static_cast<const uint8_t*>(GST_VIDEO_FRAME_PLANE_DATA(&frame, 0));
+    const gint stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0);
+    for (gint y = 0; y < thumbnail->height; y++) {
+      memcpy(&thumbnail->pixels[row * y], src + stride * y, row);
+    }
+    gst_video_frame_unmap(&frame);
+  }
+  gst_sample_unref(sample);
+  return thumbnail;
+}
+
+std::optional<Thumbnail> Scrubber::Lookup(GstClockTime position) {
+  auto it = cache_.upper_bound(position);
+  if (it == cache_.begin()) {
+    return std::nullopt;
+  }
+  --it;
+  if (position > it->second.covered_end) {
+    return std::nullopt;
+  }
+  lru_.remove(it->first);
+  lru_.push_front(it->first);
+  return it->second.thumbnail;
+}
+
+void Scrubber::Insert(GstClockTime position, const Thumbnail& thumbnail) {
+  // There is no keyframe between the one the seek snapped to and the
+  // requested position, so that whole range maps to this frame.
+  const GstClockTime keyframe = std::min(thumbnail.timestamp, position);
+  auto [it, inserted] =
+      cache_.try_emplace(keyframe, CacheEntry{thumbnail, position});
+  if (!inserted) {
+    it->second.covered_end = std::max(it->second.covered_end, position);
+  }
+  lru_.remove(keyframe);
+  lru_.push_front(keyframe);
+
+  while (cache_.size() > kMaxCachedFrames) {
+    cache_.erase(lru_.back());
+    lru_.pop_back();
+  }
+}
+
+}  // namespace video_player_linux
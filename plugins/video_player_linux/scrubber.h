@@ -0,0 +1,197 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <gst/gst.h>
+}
+
+namespace video_player_linux {
+
+// playbin "flags", GstPlayFlags is not in a public header.
+typedef enum {
+  GST_PLAY_FLAG_VIDEO = (1 << 0),
+  GST_PLAY_FLAG_AUDIO = (1 << 1),
+  GST_PLAY_FLAG_TEXT = (1 << 2),
+  GST_PLAY_FLAG_DOWNLOAD = (1 << 7)
+} GstPlayFlags;
+
+// Low resolution RGBA frame of a keyframe.
+struct Thumbnail {
+  gint width{};
+  gint height{};
+  // Timestamp of the keyframe in nanoseconds
+  GstClockTime timestamp{};
+  std::vector<uint8_t> pixels;
+};
+
+/**
+ * Preview frames for a timeline bar, decoded by a second playbin.
+ *
+ * The pipeline only has a video stream, scales to a small RGBA frame and is
+ * kept PAUSED on its own thread, so scrubbing never seeks or blocks the
+ * playback pipeline.  Seeks snap to the keyframe before the requested
+ * position.  Each decoded keyframe is cached together with the range of
+ * positions known to snap to it, which grows with every seek that lands on
+ * it; requests inside a known range are answered without decoding.  While a
+ * seek is running only the newest request is kept, older ones complete with
+ * std::nullopt.
+ */
+class Scrubber {
+ public:
+  using Callback =
+      std::function<void(const std::optional<Thumbnail>& thumbnail)>;
+
+  static constexpr size_t kMaxCachedFrames = 64;
+  static constexpr GstClockTime kPrerollTimeout = 5 * GST_SECOND;
+
+  struct Stats {
+    uint64_t requests;
+    uint64_t cache_hits;
+    uint64_t superseded;
+    uint64_t seeks;
+    // Sum and maximum of seek to preroll latency
+    GstClockTime seek_time;
+    GstClockTime max_seek_time;
+  };
+
+  /**
+   * @brief Create a scrubber, the pipeline is built on first use
+   * @param[in] uri URI of the stream
+   * @param[in] http_headers Extra HTTP headers of network sources
+   * @param[in] width Preview width
+   * @param[in] height Preview height
+   * @relation
+   * gstreamer
+   */
+  Scrubber(std::string uri,
+           std::map<std::string, std::string> http_headers,
+           gint width,
+           gint height);
+  ~Scrubber();
+
+  // Prevent copying.
+  Scrubber(Scrubber const&) = delete;
+  Scrubber& operator=(Scrubber const&) = delete;
+
+  /**
+   * @brief Request the preview frame for a position
+   * @param[in] position Position in nanoseconds
+   * @param[in] callback Invoked on the scrubber thread, or inline on a cache
+   * hit
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void Request(GstClockTime position, Callback callback);
+
+  gint width() const { return width_; }
+
+  Stats stats();
+
+ private:
+  struct PendingRequest {
+    GstClockTime position;
+    Callback callback;
+  };
+
+  struct CacheEntry {
+    Thumbnail thumbnail;
+    // Last position known to snap to this keyframe
+    GstClockTime covered_end;
+  };
+
+  std::string uri_;
+  std::map<std::string, std::string> http_headers_;
+  gint width_;
+  gint height_;
+
+  // Set by the scrubber thread with mutex_ held, so that the destructor can
+  // stop a preroll in progress.
+  GstElement* playbin_{};
+  GstElement* sink_{};
+  GstBus* bus_{};
+  bool pipeline_failed_ = false;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::optional<PendingRequest> pending_;
+  bool exit_ = false;
+  std::thread thread_;
+
+  // Keyframe timestamp -> preview, guarded by mutex_
+  std::map<GstClockTime, CacheEntry> cache_;
+  // Keyframe timestamps, most recently used first
+  std::list<GstClockTime> lru_;
+  Stats stats_{};
+
+  void Run();
+
+  bool EnsurePipeline();
+
+  void DestroyPipeline();
+
+  static void OnSourceSetup(GstElement* playbin,
+                            GstElement* source,
+                            gpointer user_data);
+
+  /**
+   * @brief Seek to the keyframe before a position and copy the prerolled
+   * frame
+   * @param[in] position Position in nanoseconds
+   * @return std::optional<Thumbnail>
+   * @retval std::nullopt Seek or preroll failed
+   * @relation
+   * gstreamer
+   */
+  std::optional<Thumbnail> Decode(GstClockTime position);
+
+  /**
+   * @brief Find a cached keyframe whose known range contains a position.
+   * mutex_ must be held.
+   * @param[in] position Position in nanoseconds
+   * @return std::optional<Thumbnail>
+   * @relation
+   * gstreamer
+   */
+  std::optional<Thumbnail> Lookup(GstClockTime position);
+
+  /**
+   * @brief Cache a keyframe that a seek to a position snapped to.  mutex_
+   * must be held.
+   * @param[in] position Requested position in nanoseconds
+   * @param[in] thumbnail Decoded keyframe
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void Insert(GstClockTime position, const Thumbnail& thumbnail);
+};
+
+}  // namespace video_player_linux
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "decoder_registry.h"
+#include "plugins/common/testing/testing.h"
+
+using video_player_linux::DecoderRegistry;
+
+namespace {
+
+// Decoders of a caps type no real decoder accepts, registered as static
+// elements.
+constexpr char kCaps[] = "video/x-decoder-registry-test";
+
+struct TestDecoder {
+  const char* name;
+  const char* klass;
+  guint rank;
+  // The element fails to go to READY, like a hardware decoder without its
+  // device.
+  bool fails;
+  // Elements created, by Validate
+  int created;
+};
+
+TestDecoder decoders[] = {
+    // Preferred by name, but unusable
+    {"vadecoderregistrytest", "Codec/Decoder/Video/Hardware", GST_RANK_MARGINAL,
+     true, 0},
+    // Hardware ranks above software whatever the rank
+    {"hwdecoderregistrytest", "Codec/Decoder/Video/Hardware", GST_RANK_MARGINAL,
+     false, 0},
+    {"swdecoderregistrytest", "Codec/Decoder/Video", GST_RANK_PRIMARY, false,
+     0},
+    {"sw2decoderregistrytest", "Codec/Decoder/Video", GST_RANK_SECONDARY, false,
+     0},
+};
+
+std::map<GType, TestDecoder*> types;
+
+GstStateChangeReturn FailReady(GstElement* element, GstStateChange transition) {
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY) {
+    return GST_STATE_CHANGE_FAILURE;
+  }
+  auto parent = GST_ELEMENT_CLASS(g_type_class_peek(GST_TYPE_ELEMENT));
+  return parent->change_state(element, transition);
+}
+
+void ClassInit(gpointer g_class, gpointer class_data) {
+  auto decoder = static_cast<const TestDecoder*>(class_data);
+  auto element_class = GST_ELEMENT_CLASS(g_class);
+  gst_element_class_set_static_metadata(element_class, decoder->name,
+                                        decoder->klass, "Test decoder",
+                                        "test");
+  GstCaps* sink_caps = gst_caps_from_string(kCaps);
+  GstCaps* src_caps = gst_caps_from_string("video/x-raw");
+  gst_element_class_add_pad_template(
+      element_class,
+      gst_pad_template_new("sink", GST_PAD_SINK, GST_PAD_ALWAYS, sink_caps));
+  gst_element_class_add_pad_template(
+      element_class,
+      gst_pad_template_new("src", GST_PAD_SRC, GST_PAD_ALWAYS, src_caps));
+  gst_caps_unref(sink_caps);
+  gst_caps_unref(src_caps);
+  if (decoder->fails) {
+    element_class->change_state = FailReady;
+  }
+}
+
+void InstanceInit(GTypeInstance* /* instance */, gpointer g_class) {
+  types[G_TYPE_FROM_CLASS(g_class)]->created++;
+}
+
+void Register() {
+  for (auto& decoder : decoders) {
+    GTypeInfo info{};
+    info.class_size = sizeof(GstElementClass);
+    info.class_init = ClassInit;
+    info.class_data = &decoder;
+    info.instance_size = sizeof(GstElement);
+    info.instance_init = InstanceInit;
+    const std::string type_name = std::string("Test_") + decoder.name;
+    const GType type = g_type_register_static(
+        GST_TYPE_ELEMENT, type_name.c_str(), &info, static_cast<GTypeFlags>(0));
+    types[type] = &decoder;
+    gst_element_register(nullptr, decoder.name, decoder.rank, type);
+  }
+}
+
+std::string Name(GstElementFactory* factory) {
+  if (!factory) {
+    return "";
+  }
+  std::string name = GST_OBJECT_NAME(factory);
+  gst_object_unref(factory);
+  return name;
+}
+
+// Unusable decoders are skipped, failed ones fall back to the next best.
+void TestFallback() {
+  DecoderRegistry registry;
+
+  EXPECT(Name(registry.Select(kCaps)) == "hwdecoderregistrytest");
+  // Validated once
+  EXPECT(Name(registry.Select(kCaps)) == "hwdecoderregistrytest");
+  EXPECT(decoders[0].created == 1);
+  EXPECT(decoders[1].created == 1);
+  EXPECT(decoders[2].created == 0);
+
+  GstElementFactory* hardware = gst_element_factory_find(decoders[1].name);
+  registry.MarkFailed(hardware);
+  gst_object_unref(hardware);
+  EXPECT(Name(registry.Select(kCaps)) == "swdecoderregistrytest");
+
+  GstElementFactory* software = gst_element_factory_find(decoders[2].name);
+  registry.MarkFailed(software);
+  gst_object_unref(software);
+  EXPECT(Name(registry.Select(kCaps)) == "sw2decoderregistrytest");
+
+  GstElementFactory* last = gst_element_factory_find(decoders[3].name);
+  registry.MarkFailed(last);
+  gst_object_unref(last);
+  EXPECT(registry.Select(kCaps) == nullptr);
+  EXPECT(decoders[0].created == 1);
+}
+
+// Failures are kept per registry, caps without a decoder select nothing.
+void TestNoDecoder() {
+  DecoderRegistry registry;
+  EXPECT(Name(registry.Select(kCaps)) == "hwdecoderregistrytest");
+  EXPECT(registry.Select("video/x-decoder-registry-none") == nullptr);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+  Register();
+  TestFallback();
+  TestNoDecoder();
+  return plugin_common_testing::TestResult();
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "frame_queue.h"
+#include "plugins/common/testing/testing.h"
+
+using video_player_linux::FrameQueue;
+
+static guint RefCount(GstBuffer* buffer) {
+  return GST_MINI_OBJECT_REFCOUNT_VALUE(buffer);
+}
+
+// Pops hand the queue's reference to the caller, replaced frames are
+// dropped and released.
+static void TestMailbox() {
+  FrameQueue queue;
+  EXPECT(!queue.has_frame());
+  EXPECT(queue.pop().buffer == nullptr);
+
+  GstBuffer* a = gst_buffer_new();
+  GstBuffer* b = gst_buffer_new();
+  GstCaps* caps = gst_caps_new_empty_simple("video/x-raw");
+
+  queue.push(a, caps);
+  EXPECT(queue.has_frame());
+  EXPECT(RefCount(a) == 2);
+  auto frame = queue.pop();
+  EXPECT(frame.buffer == a);
+  EXPECT(frame.caps == caps);
+  EXPECT(frame.queued_at > 0);
+  EXPECT(!queue.has_frame());
+  EXPECT(queue.pop().buffer == nullptr);
+  FrameQueue::release(frame);
+  EXPECT(frame.buffer == nullptr);
+  EXPECT(RefCount(a) == 1);
+
+  // Replaced before it was popped
+  queue.push(a, nullptr);
+  queue.push(b, nullptr);
+  EXPECT(RefCount(a) == 2);
+  frame = queue.pop();
+  EXPECT(frame.buffer == b);
+  EXPECT(frame.caps == nullptr);
+  FrameQueue::release(frame);
+  queue.push(b, nullptr);
+  EXPECT(RefCount(a) == 1);
+
+  auto stats = queue.stats();
+  EXPECT(stats.queued == 4);
+  EXPECT(stats.dropped == 1);
+
+  queue.clear();
+  EXPECT(!queue.has_frame());
+  EXPECT(RefCount(a) == 1);
+  EXPECT(RefCount(b) == 1);
+
+  // Usable after clear
+  queue.push(a, nullptr);
+  frame = queue.pop();
+  EXPECT(frame.buffer == a);
+  FrameQueue::release(frame);
+
+  gst_buffer_unref(a);
+  gst_buffer_unref(b);
+  gst_caps_unref(caps);
+}
+
+// The consumer sees frames in order, each at most once, and every frame is
+// either popped or counted as dropped.
+static void TestThreads() {
+  constexpr guint64 kFrames = 100000;
+  std::vector<GstBuffer*> buffers;
+  for (guint64 i = 0; i < kFrames; i++) {
+    buffers.push_back(gst_buffer_new());
+    GST_BUFFER_OFFSET(buffers.back()) = i;
+  }
+
+  FrameQueue queue;
+  uint64_t popped = 0;
+  bool ordered = true;
+  std::thread producer([&] {
+    for (auto* buffer : buffers) {
+      queue.push(buffer, nullptr);
+    }
+  });
+  gint64 last = -1;
+  while (last + 1 < static_cast<gint64>(kFrames)) {
+    auto frame = queue.pop();
+    if (!frame.buffer) {
+      std::this_thread::yield();
+      continue;
+    }
+    const auto offset = static_cast<gint64>(GST_BUFFER_OFFSET(frame.buffer));
+    ordered = ordered && offset > last;
+    last = offset;
+    popped++;
+    FrameQueue::release(frame);
+  }
+  producer.join();
+
+  EXPECT(ordered);
+  const auto stats = queue.stats();
+  EXPECT(stats.queued == kFrames);
+  EXPECT(popped + stats.dropped == kFrames);
+  queue.clear();
+  for (auto* buffer : buffers) {
+    EXPECT(RefCount(buffer) == 1);
+    gst_buffer_unref(buffer);
+  }
+  printf("%" PRIu64 " of %" PRIu64 " frames popped\n", popped, kFrames);
+}
+
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+  TestMailbox();
+  TestThreads();
+  return plugin_common_testing::TestResult();
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "media_info_cache.h"
+#include "plugins/common/testing/testing.h"
+#include "test/test_clip.h"
+
+using video_player_linux::MediaInfo;
+using video_player_linux::MediaInfoCache;
+using video_player_linux_testing::FileUri;
+using video_player_linux_testing::WriteClip;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Clip {
+  fs::path path;
+  std::string uri;
+  // 0 when not known, for clips passed on the command line
+  gint width;
+  gint height;
+};
+
+// Probes on the default main context, as the plugin does, and waits for
+// the result.
+std::optional<MediaInfo> ProbeAndWait(MediaInfoCache& cache,
+                                      const std::string& uri,
+                                      int64_t request_id) {
+  bool done = false;
+  std::optional<MediaInfo> result;
+  cache.Probe(uri, request_id, [&](const std::optional<MediaInfo>& info) {
+    result = info;
+    done = true;
+  });
+  while (!done) {
+    g_main_context_iteration(nullptr, TRUE);
+  }
+  return result;
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Startup latency of each clip: the first create probes, the next ones
+// take the cached metadata.
+void TestStartup(const std::vector<Clip>& clips) {
+  MediaInfoCache cache;
+  double probe_total = 0;
+  double cached_total = 0;
+  int64_t request_id = 0;
+  for (const auto& clip : clips) {
+    auto start = std::chrono::steady_clock::now();
+    const auto probed = ProbeAndWait(cache, clip.uri, ++request_id);
+    const double probe_ms = ElapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    const auto cached = cache.Lookup(clip.uri);
+    const double cached_ms = ElapsedMs(start);
+
+    if (clip.width) {
+      EXPECT(probed && probed->width == clip.width &&
+             probed->height == clip.height && probed->duration > 0);
+      EXPECT(probed && cached && cached->width == clip.width &&
+             cached->duration == probed->duration);
+    }
+    if (!probed) {
+      printf("%s: no video\n", clip.uri.c_str());
+      continue;
+    }
+    probe_total += probe_ms;
+    cached_total += cached_ms;
+    printf("%s: %dx%d, probed in %.2f ms, cached in %.3f ms\n",
+           clip.uri.c_str(), probed->width, probed->height, probe_ms,
+           cached_ms);
+  }
+  printf("%zu clips: probed in %.2f ms, cached in %.3f ms\n", clips.size(),
+         probe_total, cached_total);
+}
+
+// A modified file is probed again.
+void TestModified(const Clip& clip) {
+  MediaInfoCache cache;
+  EXPECT(ProbeAndWait(cache, clip.uri, 1));
+  EXPECT(cache.Lookup(clip.uri));
+  fs::last_write_time(clip.path,
+                      fs::last_write_time(clip.path) + std::chrono::hours(1));
+  EXPECT(!cache.Lookup(clip.uri));
+}
+
+// A cancelled request is not answered, the result is still cached.
+void TestCancel(const Clip& a, const Clip& b) {
+  MediaInfoCache cache;
+  bool called = false;
+  cache.Probe(a.uri, 1, [&](const std::optional<MediaInfo>& /* info */) {
+    called = true;
+  });
+  cache.Cancel(1);
+  // Discovered in order, a is done once b is.
+  EXPECT(ProbeAndWait(cache, b.uri, 2));
+  EXPECT(!called);
+  EXPECT(cache.Lookup(a.uri));
+}
+
+// The least recently used entry goes beyond the capacity, failures are not
+// cached.
+void TestEvict(const std::vector<Clip>& clips, const fs::path& dir) {
+  MediaInfoCache cache(2);
+  for (const auto& clip : clips) {
+    EXPECT(ProbeAndWait(cache, clip.uri, 1));
+  }
+  EXPECT(!cache.Lookup(clips[0].uri));
+  EXPECT(cache.Lookup(clips[1].uri));
+  EXPECT(cache.Lookup(clips[2].uri));
+
+  const std::string missing = FileUri(dir / "missing.ogv");
+  EXPECT(!ProbeAndWait(cache, missing, 2));
+  EXPECT(!cache.Lookup(missing));
+  EXPECT(cache.Lookup(clips[1].uri));
+}
+
+}  // namespace
+
+// Without arguments, tests against generated clips.  Given a directory,
+// reports the startup latency of the clips in it.
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+
+  if (argc > 1) {
+    std::vector<Clip> clips;
+    for (const auto& file : fs::directory_iterator(argv[1])) {
+      if (file.is_regular_file()) {
+        const auto path = fs::absolute(file.path());
+        clips.push_back({path, FileUri(path), 0, 0});
+      }
+    }
+    std::sort(clips.begin(), clips.end(),
+              [](const Clip& a, const Clip& b) { return a.path < b.path; });
+    TestStartup(clips);
+    return plugin_common_testing::TestResult();
+  }
+
+  char temp[] = "/tmp/media_info_cache_test.XXXXXX";
+  if (!mkdtemp(temp)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  const fs::path dir(temp);
+  std::vector<Clip> clips;
+  const std::pair<gint, gint> sizes[] = {{320, 240}, {640, 360}, {176, 144}};
+  for (auto [width, height] : sizes) {
+    const auto path = dir / ("clip" + std::to_string(clips.size()) + ".ogv");
+    clips.push_back({path, FileUri(path), width, height});
+  }
+  for (const auto& clip : clips) {
+    if (!WriteClip(clip.path, clip.width, clip.height, 15)) {
+      std::error_code ec;
+      fs::remove_all(dir, ec);
+      printf("skipped: cannot encode test clips\n");
+      return plugin_common_testing::kSkipped;
+    }
+  }
+
+  TestStartup(clips);
+  TestModified(clips[0]);
+  TestCancel(clips[1], clips[2]);
+  TestEvict(clips, dir);
+
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+  return plugin_common_testing::TestResult();
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "frame_queue.h"
+#include "playback_stats.h"
+#include "plugins/common/testing/testing.h"
+
+using video_player_linux::FrameQueue;
+using video_player_linux::PlaybackStats;
+
+// Counters and timings as recorded by the sink and render callbacks,
+// negative durations ignored.
+static void TestCounters() {
+  PlaybackStats stats;
+  auto snapshot = stats.snapshot(0, 0);
+  EXPECT(snapshot.first_frame_at == 0);
+  EXPECT(snapshot.frames_decoded == 0);
+  EXPECT(snapshot.queue.count == 0 && snapshot.queue.average_us() == 0);
+
+  stats.frame_decoded();
+  const auto first_frame_at = stats.snapshot(0, 0).first_frame_at;
+  EXPECT(first_frame_at > 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  stats.frame_decoded();
+  stats.frame_decoded();
+
+  stats.frame_rendered(100, 200);
+  stats.frame_rendered(300, 50);
+  stats.frame_rendered(-1, 10);
+  stats.set_qos_dropped(7);
+  stats.set_latency(1500);
+
+  snapshot = stats.snapshot(5, 2);
+  EXPECT(snapshot.first_frame_at == first_frame_at);
+  EXPECT(snapshot.taken_at >= first_frame_at);
+  EXPECT(snapshot.frames_decoded == 3);
+  EXPECT(snapshot.frames_rendered == 3);
+  EXPECT(snapshot.frames_dropped == 5);
+  EXPECT(snapshot.frames_late == 2);
+  EXPECT(snapshot.qos_dropped == 7);
+  EXPECT(snapshot.latency_us == 1500);
+  EXPECT(snapshot.queue.count == 2);
+  EXPECT(snapshot.queue.sum_us == 400);
+  EXPECT(snapshot.queue.max_us == 300);
+  EXPECT(snapshot.queue.average_us() == 200);
+  EXPECT(snapshot.upload.count == 3);
+  EXPECT(snapshot.upload.sum_us == 260);
+  EXPECT(snapshot.upload.max_us == 200);
+}
+
+// A pull counts once per rendered frame; jitter needs a previous pull and a
+// frame duration.
+static void TestPresent() {
+  PlaybackStats stats;
+  stats.frame_pulled();
+  EXPECT(stats.snapshot(0, 0).present.count == 0);
+
+  stats.frame_rendered(0, 0);
+  stats.frame_pulled();
+  stats.frame_pulled();
+  auto snapshot = stats.snapshot(0, 0);
+  EXPECT(snapshot.present.count == 1);
+
+  stats.frame_rendered(0, 0);
+  stats.frame_pulled();
+  snapshot = stats.snapshot(0, 0);
+  EXPECT(snapshot.present.count == 2);
+  for (auto count : snapshot.jitter) {
+    EXPECT(count == 0);
+  }
+
+  // Pulled well within a 10 s frame, off by more than the last bound
+  stats.set_frame_duration(10 * 1000 * 1000);
+  stats.frame_rendered(0, 0);
+  stats.frame_pulled();
+  snapshot = stats.snapshot(0, 0);
+  EXPECT(snapshot.present.count == 3);
+  EXPECT(snapshot.jitter.back() == 1);
+  uint64_t total = 0;
+  for (auto count : snapshot.jitter) {
+    total += count;
+  }
+  EXPECT(total == 1);
+}
+
+// Frames replaced in the queue and drawn late reach the snapshot the way
+// the player takes it.
+static void TestQueue() {
+  PlaybackStats stats;
+  FrameQueue queue;
+  GstBuffer* buffer = gst_buffer_new();
+  for (int i = 0; i < 3; i++) {
+    stats.frame_decoded();
+    queue.push(buffer, nullptr);
+  }
+  auto frame = queue.pop();
+  EXPECT(frame.buffer == buffer);
+  queue.mark_late();
+  stats.frame_rendered(g_get_monotonic_time() - frame.queued_at, 0);
+  FrameQueue::release(frame);
+
+  const auto counts = queue.stats();
+  EXPECT(counts.queued == 3);
+  EXPECT(counts.dropped == 2);
+  EXPECT(counts.late == 1);
+  const auto snapshot = stats.snapshot(counts.dropped, counts.late);
+  EXPECT(snapshot.frames_decoded == 3);
+  EXPECT(snapshot.frames_rendered == 1);
+  EXPECT(snapshot.frames_dropped == 2);
+  EXPECT(snapshot.frames_late == 1);
+  EXPECT(snapshot.frames_decoded ==
+         snapshot.frames_rendered + snapshot.frames_dropped);
+
+  queue.clear();
+  gst_buffer_unref(buffer);
+}
+
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+  TestCounters();
+  TestPresent();
+  TestQueue();
+  return plugin_common_testing::TestResult();
+}
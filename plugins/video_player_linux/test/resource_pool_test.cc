@@ -0,0 +1,181 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "plugins/common/testing/testing.h"
+#include "resource_pool.h"
+#include "test/test_clip.h"
+
+using video_player_linux::ResourcePool;
+using video_player_linux_testing::FileUri;
+using video_player_linux_testing::WriteClip;
+
+namespace {
+
+constexpr unsigned kPlayers = 100;
+constexpr char kKey[] = "theoradec|upload|file";
+
+// playbin with a sink bin like the one VideoPlayer builds for the key.
+ResourcePool::Pipeline Build() {
+  ResourcePool::Pipeline pipeline{};
+  pipeline.playbin = gst_element_factory_make("playbin", nullptr);
+  pipeline.sink_bin = gst_parse_bin_from_description(
+      "theoradec name=decoder ! videoconvert name=convert ! "
+      "videoscale name=scale ! fakesink name=sink sync=true qos=true",
+      TRUE, nullptr);
+  if (!pipeline.playbin || !pipeline.sink_bin) {
+    return pipeline;
+  }
+  auto bin = GST_BIN(pipeline.sink_bin);
+  pipeline.decoder = gst_bin_get_by_name(bin, "decoder");
+  pipeline.video_convert = gst_bin_get_by_name(bin, "convert");
+  pipeline.video_scale = gst_bin_get_by_name(bin, "scale");
+  pipeline.sink = gst_bin_get_by_name(bin, "sink");
+  // The bin keeps them alive, like the player's pointers.
+  for (GstElement* element : {pipeline.decoder, pipeline.video_convert,
+                              pipeline.video_scale, pipeline.sink}) {
+    gst_object_unref(element);
+  }
+  g_object_set(pipeline.playbin, "video-sink", pipeline.sink_bin, nullptr);
+  pipeline.key = kKey;
+  return pipeline;
+}
+
+void Finalized(gpointer data, GObject* /* object */) {
+  (*static_cast<size_t*>(data))++;
+}
+
+// Idle pipelines are matched by key and capped, the pool unrefs the rest.
+void TestIdle() {
+  size_t finalized = 0;
+  {
+    ResourcePool pool;
+    EXPECT(!pool.AcquirePipeline(kKey));
+
+    std::vector<ResourcePool::Pipeline> pipelines;
+    for (size_t i = 0; i < ResourcePool::kMaxIdlePipelines + 2; i++) {
+      pipelines.push_back(Build());
+      g_object_weak_ref(G_OBJECT(pipelines.back().playbin), Finalized,
+                        &finalized);
+    }
+    for (const auto& pipeline : pipelines) {
+      pool.ReleasePipeline(pipeline);
+    }
+    EXPECT(finalized == 2);
+
+    EXPECT(!pool.AcquirePipeline("theoradec|dmabuf|file"));
+    // Most recently released first
+    auto pipeline = pool.AcquirePipeline(kKey);
+    EXPECT(pipeline && pipeline->playbin == pipelines.back().playbin);
+    pool.ReleasePipeline(*pipeline);
+
+    const auto stats = pool.stats();
+    EXPECT(stats.pipeline_hits == 1);
+    EXPECT(stats.pipeline_misses == 2);
+  }
+  EXPECT(finalized == ResourcePool::kMaxIdlePipelines + 2);
+}
+
+// A player's pipeline from creation to the first frame, then disposed.
+// Without a pool it is built and destroyed each time.
+double CreateAndDispose(ResourcePool* pool, const std::string& uri) {
+  const auto start = std::chrono::steady_clock::now();
+  std::optional<ResourcePool::Pipeline> pipeline;
+  if (pool) {
+    pipeline = pool->AcquirePipeline(kKey);
+  }
+  if (!pipeline) {
+    pipeline = Build();
+  }
+  g_object_set(pipeline->playbin, "uri", uri.c_str(), nullptr);
+  gst_element_set_state(pipeline->playbin, GST_STATE_PAUSED);
+  const auto ret = gst_element_get_state(pipeline->playbin, nullptr, nullptr,
+                                         GST_CLOCK_TIME_NONE);
+  EXPECT(ret == GST_STATE_CHANGE_SUCCESS);
+  const double elapsed = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  gst_element_set_state(pipeline->playbin, GST_STATE_NULL);
+  if (pool) {
+    pool->ReleasePipeline(*pipeline);
+  } else {
+    gst_object_unref(pipeline->playbin);
+  }
+  return elapsed;
+}
+
+// Creates and disposes kPlayers players with and without the pool.  The
+// n-th pooled player costs a URI swap and a preroll.
+void Benchmark(const std::string& uri) {
+  for (bool pooled : {false, true}) {
+    ResourcePool pool;
+    double first = 0;
+    double total = 0;
+    for (unsigned i = 0; i < kPlayers; i++) {
+      const double elapsed = CreateAndDispose(pooled ? &pool : nullptr, uri);
+      if (i == 0) {
+        first = elapsed;
+      }
+      total += elapsed;
+    }
+    printf("%s: first player %.2f ms, average of %u %.2f ms\n",
+           pooled ? "pooled" : "unpooled", first, kPlayers, total / kPlayers);
+    if (pooled) {
+      const auto stats = pool.stats();
+      EXPECT(stats.pipeline_hits == kPlayers - 1);
+      EXPECT(stats.pipeline_misses == 1);
+    }
+  }
+}
+
+}  // namespace
+
+// Shaders need the texture GL context and are left to the players.
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+  GstElementFactory* decoder = gst_element_factory_find("theoradec");
+  if (!decoder) {
+    printf("skipped: no theoradec\n");
+    return plugin_common_testing::kSkipped;
+  }
+  gst_object_unref(decoder);
+
+  TestIdle();
+
+  char path[] = "/tmp/resource_pool_test.XXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+  if (WriteClip(path, 320, 240, 2)) {
+    Benchmark(FileUri(path));
+  } else {
+    printf("benchmark skipped: cannot encode the test clip\n");
+  }
+  unlink(path);
+  return plugin_common_testing::TestResult();
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+extern "C" {
+#include <gst/gst.h>
+}
+
+namespace video_player_linux_testing {
+
+/**
+ * @brief Encode frames of the test pattern to an Ogg Theora file
+ * @param[in] path File to write
+ * @param[in] width Frame width
+ * @param[in] height Frame height
+ * @param[in] frames Frames at 30 fps
+ * @return bool
+ * @retval false The encoders are not available or encoding failed
+ * @relation
+ * gstreamer
+ */
+inline bool WriteClip(const std::string& path,
+                      int width,
+                      int height,
+                      int frames) {
+  gchar* description = g_strdup_printf(
+      "videotestsrc num-buffers=%d ! "
+      "video/x-raw,width=%d,height=%d,framerate=30/1 ! theoraenc ! oggmux ! "
+      "filesink location=\"%s\"",
+      frames, width, height, path.c_str());
+  GError* error = nullptr;
+  GstElement* pipeline = gst_parse_launch(description, &error);
+  g_free(description);
+  if (error) {
+    fprintf(stderr, "%s\n", error->message);
+    g_clear_error(&error);
+    if (pipeline) {
+      gst_object_unref(pipeline);
+    }
+    return false;
+  }
+
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  GstBus* bus = gst_element_get_bus(pipeline);
+  GstMessage* msg = gst_bus_timed_pop_filtered(
+      bus, GST_CLOCK_TIME_NONE,
+      static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  const bool written = GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+  gst_message_unref(msg);
+  gst_object_unref(bus);
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(pipeline);
+  return written;
+}
+
+// file:// URI of a local path, empty if it is not absolute.
+inline std::string FileUri(const std::string& path) {
+  gchar* uri = g_filename_to_uri(path.c_str(), nullptr, nullptr);
+  std::string result = uri ? uri : "";
+  g_free(uri);
+  return result;
+}
+
+}  // namespace video_player_linux_testing
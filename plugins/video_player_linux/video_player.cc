@@ -24,45 +24,53 @@
 
 #include <backend/backend.h>
 #include <plugins/common/common.h>
+#include <algorithm>
+#include <cmath>
 #include <utility>
 
 #define GSTREAMER_DEBUG 0
 
 namespace video_player_linux {
 
-typedef enum {
-  GST_PLAY_FLAG_AUDIO = (1 << 0),
-  GST_PLAY_FLAG_VIDEO = (1 << 1),
-  GST_PLAY_FLAG_TEXT = (1 << 2)
-} GstPlayFlags;
-
 VideoPlayer::VideoPlayer(flutter::PluginRegistrarDesktop* registrar,
                          const std::string& uri,
                          std::map<std::string, std::string> http_headers,
-                         GLsizei width,
-                         GLsizei height,
-                         gint64 duration,
-                         GstElementFactory* decoder_factory)
+                         DecoderRegistry* decoder_registry,
+                         ResourcePool* resource_pool,
+                         const BufferingOptions& buffering_options)
     : m_registrar(registrar),
       uri_(uri),
       http_headers_(std::move(http_headers)),
-      width_(width),
-      height_(height),
-      duration_(duration),
-      decoder_factory_(decoder_factory),
+      decoder_registry_(decoder_registry),
+      resource_pool_(resource_pool),
+      buffering_options_(buffering_options),
+      is_network_(!gst_uri_has_protocol(uri.c_str(), "file")),
+      width_(1),
+      height_(1),
       event_channel_(nullptr),
       media_state_(GST_STATE_VOID_PENDING) {
-  SPDLOG_DEBUG(
-      "[VideoPlayer] uri: {}, http_headers: {}, size: {} x {}, duration: {}",
-      uri.c_str(), http_headers_.size(), width, height, duration);
+  SPDLOG_DEBUG("[VideoPlayer] uri: {}, http_headers: {}", uri.c_str(),
+               http_headers_.size());
 
   std::lock_guard<std::mutex> buffer_lock(buffer_mutex_);
 
   /// Setup OpenGL
 
   m_registrar->texture_registrar()->TextureMakeCurrent();
-  shader_ = std::make_unique<nv12::Shader>(width_, height_);
+  shader_ = resource_pool_->AcquireShader(width_, height_);
   m_texture_id = shader_->textureId;
+#if defined(ENABLE_DMABUF)
+  dmabuf_importer_ = dmabuf::Importer::Create();
+  if (dmabuf_importer_) {
+    sink_mode_ = SinkMode::kDmaBuf;
+  }
+#endif
+#if defined(ENABLE_NATIVE_SIZE)
+  scale_mode_ = ScaleMode::kNative;
+#endif
+  SPDLOG_DEBUG("[VideoPlayer] sink mode: {}, scale: {}",
+               sink_mode_ == SinkMode::kDmaBuf ? "dmabuf" : "upload",
+               scale_mode_ == ScaleMode::kNative ? "gpu" : "videoscale");
 
   /// Setup GL Texture 2D
 
@@ -80,48 +88,90 @@ VideoPlayer::VideoPlayer(flutter::PluginRegistrarDesktop* registrar,
       FlutterDesktopGpuSurfaceType::kFlutterDesktopGpuSurfaceTypeGlTexture2D,
       [&](size_t /* width */,
           size_t /* height */) -> const FlutterDesktopGpuSurfaceDescriptor* {
+        stats_.frame_pulled();
+        {
+          std::lock_guard<std::mutex> lock(render_mutex_);
+          frame_pulled_ = true;
+        }
+        render_cv_.notify_one();
         return &m_descriptor;
       });
 
   flutter::TextureVariant texture = *gpu_surface_texture_;
   m_registrar->texture_registrar()->RegisterTexture(&texture);
 
-  /// Setup GST Pipeline
+  m_registrar->texture_registrar()->TextureClearCurrent();
 
   context_ = g_main_context_get_thread_default();
 
-  playbin_ = gst_element_factory_make("playbin", nullptr);
-  assert(playbin_);
-  g_object_set(playbin_, "uri", uri_.c_str(), nullptr);
+  render_thread_ = std::thread(&VideoPlayer::RenderLoop, this);
+}
 
-  if (!http_headers_.empty()) {
-    std::stringstream ss;
-    for (auto& [key, value] : http_headers_) {
-      ss << key << ":" << value << " ";
+void VideoPlayer::OnMediaInfo(const std::optional<MediaInfo>& info) {
+  GstElementFactory* decoder_factory = nullptr;
+  if (info.has_value()) {
+    decoder_factory = decoder_registry_->Select(info->video_caps);
+    if (decoder_factory == nullptr) {
+      spdlog::error(
+          "[VideoPlayer] Failed to find decoder: {}.  May be a missing "
+          "runtime package",
+          info->video_caps);
     }
-    SPDLOG_DEBUG("extra-headers: {}", ss.str().c_str());
-    GstStructure* extraHeaders =
-        gst_structure_from_string((const gchar*)(ss.str().c_str()), nullptr);
-    if (extraHeaders != nullptr) {
-      g_object_set(playbin_, "extra-headers", extraHeaders, nullptr);
-      gst_structure_free(extraHeaders);
+  }
+  if (!info.has_value() || decoder_factory == nullptr) {
+    spdlog::error("[VideoPlayer] Unable to play: {}", uri_);
+    if (event_sink_) {
+      event_sink_->Error("media_info_failed", "Unable to probe media");
     }
+    return;
   }
 
-  gint flags = 0;
-  g_object_get(playbin_, "flags", &flags, nullptr);
-  flags |= GST_PLAY_FLAG_VIDEO | GST_PLAY_FLAG_AUDIO;
-  flags &= ~GST_PLAY_FLAG_TEXT;
-  g_object_set(playbin_, "flags", flags, nullptr);
-  g_object_set(playbin_, "connection-speed", 56, nullptr);
+  SPDLOG_DEBUG("[VideoPlayer] size: {} x {}, duration: {}, decoder: {}",
+               info->width, info->height, info->duration,
+               GST_OBJECT_NAME(decoder_factory));
+  {
+    std::lock_guard<std::mutex> lock(gst_mutex_);
+    video_caps_ = info->video_caps;
+    width_ = info->width;
+    height_ = info->height;
+    duration_ = info->duration;
+
+    m_registrar->texture_registrar()->TextureMakeCurrent();
+    shader_->resize(width_, height_);
+    m_registrar->texture_registrar()->TextureClearCurrent();
+
+    m_descriptor.width = static_cast<size_t>(width_);
+    m_descriptor.height = static_cast<size_t>(height_);
+    m_descriptor.visible_width = static_cast<size_t>(width_);
+    m_descriptor.visible_height = static_cast<size_t>(height_);
+  }
 
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
+  BuildPipeline(decoder_factory);
+  gst_object_unref(decoder_factory);
+
+  // Preroll so "initialized" is sent, or start if Play() came first.
+  gst_element_set_state(playbin_, target_state_);
+}
+
+std::string VideoPlayer::PipelineKey(GstElementFactory* decoder_factory) const {
+  std::string key = GST_OBJECT_NAME(decoder_factory);
+  key += sink_mode_ == SinkMode::kDmaBuf ? "|dmabuf" : "|upload";
+  if (scale_mode_ == ScaleMode::kVideoScale) {
+    key += "|" + std::to_string(width_) + "x" + std::to_string(height_);
+  }
+  key += is_network_ ? "|network" : "|file";
+  return key;
+}
+
+void VideoPlayer::BuildSinkBin(GstElementFactory* decoder_factory) {
   sink_ = gst_element_factory_make("fakesink", nullptr);
   assert(sink_);
   g_object_set(sink_, "sync", TRUE, nullptr);
   g_object_set(sink_, "signal-handoffs", TRUE, nullptr);
   g_object_set(sink_, "can-activate-pull", TRUE, nullptr);
-  handoff_handler_id_ = g_signal_connect(
-      sink_, "handoff", reinterpret_cast<GCallback>(handoff_handler), this);
+  // Late frames are dropped and reported in QoS messages.
+  g_object_set(sink_, "qos", TRUE, nullptr);
 
   decoder_ = gst_element_factory_create(decoder_factory, "decoder");
   assert(decoder_);
@@ -129,25 +179,49 @@ VideoPlayer::VideoPlayer(flutter::PluginRegistrarDesktop* registrar,
   video_convert_ = gst_element_factory_make("videoconvert", nullptr);
   assert(video_convert_);
 
-  GstCaps* caps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING,
+  // Native mode takes the decoder output as is when the shader can sample it,
+  // anything else is converted to NV12 without scaling.
+  GstCaps* caps = scale_mode_ == ScaleMode::kNative
+                      ? gst_caps_from_string(
+                            "video/x-raw, format=(string){ NV12, I420 }")
+                      : gst_caps_new_simple("video/x-raw", "format",
+                                            G_TYPE_STRING, "NV12", nullptr);
+#if defined(ENABLE_DMABUF)
+  // Prefer dmabuf NV12 at the decoded size; videoconvert and videoscale pass
+  // it through untouched.
+  GstCaps* dmabuf_caps = nullptr;
+  if (sink_mode_ == SinkMode::kDmaBuf) {
+    dmabuf_caps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING,
                                       "NV12", nullptr);
-
-  video_scale_ = gst_element_factory_make("videoscale", nullptr);
-  assert(video_scale_);
-
-  GstCaps* scale =
-      gst_caps_new_simple("video/x-raw", "width", G_TYPE_INT, width_, "height",
-                          G_TYPE_INT, height_, nullptr);
+    gst_caps_set_features(
+        dmabuf_caps, 0,
+        gst_caps_features_new(GST_CAPS_FEATURE_MEMORY_DMABUF, nullptr));
+    caps = gst_caps_merge(gst_caps_ref(dmabuf_caps), caps);
+  }
+#endif
 
   pipeline_ = gst_bin_new(nullptr);
 
-  gst_bin_add_many(reinterpret_cast<GstBin*>(pipeline_), decoder_,
-                   video_convert_, video_scale_, sink_, nullptr);
+  if (scale_mode_ == ScaleMode::kNative) {
+    gst_bin_add_many(reinterpret_cast<GstBin*>(pipeline_), decoder_,
+                     video_convert_, sink_, nullptr);
+  } else {
+    video_scale_ = gst_element_factory_make("videoscale", nullptr);
+    assert(video_scale_);
+    gst_bin_add_many(reinterpret_cast<GstBin*>(pipeline_), decoder_,
+                     video_convert_, video_scale_, sink_, nullptr);
+  }
   if (!gst_element_link(decoder_, video_convert_)) {
     SPDLOG_ERROR("[VideoPlayer] Failed to link decoder with videoconvert");
   }
 
-  if (!gst_element_link_filtered(video_convert_, video_scale_, caps)) {
+  if (scale_mode_ == ScaleMode::kNative) {
+    if (!gst_element_link_filtered(video_convert_, sink_, caps)) {
+      SPDLOG_ERROR(
+          "[VideoPlayer] Failed to link videoconvert with fakesink using "
+          "filter");
+    }
+  } else if (!gst_element_link_filtered(video_convert_, video_scale_, caps)) {
     SPDLOG_ERROR(
         "[VideoPlayer] Failed to link videoconvert with videoscale using "
         "filter");
@@ -165,25 +239,341 @@ VideoPlayer::VideoPlayer(flutter::PluginRegistrarDesktop* registrar,
   gst_element_add_pad(pipeline_, ghost_pad);
   gst_object_unref(pad);
 
-  if (!gst_element_link_filtered(video_scale_, sink_, scale)) {
-    SPDLOG_ERROR(
-        "[VideoPlayer] Failed to link videoscale with fakesink using filter");
+  if (scale_mode_ == ScaleMode::kVideoScale) {
+    GstCaps* scale =
+        gst_caps_new_simple("video/x-raw", "width", G_TYPE_INT, width_,
+                            "height", G_TYPE_INT, height_, nullptr);
+#if defined(ENABLE_DMABUF)
+    if (dmabuf_caps) {
+      scale = gst_caps_merge(gst_caps_ref(dmabuf_caps), scale);
+    }
+#endif
+    if (!gst_element_link_filtered(video_scale_, sink_, scale)) {
+      SPDLOG_ERROR(
+          "[VideoPlayer] Failed to link videoscale with fakesink using "
+          "filter");
+    }
+    gst_caps_unref(scale);
+  }
+#if defined(ENABLE_DMABUF)
+  if (dmabuf_caps) {
+    gst_caps_unref(dmabuf_caps);
+  }
+#endif
+}
+
+void VideoPlayer::BuildPipeline(GstElementFactory* decoder_factory) {
+  pipeline_error_ = false;
+  pipeline_key_ = PipelineKey(decoder_factory);
+  if (auto pooled = resource_pool_->AcquirePipeline(pipeline_key_)) {
+    SPDLOG_DEBUG("[VideoPlayer] reusing pipeline: {}", pipeline_key_);
+    playbin_ = pooled->playbin;
+    pipeline_ = pooled->sink_bin;
+    sink_ = pooled->sink;
+    decoder_ = pooled->decoder;
+    video_convert_ = pooled->video_convert;
+    video_scale_ = pooled->video_scale;
+  } else {
+    playbin_ = gst_element_factory_make("playbin", nullptr);
+    assert(playbin_);
+    BuildSinkBin(decoder_factory);
+    g_object_set(playbin_, "video-sink", pipeline_, nullptr);
   }
-  gst_caps_unref(scale);
 
-  g_object_set(playbin_, "video-sink", pipeline_, nullptr);
+  // Everything below is per player, a pooled playbin only gets a new URI.
+  g_object_set(playbin_, "uri", uri_.c_str(), nullptr);
+
+  GstStructure* extraHeaders = nullptr;
+  if (!http_headers_.empty()) {
+    std::stringstream ss;
+    for (auto& [key, value] : http_headers_) {
+      ss << key << ":" << value << " ";
+    }
+    SPDLOG_DEBUG("extra-headers: {}", ss.str().c_str());
+    extraHeaders =
+        gst_structure_from_string((const gchar*)(ss.str().c_str()), nullptr);
+  }
+  g_object_set(playbin_, "extra-headers", extraHeaders, nullptr);
+  if (extraHeaders != nullptr) {
+    gst_structure_free(extraHeaders);
+  }
+
+  gint flags = 0;
+  g_object_get(playbin_, "flags", &flags, nullptr);
+  flags |= GST_PLAY_FLAG_VIDEO | GST_PLAY_FLAG_AUDIO;
+  flags &= ~(GST_PLAY_FLAG_TEXT | GST_PLAY_FLAG_DOWNLOAD);
+  if (is_network_ && buffering_options_.download) {
+    flags |= GST_PLAY_FLAG_DOWNLOAD;
+  }
+  g_object_set(playbin_, "flags", flags, nullptr);
+
+  if (is_network_) {
+    // connection-speed is left at 0 so adaptive demuxers measure bandwidth.
+    g_object_set(playbin_, "ring-buffer-max-size",
+                 buffering_options_.ring_buffer_max_size, "buffer-size",
+                 buffering_options_.buffer_size, "buffer-duration",
+                 buffering_options_.buffer_duration, nullptr);
+    deep_element_added_id_ =
+        g_signal_connect(playbin_, "deep-element-added",
+                         G_CALLBACK(OnDeepElementAdded), this);
+  }
+
+  handoff_handler_id_ = g_signal_connect(
+      sink_, "handoff", reinterpret_cast<GCallback>(handoff_handler), this);
 
   bus_ = gst_element_get_bus(playbin_);
-  GSource* bus_source = gst_bus_create_watch(bus_);
+  bus_source_ = gst_bus_create_watch(bus_);
   g_source_set_callback(
-      bus_source, reinterpret_cast<GSourceFunc>(gst_bus_async_signal_func),
+      bus_source_, reinterpret_cast<GSourceFunc>(gst_bus_async_signal_func),
       nullptr, nullptr);
-  g_source_attach(bus_source, context_);
-  g_source_unref(bus_source);
+  g_source_attach(bus_source_, context_);
   on_bus_msg_id_ = g_signal_connect(
       bus_, "message", reinterpret_cast<GCallback>(OnBusMessage), this);
 
-  m_registrar->texture_registrar()->TextureClearCurrent();
+  if (is_network_ && buffering_options_.update_interval_ms > 0) {
+    buffering_timer_ =
+        g_timeout_source_new(buffering_options_.update_interval_ms);
+    AttachTimer(buffering_timer_, OnBufferingTimer);
+  }
+
+  pipeline_ready_ = true;
+}
+
+void VideoPlayer::OnDeepElementAdded(GstBin* /* bin */,
+                                     GstBin* /* sub_bin */,
+                                     GstElement* element,
+                                     gpointer user_data) {
+  auto obj = static_cast<VideoPlayer*>(user_data);
+  GObjectClass* klass = G_OBJECT_GET_CLASS(element);
+  // queue2 and multiqueue post the buffering messages.
+  if (g_object_class_find_property(klass, "low-watermark") &&
+      g_object_class_find_property(klass, "high-watermark")) {
+    g_object_set(element, "low-watermark",
+                 obj->buffering_options_.low_watermark, "high-watermark",
+                 obj->buffering_options_.high_watermark, nullptr);
+  }
+}
+
+void VideoPlayer::AttachTimer(GSource* source, GSourceFunc func) {
+  g_source_set_callback(
+      source, func, new TimerData{timer_mutex_, this},
+      [](gpointer data) { delete static_cast<TimerData*>(data); });
+  g_source_attach(source, context_);
+}
+
+gboolean VideoPlayer::OnStatsTimer(gpointer user_data) {
+  auto data = static_cast<TimerData*>(user_data);
+  std::lock_guard<std::mutex> lock(*data->mutex);
+  // Destroyed with the lock held, the player is alive until then.
+  if (g_source_is_destroyed(g_main_current_source())) {
+    return G_SOURCE_REMOVE;
+  }
+  auto obj = data->player;
+  if (!obj->event_sink_) {
+    return G_SOURCE_CONTINUE;
+  }
+  const auto queue = obj->frame_queue_.stats();
+  const auto stats = obj->stats_.snapshot(queue.dropped, queue.late);
+  auto event =
+      StatsToMap(stats, obj->last_stats_ ? &obj->last_stats_.value() : nullptr);
+  obj->last_stats_ = stats;
+  event.insert({flutter::EncodableValue("event"),
+                flutter::EncodableValue("stats")});
+  obj->event_sink_->Success(flutter::EncodableValue(event));
+  return G_SOURCE_CONTINUE;
+}
+
+void VideoPlayer::SetStatsInterval(guint interval_ms) {
+  // g_source_destroy does not wait for a tick already dispatched.
+  std::lock_guard<std::mutex> lock(*timer_mutex_);
+  if (stats_timer_) {
+    g_source_destroy(stats_timer_);
+    g_source_unref(stats_timer_);
+    stats_timer_ = nullptr;
+  }
+  last_stats_.reset();
+  if (interval_ms == 0) {
+    return;
+  }
+  stats_timer_ = g_timeout_source_new(interval_ms);
+  AttachTimer(stats_timer_, OnStatsTimer);
+}
+
+flutter::EncodableMap VideoPlayer::GetStats() {
+  const auto queue = frame_queue_.stats();
+  return StatsToMap(stats_.snapshot(queue.dropped, queue.late), nullptr);
+}
+
+flutter::EncodableMap VideoPlayer::StatsToMap(
+    const PlaybackStats::Snapshot& stats,
+    const PlaybackStats::Snapshot* previous) {
+  // Frames per second since the previous snapshot or the first frame.
+  const int64_t since = previous ? previous->taken_at : stats.first_frame_at;
+  const uint64_t frames =
+      stats.frames_decoded - (previous ? previous->frames_decoded : 0);
+  const double decode_fps =
+      since > 0 && stats.taken_at > since
+          ? static_cast<double>(frames) * G_USEC_PER_SEC /
+                static_cast<double>(stats.taken_at - since)
+          : 0.0;
+
+  auto timing = [](const PlaybackStats::Timing::Snapshot& timing) {
+    return flutter::EncodableValue(flutter::EncodableMap{
+        {flutter::EncodableValue("count"),
+         flutter::EncodableValue(static_cast<int64_t>(timing.count))},
+        {flutter::EncodableValue("averageUs"),
+         flutter::EncodableValue(static_cast<int64_t>(timing.average_us()))},
+        {flutter::EncodableValue("maxUs"),
+         flutter::EncodableValue(static_cast<int64_t>(timing.max_us))},
+    });
+  };
+
+  flutter::EncodableList buckets;
+  for (const auto bound : PlaybackStats::kJitterBucketsUs) {
+    buckets.emplace_back(static_cast<int64_t>(bound));
+  }
+  flutter::EncodableList jitter;
+  for (const auto count : stats.jitter) {
+    jitter.emplace_back(static_cast<int64_t>(count));
+  }
+
+  return flutter::EncodableMap{
+      {flutter::EncodableValue("decodedFrames"),
+       flutter::EncodableValue(static_cast<int64_t>(stats.frames_decoded))},
+      {flutter::EncodableValue("renderedFrames"),
+       flutter::EncodableValue(static_cast<int64_t>(stats.frames_rendered))},
+      {flutter::EncodableValue("droppedFrames"),
+       flutter::EncodableValue(static_cast<int64_t>(stats.frames_dropped))},
+      {flutter::EncodableValue("lateFrames"),
+       flutter::EncodableValue(static_cast<int64_t>(stats.frames_late))},
+      {flutter::EncodableValue("qosDroppedFrames"),
+       flutter::EncodableValue(static_cast<int64_t>(stats.qos_dropped))},
+      {flutter::EncodableValue("decodeFps"),
+       flutter::EncodableValue(decode_fps)},
+      {flutter::EncodableValue("latencyUs"),
+       flutter::EncodableValue(static_cast<int64_t>(stats.latency_us))},
+      {flutter::EncodableValue("queue"), timing(stats.queue)},
+      {flutter::EncodableValue("upload"), timing(stats.upload)},
+      {flutter::EncodableValue("present"), timing(stats.present)},
+      {flutter::EncodableValue("jitterBucketsUs"),
+       flutter::EncodableValue(buckets)},
+      {flutter::EncodableValue("jitter"), flutter::EncodableValue(jitter)},
+  };
+}
+
+void VideoPlayer::OnQos(GstMessage* msg) {
+  GstFormat format;
+  guint64 processed, dropped;
+  gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+  if (format != GST_FORMAT_BUFFERS && format != GST_FORMAT_DEFAULT) {
+    return;
+  }
+  if (dropped == static_cast<guint64>(-1)) {
+    return;
+  }
+
+  // Each element reports its own running total.
+  gchar* path = gst_object_get_path_string(GST_MESSAGE_SRC(msg));
+  qos_dropped_[path] = dropped;
+  g_free(path);
+  guint64 total = 0;
+  for (const auto& [element, count] : qos_dropped_) {
+    total += count;
+  }
+  stats_.set_qos_dropped(total);
+}
+
+gboolean VideoPlayer::OnBufferingTimer(gpointer user_data) {
+  auto data = static_cast<TimerData*>(user_data);
+  std::lock_guard<std::mutex> timer_lock(*data->mutex);
+  // Destroyed by Dispose with the lock held, the player is alive until then.
+  if (g_source_is_destroyed(g_main_current_source())) {
+    return G_SOURCE_REMOVE;
+  }
+  auto obj = data->player;
+  std::lock_guard<std::mutex> lock(obj->pipeline_mutex_);
+  // Or by DetachPipeline while waiting for the pipeline.
+  if (g_source_is_destroyed(g_main_current_source())) {
+    return G_SOURCE_REMOVE;
+  }
+  if (obj->pipeline_ready_ && obj->media_state_ >= GST_STATE_PAUSED) {
+    obj->SendBufferingUpdate();
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+void VideoPlayer::StopBufferingTimer() {
+  if (buffering_timer_) {
+    g_source_destroy(buffering_timer_);
+    g_source_unref(buffering_timer_);
+    buffering_timer_ = nullptr;
+  }
+}
+
+void VideoPlayer::DetachPipeline() {
+  pipeline_ready_ = false;
+  StopBufferingTimer();
+  gst_element_set_state(playbin_, GST_STATE_NULL);
+
+  g_signal_handler_disconnect(G_OBJECT(bus_), on_bus_msg_id_);
+  g_signal_handler_disconnect(G_OBJECT(sink_), handoff_handler_id_);
+  if (deep_element_added_id_) {
+    g_signal_handler_disconnect(G_OBJECT(playbin_), deep_element_added_id_);
+    deep_element_added_id_ = 0;
+  }
+  g_source_destroy(bus_source_);
+  g_source_unref(bus_source_);
+  bus_source_ = nullptr;
+  gst_object_unref(bus_);
+  bus_ = nullptr;
+}
+
+void VideoPlayer::TearDownPipeline() {
+  DetachPipeline();
+
+  // playbin owns the video sink bin and its elements.
+  gst_object_unref(playbin_);
+  playbin_ = nullptr;
+  pipeline_ = nullptr;
+  sink_ = nullptr;
+  decoder_ = nullptr;
+  video_convert_ = nullptr;
+  video_scale_ = nullptr;
+}
+
+void VideoPlayer::RecyclePipeline() {
+  DetachPipeline();
+
+  resource_pool_->ReleasePipeline({playbin_, pipeline_, sink_, decoder_,
+                                   video_convert_, video_scale_,
+                                   pipeline_key_});
+  playbin_ = nullptr;
+  pipeline_ = nullptr;
+  sink_ = nullptr;
+  decoder_ = nullptr;
+  video_convert_ = nullptr;
+  video_scale_ = nullptr;
+}
+
+bool VideoPlayer::FallbackDecoder() {
+  decoder_registry_->MarkFailed(gst_element_get_factory(decoder_));
+  GstElementFactory* decoder_factory = decoder_registry_->Select(video_caps_);
+  if (decoder_factory == nullptr) {
+    return false;
+  }
+
+  gint64 position = 0;
+  gst_element_query_position(playbin_, GST_FORMAT_TIME, &position);
+
+  TearDownPipeline();
+  BuildPipeline(decoder_factory);
+  SPDLOG_DEBUG("[VideoPlayer] decoder: {}", GST_OBJECT_NAME(decoder_factory));
+  gst_object_unref(decoder_factory);
+
+  resume_position_ = position;
+  rate_pending_ = rate_ != 1.0;
+  gst_element_set_state(playbin_, target_state_);
+  return true;
 }
 
 void VideoPlayer::OnMediaError(GstMessage* msg) {
@@ -214,11 +604,24 @@ gboolean VideoPlayer::OnBusMessage(GstBus* bus,
                                    GstMessage* msg,
                                    void* user_data) {
   auto obj = static_cast<VideoPlayer*>(user_data);
+  std::lock_guard<std::mutex> lock(obj->pipeline_mutex_);
+  if (bus != obj->bus_) {
+    // Dispatched while the pipeline was replaced or detached.
+    return TRUE;
+  }
   switch (GST_MESSAGE_TYPE(msg)) {
     case GST_MESSAGE_ERROR:
       VideoPlayer::OnMediaError(msg);
-      gst_object_unref(bus);
-      return FALSE;
+      obj->pipeline_error_ = true;
+      if (obj->decoder_ &&
+          (GST_MESSAGE_SRC(msg) == GST_OBJECT(obj->decoder_) ||
+           gst_object_has_as_ancestor(GST_MESSAGE_SRC(msg),
+                                      GST_OBJECT(obj->decoder_))) &&
+          obj->FallbackDecoder()) {
+        return TRUE;
+      }
+      // bus_ is released with the pipeline on dispose.
+      break;
     case GST_MESSAGE_EOS: {
       SPDLOG_DEBUG("[VideoPlayer] EOS: texture_id: {}", obj->m_texture_id);
       obj->OnPlaybackEnded();
@@ -237,7 +640,10 @@ gboolean VideoPlayer::OnBusMessage(GstBus* bus,
       obj->OnMediaDurationChange();
       break;
     }
-#if 0
+    case GST_MESSAGE_QOS: {
+      obj->OnQos(msg);
+      break;
+    }
     case GST_MESSAGE_LATENCY: {
       auto src = GST_MESSAGE_SRC(msg);
       SPDLOG_DEBUG("[VideoPlayer] Latency: {}", src->name);
@@ -250,11 +656,13 @@ gboolean VideoPlayer::OnBusMessage(GstBus* bus,
         GstClockTime max_latency;
         gst_query_parse_latency(query, &obj->is_live_, &min_latency,
                                 &max_latency);
+        if (GST_CLOCK_TIME_IS_VALID(min_latency)) {
+          obj->stats_.set_latency(GST_TIME_AS_USECONDS(min_latency));
+        }
       }
       gst_query_unref(query);
       break;
     }
-#endif
     case GST_MESSAGE_WARNING: {
       SPDLOG_WARN("[VideoPlayer] Warning");
       break;
@@ -278,30 +686,26 @@ gboolean VideoPlayer::OnBusMessage(GstBus* bus,
 
       gint percent;
       gst_message_parse_buffering(msg, &percent);
-      // SPDLOG_DEBUG("Buffering: {}%", percent);
-
-      // TODO - bufferingUpdate
+      SPDLOG_TRACE("[VideoPlayer] Buffering: {}%", percent);
 
+      // queue2 reports 100% once the high watermark is reached and drops
+      // below it when the low watermark is hit.  The target state is kept so
+      // Play/Pause from Dart still apply while rebuffering.
       if (percent == 100) {
-        // a 100% message means buffering is done
         if (obj->is_buffering_) {
           obj->is_buffering_ = false;
           obj->SetBuffering(obj->is_buffering_);
+          if (obj->target_state_ == GST_STATE_PLAYING) {
+            gst_element_set_state(obj->playbin_, GST_STATE_PLAYING);
+          }
+          obj->SendBufferingUpdate();
         }
-        // if the desired state is playing, go back
-        //        if (obj->target_state_ == GST_STATE_PLAYING) {
-        //          gst_element_set_state(obj->playbin_, GST_STATE_PLAYING);
-        //        }
-      } else {
-        // buffering busy
-        if (!obj->is_buffering_ && obj->target_state_ == GST_STATE_PLAYING) {
-          // we were not buffering but PLAYING, PAUSE the pipeline
-          //          gst_element_set_state(obj->playbin_, GST_STATE_PAUSED);
-        }
-        // if (!obj->is_buffering_) {
+      } else if (!obj->is_buffering_) {
         obj->is_buffering_ = true;
         obj->SetBuffering(obj->is_buffering_);
-        //}
+        if (obj->target_state_ == GST_STATE_PLAYING) {
+          gst_element_set_state(obj->playbin_, GST_STATE_PAUSED);
+        }
       }
       break;
     }
@@ -415,51 +819,211 @@ void VideoPlayer::OnTag(const GstTagList* list,
 
 void VideoPlayer::handoff_handler(GstElement* /* fakesink */,
                                   GstBuffer* buffer,
-                                  GstPad* /* pad */,
+                                  GstPad* pad,
                                   void* user_data) {
   auto obj = static_cast<VideoPlayer*>(user_data);
-  if (!obj->is_initialized_ || obj->info_.finfo == nullptr) {
+  if (!obj->is_initialized_) {
     return;
   }
 
-  std::lock_guard<std::mutex> lock(obj->gst_mutex_);
-  GstVideoFrame frame;
-  if (gst_video_frame_map(&frame, &obj->info_, buffer, GST_MAP_READ)) {
-    obj->m_registrar->texture_registrar()->TextureMakeCurrent();
-    glBindVertexArray(obj->shader_->vertex_arr_id_);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    const guint n_planes = GST_VIDEO_INFO_N_PLANES(&obj->info_);
-    if (n_planes == 2) {
-      // Assume NV12
-      gpointer y_buf = GST_VIDEO_FRAME_PLANE_DATA(&frame, 0);
-      const GLsizei y_stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0);
-      const GLsizei y_pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, 0);
-      gpointer uv_buf = GST_VIDEO_FRAME_PLANE_DATA(&frame, 1);
-      const GLsizei uv_stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 1);
-      const GLsizei uv_pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, 1);
-      obj->shader_->load_pixels(static_cast<unsigned char*>(y_buf),
-                                static_cast<unsigned char*>(uv_buf),
-                                y_pixel_stride, y_stride, uv_pixel_stride,
-                                uv_stride);
-    } else {
-      // Assume RGB
-      gpointer video_frame_plane_buffer = GST_VIDEO_FRAME_PLANE_DATA(&frame, 0);
-      obj->shader_->load_rgb_pixels(
-          static_cast<unsigned char*>(video_frame_plane_buffer));
+  // No GL work on the streaming thread, a slow upload must not back-pressure
+  // the decoder or audio sync.  The caps travel with the frame so a
+  // renegotiation applies to exactly the frames that follow it.
+  obj->stats_.frame_decoded();
+  GstCaps* caps = gst_pad_get_current_caps(pad);
+  obj->frame_queue_.push(buffer, caps);
+  if (caps) {
+    gst_caps_unref(caps);
+  }
+  {
+    std::lock_guard<std::mutex> lock(obj->render_mutex_);
+  }
+  obj->render_cv_.notify_one();
+}
+
+void VideoPlayer::RenderLoop() {
+  std::unique_lock<std::mutex> lock(render_mutex_);
+  while (true) {
+    render_cv_.wait(lock, [this] {
+      return render_exit_ || (frame_pulled_ && frame_queue_.has_frame());
+    });
+    if (render_exit_) {
+      break;
+    }
+    frame_pulled_ = false;
+    lock.unlock();
+
+    auto frame = frame_queue_.pop();
+    bool rendered = false;
+    if (frame.buffer) {
+      rendered = RenderFrame(frame);
+      FrameQueue::release(frame);
     }
-    gst_video_frame_unmap(&frame);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, obj->shader_->framebuffer);
-    obj->shader_->draw_core();
+    lock.lock();
+    if (!rendered) {
+      // Flutter will not pull a frame that was never marked available.
+      frame_pulled_ = true;
+    }
+  }
+}
 
-    obj->m_registrar->texture_registrar()->TextureClearCurrent();
-    obj->m_registrar->texture_registrar()->MarkTextureFrameAvailable(
-        obj->m_texture_id);
-    SPDLOG_TRACE("[VideoPlayer] frame");
-  } else {
+void VideoPlayer::StopRenderThread() {
+  if (!render_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(render_mutex_);
+    render_exit_ = true;
+  }
+  render_cv_.notify_one();
+  render_thread_.join();
+  if (frame_caps_) {
+    gst_caps_unref(frame_caps_);
+    frame_caps_ = nullptr;
+  }
+
+  const auto queue = frame_queue_.stats();
+  const auto stats = stats_.snapshot(queue.dropped, queue.late);
+  SPDLOG_DEBUG(
+      "[VideoPlayer] frames queued: {}, dropped: {}, late: {}, qos dropped: "
+      "{}, upload: {} us avg, {} us max",
+      queue.queued, queue.dropped, queue.late, stats.qos_dropped,
+      stats.upload.average_us(), stats.upload.max_us);
+}
+
+bool VideoPlayer::RenderFrame(const FrameQueue::Frame& frame) {
+  std::lock_guard<std::mutex> lock(gst_mutex_);
+  if (frame.caps && frame.caps != frame_caps_ && !ApplyFrameCaps(frame.caps)) {
+    return false;
+  }
+  if (!shader_ || info_.finfo == nullptr) {
+    return false;
+  }
+
+  // A frame that waited longer than its own duration missed its slot.
+  GstClockTime duration = GST_BUFFER_DURATION(frame.buffer);
+  if (!GST_CLOCK_TIME_IS_VALID(duration) && GST_VIDEO_INFO_FPS_N(&info_) > 0) {
+    duration = gst_util_uint64_scale_int(
+        GST_SECOND, GST_VIDEO_INFO_FPS_D(&info_), GST_VIDEO_INFO_FPS_N(&info_));
+  }
+  if (GST_CLOCK_TIME_IS_VALID(duration) &&
+      static_cast<GstClockTime>(g_get_monotonic_time() - frame.queued_at) *
+              GST_USECOND >
+          duration) {
+    frame_queue_.mark_late();
+  }
+
+  GstBuffer* buffer = frame.buffer;
+  const gint64 render_start = g_get_monotonic_time();
+  m_registrar->texture_registrar()->TextureMakeCurrent();
+  glBindVertexArray(shader_->vertex_arr_id_);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  bool imported = false;
+#if defined(ENABLE_DMABUF)
+  if (sink_mode_ == SinkMode::kDmaBuf && dmabuf::Importer::is_dmabuf(buffer)) {
+    imported = dmabuf_importer_->import(buffer, &info_,
+                                        shader_->plane_textures());
+    if (imported) {
+      shader_->bind_planes();
+    }
+  }
+#endif
+
+  if (!imported && !upload_frame(this, buffer)) {
+    m_registrar->texture_registrar()->TextureClearCurrent();
     SPDLOG_ERROR("[VideoPlayer] Cannot read video frame out from buffer");
+    return false;
   }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, shader_->framebuffer);
+  shader_->draw_core();
+#if defined(ENABLE_DMABUF)
+  if (imported) {
+    // The decoder may reuse the dmabuf once the buffer is unreffed.
+    shader_->wait_draw();
+    dmabuf_importer_->release();
+  }
+#endif
+
+  m_registrar->texture_registrar()->TextureClearCurrent();
+  stats_.frame_rendered(render_start - frame.queued_at,
+                        g_get_monotonic_time() - render_start);
+  m_registrar->texture_registrar()->MarkTextureFrameAvailable(m_texture_id);
+  SPDLOG_TRACE("[VideoPlayer] frame");
+  return true;
+}
+
+bool VideoPlayer::ApplyFrameCaps(GstCaps* caps) {
+  if (!gst_video_info_from_caps(&info_, caps)) {
+    SPDLOG_ERROR("[VideoPlayer] Fail to get video info from the cap");
+    return false;
+  }
+  if (frame_caps_) {
+    gst_caps_unref(frame_caps_);
+  }
+  frame_caps_ = gst_caps_ref(caps);
+
+  nv12::ColorMatrix matrix;
+  switch (info_.colorimetry.matrix) {
+    case GST_VIDEO_COLOR_MATRIX_BT709:
+      matrix = nv12::ColorMatrix::kBT709;
+      break;
+    case GST_VIDEO_COLOR_MATRIX_BT2020:
+      matrix = nv12::ColorMatrix::kBT2020;
+      break;
+    default:
+      matrix = nv12::ColorMatrix::kBT601;
+      break;
+  }
+  const bool full_range =
+      info_.colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255;
+  if (GST_VIDEO_INFO_FPS_N(&info_) > 0) {
+    stats_.set_frame_duration(static_cast<int64_t>(
+        gst_util_uint64_scale_int(G_USEC_PER_SEC, GST_VIDEO_INFO_FPS_D(&info_),
+                                  GST_VIDEO_INFO_FPS_N(&info_))));
+  }
+  if (shader_) {
+    shader_->set_color_space(matrix, full_range);
+  }
+
+  SPDLOG_DEBUG("[VideoPlayer] frame caps: {}x{} {} {}", info_.width,
+               info_.height, GST_VIDEO_INFO_NAME(&info_),
+               gst_caps_features_contains(gst_caps_get_features(caps, 0),
+                                          GST_CAPS_FEATURE_MEMORY_DMABUF)
+                   ? "dmabuf"
+                   : "system memory");
+  return true;
+}
+
+bool VideoPlayer::upload_frame(VideoPlayer* obj, GstBuffer* buffer) {
+  GstVideoFrame frame;
+  if (!gst_video_frame_map(&frame, &obj->info_, buffer, GST_MAP_READ)) {
+    return false;
+  }
+
+  const GstVideoFormat format = GST_VIDEO_INFO_FORMAT(&obj->info_);
+  if (format == GST_VIDEO_FORMAT_NV12 || format == GST_VIDEO_FORMAT_I420) {
+    nv12::Plane planes[nv12::kMaxPlanes]{};
+    const int n_planes = static_cast<int>(GST_VIDEO_FRAME_N_PLANES(&frame));
+    for (int i = 0; i < n_planes; i++) {
+      planes[i].data = static_cast<const unsigned char*>(
+          GST_VIDEO_FRAME_PLANE_DATA(&frame, i));
+      planes[i].stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, i);
+      planes[i].pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, i);
+      planes[i].width = GST_VIDEO_FRAME_COMP_WIDTH(&frame, i);
+      planes[i].height = GST_VIDEO_FRAME_COMP_HEIGHT(&frame, i);
+    }
+    obj->shader_->load_planes(planes, n_planes);
+  } else {
+    // Assume RGB
+    gpointer video_frame_plane_buffer = GST_VIDEO_FRAME_PLANE_DATA(&frame, 0);
+    obj->shader_->load_rgb_pixels(
+        static_cast<unsigned char*>(video_frame_plane_buffer));
+  }
+  gst_video_frame_unmap(&frame);
+  return true;
 }
 
 void VideoPlayer::Init(flutter::BinaryMessenger* messenger) {
@@ -484,6 +1048,10 @@ void VideoPlayer::Init(flutter::BinaryMessenger* messenger) {
               -> std::unique_ptr<
                   flutter::StreamHandlerError<flutter::EncodableValue>> {
             event_sink_ = std::move(events);
+            // The pipeline may have prerolled before Dart started listening.
+            if (is_initialized_) {
+              SendInitialized();
+            }
             return nullptr;
           },
           [this](const flutter::EncodableValue* /* arguments */)
@@ -495,6 +1063,7 @@ void VideoPlayer::Init(flutter::BinaryMessenger* messenger) {
 }
 
 VideoPlayer::~VideoPlayer() {
+  StopRenderThread();
   m_valid = false;
 }
 
@@ -510,7 +1079,8 @@ void VideoPlayer::SendInitialized() {
       flutter::EncodableMap({{flutter::EncodableValue("event"),
                               flutter::EncodableValue("initialized")},
                              {flutter::EncodableValue("duration"),
-                              flutter::EncodableValue((int64_t)duration_)}});
+                              flutter::EncodableValue(static_cast<int64_t>(
+                                  GST_TIME_AS_MSECONDS(duration_)))}});
 
   event.insert({flutter::EncodableValue("width"),
                 flutter::EncodableValue(static_cast<int32_t>(width_))});
@@ -530,6 +1100,7 @@ void VideoPlayer::OnPlaybackEnded() {
 }
 
 void VideoPlayer::OnMediaStateChange(GstState new_state) {
+  media_state_ = new_state;
   if (new_state == GstState::GST_STATE_NULL) {
     SetBuffering(true);
     SendBufferingUpdate();
@@ -538,7 +1109,24 @@ void VideoPlayer::OnMediaStateChange(GstState new_state) {
       is_initialized_ = true;
       SendInitialized();
     }
-    SetBuffering(false);
+    if (!is_buffering_) {
+      SetBuffering(false);
+    }
+
+    if ((pending_seek_ || resume_position_ > 0 || rate_pending_) &&
+        new_state >= GST_STATE_PAUSED) {
+      // Go where Dart seeked to before the preroll, else continue where the
+      // failed decoder stopped, at the requested rate.
+      gint64 position = pending_seek_.value_or(resume_position_);
+      const SeekMode mode = pending_seek_ ? seek_mode_ : SeekMode::kKeyFrame;
+      if (!pending_seek_ && position == 0) {
+        gst_element_query_position(playbin_, GST_FORMAT_TIME, &position);
+      }
+      pending_seek_.reset();
+      resume_position_ = 0;
+      rate_pending_ = false;
+      Seek(position, SeekFlags(mode));
+    }
 
     if (new_state == GST_STATE_PLAYING) {
       SPDLOG_DEBUG("[VideoPlayer] message state changed, start playing {}",
@@ -566,15 +1154,35 @@ void VideoPlayer::Dispose() {
   SPDLOG_DEBUG("[VideoPlayer] Dispose");
   std::lock_guard<std::mutex> buffer_lock(buffer_mutex_);
 
-  if (is_initialized_) {
-    Pause();
+  // Completes a pending scrub request before the player goes away.
+  scrubber_.reset();
+  SetStatsInterval(0);
+  {
+    // Same order as OnBufferingTimer, which waits on the pipeline.
+    std::lock_guard<std::mutex> timer_lock(*timer_mutex_);
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    StopBufferingTimer();
   }
 
-  g_signal_handler_disconnect(G_OBJECT(bus_), on_bus_msg_id_);
-  g_signal_handler_disconnect(G_OBJECT(sink_), handoff_handler_id_);
+  {
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    if (pipeline_ready_) {
+      // A pipeline that posted an error is not handed to another player.
+      if (pipeline_error_) {
+        TearDownPipeline();
+      } else {
+        RecyclePipeline();
+      }
+    }
+  }
+  StopRenderThread();
+  frame_queue_.clear();
 
   m_registrar->texture_registrar()->TextureMakeCurrent();
-  shader_.reset();
+#if defined(ENABLE_DMABUF)
+  dmabuf_importer_.reset();
+#endif
+  resource_pool_->ReleaseShader(std::move(shader_));
   m_registrar->texture_registrar()->TextureClearCurrent();
 
   m_registrar->texture_registrar()->UnregisterTexture(m_texture_id);
@@ -595,27 +1203,121 @@ void VideoPlayer::SetVolume(double volume) {
 }
 
 void VideoPlayer::SetPlaybackSpeed(double playbackSpeed) {
-  GstEvent* seek_event;
-  if (playbackSpeed > 0) {
-    seek_event = gst_event_new_seek(
-        playbackSpeed, GST_FORMAT_TIME,
-        static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
-        GST_SEEK_TYPE_SET, position_, GST_SEEK_TYPE_END, 0);
-  } else {
-    seek_event = gst_event_new_seek(
-        playbackSpeed, GST_FORMAT_TIME,
-        static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
-        GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, position_);
+  if (playbackSpeed == 0.0) {
+    // Not a GStreamer rate, pausing is up to Pause().
+    return;
   }
-
-  gst_element_send_event(sink_, seek_event);
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
   rate_ = playbackSpeed;
-
   SPDLOG_DEBUG("[VideoPlayer] Playback speed: {}", rate_);
+  if (!pipeline_ready_ || media_state_ < GST_STATE_PAUSED) {
+    rate_pending_ = true;
+    return;
+  }
+
+  // position_ is only updated when Dart polls, take the current one.
+  gint64 position;
+  if (!gst_element_query_position(playbin_, GST_FORMAT_TIME, &position)) {
+    position = position_;
+  }
+
+  // A rate change keeps the playhead where it is, except in trick mode where
+  // playback continues from a keyframe.
+  const GstSeekFlags flags =
+      std::abs(rate_) > kTrickModeRate
+          ? SeekFlags(SeekMode::kKeyFrame)
+          : static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH |
+                                      GST_SEEK_FLAG_ACCURATE);
+  if (!Seek(position, flags)) {
+    SPDLOG_ERROR("[VideoPlayer] Failed to set playback speed: {}", rate_);
+  }
+}
+
+GstSeekFlags VideoPlayer::SeekFlags(SeekMode mode) const {
+  if (std::abs(rate_) > kTrickModeRate) {
+    // Only keyframes are decoded, there is nothing to be accurate to.
+    return static_cast<GstSeekFlags>(
+        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_TRICKMODE |
+        GST_SEEK_FLAG_TRICKMODE_KEY_UNITS | GST_SEEK_FLAG_TRICKMODE_NO_AUDIO);
+  }
+  switch (mode) {
+    case SeekMode::kAccurate:
+      return static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH |
+                                       GST_SEEK_FLAG_ACCURATE);
+    case SeekMode::kSnapBefore:
+      return static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH |
+                                       GST_SEEK_FLAG_KEY_UNIT |
+                                       GST_SEEK_FLAG_SNAP_BEFORE);
+    case SeekMode::kSnapAfter:
+      return static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH |
+                                       GST_SEEK_FLAG_KEY_UNIT |
+                                       GST_SEEK_FLAG_SNAP_AFTER);
+    case SeekMode::kKeyFrame:
+    default:
+      return static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH |
+                                       GST_SEEK_FLAG_KEY_UNIT);
+  }
+}
+
+bool VideoPlayer::Seek(gint64 position, GstSeekFlags flags) {
+  // Reverse playback runs from the position back to the start.
+  GstEvent* seek_event =
+      rate_ > 0 ? gst_event_new_seek(rate_, GST_FORMAT_TIME, flags,
+                                     GST_SEEK_TYPE_SET, position,
+                                     GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE)
+                : gst_event_new_seek(rate_, GST_FORMAT_TIME, flags,
+                                     GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET,
+                                     position);
+  if (!gst_element_send_event(playbin_, seek_event)) {
+    return false;
+  }
+  position_ = position;
+  return true;
+}
+
+void VideoPlayer::SetSeekMode(SeekMode mode) {
+  seek_mode_ = mode;
+}
+
+void VideoPlayer::Scrub(int64_t position,
+                        gint width,
+                        Scrubber::Callback callback) {
+  gint video_width, video_height;
+  bool has_media_info;
+  {
+    std::lock_guard<std::mutex> lock(gst_mutex_);
+    video_width = width_;
+    video_height = height_;
+    has_media_info = !video_caps_.empty();
+  }
+  if (!has_media_info || width <= 0) {
+    // Media info not known yet
+    callback(std::nullopt);
+    return;
+  }
+
+  // Even sizes keep videoscale and the chroma planes aligned.
+  width = std::max(2, std::min(width, video_width) & ~1);
+  const gint height = std::max(
+      2, static_cast<gint>(gst_util_uint64_scale_int(width, video_height,
+                                                     video_width)) &
+             ~1);
+  if (!scrubber_ || scrubber_->width() != width) {
+    scrubber_ =
+        std::make_unique<Scrubber>(uri_, http_headers_, width, height);
+  }
+  scrubber_->Request(static_cast<GstClockTime>(std::max<int64_t>(position, 0)) *
+                         GST_MSECOND,
+                     std::move(callback));
 }
 
 void VideoPlayer::Play() {
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
   target_state_ = GST_STATE_PLAYING;
+  if (!pipeline_ready_) {
+    // Applied once the media info is known.
+    return;
+  }
   const GstStateChangeReturn ret =
       gst_element_set_state(playbin_, GST_STATE_PLAYING);
   if (ret == GST_STATE_CHANGE_FAILURE) {
@@ -625,9 +1327,16 @@ void VideoPlayer::Play() {
 }
 
 void VideoPlayer::Pause() {
-  GstState state;
-  gst_element_get_state(playbin_, &state, nullptr, GST_CLOCK_TIME_NONE);
-  if (state != GST_STATE_NULL) {
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
+  if (!pipeline_ready_) {
+    target_state_ = GST_STATE_PAUSED;
+    return;
+  }
+  // Current and pending state, waiting for a preroll would block the bus
+  // with the lock held.
+  GstState state, pending;
+  gst_element_get_state(playbin_, &state, &pending, 0);
+  if (state != GST_STATE_NULL || pending != GST_STATE_VOID_PENDING) {
     target_state_ = GST_STATE_PAUSED;
     const GstStateChangeReturn ret =
         gst_element_set_state(playbin_, GST_STATE_PAUSED);
@@ -641,11 +1350,15 @@ void VideoPlayer::Pause() {
 }
 
 int64_t VideoPlayer::GetPosition() {
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
+  if (!pipeline_ready_) {
+    return 0;
+  }
   auto res = gst_element_query_position(playbin_, GST_FORMAT_TIME, &position_);
   if (res) {
     SPDLOG_TRACE("[VideoPlayer] Position: {}", position_);
   }
-  return position_ >= 0 ? (position_ / AV_TIME_BASE) : 0;
+  return position_ >= 0 ? GST_TIME_AS_MSECONDS(position_) : 0;
 }
 
 void VideoPlayer::SendBufferingUpdate() {
@@ -653,12 +1366,9 @@ void VideoPlayer::SendBufferingUpdate() {
     return;
   }
   auto values = flutter::EncodableList();
-  // TODO ranges = player GetBufferedRanges();
-  std::vector<std::tuple<uint64_t, uint64_t>> ranges;
-  for (auto& it : ranges) {
+  for (const auto& [start, end] : GetBufferedRanges()) {
     values.emplace_back(flutter::EncodableList(
-        {flutter::EncodableValue((int64_t)(std::get<0>(it))),
-         flutter::EncodableValue((int64_t)(std::get<1>(it)))}));
+        {flutter::EncodableValue(start), flutter::EncodableValue(end)}));
   }
 
   auto res = flutter::EncodableMap(
@@ -668,19 +1378,65 @@ void VideoPlayer::SendBufferingUpdate() {
   event_sink_->Success(flutter::EncodableValue(res));
 }
 
+std::vector<std::pair<int64_t, int64_t>> VideoPlayer::GetBufferedRanges() {
+  std::vector<std::pair<int64_t, int64_t>> ranges;
+  if (!pipeline_ready_ || duration_ <= 0) {
+    return ranges;
+  }
+
+  GstQuery* query = gst_query_new_buffering(GST_FORMAT_PERCENT);
+  if (gst_element_query(playbin_, query)) {
+    GstFormat format;
+    gint64 estimated_total;
+    gst_query_parse_buffering_range(query, &format, nullptr, nullptr,
+                                    &estimated_total);
+    // Ranges come back in whatever format the buffering element tracks.
+    gint64 scale_total = 0;
+    switch (format) {
+      case GST_FORMAT_PERCENT:
+        scale_total = GST_FORMAT_PERCENT_MAX;
+        break;
+      case GST_FORMAT_BYTES:
+        scale_total = estimated_total;
+        break;
+      case GST_FORMAT_TIME:
+        scale_total = duration_;
+        break;
+      default:
+        break;
+    }
+
+    const guint n_ranges = gst_query_get_n_buffering_ranges(query);
+    for (guint i = 0; scale_total > 0 && i < n_ranges; i++) {
+      gint64 start, stop;
+      if (!gst_query_parse_nth_buffering_range(query, i, &start, &stop)) {
+        continue;
+      }
+      start = static_cast<gint64>(
+          gst_util_uint64_scale(start, duration_, scale_total));
+      stop = static_cast<gint64>(
+          gst_util_uint64_scale(stop, duration_, scale_total));
+      ranges.emplace_back(GST_TIME_AS_MSECONDS(start),
+                          GST_TIME_AS_MSECONDS(stop));
+    }
+  }
+  gst_query_unref(query);
+  return ranges;
+}
+
 void VideoPlayer::SeekTo(int64_t seek) {
-  gint64 position = seek * AV_TIME_BASE;
-  SPDLOG_DEBUG("[VideoPlayer] SeekTo: {} -> {}", seek, position);
-
-  if (!gst_element_seek_simple(
-          playbin_, GST_FORMAT_TIME,
-          static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH |
-                                    GST_SEEK_FLAG_KEY_UNIT),
-          position)) {
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
+  const gint64 position = seek * GST_MSECOND;
+  SPDLOG_DEBUG("[VideoPlayer] SeekTo: {} ms", seek);
+  if (!pipeline_ready_ || media_state_ < GST_STATE_PAUSED) {
+    // Applied once the pipeline has prerolled, the newest seek wins.
+    pending_seek_ = position;
+    return;
+  }
+
+  if (!Seek(position, SeekFlags(seek_mode_))) {
     SPDLOG_ERROR("[VideoPlayer] Seek Failed");
   }
-  gst_element_query_position(playbin_, GST_FORMAT_TIME, &position_);
-  SPDLOG_DEBUG("[VideoPlayer] SeekTo: {} -> {}", seek, position_);
 }
 
 void VideoPlayer::prepare(VideoPlayer* obj) {
@@ -699,20 +1455,15 @@ void VideoPlayer::prepare(VideoPlayer* obj) {
   }
   GstCaps* caps = gst_pad_get_current_caps(pad);
   assert(caps);
-  std::lock_guard<std::mutex> lock(obj->gst_mutex_);
-  if (!gst_video_info_from_caps(&obj->info_, caps)) {
-    SPDLOG_ERROR("[VideoPlayer] Fail to get video info from the cap");
-    // TODO g_main_loop_quit(data->main_loop);
-    // return;
-  }
-  SPDLOG_DEBUG("[VideoPlayer] original video width: {}, height: {}",
-               obj->info_.width, obj->info_.height);
-  // set to the target
-  if (!gst_video_info_set_format(&obj->info_, GST_VIDEO_FORMAT_NV12,
-                                 static_cast<guint>(obj->width_),
-                                 static_cast<guint>(obj->height_))) {
-    SPDLOG_ERROR("[VideoPlayer] Failed to set the video info to target NV12");
+  GstVideoInfo info;
+  if (gst_video_info_from_caps(&info, caps)) {
+    SPDLOG_DEBUG("[VideoPlayer] original video width: {}, height: {}",
+                 info.width, info.height);
   }
+  gst_caps_unref(caps);
+  gst_object_unref(pad);
+
+  // The render thread takes the video info from the caps of each frame.
   obj->is_initialized_ = true;
 }
 
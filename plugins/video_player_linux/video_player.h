@@ -16,13 +16,18 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <functional>
 #include <future>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <flutter/event_channel.h>
 #include <flutter/event_stream_handler.h>
@@ -30,12 +35,20 @@
 #include <flutter/plugin_registrar_homescreen.h>
 #include <flutter/standard_method_codec.h>
 
+#include "decoder_registry.h"
+#include "frame_queue.h"
+#include "media_info_cache.h"
 #include "nv12.h"
+#include "playback_stats.h"
+#include "resource_pool.h"
+#include "scrubber.h"
+#if defined(ENABLE_DMABUF)
+#include "dmabuf.h"
+#endif
 
 extern "C" {
 #include <gst/gst.h>
 #include <gst/video/video.h>
-#include <libavformat/avformat.h>
 }
 
 #include "messages.g.h"
@@ -44,15 +57,63 @@ class Backend;
 
 namespace video_player_linux {
 
+// Network buffering of playbin, only applied to non-file URIs.
+struct BufferingOptions {
+  // Progressive download into a temporary file (GST_PLAY_FLAG_DOWNLOAD)
+  bool download = true;
+  // Upper bound of the download ring buffer in bytes, 0 keeps the whole file
+  guint64 ring_buffer_max_size = 0;
+  // Queue size in bytes, -1 for the GStreamer default
+  gint buffer_size = -1;
+  // Queue size in nanoseconds, -1 for the GStreamer default
+  gint64 buffer_duration = -1;
+  // Fill level at which playback pauses to rebuffer
+  gdouble low_watermark = 0.01;
+  // Fill level at which playback resumes
+  gdouble high_watermark = 0.99;
+  // Interval of "bufferingUpdate" events while playing a network URI
+  guint update_interval_ms = 500;
+};
+
 class VideoPlayer {
  public:
+  // How decoded frames reach the Flutter texture.
+  enum class SinkMode {
+    // Map each frame and upload the planes with glTexImage2D
+    kUpload,
+    // Import dmabuf frames as EGLImages, upload anything else
+    kDmaBuf,
+  };
+
+  // Where frames are scaled to the texture size.
+  enum class ScaleMode {
+    // videoscale converts every frame to NV12 at the probed size
+    kVideoScale,
+    // Frames keep the decoded format and size, the shader converts and scales
+    kNative,
+  };
+
+  // Where SeekTo lands relative to the requested position.
+  enum class SeekMode {
+    // Nearest keyframe, the fastest
+    kKeyFrame,
+    // Exactly the requested frame, decodes from the keyframe before it
+    kAccurate,
+    // Keyframe at or before the position
+    kSnapBefore,
+    // Keyframe at or after the position
+    kSnapAfter,
+  };
+
+  // Above this absolute rate only keyframes are decoded and audio is skipped.
+  static constexpr double kTrickModeRate = 2.0;
+
   VideoPlayer(flutter::PluginRegistrarDesktop* registrar,
               const std::string& uri,
               std::map<std::string, std::string> http_headers,
-              GLsizei width,
-              GLsizei height,
-              gint64 duration,
-              GstElementFactory* decoder_factory);
+              DecoderRegistry* decoder_registry,
+              ResourcePool* resource_pool,
+              const BufferingOptions& buffering_options = {});
   ~VideoPlayer();
 
   void Dispose();
@@ -62,22 +123,68 @@ class VideoPlayer {
   void Play();
   void Pause();
   int64_t GetPosition();
+  // pipeline_mutex_ must be held.
   void SendBufferingUpdate();
+
+  /**
+   * @brief Current playback counters and timings
+   * @return flutter::EncodableMap
+   * @relation
+   * flutter
+   */
+  flutter::EncodableMap GetStats();
+
+  /**
+   * @brief Send "stats" events on the event channel periodically
+   * @param[in] interval_ms Interval in milliseconds, 0 stops the events
+   * @return void
+   * @relation
+   * flutter
+   */
+  void SetStatsInterval(guint interval_ms);
   void SeekTo(int64_t seek);
+  void SetSeekMode(SeekMode mode);
   int64_t GetTextureId() const { return m_texture_id; };
   bool IsValid();
 
   // Initializes the video player.
   void Init(flutter::BinaryMessenger* messenger);
 
+  /**
+   * @brief Size the texture and build the pipeline once media info is known
+   * @param[in] info Probed media info, std::nullopt if probing failed
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void OnMediaInfo(const std::optional<MediaInfo>& info);
+
+  /**
+   * @brief Decode a preview frame for a timeline position on a separate
+   * pipeline, playback is not affected
+   * @param[in] position Position in milliseconds
+   * @param[in] width Preview width, the height follows the aspect ratio
+   * @param[in] callback Invoked with the frame, or std::nullopt if it failed
+   * or a newer request replaced it
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void Scrub(int64_t position, gint width, Scrubber::Callback callback);
+
  private:
   flutter::PluginRegistrarDesktop* m_registrar;
   std::string uri_;
   std::map<std::string, std::string> http_headers_;
+  DecoderRegistry* decoder_registry_;
+  ResourcePool* resource_pool_;
+  BufferingOptions buffering_options_;
+  bool is_network_{};
+  GSource* buffering_timer_{};
+  std::string video_caps_;
   GLsizei width_{};
   GLsizei height_{};
   gint64 duration_{};
-  GstElementFactory* decoder_factory_;
 
   GLuint m_texture_id{};
   std::atomic<bool> m_valid = true;
@@ -98,19 +205,41 @@ class VideoPlayer {
   GstCaps* scale_{};
   GstVideoInfo info_{};
   gint64 position_ = 0;
-  gdouble rate_ = 0.0;
+  gdouble rate_ = 1.0;
+  // rate_ is applied once the pipeline has prerolled
+  bool rate_pending_ = false;
+  SeekMode seek_mode_ = SeekMode::kKeyFrame;
+  std::unique_ptr<Scrubber> scrubber_;
   GstBus* bus_{};
+  GSource* bus_source_{};
+  std::atomic<bool> pipeline_ready_ = false;
+  // The pipeline posted an error and must not be recycled
+  bool pipeline_error_ = false;
+  // Pool key of the current pipeline
+  std::string pipeline_key_;
+  // Position to restore after the pipeline was rebuilt
+  gint64 resume_position_ = 0;
+  // SeekTo() before the pipeline prerolled, in nanoseconds
+  std::optional<gint64> pending_seek_;
 
   gulong handoff_handler_id_;
   gulong on_bus_msg_id_;
+  gulong deep_element_added_id_{};
 
+  // Play()/Pause() before or while the pipeline is built, guarded by
+  // pipeline_mutex_ like the pipeline itself.
   GstState target_state_ = GST_STATE_PAUSED;
 
-  AVCodecID codec_id_{};
-
   gint n_video_{};
   gint current_video_{};
   std::unique_ptr<nv12::Shader> shader_;
+  SinkMode sink_mode_ = SinkMode::kUpload;
+  ScaleMode scale_mode_ = ScaleMode::kVideoScale;
+  // Caps info_ was last set from, owned by the render thread
+  GstCaps* frame_caps_{};
+#if defined(ENABLE_DMABUF)
+  std::unique_ptr<dmabuf::Importer> dmabuf_importer_;
+#endif
   bool is_looping_{};
   bool is_buffering_{};
   gboolean is_live_{};
@@ -118,10 +247,121 @@ class VideoPlayer {
   double volume_ = 0.0;
 
   std::mutex gst_mutex_;
+  // Held by every platform thread call and GLib callback that uses playbin_
+  // and the elements after it, FallbackDecoder() replaces them on the GLib
+  // thread.
+  std::mutex pipeline_mutex_;
+
+  // Frames handed from the streaming thread to the render thread.
+  FrameQueue frame_queue_;
+  PlaybackStats stats_;
+  GSource* stats_timer_{};
+  // Held while a stats or buffering tick runs, so that Dispose waits for it.
+  // Shared with the timers, which may dispatch after this player is gone.
+  std::shared_ptr<std::mutex> timer_mutex_ = std::make_shared<std::mutex>();
+  // Snapshot of the previous "stats" event, GLib thread only
+  std::optional<PlaybackStats::Snapshot> last_stats_;
+  // Last QoS drop count of each element, GLib thread only
+  std::map<std::string, guint64> qos_dropped_;
+  std::thread render_thread_;
+  std::mutex render_mutex_;
+  std::condition_variable render_cv_;
+  // Flutter pulled the last rendered frame, a new one may be drawn.
+  bool frame_pulled_ = true;
+  bool render_exit_ = false;
 
   bool is_initialized_ = false;
   void SetBuffering(bool buffering);
 
+  /**
+   * @brief Query the buffered parts of the stream
+   * @return std::vector<std::pair<int64_t, int64_t>>
+   * @retval Start and end of each range in milliseconds
+   * @relation
+   * gstreamer
+   */
+  std::vector<std::pair<int64_t, int64_t>> GetBufferedRanges();
+
+  struct TimerData {
+    std::shared_ptr<std::mutex> mutex;
+    VideoPlayer* player;
+  };
+
+  /**
+   * @brief Attach a timer tick of this player to context_
+   * @param[in] source Timeout source
+   * @param[in] func Tick, receives a TimerData
+   * @return void
+   * @relation
+   * glib
+   */
+  void AttachTimer(GSource* source, GSourceFunc func);
+
+  // pipeline_mutex_ must be held.
+  void StopBufferingTimer();
+
+  static gboolean OnBufferingTimer(gpointer user_data);
+
+  static gboolean OnStatsTimer(gpointer user_data);
+
+  /**
+   * @brief Convert a stats snapshot for Dart
+   * @param[in] stats Current snapshot
+   * @param[in] previous Earlier snapshot the decode rate is measured from,
+   * nullptr for the rate since the first frame
+   * @return flutter::EncodableMap
+   * @relation
+   * flutter
+   */
+  static flutter::EncodableMap StatsToMap(
+      const PlaybackStats::Snapshot& stats,
+      const PlaybackStats::Snapshot* previous);
+
+  /**
+   * @brief Track frames dropped on QoS by an element
+   * @param[in] msg QoS message
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void OnQos(GstMessage* msg);
+
+  /**
+   * @brief Seek flags for a mode at the current rate
+   * @param[in] mode Seek mode
+   * @return GstSeekFlags
+   * @relation
+   * gstreamer
+   */
+  GstSeekFlags SeekFlags(SeekMode mode) const;
+
+  /**
+   * @brief Seek playbin at the current rate
+   * @param[in] position Position in nanoseconds
+   * @param[in] flags Seek flags
+   * @return bool
+   * @retval true Seek event handled
+   * @retval false Seek failed
+   * @relation
+   * gstreamer
+   */
+  bool Seek(gint64 position, GstSeekFlags flags);
+
+  /**
+   * @brief Apply the queue watermarks to buffering elements playbin creates
+   * @param[in] bin No use
+   * @param[in] sub_bin No use
+   * @param[in] element Element added somewhere below playbin
+   * @param[in] user_data Pointer to VideoPlayer
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  static void OnDeepElementAdded(GstBin* bin,
+                                 GstBin* sub_bin,
+                                 GstElement* element,
+                                 gpointer user_data);
+
   void OnPlaybackEnded();
   void OnMediaInitialized();
   void OnMediaStateChange(GstState state);
@@ -158,7 +398,8 @@ class VideoPlayer {
   bool EnsureTextureCreated(uint32_t width, uint32_t height);
 
   /**
-   * @brief Callback called when fakesink receives new frame data
+   * @brief Callback called when fakesink receives new frame data, queues it
+   * for the render thread
    * @param[in] fakesink No use
    * @param[in] buffer Pointer to New frame data
    * @param[in] pad No use
@@ -172,6 +413,121 @@ class VideoPlayer {
                               GstPad* pad,
                               void* user_data);
 
+  /**
+   * @brief Render thread, draws the latest queued frame each time Flutter
+   * has pulled the previous one
+   * @return void
+   * @relation
+   * flutter
+   */
+  void RenderLoop();
+
+  /**
+   * @brief Stop and join the render thread
+   * @return void
+   * @relation
+   * flutter
+   */
+  void StopRenderThread();
+
+  /**
+   * @brief Draw a frame into the Flutter texture
+   * @param[in] frame Frame taken from the queue
+   * @return bool
+   * @retval true Texture frame marked available
+   * @retval false Nothing was drawn
+   * @relation
+   * flutter
+   */
+  bool RenderFrame(const FrameQueue::Frame& frame);
+
+  /**
+   * @brief Update the video info and color space after caps changed
+   * @param[in] caps Caps of the next frame
+   * @return bool
+   * @retval true Caps are usable
+   * @retval false Caps could not be parsed
+   * @relation
+   * gstreamer
+   */
+  bool ApplyFrameCaps(GstCaps* caps);
+
+  /**
+   * @brief Map frame and upload planes to the shader
+   * @param[in] obj Pointer to VideoPlayer
+   * @param[in] buffer Pointer to New frame data
+   * @return bool
+   * @retval true Normal end
+   * @retval false Abnormal end
+   * @relation
+   * flutter
+   */
+  static bool upload_frame(VideoPlayer* obj, GstBuffer* buffer);
+
+  /**
+   * @brief Take a pooled playbin or create one with the video sink bin, then
+   * configure it for this player
+   * @param[in] decoder_factory Decoder for the video stream
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void BuildPipeline(GstElementFactory* decoder_factory);
+
+  /**
+   * @brief Create the video sink bin: decoder ! videoconvert [! videoscale]
+   * ! fakesink
+   * @param[in] decoder_factory Decoder for the video stream
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void BuildSinkBin(GstElementFactory* decoder_factory);
+
+  /**
+   * @brief Pool key of a pipeline built for this player
+   * @param[in] decoder_factory Decoder for the video stream
+   * @return std::string
+   * @relation
+   * gstreamer
+   */
+  std::string PipelineKey(GstElementFactory* decoder_factory) const;
+
+  /**
+   * @brief Set playbin to NULL and disconnect everything of this player
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void DetachPipeline();
+
+  /**
+   * @brief Stop and release playbin and the video sink bin
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void TearDownPipeline();
+
+  /**
+   * @brief Stop playbin and hand it to the resource pool
+   * @return void
+   * @relation
+   * gstreamer
+   */
+  void RecyclePipeline();
+
+  /**
+   * @brief Rebuild the pipeline with the next ranked decoder after the
+   * current one failed.  pipeline_mutex_ must be held.
+   * @return bool
+   * @retval true Pipeline rebuilt
+   * @retval false No decoder left to try
+   * @relation
+   * gstreamer
+   */
+  bool FallbackDecoder();
+
   static gboolean OnBusMessage(GstBus* bus, GstMessage* msg, void* user_data);
 
   /**
@@ -19,9 +19,13 @@
 
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_homescreen.h>
+#include <flutter/standard_method_codec.h>
 
+#include "decoder_registry.h"
 #include "flutter_desktop_plugin_registrar.h"
+#include "media_info_cache.h"
 #include "messages.g.h"
+#include "resource_pool.h"
 #include "video_player.h"
 
 namespace video_player_linux {
@@ -59,39 +63,52 @@ class VideoPlayerPlugin final : public flutter::Plugin, public VideoPlayerApi {
   std::optional<FlutterError> Pause(int64_t texture_id) override;
 
  private:
+  static constexpr char kChannelName[] = "video_player_linux";
+
   // A list of all the video players instantiated by this plugin.
   std::map<int64_t, std::unique_ptr<VideoPlayer>> videoPlayers;
 
   flutter::PluginRegistrarDesktop* registrar_{};
 
-  /**
-   * @brief Get video info
-   * @param[in] url URL of the stream
-   * @param[out] width Buffer to store width info
-   * @param[out] height Buffer to store height info
-   * @param[out] duration Buffer to store duration info
-   * @param[out] codec_id Buffer to store codec info
-   * @return bool
-   * @retval true Normal end
-   * @retval false Abnormal end
-   * @relation
-   * flutter
-   */
-  static bool get_video_info(const char* url,
-                             int& width,
-                             int& height,
-                             gint64& duration,
-                             AVCodecID& codec_id);
+  // Probed stream metadata, shared by all players.
+  std::unique_ptr<MediaInfoCache> media_info_cache_;
+
+  // Network buffering applied to every player created.
+  BufferingOptions buffering_options_;
+
+  // Ranked video decoders, shared by all players.
+  std::unique_ptr<DecoderRegistry> decoder_registry_;
+
+  // Shaders and pipelines recycled between players.
+  std::unique_ptr<ResourcePool> resource_pool_;
+
+  // Methods outside the generated VideoPlayerApi: seek mode, scrubbing and
+  // playback stats.
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel_;
 
   /**
-   * @brief Return GStreamer plugin for codec ID
-   * @param[in] codec_id Codec ID
-   * @return char*
-   * @retval GStreamer plugin
+   * @brief Handle calls on kChannelName
+   *
+   * "setSeekMode" {textureId, mode}: mode is "keyFrame", "accurate",
+   * "snapBefore" or "snapAfter", used by later seekTo calls.
+   *
+   * "scrub" {textureId, position, width}: preview frame for a position in
+   * milliseconds, replied as {width, height, timestamp, pixels} with RGBA
+   * pixels, or null when a newer scrub replaced the request.
+   *
+   * "getStats" {textureId}: frame counts and timings of the player.
+   *
+   * "setStatsInterval" {textureId, interval}: send the same map as a "stats"
+   * event every interval milliseconds, 0 stops.
+   * @param[in] method_call Method call
+   * @param[in] result Reply
+   * @return void
    * @relation
    * flutter
    */
-  static const char* map_ffmpeg_plugin(AVCodecID codec_id);
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& method_call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 };
 
 }  // namespace video_player_linux